@@ -1,9 +1,11 @@
 #include "rc_switch.h"
 #include "esp_timer.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "rom/ets_sys.h"
+#include "trace.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -22,107 +24,321 @@ static const rc_protocol_t protocols[] = {
 
 #define NUM_PROTOCOLS (sizeof(protocols) / sizeof(protocols[0]))
 
-// Global receiver pointer for ISR
-static rc_receiver_t* g_receiver = NULL;
-static volatile uint32_t isr_trigger_count = 0;
+_Static_assert(NUM_PROTOCOLS == RC_SWITCH_NUM_PROTOCOLS, "RC_SWITCH_NUM_PROTOCOLS is out of date");
+
+#define SQUELCH_WINDOW_US          100000  // Edge rate measurement window
+#define SQUELCH_GLITCH_US_DEFAULT  80
+#define SQUELCH_GLITCH_US_MIN      30
+#define SQUELCH_GLITCH_US_MAX      120
+#define SQUELCH_GLITCH_LIMIT_MIN   3
+#define SQUELCH_GLITCH_LIMIT_MAX   16
+
+// The GPIO ISR service is shared by every receiver, each pin gets its own handler argument
+static bool isr_service_installed = false;
+
+// Sequence lock, like main/seqlock.h: the ISR copies the tuning out at the start of
+// every run and copies again if a write overlapped. The writer holds a spinlock with
+// interrupts masked on its core for the few bytes it copies, so the ISR only ever
+// retries while the other core is inside that copy.
+static rc_decoder_config_t decoder_config = RC_DECODER_CONFIG_DEFAULT;
+static volatile uint32_t decoder_config_seq = 0;       // Odd while a write is in progress
+static portMUX_TYPE decoder_config_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline void decoder_config_read(rc_decoder_config_t* out) {
+    for (;;) {
+        uint32_t start = __atomic_load_n(&decoder_config_seq, __ATOMIC_ACQUIRE);
+        if ((start & 1) == 0) {
+            *out = decoder_config;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&decoder_config_seq, __ATOMIC_RELAXED) == start) return;
+        }
+    }
+}
 
-// Decode the timing buffer to extract code, protocol, etc.
-static bool decode_signal(rc_receiver_t* receiver) {
-    // Try each protocol
-    for (uint8_t proto = 0; proto < NUM_PROTOCOLS; proto++) {
-        const rc_protocol_t* protocol = &protocols[proto];
-        uint32_t code = 0;
-        uint16_t delay = 0;
-        uint8_t bit_count = 0;
-        
-        // Look for sync pattern at start
-        if (receiver->buffer_pos < 8) continue;
-        
-        // Estimate pulse length from first few transitions
-        uint32_t avg_short = 0;
-        uint8_t short_count = 0;
-        
-        for (uint8_t i = 2; i < receiver->buffer_pos && i < 20; i++) {
-            if (receiver->duration_buffer[i] < 2000) {
-                avg_short += receiver->duration_buffer[i];
-                short_count++;
-            }
+static inline uint32_t edge_at(const rc_receiver_t* receiver, uint16_t i) {
+    if (receiver->edge_width == 2) return ((const uint16_t*)receiver->edge_buffer)[i];
+    return ((const uint32_t*)receiver->edge_buffer)[i];
+}
+
+static inline void edge_store(rc_receiver_t* receiver, uint16_t i, int64_t duration) {
+    if (receiver->edge_width == 2) {
+        ((uint16_t*)receiver->edge_buffer)[i] = duration > UINT16_MAX ? UINT16_MAX : duration;
+    } else {
+        ((uint32_t*)receiver->edge_buffer)[i] = duration > UINT32_MAX ? UINT32_MAX : duration;
+    }
+}
+
+// Pulse length of the capture if it is protocol, from the bit period of the first few
+// bits. A one and a zero take the same number of pulses in every protocol, so a
+// high/low pair is one.high + one.low pulses whatever the bit; averaging single
+// durations would mix short and long phases into a pulse length that fits no protocol.
+static uint16_t estimate_pulse(const rc_receiver_t* receiver, const rc_protocol_t* protocol,
+                               const rc_decoder_config_t* config) {
+    uint32_t period_sum = 0;
+    uint8_t period_count = 0;
+
+    for (uint16_t i = 1; i + 1 < receiver->buffer_pos && i < 20; i += 2) {
+        uint32_t high = edge_at(receiver, i);
+        uint32_t low = edge_at(receiver, i + 1);
+        if (high < config->short_pulse_us && low < config->short_pulse_us) {
+            period_sum += high + low;
+            period_count++;
         }
-        
-        if (short_count == 0) continue;
-        delay = avg_short / short_count;
-        
-        // Try to decode bits
-        for (uint8_t i = 1; i < receiver->buffer_pos - 1 && bit_count < 32; i += 2) {
-            uint32_t dur_high = receiver->duration_buffer[i];
-            uint32_t dur_low = receiver->duration_buffer[i + 1];
-            
-            // Calculate expected timings
-            uint32_t one_high = delay * protocol->one.high;
-            uint32_t one_low = delay * protocol->one.low;
-            uint32_t zero_high = delay * protocol->zero.high;
-            uint32_t zero_low = delay * protocol->zero.low;
-            
-            // Check if it matches a '1' bit
-            if (abs((int)dur_high - (int)one_high) < delay && 
-                abs((int)dur_low - (int)one_low) < delay) {
-                code = (code << 1) | 1;
-                bit_count++;
-            }
-            // Check if it matches a '0' bit
-            else if (abs((int)dur_high - (int)zero_high) < delay && 
-                     abs((int)dur_low - (int)zero_low) < delay) {
-                code = (code << 1) | 0;
-                bit_count++;
-            }
-            else {
-                // Invalid bit timing
-                break;
-            }
+    }
+
+    if (period_count == 0) return 0;
+    return period_sum / (period_count * (protocol->one.high + protocol->one.low));
+}
+
+// Reads bits with the timing of protocol until one does not fit. bits may be NULL when
+// only the fit matters. Returns the number of bits read; error is the summed distance of
+// their phases from the ideal timing.
+static uint16_t match_bits(rc_receiver_t* receiver, const rc_protocol_t* protocol, uint16_t delay,
+                           uint32_t* bits, uint32_t* code, bool* any_one, uint32_t* error) {
+    // rc-switch's 60 % of a pulse
+    int tolerance = delay * 60 / 100;
+    int one_high = delay * protocol->one.high;
+    int one_low = delay * protocol->one.low;
+    int zero_high = delay * protocol->zero.high;
+    int zero_low = delay * protocol->zero.low;
+    uint16_t bit_count = 0;
+
+    *code = 0;
+    *any_one = false;
+    *error = 0;
+    for (uint16_t i = 1; i < receiver->buffer_pos - 1 && bit_count < receiver->bit_capacity; i += 2) {
+        int dur_high = edge_at(receiver, i);
+        int dur_low = edge_at(receiver, i + 1);
+        int one_error = abs(dur_high - one_high) + abs(dur_low - one_low);
+        int zero_error = abs(dur_high - zero_high) + abs(dur_low - zero_low);
+
+        if (bits != NULL && (bit_count & 31) == 0) bits[bit_count >> 5] = 0;
+
+        if (abs(dur_high - one_high) < tolerance && abs(dur_low - one_low) < tolerance) {
+            if (bit_count < RC_SWITCH_MAX_BITS) *code = (*code << 1) | 1;
+            if (bits != NULL) bits[bit_count >> 5] |= 0x80000000u >> (bit_count & 31);
+            *any_one = true;
+            *error += one_error;
+        } else if (abs(dur_high - zero_high) < tolerance && abs(dur_low - zero_low) < tolerance) {
+            if (bit_count < RC_SWITCH_MAX_BITS) *code = *code << 1;
+            *error += zero_error;
+        } else {
+            break;      // Invalid bit timing
         }
-        
-        // Valid if we decoded at least 8 bits
-        if (bit_count >= 8 && code != 0) {
-            receiver->received_value = code;
-            receiver->received_bitlength = bit_count;
-            receiver->received_protocol = proto + 1;  // 1-indexed
-            receiver->received_delay = delay;
-            return true;
+        bit_count++;
+    }
+    return bit_count;
+}
+
+// Decode the timing buffer to extract code, protocol, etc. Protocols with different
+// ratios can both fit within the tolerance (1:2 bits pass as 1:3 ones once the pulse
+// length is scaled), so every protocol is tried and the one that reads the most bits
+// with the smallest timing error per bit wins. Protocols with the same ratios tie and
+// the lower number is reported.
+static bool decode_signal(rc_receiver_t* receiver, const rc_decoder_config_t* config) {
+    if (receiver->buffer_pos < 8) return false;
+
+    int best = -1;
+    uint16_t best_bits = 0;
+    uint16_t best_delay = 0;
+    uint32_t best_error = 0;
+
+    for (uint8_t proto = 0; proto < NUM_PROTOCOLS; proto++) {
+        const rc_protocol_t* protocol = &protocols[proto];
+        uint16_t delay = estimate_pulse(receiver, protocol, config);
+        if (delay == 0) continue;
+
+        uint32_t code;
+        bool any_one;
+        uint32_t error;
+        uint16_t bit_count = match_bits(receiver, protocol, delay, NULL, &code, &any_one, &error);
+        if (bit_count < config->min_bits || !any_one) continue;
+
+        // Errors are compared per bit and relative to the pulse length, as error / (bits * delay)
+        if (best < 0 || bit_count > best_bits ||
+            (bit_count == best_bits && (uint64_t)error * best_delay < (uint64_t)best_error * delay)) {
+            best = proto;
+            best_bits = bit_count;
+            best_delay = delay;
+            best_error = error;
         }
     }
-    
-    return false;
+    if (best < 0) return false;
+
+    // Read the winner again, this time into the bit array
+    uint32_t code;
+    bool any_one;
+    uint32_t error;
+    uint32_t* bits = receiver->decode_bits;
+    uint16_t bit_count = match_bits(receiver, &protocols[best], best_delay, bits, &code, &any_one, &error);
+
+    uint8_t value_bits = bit_count < RC_SWITCH_MAX_BITS ? bit_count : RC_SWITCH_MAX_BITS;
+    // Keep the timings that made up this frame for post-decode stages
+    uint8_t count = 1 + 2 * value_bits;
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t d = edge_at(receiver, i);
+        receiver->received_timings[i] = d > UINT16_MAX ? UINT16_MAX : d;
+    }
+    receiver->received_timing_count = count;
+    memcpy(receiver->received_bits, bits, ((bit_count + 31) / 32) * sizeof(uint32_t));
+    receiver->received_bit_count = bit_count;
+    receiver->received_value = code;
+    receiver->received_bitlength = value_bits;
+    receiver->received_protocol = best + 1;  // 1-indexed
+    receiver->received_delay = best_delay;
+    return true;
+}
+
+// Closes the edge rate window once it is long enough
+static inline void squelch_window(rc_squelch_t* sq, int64_t time) {
+    sq->window_edges++;
+
+    int64_t elapsed = time - sq->window_start;
+    if (elapsed < SQUELCH_WINDOW_US) return;
+
+    uint32_t elapsed_ms = (uint32_t)(elapsed / 1000);
+    sq->edge_rate = sq->window_edges * 1000 / elapsed_ms;
+    sq->noise = sq->window_decodes == 0 && sq->window_aborts > 0;
+    if (sq->window_decodes == 0) {
+        sq->noise_rate = (sq->noise_rate * 7 + sq->edge_rate) / 8;
+    }
+    if (sq->noise) {
+        sq->noise_ms += elapsed_ms;
+    }
+
+    sq->window_start = time;
+    sq->window_edges = 0;
+    sq->window_decodes = 0;
+    sq->window_aborts = 0;
+}
+
+// Moves the thresholds towards what real frames on this receiver look like:
+// glitches are well under a third of the pulse length, and the glitch budget
+// leaves headroom above what good frames usually carry.
+static inline void squelch_adapt(rc_squelch_t* sq, uint16_t pulse) {
+    sq->window_decodes++;
+
+    sq->pulse_avg = sq->pulse_avg ? (sq->pulse_avg * 7 + pulse) / 8 : pulse;
+    uint16_t glitch_us = sq->pulse_avg / 3;
+    if (glitch_us < SQUELCH_GLITCH_US_MIN) glitch_us = SQUELCH_GLITCH_US_MIN;
+    if (glitch_us > SQUELCH_GLITCH_US_MAX) glitch_us = SQUELCH_GLITCH_US_MAX;
+    sq->glitch_us = glitch_us;
+
+    sq->frame_glitches_x16 = (sq->frame_glitches_x16 * 7 + sq->glitches * 16) / 8;
+    uint8_t limit = sq->frame_glitches_x16 / 16 + SQUELCH_GLITCH_LIMIT_MIN;
+    if (limit > SQUELCH_GLITCH_LIMIT_MAX) limit = SQUELCH_GLITCH_LIMIT_MAX;
+    sq->glitch_limit = limit;
 }
 
 // ISR handler
 static void IRAM_ATTR rc_receiver_isr_handler(void* arg) {
     rc_receiver_t* receiver = (rc_receiver_t*)arg;
+    rc_squelch_t* sq = &receiver->squelch;
+    rc_decoder_config_t config_copy;
+    decoder_config_read(&config_copy);
+    const rc_decoder_config_t* config = &config_copy;
     int64_t time = esp_timer_get_time();
     int64_t duration = time - receiver->last_time;
     
-    isr_trigger_count++; // Track ISR triggers for debugging
+    receiver->isr_count++; // Track ISR triggers for debugging
+    squelch_window(sq, time);
 
-    if (duration > 5000) {  // Sync period detected (>5ms gap)
+    if (duration > config->sync_gap_us) {  // Sync period detected (>5ms gap by default)
+        // Only edges that close a frame are traced, noise would flush the ring in milliseconds
+        TRACE_BEGIN(TRACE_RX_ISR, receiver->pin);
         if (receiver->buffer_pos > 7) {  // Minimum valid signal length
-            // Try to decode the signal
-            if (decode_signal(receiver)) {
-                receiver->available = true;
+            if (sq->capturing) {
+                // Try to decode the signal
+                sq->decode_attempts++;
+                TRACE_BEGIN(TRACE_DECODE, receiver->buffer_pos);
+                bool decoded = decode_signal(receiver, config);
+                TRACE_END(TRACE_DECODE, decoded);
+                if (decoded) {
+                    receiver->received_time = time;
+                    receiver->decoded_count++;
+                    receiver->available = true;
+                    if (sq->enabled) squelch_adapt(sq, receiver->received_delay);
+                }
+            } else {
+                sq->skipped_decodes++;
             }
         }
         receiver->buffer_pos = 0;
+        receiver->capture_overflow = false;
+        sq->capturing = true;
+        sq->glitches = 0;
+        TRACE_END(TRACE_RX_ISR, receiver->pin);
+    } else if (sq->enabled) {
+        if (!sq->capturing) {
+            // Noise: nothing is buffered until the next sync gap
+            sq->skipped_edges++;
+            receiver->last_time = time;
+            return;
+        }
+        if (duration < sq->glitch_us && ++sq->glitches > sq->glitch_limit) {
+            sq->capturing = false;
+            sq->aborted_captures++;
+            sq->window_aborts++;
+            receiver->last_time = time;
+            return;
+        }
     }
 
-    if (receiver->buffer_pos < 256) {
-        receiver->duration_buffer[receiver->buffer_pos++] = duration;
+    // A capture longer than the buffer keeps its start, that is where the frame is decoded from
+    if (receiver->buffer_pos < receiver->edge_capacity) {
+        edge_store(receiver, receiver->buffer_pos++, duration);
+    } else if (!receiver->capture_overflow) {
+        receiver->capture_overflow = true;
+        receiver->overflow_count++;
     }
 
     receiver->last_time = time;
 }
 
 void rc_receiver_init(rc_receiver_t* receiver, gpio_num_t pin) {
+    const rc_receiver_buffer_config_t buffer = RC_RECEIVER_BUFFER_DEFAULT;
+    rc_receiver_init_ex(receiver, pin, &buffer);
+}
+
+esp_err_t rc_receiver_init_ex(rc_receiver_t* receiver, gpio_num_t pin, const rc_receiver_buffer_config_t* buffer) {
+    if (buffer->edges < 8 || (buffer->width != 2 && buffer->width != 4)) {
+        ESP_LOGE(TAG, "Invalid capture buffer for GPIO %d: %u edges of %u bytes", pin, buffer->edges, buffer->width);
+        return ESP_ERR_INVALID_ARG;
+    }
+
     memset(receiver, 0, sizeof(rc_receiver_t));
     receiver->pin = pin;
-    g_receiver = receiver;
+
+    // The ISR service is not installed IRAM-only, so the ISR never runs while the
+    // cache is off for a flash write and may use a buffer in PSRAM
+    if (buffer->psram) {
+        receiver->edge_buffer = heap_caps_calloc(buffer->edges, buffer->width, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        receiver->edge_buffer_psram = receiver->edge_buffer != NULL;
+    }
+    if (receiver->edge_buffer == NULL) {
+        receiver->edge_buffer = heap_caps_calloc(buffer->edges, buffer->width, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (receiver->edge_buffer == NULL) {
+        ESP_LOGE(TAG, "No memory for the capture buffer of GPIO %d", pin);
+        return ESP_ERR_NO_MEM;
+    }
+    // Two bit arrays, the decoder fills one while the other holds the last frame
+    receiver->bit_capacity = buffer->edges / 2;
+    uint16_t words = (receiver->bit_capacity + 31) / 32;
+    receiver->decode_bits = heap_caps_calloc(2 * words, sizeof(uint32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (receiver->decode_bits == NULL) {
+        ESP_LOGE(TAG, "No memory for the frame bits of GPIO %d", pin);
+        heap_caps_free(receiver->edge_buffer);
+        receiver->edge_buffer = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    receiver->received_bits = receiver->decode_bits + words;
+    receiver->edge_capacity = buffer->edges;
+    receiver->edge_width = buffer->width;
+    receiver->squelch.enabled = true;
+    receiver->squelch.capturing = true;
+    receiver->squelch.glitch_us = SQUELCH_GLITCH_US_DEFAULT;
+    receiver->squelch.glitch_limit = SQUELCH_GLITCH_LIMIT_MIN;
 
     // Configure GPIO
     gpio_config_t io_conf = {
@@ -134,12 +350,23 @@ void rc_receiver_init(rc_receiver_t* receiver, gpio_num_t pin) {
     };
     gpio_config(&io_conf);
 
-    // Install ISR service
-    gpio_install_isr_service(0);
+    // Install ISR service once, later receivers only add their pin handler
+    if (!isr_service_installed) {
+        esp_err_t err = gpio_install_isr_service(0);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(err));
+            return err;
+        }
+        isr_service_installed = true;
+    }
     gpio_isr_handler_add(pin, rc_receiver_isr_handler, (void*)receiver);
 
     receiver->last_time = esp_timer_get_time();
-    ESP_LOGI(TAG, "Receiver initialized on GPIO %d", pin);
+    receiver->squelch.window_start = receiver->last_time;
+    ESP_LOGI(TAG, "Receiver initialized on GPIO %d (%u-edge buffer, %u bytes in %s)", pin,
+             receiver->edge_capacity, receiver->edge_capacity * receiver->edge_width,
+             receiver->edge_buffer_psram ? "PSRAM" : "internal RAM");
+    return ESP_OK;
 }
 
 bool rc_receiver_available(rc_receiver_t* receiver) {
@@ -162,13 +389,49 @@ uint16_t rc_receiver_get_delay(rc_receiver_t* receiver) {
     return receiver->received_delay;
 }
 
+uint8_t rc_receiver_get_timings(rc_receiver_t* receiver, const uint16_t** timings) {
+    *timings = receiver->received_timings;
+    return receiver->received_timing_count;
+}
+
+uint16_t rc_receiver_get_bits(rc_receiver_t* receiver, const uint32_t** words) {
+    *words = receiver->received_bits;
+    return receiver->received_bit_count;
+}
+
 void rc_receiver_reset(rc_receiver_t* receiver) {
     receiver->available = false;
     receiver->buffer_pos = 0;
+    receiver->capture_overflow = false;
+}
+
+uint32_t rc_receiver_get_isr_count(rc_receiver_t* receiver) {
+    return receiver->isr_count;
+}
+
+void rc_receiver_set_squelch(rc_receiver_t* receiver, bool enabled) {
+    receiver->squelch.enabled = enabled;
+    if (!enabled) {
+        receiver->squelch.capturing = true;
+    }
+    ESP_LOGI(TAG, "Squelch %s on GPIO %d", enabled ? "enabled" : "disabled", receiver->pin);
 }
 
-uint32_t rc_receiver_get_isr_count(void) {
-    return isr_trigger_count;
+void rc_receiver_get_squelch(rc_receiver_t* receiver, rc_squelch_t* out) {
+    memcpy(out, &receiver->squelch, sizeof(*out));
+}
+
+void rc_receiver_set_decoder_config(const rc_decoder_config_t* config) {
+    portENTER_CRITICAL(&decoder_config_mux);
+    __atomic_store_n(&decoder_config_seq, decoder_config_seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    decoder_config = *config;
+    __atomic_store_n(&decoder_config_seq, decoder_config_seq + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&decoder_config_mux);
+}
+
+void rc_receiver_get_decoder_config(rc_decoder_config_t* out) {
+    decoder_config_read(out);
 }
 
 void rc_transmitter_init(rc_transmitter_t* transmitter, gpio_num_t pin) {
@@ -235,34 +498,67 @@ static void transmit_sync(rc_transmitter_t* transmitter) {
     ets_delay_us(transmitter->pulse_length * protocol->sync_factor.low);
 }
 
-void rc_transmitter_send(rc_transmitter_t* transmitter, uint32_t code, uint8_t length) {
+const rc_protocol_t* rc_get_protocol(uint8_t protocol) {
+    return protocol < NUM_PROTOCOLS ? &protocols[protocol] : NULL;
+}
+
+uint32_t rc_frame_airtime_us(uint8_t protocol, uint16_t pulse_length, uint32_t code, uint8_t length) {
+    if (protocol >= NUM_PROTOCOLS) return 0;
     if (length > 32) length = 32;
 
-    // Transmit each repeat separately to avoid watchdog timeout
-    for (uint8_t repeat = 0; repeat < transmitter->repeat_transmit; repeat++) {
-        // Disable interrupts only for single transmission
-        portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
-        portENTER_CRITICAL(&mux);
+    const rc_protocol_t* p = &protocols[protocol];
+    uint8_t ones = __builtin_popcount(length < 32 ? code & ((1UL << length) - 1) : code);
+    uint32_t cycles = p->sync_factor.high + p->sync_factor.low +
+                      ones * (p->one.high + p->one.low) +
+                      (length - ones) * (p->zero.high + p->zero.low);
+    return cycles * pulse_length;
+}
 
-        // Send sync
-        transmit_sync(transmitter);
+void rc_transmitter_send_frame(rc_transmitter_t* transmitter, uint32_t code, uint8_t length) {
+    if (length > 32) length = 32;
 
-        // Send bits (MSB first)
-        for (int8_t i = length - 1; i >= 0; i--) {
-            bool bit = (code >> i) & 1;
-            transmit_bit(transmitter, bit);
-        }
+    // Disable interrupts only for single transmission
+    TRACE_BEGIN(TRACE_TX_FRAME, code);
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    portENTER_CRITICAL(&mux);
+
+    // Send bits (MSB first)
+    for (int8_t i = length - 1; i >= 0; i--) {
+        bool bit = (code >> i) & 1;
+        transmit_bit(transmitter, bit);
+    }
+
+    // Sync last, as rc-switch does: the pause between repeats then only lengthens the
+    // sync low, which the receiver treats as a gap anyway. Sent first, the pause would
+    // stretch the low of the last bit into a gap and the receiver would lose that bit.
+    transmit_sync(transmitter);
+
+    // Ensure pin is low
+    gpio_set_level(transmitter->pin, 0);
+
+    portEXIT_CRITICAL(&mux);
+    TRACE_END(TRACE_TX_FRAME, code);
+    transmitter->frame_count++;
+    transmitter->airtime_us += rc_frame_airtime_us(transmitter->protocol, transmitter->pulse_length, code, length);
+}
 
-        // Ensure pin is low
-        gpio_set_level(transmitter->pin, 0);
+void rc_transmitter_send(rc_transmitter_t* transmitter, uint32_t code, uint8_t length) {
+    if (length > 32) length = 32;
+
+    transmitter->send_count++;
+    TRACE_BEGIN(TRACE_TX_SEND, code);
 
-        portEXIT_CRITICAL(&mux);
+    // Transmit each repeat separately to avoid watchdog timeout
+    for (uint8_t repeat = 0; repeat < transmitter->repeat_transmit; repeat++) {
+        rc_transmitter_send_frame(transmitter, code, length);
 
         // Small delay between repeats to let watchdog breathe
         if (repeat < transmitter->repeat_transmit - 1) {
             vTaskDelay(1);
         }
     }
+    TRACE_END(TRACE_TX_SEND, code);
 
-    ESP_LOGI(TAG, "Transmitted: code=%lu, bits=%d, protocol=%d", code, length, transmitter->protocol + 1);
+    ESP_LOGI(TAG, "Transmitted on GPIO %d: code=%lu, bits=%d, protocol=%d",
+             transmitter->pin, code, length, transmitter->protocol + 1);
 }
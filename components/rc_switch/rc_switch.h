@@ -3,12 +3,19 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "esp_err.h"
 #include "driver/gpio.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define RC_SWITCH_NUM_PROTOCOLS 7
+#define RC_SWITCH_MAX_BITS      32      // Bits in received_value and in a transmitted code
+
+// Timings kept per decoded frame: the sync gap plus high/low pairs for the first 32 bits
+#define RC_FRAME_TIMINGS (2 + 2 * RC_SWITCH_MAX_BITS)
+
 typedef struct {
     uint16_t pulse_length;
     struct {
@@ -26,16 +33,80 @@ typedef struct {
     bool invert_signal;
 } rc_protocol_t;
 
+// Squelch for superregenerative receivers, whose AGC makes the data pin toggle
+// constantly when the air is idle. A capture (the edges after a sync gap) that
+// collects more than glitch_limit pulses shorter than glitch_us is treated as
+// noise: the ISR stops buffering edges and skips decoding until the next sync gap.
+// Both thresholds follow the frames that do decode.
+typedef struct {
+    bool enabled;
+    bool capturing;             // false while the current capture is judged noise
+    uint8_t glitches;           // Short pulses in the current capture
+    uint8_t glitch_limit;       // Adaptive: glitches tolerated per capture
+    uint16_t glitch_us;         // Adaptive: pulses below this are glitches
+    uint16_t pulse_avg;         // Average pulse length of decoded frames
+    uint16_t frame_glitches_x16; // Average glitches in decoded frames, x16 fixed point
+    int64_t window_start;
+    uint32_t window_edges;
+    uint32_t window_decodes;
+    uint32_t window_aborts;
+    bool noise;                 // Last window only produced noise
+    uint32_t edge_rate;         // Edges/s over the last window
+    uint32_t noise_rate;        // Smoothed edges/s over windows without a frame
+    uint32_t noise_ms;          // Time spent in noise-only windows
+    uint32_t aborted_captures;
+    uint32_t skipped_edges;     // Edges not buffered because the capture was noise
+    uint32_t skipped_decodes;   // Sync gaps where decoding was skipped
+    uint32_t decode_attempts;
+} rc_squelch_t;
+
+// Decoder tuning shared by every receiver
+typedef struct {
+    uint16_t sync_gap_us;       // Gap that ends one capture and starts the next
+    uint16_t short_pulse_us;    // Durations below this feed the pulse length estimate
+    uint8_t min_bits;           // Shortest frame the decoder accepts
+} rc_decoder_config_t;
+
+#define RC_DECODER_CONFIG_DEFAULT { .sync_gap_us = 5000, .short_pulse_us = 2000, .min_bits = 8 }
+
+// Capture buffer of a receiver, the durations between the edges after a sync gap.
+// 2-byte entries hold up to 65535 us, longer durations are clamped; only the sync gap
+// in front of a frame is ever that long. A capture longer than the buffer keeps its
+// start, the edges past the end are dropped and counted in overflow_count.
+// A frame can have up to edges / 2 bits, see rc_receiver_get_bits.
+typedef struct {
+    uint16_t edges;             // Durations one capture can hold, at least 8
+    uint8_t width;              // Bytes per duration, 2 or 4
+    bool psram;                 // Prefer external RAM, internal RAM when there is none
+} rc_receiver_buffer_config_t;
+
+#define RC_RECEIVER_BUFFER_DEFAULT { .edges = 256, .width = 2, .psram = false }
+
 typedef struct {
     gpio_num_t pin;
     bool available;
-    uint32_t received_value;
-    uint8_t received_bitlength;
+    uint32_t received_value;        // The first 32 bits of the frame
+    uint8_t received_bitlength;     // Bits in received_value, at most 32
     uint8_t received_protocol;
     uint16_t received_delay;
+    int64_t received_time;          // esp_timer time the current frame was decoded at
+    uint16_t received_timings[RC_FRAME_TIMINGS]; // Raw durations (us) of the decoded frame, [0] is the sync gap
+    uint8_t received_timing_count;
+    uint32_t* received_bits;        // Every bit of the frame, MSB first from received_bits[0]
+    uint16_t received_bit_count;    // Bits in the frame, can be more than 32
+    uint32_t* decode_bits;          // Bits of the frame being decoded, copied to received_bits once it decodes
+    uint16_t bit_capacity;          // Bits received_bits holds, edge_capacity / 2
     volatile int64_t last_time;
-    volatile uint32_t duration_buffer[256];
-    volatile uint8_t buffer_pos;
+    void* edge_buffer;              // Capture durations, edge_width bytes each
+    uint16_t edge_capacity;
+    uint8_t edge_width;
+    bool edge_buffer_psram;         // The buffer ended up in external RAM
+    volatile uint16_t buffer_pos;
+    bool capture_overflow;          // The current capture ran past the buffer
+    volatile uint32_t overflow_count; // Captures that ran past the buffer
+    volatile uint32_t isr_count;    // Edges seen on this receiver's pin
+    volatile uint32_t decoded_count; // Frames decoded on this receiver
+    rc_squelch_t squelch;
 } rc_receiver_t;
 
 typedef struct {
@@ -43,17 +114,36 @@ typedef struct {
     uint8_t protocol;
     uint16_t pulse_length;
     uint8_t repeat_transmit;
+    uint32_t send_count;            // Calls to rc_transmitter_send
+    uint32_t frame_count;           // Frames put on air, repeats included
+    uint64_t airtime_us;            // Time spent transmitting frames
 } rc_transmitter_t;
 
 // Receiver API: for signal reception and decoding from an RF receiver module.
+// Any number of receivers can run at once, each on its own pin, sharing the GPIO ISR service.
+// rc_receiver_init uses RC_RECEIVER_BUFFER_DEFAULT.
 void rc_receiver_init(rc_receiver_t* receiver, gpio_num_t pin);
+esp_err_t rc_receiver_init_ex(rc_receiver_t* receiver, gpio_num_t pin, const rc_receiver_buffer_config_t* buffer);
 bool rc_receiver_available(rc_receiver_t* receiver);
 uint32_t rc_receiver_get_value(rc_receiver_t* receiver);
 uint8_t rc_receiver_get_bitlength(rc_receiver_t* receiver);
 uint8_t rc_receiver_get_protocol(rc_receiver_t* receiver);
 uint16_t rc_receiver_get_delay(rc_receiver_t* receiver);
+// Raw durations of the current frame, returns how many there are
+uint8_t rc_receiver_get_timings(rc_receiver_t* receiver, const uint16_t** timings);
+// Every bit of the current frame, for frames longer than received_value holds. Bit i
+// is (words[i / 32] >> (31 - i % 32)) & 1. Returns the bit count.
+uint16_t rc_receiver_get_bits(rc_receiver_t* receiver, const uint32_t** words);
 void rc_receiver_reset(rc_receiver_t* receiver);
-uint32_t rc_receiver_get_isr_count(void);
+uint32_t rc_receiver_get_isr_count(rc_receiver_t* receiver);
+void rc_receiver_set_squelch(rc_receiver_t* receiver, bool enabled);
+// Copies the squelch state and counters (read while the ISR keeps running)
+void rc_receiver_get_squelch(rc_receiver_t* receiver, rc_squelch_t* out);
+// Replaces the decoder tuning of all receivers. Every ISR run copies the tuning out
+// under a sequence count and copies again when a write overlapped, so it decodes with
+// either the old or the new settings, never a mix. Safe from several tasks.
+void rc_receiver_set_decoder_config(const rc_decoder_config_t* config);
+void rc_receiver_get_decoder_config(rc_decoder_config_t* out);
 
 // Transmitter API: for configuring and sending RF codes via a transmitter module.
 void rc_transmitter_init(rc_transmitter_t* transmitter, gpio_num_t pin);
@@ -61,6 +151,16 @@ void rc_transmitter_set_protocol(rc_transmitter_t* transmitter, uint8_t protocol
 void rc_transmitter_set_pulse_length(rc_transmitter_t* transmitter, uint16_t pulse_length);
 void rc_transmitter_set_repeat(rc_transmitter_t* transmitter, uint8_t repeat);
 void rc_transmitter_send(rc_transmitter_t* transmitter, uint32_t code, uint8_t length);
+// Sends a single frame, no repeats. For callers that pace repeats themselves.
+// Interrupts on the calling core are masked for the length of the frame.
+void rc_transmitter_send_frame(rc_transmitter_t* transmitter, uint32_t code, uint8_t length);
+
+// Exact on-air time of one frame (sync plus every bit of code) in us.
+// protocol is 0-based like rc_transmitter_set_protocol, returns 0 for an unknown protocol.
+uint32_t rc_frame_airtime_us(uint8_t protocol, uint16_t pulse_length, uint32_t code, uint8_t length);
+
+// Timing definition of a protocol, 0-based like rc_transmitter_set_protocol. NULL if unknown.
+const rc_protocol_t* rc_get_protocol(uint8_t protocol);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,318 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_ipc.h"
+#include "esp_freertos_hooks.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+
+_Static_assert(sizeof(trace_event_t) == 12, "trace_event_t must stay 12 bytes");
+_Static_assert(portNUM_PROCESSORS <= TRACE_MAX_CORES, "more cores than TRACE_MAX_CORES");
+
+#define EXPORT_BUFFER 1024  // Converted JSON is handed to the writer in pieces this size
+
+static const char *const point_names[TRACE_POINT_COUNT] = {
+    [TRACE_RX_ISR]      = "rx_isr",
+    [TRACE_DECODE]      = "decode_signal",
+    [TRACE_RF_FRAME]    = "rf_frame",
+    [TRACE_TRACK]       = "track_signal",
+    [TRACE_HTTP]        = "http",
+    [TRACE_HTTP_WORKER] = "http_worker",
+    [TRACE_TX_SEND]     = "rc_transmitter_send",
+    [TRACE_TX_FRAME]    = "tx_frame",
+};
+
+const char *trace_point_to_string(trace_point_t point)
+{
+    return point < TRACE_POINT_COUNT ? point_names[point] : "unknown";
+}
+
+#if CONFIG_RF_TRACE
+
+static const char *TAG = "TRACE";
+
+#define RING_EVENTS CONFIG_RF_TRACE_EVENTS
+
+typedef struct {
+    trace_event_t events[RING_EVENTS];
+    volatile uint32_t head;     // Events written since boot, the next goes to head % RING_EVENTS
+    uint32_t cleared;           // head at the last trace_clear, older events are not exported
+    uint32_t last_cycles;
+    uint16_t cycles_hi;
+    // Cycle count and esp_timer time taken together on this core by trace_init
+    uint64_t base_cycles;
+    int64_t base_us;
+} trace_ring_t;
+
+static trace_ring_t rings[portNUM_PROCESSORS];
+static uint32_t cycles_per_us = 1;
+
+// Called with interrupts masked on the ring's own core
+static inline void IRAM_ATTR ring_now(trace_ring_t *ring, uint32_t *cycles)
+{
+    uint32_t now = esp_cpu_get_cycle_count();
+    if (now < ring->last_cycles) ring->cycles_hi++;
+    ring->last_cycles = now;
+    *cycles = now;
+}
+
+void IRAM_ATTR trace_record(trace_point_t point, trace_phase_t phase, uint32_t arg)
+{
+    UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    trace_ring_t *ring = &rings[esp_cpu_get_core_id()];
+
+    uint32_t head = ring->head;
+    trace_event_t *ev = &ring->events[head % RING_EVENTS];
+    ring_now(ring, &ev->cycles);
+    ev->arg = arg;
+    ev->cycles_hi = ring->cycles_hi;
+    ev->point = point;
+    ev->phase = phase;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+}
+
+// Runs every tick on each core, so a wrap is counted even when no probe fires for a while
+static void IRAM_ATTR tick_hook(void)
+{
+    UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    uint32_t cycles;
+    ring_now(&rings[esp_cpu_get_core_id()], &cycles);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+}
+
+static void calibrate(void *arg)
+{
+    UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    trace_ring_t *ring = &rings[esp_cpu_get_core_id()];
+    uint32_t cycles;
+    ring_now(ring, &cycles);
+    ring->base_cycles = ((uint64_t)ring->cycles_hi << 32) | cycles;
+    ring->base_us = esp_timer_get_time();
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+}
+
+esp_err_t trace_init(void)
+{
+    cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        esp_err_t err = esp_ipc_call_blocking(core, calibrate, NULL);
+        if (err == ESP_OK) {
+            err = esp_register_freertos_tick_hook_for_cpu(tick_hook, core);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Core %d setup failed: %s", core, esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    ESP_LOGI(TAG, "Trace recorder ready: %d events per core, %lu cycles/us",
+             RING_EVENTS, cycles_per_us);
+    return ESP_OK;
+}
+
+bool trace_enabled(void)
+{
+    return true;
+}
+
+void trace_get_stats(trace_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->capacity = RING_EVENTS;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        stats->recorded[core] = rings[core].head;
+    }
+}
+
+void trace_clear(void)
+{
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        rings[core].cleared = __atomic_load_n(&rings[core].head, __ATOMIC_ACQUIRE);
+    }
+}
+
+// Copies a ring out while its core keeps writing. Returns the number of events in
+// out, oldest first; events overwritten during the copy are dropped.
+static size_t ring_snapshot(const trace_ring_t *ring, trace_event_t *out)
+{
+    uint32_t end = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t start = end > RING_EVENTS ? end - RING_EVENTS : 0;
+    if (start < ring->cleared) start = ring->cleared;
+
+    for (uint32_t i = start; i < end; i++) {
+        out[i - start] = ring->events[i % RING_EVENTS];
+    }
+
+    // Slot i is reused by event i + RING_EVENTS, which may be half written while
+    // head still reads i + RING_EVENTS
+    uint32_t now = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t first_valid = now >= RING_EVENTS ? now - RING_EVENTS + 1 : 0;
+    if (first_valid <= start) return end - start;
+    if (first_valid >= end) return 0;
+    memmove(out, out + (first_valid - start), (end - first_valid) * sizeof(*out));
+    return end - first_valid;
+}
+
+static double event_time_us(const trace_ring_t *ring, const trace_event_t *ev)
+{
+    uint64_t cycles = ((uint64_t)ev->cycles_hi << 32) | ev->cycles;
+    return ring->base_us + (double)(int64_t)(cycles - ring->base_cycles) / cycles_per_us;
+}
+
+// Probe families each get their own thread in the viewer, their begin/end pairs
+// nest within a family. Workers of different HTTP classes get one thread each.
+#define LANE_ISR        1
+#define LANE_RF         2
+#define LANE_HTTPD      3
+#define LANE_TX         4
+#define LANE_WORKER     10
+
+static int point_lane(const trace_event_t *ev)
+{
+    switch (ev->point) {
+        case TRACE_RX_ISR:
+        case TRACE_DECODE:      return LANE_ISR;
+        case TRACE_RF_FRAME:
+        case TRACE_TRACK:       return LANE_RF;
+        case TRACE_HTTP:        return LANE_HTTPD;
+        case TRACE_HTTP_WORKER: return LANE_WORKER + ev->arg;
+        default:                return LANE_TX;
+    }
+}
+
+typedef struct {
+    trace_write_fn write;
+    void *ctx;
+    char buf[EXPORT_BUFFER];
+    size_t len;
+    bool first;
+    esp_err_t err;
+} export_t;
+
+static void export_flush(export_t *ex)
+{
+    if (ex->len > 0 && ex->err == ESP_OK) {
+        ex->err = ex->write(ex->ctx, ex->buf, ex->len);
+    }
+    ex->len = 0;
+}
+
+// Appends one trace event object, the separator is added as needed
+static void export_event(export_t *ex, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void export_event(export_t *ex, const char *fmt, ...)
+{
+    char line[192];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n >= sizeof(line)) n = sizeof(line) - 1;
+
+    if (ex->len + n + 2 > sizeof(ex->buf)) {
+        export_flush(ex);
+    }
+    if (!ex->first) ex->buf[ex->len++] = ',';
+    ex->buf[ex->len++] = '\n';
+    memcpy(ex->buf + ex->len, line, n);
+    ex->len += n;
+    ex->first = false;
+}
+
+static void export_thread_name(export_t *ex, int core, int lane, const char *name)
+{
+    export_event(ex, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                 core, lane, name);
+}
+
+esp_err_t trace_export_chrome(trace_write_fn write, void *ctx)
+{
+    export_t *ex = malloc(sizeof(export_t));
+    if (ex == NULL) return ESP_ERR_NO_MEM;
+    ex->write = write;
+    ex->ctx = ctx;
+    ex->len = 0;
+    ex->first = true;
+    ex->err = ESP_OK;
+
+    const char *header = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    ex->len = strlen(header);
+    memcpy(ex->buf, header, ex->len);
+
+    trace_event_t *events = malloc(RING_EVENTS * sizeof(trace_event_t));
+    if (events == NULL) {
+        free(ex);
+        return ESP_ERR_NO_MEM;
+    }
+
+    static const char phase_codes[] = { 'B', 'E', 'i' };
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        export_event(ex, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"core %d\"}}",
+                     core, core);
+        export_thread_name(ex, core, LANE_ISR, "rx isr");
+        export_thread_name(ex, core, LANE_RF, "rf_monitor");
+        export_thread_name(ex, core, LANE_HTTPD, "httpd");
+        export_thread_name(ex, core, LANE_TX, "transmit");
+
+        const trace_ring_t *ring = &rings[core];
+        size_t count = ring_snapshot(ring, events);
+        for (size_t i = 0; i < count && ex->err == ESP_OK; i++) {
+            const trace_event_t *ev = &events[i];
+            if (ev->point >= TRACE_POINT_COUNT || ev->phase > TRACE_PHASE_INSTANT) continue;
+
+            export_event(ex, "{\"name\":\"%s\",\"cat\":\"rf\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d%s,\"args\":{\"arg\":%lu}}",
+                         point_names[ev->point], phase_codes[ev->phase], event_time_us(ring, ev),
+                         core, point_lane(ev), ev->phase == TRACE_PHASE_INSTANT ? ",\"s\":\"t\"" : "",
+                         (unsigned long)ev->arg);
+        }
+    }
+    free(events);
+
+    if (ex->len + 2 > sizeof(ex->buf)) export_flush(ex);
+    memcpy(ex->buf + ex->len, "]}", 2);
+    ex->len += 2;
+    export_flush(ex);
+
+    esp_err_t err = ex->err;
+    free(ex);
+    return err;
+}
+
+#else // !CONFIG_RF_TRACE
+
+esp_err_t trace_init(void)
+{
+    return ESP_OK;
+}
+
+bool trace_enabled(void)
+{
+    return false;
+}
+
+void trace_get_stats(trace_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void trace_clear(void)
+{
+}
+
+esp_err_t trace_export_chrome(trace_write_fn write, void *ctx)
+{
+    const char *empty = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[]}";
+    return write(ctx, empty, strlen(empty));
+}
+
+#endif // CONFIG_RF_TRACE
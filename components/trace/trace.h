@@ -0,0 +1,90 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hot-path trace recorder. Probes write begin/end events stamped with the CPU
+// cycle counter into a ring per core. A writer only ever touches the ring of the
+// core it runs on and masks interrupts for the dozen instructions of the write,
+// so there is no lock and an ISR can never tear a task's event. Readers copy a
+// ring and drop whatever was overwritten while they copied.
+//
+// Probes compile to nothing without CONFIG_RF_TRACE (menuconfig, "RF trace recorder").
+
+typedef enum {
+    TRACE_RX_ISR = 0,       // Receiver edge interrupt, arg: GPIO
+    TRACE_DECODE,           // decode_signal in the ISR, begin arg: edges buffered, end arg: 1 when decoded
+    TRACE_RF_FRAME,         // rf_monitor_task handling one frame, arg: code
+    TRACE_TRACK,            // track_signal, arg: code
+    TRACE_HTTP,             // An HTTP handler on the server task, arg: handler specific
+    TRACE_HTTP_WORKER,      // A deferred handler on an async worker, arg: worker class
+    TRACE_TX_SEND,          // rc_transmitter_send, arg: code
+    TRACE_TX_FRAME,         // One frame on air, interrupts masked, arg: code
+    TRACE_POINT_COUNT
+} trace_point_t;
+
+#define TRACE_MAX_CORES 2
+
+typedef enum {
+    TRACE_PHASE_BEGIN = 0,
+    TRACE_PHASE_END,
+    TRACE_PHASE_INSTANT,
+} trace_phase_t;
+
+typedef struct {
+    uint32_t cycles;        // Low word of the core's cycle counter
+    uint32_t arg;
+    uint16_t cycles_hi;     // Counter wraps seen on this core (every ~18 s at 240 MHz)
+    uint8_t point;          // trace_point_t
+    uint8_t phase;          // trace_phase_t
+} trace_event_t;
+
+#if CONFIG_RF_TRACE
+
+#define TRACE_BEGIN(point, arg)   trace_record((point), TRACE_PHASE_BEGIN, (uint32_t)(arg))
+#define TRACE_END(point, arg)     trace_record((point), TRACE_PHASE_END, (uint32_t)(arg))
+#define TRACE_INSTANT(point, arg) trace_record((point), TRACE_PHASE_INSTANT, (uint32_t)(arg))
+
+void trace_record(trace_point_t point, trace_phase_t phase, uint32_t arg);
+
+#else
+
+#define TRACE_BEGIN(point, arg)   ((void)0)
+#define TRACE_END(point, arg)     ((void)0)
+#define TRACE_INSTANT(point, arg) ((void)0)
+
+#endif
+
+typedef struct {
+    uint32_t capacity;      // Events per core
+    uint32_t recorded[TRACE_MAX_CORES];  // Events written since boot, per core
+} trace_stats_t;
+
+// Lines the cycle counter of every core up with esp_timer and hooks the tick
+// interrupt that keeps counting wraps during idle stretches. Call once at boot;
+// events recorded before this are kept but their timestamps may be off.
+esp_err_t trace_init(void);
+
+bool trace_enabled(void);
+void trace_get_stats(trace_stats_t *stats);
+void trace_clear(void);
+const char *trace_point_to_string(trace_point_t point);
+
+// Writes the rings as Chrome trace event JSON (chrome://tracing, ui.perfetto.dev),
+// converting one event at a time. Each core is a process, each probe family a thread.
+typedef esp_err_t (*trace_write_fn)(void *ctx, const char *data, size_t len);
+esp_err_t trace_export_chrome(trace_write_fn write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,670 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <getopt.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "host.h"
+#include "esp_http_server.h"
+#include "routes_trie.h"
+
+// Boots the firmware in this process, fills the signal library (and optionally the
+// tracked signal list through the loopback radio), then drives each endpoint from
+// several keep-alive clients. Reports throughput, latency percentiles and heap
+// allocations per request. --save and --compare turn it into a regression gate.
+// --routes instead times the route lookup alone, without the server.
+
+#define MAX_ENDPOINTS   32
+#define MAX_CLIENTS     16
+#define REQUEST_SIZE    2048
+#define READ_BUF_SIZE   16384
+
+typedef struct {
+    char name[256];             // "METHOD /path", the key in saved results
+    char request[REQUEST_SIZE]; // Complete request, sent as is
+    size_t request_len;
+} endpoint_t;
+
+typedef struct {
+    double req_per_s;
+    double p50_us;
+    double p99_us;
+    double allocs_per_req;
+    double bytes_per_req;
+    uint32_t errors;
+} result_t;
+
+typedef struct {
+    int fd;
+    char buf[READ_BUF_SIZE];
+    size_t len;
+    size_t pos;
+} conn_t;
+
+typedef struct {
+    const endpoint_t *endpoint;
+    conn_t conn;
+    uint32_t count;
+    uint32_t *latency_us;       // count entries, preallocated
+    uint32_t errors;
+} client_t;
+
+static uint16_t port = 18080;
+static pthread_barrier_t start_barrier;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//
+// Minimal keep-alive HTTP/1.1 client. No allocations, so the counters only see the server.
+//
+
+static bool conn_open(conn_t *conn)
+{
+    conn->len = conn->pos = 0;
+    conn->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (conn->fd < 0) return false;
+    int one = 1;
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval timeout = { .tv_sec = 10 };
+    setsockopt(conn->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    if (connect(conn->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(conn->fd);
+        conn->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+static void conn_close(conn_t *conn)
+{
+    if (conn->fd >= 0) close(conn->fd);
+    conn->fd = -1;
+}
+
+static bool conn_fill(conn_t *conn)
+{
+    if (conn->pos == conn->len) conn->pos = conn->len = 0;
+    if (conn->len == sizeof(conn->buf)) {
+        memmove(conn->buf, conn->buf + conn->pos, conn->len - conn->pos);
+        conn->len -= conn->pos;
+        conn->pos = 0;
+    }
+    ssize_t n = recv(conn->fd, conn->buf + conn->len, sizeof(conn->buf) - conn->len, 0);
+    if (n <= 0) return false;
+    conn->len += n;
+    return true;
+}
+
+// Reads one CRLF terminated line into out (without the CRLF)
+static bool conn_read_line(conn_t *conn, char *out, size_t size)
+{
+    while (1) {
+        char *start = conn->buf + conn->pos;
+        char *end = memchr(start, '\n', conn->len - conn->pos);
+        if (end != NULL) {
+            size_t len = end - start;
+            if (len > 0 && start[len - 1] == '\r') len--;
+            if (len >= size) len = size - 1;
+            memcpy(out, start, len);
+            out[len] = '\0';
+            conn->pos = end + 1 - conn->buf;
+            return true;
+        }
+        if (!conn_fill(conn)) return false;
+    }
+}
+
+static bool conn_skip(conn_t *conn, size_t count)
+{
+    while (count > 0) {
+        if (conn->pos == conn->len && !conn_fill(conn)) return false;
+        size_t n = conn->len - conn->pos;
+        if (n > count) n = count;
+        conn->pos += n;
+        count -= n;
+    }
+    return true;
+}
+
+// Reads a whole response, body included. Returns the status code, 0 on connection errors.
+static int conn_read_response(conn_t *conn, size_t *body_len)
+{
+    char line[512];
+    if (!conn_read_line(conn, line, sizeof(line))) return 0;
+    int status = 0;
+    if (sscanf(line, "HTTP/1.%*d %d", &status) != 1) return 0;
+
+    long content_length = -1;
+    bool chunked = false;
+    bool close_after = false;
+    while (1) {
+        if (!conn_read_line(conn, line, sizeof(line))) return 0;
+        if (line[0] == '\0') break;
+        if (strncasecmp(line, "Content-Length:", 15) == 0) content_length = strtol(line + 15, NULL, 10);
+        if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line, "chunked") != NULL) chunked = true;
+        if (strncasecmp(line, "Connection:", 11) == 0 && strstr(line, "close") != NULL) close_after = true;
+    }
+
+    *body_len = 0;
+    if (chunked) {
+        while (1) {
+            if (!conn_read_line(conn, line, sizeof(line))) return 0;
+            size_t size = strtoul(line, NULL, 16);
+            if (!conn_skip(conn, size + 2)) return 0;
+            *body_len += size;
+            if (size == 0) break;
+        }
+    } else if (content_length >= 0) {
+        if (!conn_skip(conn, content_length)) return 0;
+        *body_len = content_length;
+    }
+    if (close_after) conn_close(conn);
+    return status;
+}
+
+// Sends a request and reads its response, reconnecting once if the server dropped the socket
+static int conn_request(conn_t *conn, const char *request, size_t len, size_t *body_len)
+{
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (conn->fd < 0 && !conn_open(conn)) return 0;
+        if (send(conn->fd, request, len, MSG_NOSIGNAL) == (ssize_t)len) {
+            int status = conn_read_response(conn, body_len);
+            if (status != 0) return status;
+        }
+        conn_close(conn);
+    }
+    return 0;
+}
+
+//
+// Endpoints
+//
+
+static bool endpoint_init(endpoint_t *ep, const char *method, const char *path, const char *body,
+                          const char *extra_headers)
+{
+    snprintf(ep->name, sizeof(ep->name), "%s %s%s", method, path,
+             extra_headers != NULL && strstr(extra_headers, "cbor") ? " (cbor)" : "");
+    int len;
+    if (body != NULL) {
+        len = snprintf(ep->request, sizeof(ep->request),
+                       "%s %s HTTP/1.1\r\nHost: localhost\r\n%sContent-Type: application/json\r\n"
+                       "Content-Length: %zu\r\n\r\n%s",
+                       method, path, extra_headers ? extra_headers : "", strlen(body), body);
+    } else {
+        len = snprintf(ep->request, sizeof(ep->request), "%s %s HTTP/1.1\r\nHost: localhost\r\n%s\r\n",
+                       method, path, extra_headers ? extra_headers : "");
+    }
+    if (len < 0 || (size_t)len >= sizeof(ep->request)) return false;
+    ep->request_len = len;
+    return true;
+}
+
+// "METHOD /path [body]"
+static bool endpoint_parse(endpoint_t *ep, const char *spec)
+{
+    char method[16];
+    char path[512];
+    int consumed = 0;
+    if (sscanf(spec, "%15s %511s %n", method, path, &consumed) < 2) return false;
+    const char *body = spec[consumed] != '\0' ? spec + consumed : NULL;
+    return endpoint_init(ep, method, path, body, NULL);
+}
+
+static int default_endpoints(endpoint_t *eps)
+{
+    int n = 0;
+    endpoint_init(&eps[n++], "GET", "/api/ping", NULL, NULL);
+    endpoint_init(&eps[n++], "GET", "/api/info", NULL, NULL);
+    endpoint_init(&eps[n++], "GET", "/api/signals", NULL, NULL);
+    endpoint_init(&eps[n++], "GET", "/api/signals", NULL, "Accept: application/cbor\r\n");
+    endpoint_init(&eps[n++], "GET", "/api/signal-history", NULL, NULL);
+    endpoint_init(&eps[n++], "GET", "/api/signal-history", NULL, "Accept: application/cbor\r\n");
+    endpoint_init(&eps[n++], "GET", "/api/signals/export", NULL, NULL);
+    endpoint_init(&eps[n++], "GET", "/api/settings", NULL, NULL);
+    endpoint_init(&eps[n++], "GET", "/api/http", NULL, NULL);
+    endpoint_init(&eps[n++], "GET", "/", NULL, NULL);
+    endpoint_init(&eps[n++], "GET", "/js/signals.js", NULL, NULL);
+    return n;
+}
+
+//
+// Seeding
+//
+
+// One request on a fresh connection, for setup only
+static int request_once(const char *method, const char *path, const char *body)
+{
+    endpoint_t ep;
+    if (!endpoint_init(&ep, method, path, body, NULL)) return 0;
+    conn_t *conn = malloc(sizeof(conn_t));
+    conn->fd = -1;
+    size_t body_len;
+    int status = conn_request(conn, ep.request, ep.request_len, &body_len);
+    conn_close(conn);
+    free(conn);
+    return status;
+}
+
+static bool seed_signals(int count)
+{
+    for (int i = 0; i < count; i++) {
+        char body[256];
+        snprintf(body, sizeof(body),
+                 "{\"name\":\"Bench signal %d\",\"code\":%d,\"bitLength\":24,\"protocol\":1,\"pulseLength\":350}",
+                 i, 0x100000 + i);
+        int status = request_once("POST", "/api/signals", body);
+        if (status != 200) {
+            fprintf(stderr, "rf_bench: adding signal %d failed with status %d\n", i, status);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Each transmission loops back into the receiver and becomes a tracked signal
+static bool seed_tracked(int count)
+{
+    for (int i = 0; i < count; i++) {
+        char body[256];
+        snprintf(body, sizeof(body),
+                 "{\"code\":%d,\"bitLength\":24,\"protocol\":1,\"pulseLength\":350,\"repeats\":2}", 0x200000 + i);
+        int status = request_once("POST", "/api/transmit", body);
+        if (status != 200) {
+            fprintf(stderr, "rf_bench: transmitting signal %d failed with status %d\n", i, status);
+            return false;
+        }
+    }
+    usleep(200 * 1000);     // Let the monitor task drain the last frames
+    return true;
+}
+
+//
+// Measurement
+//
+
+static void *client_thread(void *arg)
+{
+    client_t *client = arg;
+    const endpoint_t *ep = client->endpoint;
+    pthread_barrier_wait(&start_barrier);
+
+    for (uint32_t i = 0; i < client->count; i++) {
+        size_t body_len;
+        int64_t start = now_us();
+        int status = conn_request(&client->conn, ep->request, ep->request_len, &body_len);
+        client->latency_us[i] = (uint32_t)(now_us() - start);
+        if (status < 200 || status >= 300) client->errors++;
+    }
+    return NULL;
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void run_endpoint(const endpoint_t *ep, int clients, uint32_t requests, result_t *out)
+{
+    static client_t pool[MAX_CLIENTS];
+    uint32_t per_client = (requests + clients - 1) / clients;
+    uint32_t *latency = malloc(sizeof(uint32_t) * per_client * clients);
+
+    // Warm up caches and connections outside the measurement
+    for (int c = 0; c < clients; c++) {
+        pool[c] = (client_t){ .endpoint = ep, .conn.fd = -1, .count = per_client,
+                              .latency_us = latency + c * per_client };
+        size_t body_len;
+        for (int i = 0; i < 10; i++) {
+            conn_request(&pool[c].conn, ep->request, ep->request_len, &body_len);
+        }
+    }
+
+    pthread_t threads[MAX_CLIENTS];
+    pthread_barrier_init(&start_barrier, NULL, clients + 1);
+    for (int c = 0; c < clients; c++) {
+        pthread_create(&threads[c], NULL, client_thread, &pool[c]);
+    }
+
+    host_alloc_stats_t before, after;
+    host_alloc_get_stats(&before);
+    int64_t start = now_us();
+    pthread_barrier_wait(&start_barrier);
+    for (int c = 0; c < clients; c++) {
+        pthread_join(threads[c], NULL);
+    }
+    int64_t elapsed = now_us() - start;
+    host_alloc_get_stats(&after);
+    pthread_barrier_destroy(&start_barrier);
+
+    uint32_t total = per_client * clients;
+    memset(out, 0, sizeof(*out));
+    for (int c = 0; c < clients; c++) {
+        out->errors += pool[c].errors;
+        conn_close(&pool[c].conn);
+    }
+    qsort(latency, total, sizeof(uint32_t), compare_u32);
+    out->req_per_s = total * 1e6 / (elapsed > 0 ? elapsed : 1);
+    out->p50_us = latency[total / 2];
+    out->p99_us = latency[(uint32_t)(total * 0.99)];
+    out->allocs_per_req = (double)(after.allocs - before.allocs) / total;
+    out->bytes_per_req = (double)(after.alloc_bytes - before.alloc_bytes) / total;
+    free(latency);
+}
+
+//
+// Route lookup
+//
+
+typedef struct {
+    int method;
+    const char *path;
+} route_def_t;
+
+static const route_def_t route_defs[] = {
+#define ROUTE(method, path, handler) { HTTP_##method, path },
+#include "routes.def"
+#undef ROUTE
+};
+
+// What the server did before the trie: one wildcard pattern per route ("/api/signals/*"
+// for "/api/signals/{index}"), tried in registration order
+static char wildcard_patterns[API_ROUTE_COUNT][64];
+
+static void make_wildcard_patterns(void)
+{
+    for (int i = 0; i < API_ROUTE_COUNT; i++) {
+        const char *param = strchr(route_defs[i].path, '{');
+        int length = param ? (int)(param - route_defs[i].path) : (int)strlen(route_defs[i].path);
+        snprintf(wildcard_patterns[i], sizeof(wildcard_patterns[i]), "%.*s%s", length, route_defs[i].path,
+                 param ? "*" : "");
+    }
+}
+
+static int wildcard_lookup(int method, const char *uri)
+{
+    size_t length = strcspn(uri, "?");
+    for (int i = 0; i < API_ROUTE_COUNT; i++) {
+        if (route_defs[i].method == method && httpd_uri_match_wildcard(wildcard_patterns[i], uri, length)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int trie_lookup(int method, const char *uri)
+{
+    router_match_t match;
+    return router_lookup(&api_route_trie, method, uri, &match) == ROUTER_FOUND ? match.route : -1;
+}
+
+// Nanoseconds per call of lookup, over iterations calls
+static double time_lookup(int (*lookup)(int, const char *), int method, const char *uri, uint32_t iterations,
+                          int *route)
+{
+    volatile int sink = 0;
+    struct timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (uint32_t i = 0; i < iterations; i++) {
+        sink = lookup(method, uri);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    *route = sink;
+    return ((b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec)) / iterations;
+}
+
+static const char *method_name(int method)
+{
+    switch (method) {
+        case HTTP_GET:    return "GET";
+        case HTTP_POST:   return "POST";
+        case HTTP_PUT:    return "PUT";
+        case HTTP_DELETE: return "DELETE";
+        default:          return "?";
+    }
+}
+
+// Every route with sample parameters, plus a static file that matches none. Prints the
+// cost of both lookups and where the wildcard walk picks a different handler.
+static int run_routes(uint32_t iterations)
+{
+    make_wildcard_patterns();
+
+    int count = 0;
+    int differ = 0;
+    double trie_total = 0;
+    double wildcard_total = 0;
+    printf("%lu lookups per path\n\n", (unsigned long)iterations);
+    printf("%-44s %9s %12s  %s\n", "path", "trie ns", "wildcard ns", "wildcard picks");
+    for (int i = 0; i <= API_ROUTE_COUNT; i++) {
+        char uri[96];
+        int method = HTTP_GET;
+        if (i == API_ROUTE_COUNT) {
+            snprintf(uri, sizeof(uri), "/js/signals.js");
+        } else {
+            // {index} and {id} become numbers, {name} a name that needs decoding
+            const char *path = route_defs[i].path;
+            const char *param = strchr(path, '{');
+            const char *value = param && strncmp(param, "{name}", 6) == 0 ? "Garage%20Door" : "3";
+            int length = param ? (int)(param - path) : (int)strlen(path);
+            snprintf(uri, sizeof(uri), "%.*s%s", length, path, param ? value : "");
+            method = route_defs[i].method;
+        }
+
+        int trie_route, wildcard_route;
+        double trie_ns = time_lookup(trie_lookup, method, uri, iterations, &trie_route);
+        double wildcard_ns = time_lookup(wildcard_lookup, method, uri, iterations, &wildcard_route);
+        trie_total += trie_ns;
+        wildcard_total += wildcard_ns;
+        count++;
+
+        char name[128];
+        snprintf(name, sizeof(name), "%s %s", method_name(method), uri);
+        const char *picks = "same";
+        if (wildcard_route != trie_route) {
+            picks = wildcard_route < 0 ? "(none)" : wildcard_patterns[wildcard_route];
+            differ++;
+        }
+        printf("%-44s %9.1f %12.1f  %s\n", name, trie_ns, wildcard_ns, picks);
+    }
+    printf("\n%-44s %9.1f %12.1f  %d of %d differ\n", "mean", trie_total / count, wildcard_total / count,
+           differ, count);
+    return 0;
+}
+
+//
+// Saved results
+//
+
+static void save_results(const char *path, endpoint_t *eps, result_t *results, int count)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "rf_bench: cannot write %s: %s\n", path, strerror(errno));
+        return;
+    }
+    fprintf(f, "# endpoint\treq/s\tp50_us\tp99_us\tallocs/req\tbytes/req\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(f, "%s\t%.1f\t%.0f\t%.0f\t%.2f\t%.0f\n", eps[i].name, results[i].req_per_s,
+                results[i].p50_us, results[i].p99_us, results[i].allocs_per_req, results[i].bytes_per_req);
+    }
+    fclose(f);
+}
+
+// Returns the number of regressions against the baseline, -1 if it cannot be read
+static int compare_results(const char *path, double tolerance, endpoint_t *eps, result_t *results, int count)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "rf_bench: cannot read %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int regressions = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (line[0] == '#') continue;
+        char *tab = strchr(line, '\t');
+        if (tab == NULL) continue;
+        *tab = '\0';
+        result_t base;
+        if (sscanf(tab + 1, "%lf %lf %lf %lf %lf", &base.req_per_s, &base.p50_us, &base.p99_us,
+                   &base.allocs_per_req, &base.bytes_per_req) != 5) continue;
+
+        for (int i = 0; i < count; i++) {
+            if (strcmp(eps[i].name, line) != 0) continue;
+            const result_t *r = &results[i];
+            if (r->errors > 0) {
+                printf("REGRESSION %s: %lu failed requests\n", line, (unsigned long)r->errors);
+                regressions++;
+            }
+            if (r->req_per_s < base.req_per_s * (1 - tolerance)) {
+                printf("REGRESSION %s: %.0f req/s, baseline %.0f\n", line, r->req_per_s, base.req_per_s);
+                regressions++;
+            }
+            if (r->p99_us > base.p99_us * (1 + tolerance)) {
+                printf("REGRESSION %s: p99 %.0f us, baseline %.0f\n", line, r->p99_us, base.p99_us);
+                regressions++;
+            }
+            // Allocation counts are deterministic, more than one extra per request is a real change
+            if (r->allocs_per_req > base.allocs_per_req + 1) {
+                printf("REGRESSION %s: %.2f allocs/req, baseline %.2f\n", line, r->allocs_per_req,
+                       base.allocs_per_req);
+                regressions++;
+            }
+        }
+    }
+    fclose(f);
+    return regressions;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: rf_bench [options]\n"
+            "  --port N          port for the in-process server (default 18080)\n"
+            "  --signals N       saved signals to create first, up to 500 (default 100)\n"
+            "  --tracked N       signals to transmit so they show up in signal-history (default 0)\n"
+            "  --clients N       concurrent keep-alive clients (default 4, max %d)\n"
+            "  --requests N      measured requests per endpoint (default 2000)\n"
+            "  --endpoint SPEC   \"METHOD /path [body]\" to run instead of the defaults, repeatable\n"
+            "  --save FILE       write the results as a baseline\n"
+            "  --compare FILE    compare against a baseline, exit 1 on regressions\n"
+            "  --tolerance PCT   allowed req/s and p99 change for --compare (default 25)\n"
+            "  --routes N        time N route lookups per path against the old wildcard walk, no server\n",
+            MAX_CLIENTS);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "port", required_argument, NULL, 'p' },
+        { "signals", required_argument, NULL, 's' },
+        { "tracked", required_argument, NULL, 't' },
+        { "clients", required_argument, NULL, 'c' },
+        { "requests", required_argument, NULL, 'n' },
+        { "endpoint", required_argument, NULL, 'e' },
+        { "save", required_argument, NULL, 'S' },
+        { "compare", required_argument, NULL, 'C' },
+        { "tolerance", required_argument, NULL, 'T' },
+        { "routes", required_argument, NULL, 'r' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    static endpoint_t endpoints[MAX_ENDPOINTS];
+    static result_t results[MAX_ENDPOINTS];
+    int endpoint_count = 0;
+    int signals = 100;
+    int tracked = 0;
+    int clients = 4;
+    uint32_t requests = 2000;
+    const char *save_path = NULL;
+    const char *compare_path = NULL;
+    double tolerance = 0.25;
+    uint32_t route_lookups = 0;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 's': signals = atoi(optarg); break;
+            case 't': tracked = atoi(optarg); break;
+            case 'c': clients = atoi(optarg); break;
+            case 'n': requests = strtoul(optarg, NULL, 10); break;
+            case 'S': save_path = optarg; break;
+            case 'C': compare_path = optarg; break;
+            case 'T': tolerance = atof(optarg) / 100; break;
+            case 'r': route_lookups = strtoul(optarg, NULL, 10); break;
+            case 'e':
+                if (endpoint_count == MAX_ENDPOINTS || !endpoint_parse(&endpoints[endpoint_count], optarg)) {
+                    fprintf(stderr, "rf_bench: bad endpoint \"%s\"\n", optarg);
+                    return 2;
+                }
+                endpoint_count++;
+                break;
+            default:
+                usage();
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (clients < 1 || clients > MAX_CLIENTS || requests == 0 || signals < 0 || tracked < 0) {
+        usage();
+        return 2;
+    }
+    if (route_lookups > 0) return run_routes(route_lookups);
+    if (endpoint_count == 0) endpoint_count = default_endpoints(endpoints);
+
+    // The firmware reads these when it starts
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%u", port);
+    setenv("RF_HOST_PORT", port_str, 1);
+    setenv("RF_HOST_LOG", "E", 0);
+
+    if (host_boot(5000) == 0) {
+        fprintf(stderr, "rf_bench: the web server did not start on port %u\n", port);
+        return 2;
+    }
+    if (!seed_signals(signals) || !seed_tracked(tracked)) return 2;
+
+    printf("%d signals, %d tracked, %d clients, %lu requests per endpoint\n\n",
+           signals, tracked, clients, (unsigned long)requests);
+    printf("%-40s %9s %9s %9s %11s %11s %7s\n", "endpoint", "req/s", "p50 us", "p99 us",
+           "allocs/req", "bytes/req", "errors");
+    for (int i = 0; i < endpoint_count; i++) {
+        run_endpoint(&endpoints[i], clients, requests, &results[i]);
+        const result_t *r = &results[i];
+        printf("%-40s %9.0f %9.0f %9.0f %11.2f %11.0f %7lu\n", endpoints[i].name, r->req_per_s,
+               r->p50_us, r->p99_us, r->allocs_per_req, r->bytes_per_req, (unsigned long)r->errors);
+        fflush(stdout);
+    }
+
+    if (save_path != NULL) save_results(save_path, endpoints, results, endpoint_count);
+    if (compare_path != NULL) {
+        int regressions = compare_results(compare_path, tolerance, endpoints, results, endpoint_count);
+        if (regressions != 0) {
+            printf("\n%d regression%s against %s\n", regressions, regressions == 1 ? "" : "s", compare_path);
+            return 1;
+        }
+        printf("\nNo regressions against %s\n", compare_path);
+    }
+    return 0;
+}
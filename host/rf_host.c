@@ -0,0 +1,20 @@
+#include <stdio.h>
+#include <unistd.h>
+#include "host.h"
+
+// Runs the firmware on this machine. The web UI and the API are served on
+// port 8080, or RF_HOST_PORT. Transmitted signals loop back into the receiver.
+int main(void)
+{
+    uint16_t port = host_boot(5000);
+    if (port == 0) {
+        fprintf(stderr, "rf_host: the web server did not start\n");
+        return 1;
+    }
+    printf("rf_host: serving http://127.0.0.1:%u/\n", port);
+    fflush(stdout);
+
+    while (1) {
+        pause();
+    }
+}
@@ -0,0 +1,417 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include "rc_switch.h"
+#include "host.h"
+
+// Runs the real transmitter on a virtual clock for every protocol, bit length and
+// repeat count. Every gpio_set_level is recorded with its time and checked against
+// the rc_protocol_t timing, and the same edges reach the real receiver ISR, which
+// shows whether the frames decode back to what was sent. Frames longer than a
+// transmitted code can be are driven onto the air directly and have to come back
+// bit for bit from rc_receiver_get_bits.
+
+#define TX_PIN          GPIO_NUM_2
+#define RX_PIN          GPIO_NUM_4
+#define FLUSH_PIN       GPIO_NUM_5      // Ends the last capture with one more edge
+#define LONG_RX_PIN     GPIO_NUM_12     // Receiver with a buffer for long frames
+#define LONG_RX_EDGES   1024
+#define MAX_LEVELS      4096
+#define CODES_PER_CASE  3
+#define MIN_BITS        8
+
+static const uint8_t repeat_counts[] = { 1, 2, 3, 5, 10, 20 };
+#define NUM_REPEAT_COUNTS (sizeof(repeat_counts) / sizeof(repeat_counts[0]))
+
+// Long frame lengths in bits, the last one is more than LONG_RX_EDGES can hold
+static const uint16_t long_lengths[] = { 33, 64, 128, 200, 300, 600 };
+#define NUM_LONG_LENGTHS (sizeof(long_lengths) / sizeof(long_lengths[0]))
+#define LONG_MAX_BITS 600
+
+typedef struct {
+    uint32_t level;
+    int64_t time_us;
+} level_change_t;
+
+typedef struct {
+    uint32_t cases;
+    uint32_t wave_failures;     // Wrong levels, wrong number of calls or timing beyond tolerance
+    uint32_t max_phase_error_us; // Largest error of a single high or low phase
+    uint32_t max_drift_us;      // Largest error at the end of a frame
+    uint32_t round_trips;       // Cases with 2+ repeats, the receiver needs a frame after the one it decodes
+    uint32_t decoded;           // Decoded to the code and bit length that were sent
+    uint32_t other_protocol;    // Of those, reported as another protocol with the same timing ratios
+} protocol_result_t;
+
+static level_change_t levels[MAX_LEVELS];
+static uint32_t level_count;
+static bool verbose = false;
+
+static void record_level(gpio_num_t pin, uint32_t level, int64_t time_us)
+{
+    if (pin != TX_PIN || level_count == MAX_LEVELS) return;
+    levels[level_count++] = (level_change_t){ level, time_us };
+}
+
+static uint32_t abs_diff(int64_t a, int64_t b)
+{
+    return (uint32_t)(a > b ? a - b : b - a);
+}
+
+// Checks the recorded calls of one send against the protocol definition. Each frame is
+// a high/low pair per bit (MSB first), sync high, sync low, then the pin is driven low.
+static bool check_waveform(uint8_t proto, uint16_t pulse, uint32_t code, uint8_t length, uint8_t repeats,
+                           uint32_t tolerance_us, protocol_result_t *result)
+{
+    const rc_protocol_t *p = rc_get_protocol(proto);
+    uint32_t calls_per_frame = 2 + 2 * length + 1;
+    if (level_count != calls_per_frame * repeats) {
+        if (verbose) printf("  protocol %d, %d bits, %d repeats: %lu level changes, expected %lu\n", proto + 1,
+                            length, repeats, (unsigned long)level_count, (unsigned long)(calls_per_frame * repeats));
+        return false;
+    }
+
+    uint32_t high = p->invert_signal ? 0 : 1;
+    bool ok = true;
+    for (uint8_t frame = 0; frame < repeats; frame++) {
+        const level_change_t *calls = &levels[frame * calls_per_frame];
+        uint32_t expected_level[2 + 2 * RC_SWITCH_MAX_BITS + 1];
+        uint32_t phase_us[2 + 2 * RC_SWITCH_MAX_BITS + 1];
+        uint32_t n = 0;
+
+        for (int8_t i = length - 1; i >= 0; i--) {
+            bool bit = (code >> i) & 1;
+            expected_level[n] = high;
+            phase_us[n++] = pulse * (bit ? p->one.high : p->zero.high);
+            expected_level[n] = !high;
+            phase_us[n++] = pulse * (bit ? p->one.low : p->zero.low);
+        }
+        expected_level[n] = high;
+        phase_us[n++] = pulse * p->sync_factor.high;
+        expected_level[n] = !high;
+        phase_us[n++] = pulse * p->sync_factor.low;
+        expected_level[n] = 0;
+        phase_us[n++] = 0;
+
+        int64_t expected_time = calls[0].time_us;
+        for (uint32_t i = 0; i < n; i++) {
+            if (calls[i].level != expected_level[i]) {
+                if (verbose) printf("  protocol %d, %d bits, frame %d: call %lu drives %lu, expected %lu\n",
+                                    proto + 1, length, frame, (unsigned long)i, (unsigned long)calls[i].level,
+                                    (unsigned long)expected_level[i]);
+                ok = false;
+            }
+            if (i + 1 < n) {
+                uint32_t error = abs_diff(calls[i + 1].time_us - calls[i].time_us, phase_us[i]);
+                if (error > result->max_phase_error_us) result->max_phase_error_us = error;
+                if (error > tolerance_us) ok = false;
+            }
+            expected_time += phase_us[i];
+        }
+
+        // The last call ends the frame, it should land exactly one airtime after the first
+        uint32_t airtime = rc_frame_airtime_us(proto, pulse, code, length);
+        uint32_t drift = abs_diff(calls[n - 1].time_us - calls[0].time_us, airtime);
+        if (drift > result->max_drift_us) result->max_drift_us = drift;
+    }
+    return ok;
+}
+
+// One send of code on the transmitter, with the receiver listening on the air
+static void run_case(rc_transmitter_t *tx, rc_receiver_t *rx, uint8_t proto, uint32_t code, uint8_t length,
+                     uint8_t repeats, uint32_t tolerance_us, protocol_result_t *result)
+{
+    const rc_protocol_t *p = rc_get_protocol(proto);
+    rc_decoder_config_t decoder;
+    rc_receiver_get_decoder_config(&decoder);
+
+    // Quiet air first, so the first sync low starts a capture
+    host_clock_advance_ns(2ULL * decoder.sync_gap_us * 1000);
+    rc_receiver_reset(rx);
+
+    level_count = 0;
+    rc_transmitter_set_protocol(tx, proto);
+    rc_transmitter_set_pulse_length(tx, p->pulse_length);
+    rc_transmitter_set_repeat(tx, repeats);
+    rc_transmitter_send(tx, code, length);
+
+    result->cases++;
+    if (!check_waveform(proto, p->pulse_length, code, length, repeats, tolerance_us, result)) {
+        result->wave_failures++;
+    }
+
+    host_clock_advance_ns(2ULL * decoder.sync_gap_us * 1000);
+    gpio_set_level(FLUSH_PIN, 1);
+    host_clock_advance_ns(1000 * 1000);
+    gpio_set_level(FLUSH_PIN, 0);
+
+    // The receiver only sees where the last bit ends when the next frame starts
+    if (repeats < 2) return;
+    result->round_trips++;
+    bool decoded = rc_receiver_available(rx) && rc_receiver_get_value(rx) == code &&
+                   rc_receiver_get_bitlength(rx) == length;
+    if (decoded) {
+        result->decoded++;
+        if (rc_receiver_get_protocol(rx) != proto + 1) result->other_protocol++;
+    } else if (verbose) {
+        printf("  protocol %d, %d bits, %d repeats: sent 0x%08lx, ", proto + 1, length, repeats, (unsigned long)code);
+        if (rc_receiver_available(rx)) {
+            printf("decoded 0x%08lx/%d bits as protocol %d\n", (unsigned long)rc_receiver_get_value(rx),
+                   rc_receiver_get_bitlength(rx), rc_receiver_get_protocol(rx));
+        } else {
+            printf("nothing decoded\n");
+        }
+    }
+}
+
+//
+// Long frames
+//
+
+static void drive_pair(uint16_t pulse, uint8_t high, uint8_t low)
+{
+    gpio_set_level(TX_PIN, 1);
+    host_clock_advance_ns((uint64_t)pulse * high * 1000);
+    gpio_set_level(TX_PIN, 0);
+    host_clock_advance_ns((uint64_t)pulse * low * 1000);
+}
+
+// Sends a frame of length pseudo-random bits twice with the timing of proto, then one
+// more sync so the second copy decodes. Returns false when the bits that come back are
+// not the ones sent: all of them, or when the frame is longer than the buffer, the
+// ones that fit and an overflow.
+static bool run_long_frame(rc_receiver_t *rx, uint8_t proto, uint16_t length, uint32_t *seed)
+{
+    const rc_protocol_t *p = rc_get_protocol(proto);
+    rc_decoder_config_t decoder;
+    rc_receiver_get_decoder_config(&decoder);
+    bool sent[LONG_MAX_BITS];
+    for (uint16_t i = 0; i < length; i++) {
+        *seed = *seed * 1664525 + 1013904223;
+        sent[i] = *seed >> 31;
+    }
+
+    host_clock_advance_ns(2ULL * decoder.sync_gap_us * 1000);
+    rc_receiver_reset(rx);
+    uint32_t overflows = rx->overflow_count;
+    for (int copy = 0; copy < 2; copy++) {
+        drive_pair(p->pulse_length, p->sync_factor.high, p->sync_factor.low);
+        for (uint16_t i = 0; i < length; i++) {
+            if (sent[i]) {
+                drive_pair(p->pulse_length, p->one.high, p->one.low);
+            } else {
+                drive_pair(p->pulse_length, p->zero.high, p->zero.low);
+            }
+        }
+    }
+    drive_pair(p->pulse_length, p->sync_factor.high, p->sync_factor.low);
+
+    // The capture starts with the sync gap, every bit after it takes two entries
+    uint16_t fits = (LONG_RX_EDGES - 1) / 2;
+    uint16_t expected = length < fits ? length : fits;
+    const uint32_t *words;
+    uint16_t count = rc_receiver_available(rx) ? rc_receiver_get_bits(rx, &words) : 0;
+    uint16_t wrong = 0;
+    for (uint16_t i = 0; i < count && i < length; i++) {
+        if (((words[i / 32] >> (31 - i % 32)) & 1) != sent[i]) wrong++;
+    }
+    bool overflowed = rx->overflow_count > overflows;
+    bool ok = count == expected && wrong == 0 && overflowed == (length > fits) &&
+              rc_receiver_get_bitlength(rx) == RC_SWITCH_MAX_BITS;
+    if (!ok && verbose) {
+        printf("  long frame, protocol %d, %d bits: %d bits decoded, %d wrong%s\n", proto + 1, length, count, wrong,
+               overflowed ? ", overflowed" : "");
+    }
+    return ok;
+}
+
+//
+// Saved results
+//
+
+static void save_results(const char *path, const protocol_result_t *results)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        fprintf(stderr, "rf_wave: cannot write %s: %s\n", path, strerror(errno));
+        return;
+    }
+    fprintf(f, "# protocol\twave_failures\tmax_phase_error_us\tdecoded\n");
+    for (int i = 0; i < RC_SWITCH_NUM_PROTOCOLS; i++) {
+        fprintf(f, "%d\t%lu\t%lu\t%lu\n", i + 1, (unsigned long)results[i].wave_failures,
+                (unsigned long)results[i].max_phase_error_us, (unsigned long)results[i].decoded);
+    }
+    fclose(f);
+}
+
+// Returns the number of regressions against the baseline, -1 if it cannot be read
+static int compare_results(const char *path, const protocol_result_t *results)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "rf_wave: cannot read %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int regressions = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        int proto;
+        unsigned long wave_failures, max_error, decoded;
+        if (line[0] == '#' || sscanf(line, "%d %lu %lu %lu", &proto, &wave_failures, &max_error, &decoded) != 4) {
+            continue;
+        }
+        if (proto < 1 || proto > RC_SWITCH_NUM_PROTOCOLS) continue;
+        const protocol_result_t *r = &results[proto - 1];
+        if (r->wave_failures > wave_failures) {
+            printf("REGRESSION protocol %d: %lu waveform failures, baseline %lu\n", proto,
+                   (unsigned long)r->wave_failures, wave_failures);
+            regressions++;
+        }
+        if (r->max_phase_error_us > max_error) {
+            printf("REGRESSION protocol %d: phase error %lu us, baseline %lu\n", proto,
+                   (unsigned long)r->max_phase_error_us, max_error);
+            regressions++;
+        }
+        if (r->decoded < decoded) {
+            printf("REGRESSION protocol %d: %lu frames decoded, baseline %lu\n", proto,
+                   (unsigned long)r->decoded, decoded);
+            regressions++;
+        }
+    }
+    fclose(f);
+    return regressions;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: rf_wave [options]\n"
+            "  --set-level-ns N  virtual time one gpio_set_level takes (default 0)\n"
+            "  --tolerance PCT   allowed phase error, percent of the pulse length (default 10)\n"
+            "  --sync-gap US     decoder sync gap (default from RC_DECODER_CONFIG_DEFAULT)\n"
+            "  --no-squelch      decode without the receiver squelch\n"
+            "  --verbose         print every failing case\n"
+            "  --save FILE       write the results as a baseline\n"
+            "  --compare FILE    compare against a baseline, exit 1 on regressions\n");
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option options[] = {
+        { "set-level-ns", required_argument, NULL, 'l' },
+        { "tolerance", required_argument, NULL, 'T' },
+        { "sync-gap", required_argument, NULL, 'g' },
+        { "no-squelch", no_argument, NULL, 'q' },
+        { "verbose", no_argument, NULL, 'v' },
+        { "save", required_argument, NULL, 'S' },
+        { "compare", required_argument, NULL, 'C' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    uint32_t set_level_ns = 0;
+    uint32_t tolerance_pct = 10;
+    uint32_t sync_gap_us = 0;
+    bool squelch = true;
+    const char *save_path = NULL;
+    const char *compare_path = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (opt) {
+            case 'l': set_level_ns = strtoul(optarg, NULL, 10); break;
+            case 'T': tolerance_pct = strtoul(optarg, NULL, 10); break;
+            case 'g': sync_gap_us = strtoul(optarg, NULL, 10); break;
+            case 'q': squelch = false; break;
+            case 'v': verbose = true; break;
+            case 'S': save_path = optarg; break;
+            case 'C': compare_path = optarg; break;
+            default:
+                usage();
+                return opt == 'h' ? 0 : 2;
+        }
+    }
+    setenv("RF_HOST_LOG", "E", 0);
+
+    host_clock_set_virtual(true);
+    host_gpio_set_level_cost(set_level_ns);
+
+    rc_transmitter_t tx;
+    rc_receiver_t rx;
+    rc_transmitter_init(&tx, TX_PIN);
+    rc_receiver_init(&rx, RX_PIN);
+    rc_receiver_set_squelch(&rx, squelch);
+    rc_receiver_t long_rx;
+    const rc_receiver_buffer_config_t long_buffer = { .edges = LONG_RX_EDGES, .width = 2, .psram = false };
+    rc_receiver_init_ex(&long_rx, LONG_RX_PIN, &long_buffer);
+    rc_receiver_set_squelch(&long_rx, squelch);
+    gpio_config_t flush_conf = { .mode = GPIO_MODE_OUTPUT, .pin_bit_mask = 1ULL << FLUSH_PIN };
+    gpio_config(&flush_conf);
+    if (sync_gap_us > 0) {
+        rc_decoder_config_t decoder;
+        rc_receiver_get_decoder_config(&decoder);
+        decoder.sync_gap_us = sync_gap_us;
+        rc_receiver_set_decoder_config(&decoder);
+    }
+    host_gpio_set_hook(record_level);
+
+    protocol_result_t results[RC_SWITCH_NUM_PROTOCOLS] = { 0 };
+    uint32_t seed = 0x2545F491;
+    for (uint8_t proto = 0; proto < RC_SWITCH_NUM_PROTOCOLS; proto++) {
+        uint32_t tolerance_us = rc_get_protocol(proto)->pulse_length * tolerance_pct / 100;
+        for (uint8_t length = MIN_BITS; length <= RC_SWITCH_MAX_BITS; length++) {
+            uint32_t mask = length < 32 ? (1UL << length) - 1 : UINT32_MAX;
+            for (size_t r = 0; r < NUM_REPEAT_COUNTS; r++) {
+                // Alternating bits both ways round, and one pseudo-random code
+                seed = seed * 1664525 + 1013904223;
+                uint32_t codes[CODES_PER_CASE] = { 0xAAAAAAAA & mask, 0x55555555 & mask, (seed & mask) | 1 };
+                for (int c = 0; c < CODES_PER_CASE; c++) {
+                    run_case(&tx, &rx, proto, codes[c], length, repeat_counts[r], tolerance_us, &results[proto]);
+                }
+            }
+        }
+    }
+
+    printf("%-9s %6s %6s %9s %12s %9s %13s %15s\n", "protocol", "pulse", "cases", "waveform",
+           "phase err us", "drift us", "decoded", "other protocol");
+    bool waveform_ok = true;
+    for (int i = 0; i < RC_SWITCH_NUM_PROTOCOLS; i++) {
+        const protocol_result_t *r = &results[i];
+        char decoded[24];
+        snprintf(decoded, sizeof(decoded), "%lu/%lu", (unsigned long)r->decoded, (unsigned long)r->round_trips);
+        printf("%-9d %6u %6lu %9s %12lu %9lu %13s %15lu\n", i + 1, rc_get_protocol(i)->pulse_length,
+               (unsigned long)r->cases, r->wave_failures == 0 ? "ok" : "FAIL", (unsigned long)r->max_phase_error_us,
+               (unsigned long)r->max_drift_us, decoded, (unsigned long)r->other_protocol);
+        if (r->wave_failures > 0) waveform_ok = false;
+    }
+
+    // Only the protocols whose sync gap is longer than the decoder's can decode at all
+    uint32_t long_cases = 0;
+    uint32_t long_decoded = 0;
+    for (uint8_t proto = 0; proto < RC_SWITCH_NUM_PROTOCOLS; proto++) {
+        const rc_protocol_t *p = rc_get_protocol(proto);
+        rc_decoder_config_t decoder;
+        rc_receiver_get_decoder_config(&decoder);
+        if (p->invert_signal || (uint32_t)p->pulse_length * p->sync_factor.low <= decoder.sync_gap_us) continue;
+        for (size_t l = 0; l < NUM_LONG_LENGTHS; l++) {
+            long_cases++;
+            if (run_long_frame(&long_rx, proto, long_lengths[l], &seed)) long_decoded++;
+        }
+    }
+    printf("\nLong frames (%u-edge buffer, %u to %u bits): %lu/%lu decoded bit for bit\n", LONG_RX_EDGES,
+           long_lengths[0], long_lengths[NUM_LONG_LENGTHS - 1], (unsigned long)long_decoded, (unsigned long)long_cases);
+    bool long_ok = long_cases > 0 && long_decoded == long_cases;
+
+    if (save_path != NULL) save_results(save_path, results);
+    if (compare_path != NULL) {
+        int regressions = compare_results(compare_path, results);
+        if (regressions != 0) {
+            printf("\n%d regression%s against %s\n", regressions, regressions == 1 ? "" : "s", compare_path);
+            return 1;
+        }
+        printf("\nNo regressions against %s\n", compare_path);
+    }
+    return waveform_ok && long_ok ? 0 : 1;
+}
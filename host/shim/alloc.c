@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <malloc.h>
+#include "host.h"
+
+// Linked with -Wl,--wrap=malloc,... so every allocation in the program lands here
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static atomic_uint_fast64_t allocs;
+static atomic_uint_fast64_t frees;
+static atomic_uint_fast64_t alloc_bytes;
+static atomic_int_fast64_t live_bytes;
+static atomic_int_fast64_t peak_live_bytes;
+
+static void count_alloc(void *ptr, size_t requested)
+{
+    if (ptr == NULL) return;
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&alloc_bytes, requested, memory_order_relaxed);
+
+    int64_t live = atomic_fetch_add_explicit(&live_bytes, malloc_usable_size(ptr), memory_order_relaxed) +
+                   malloc_usable_size(ptr);
+    int64_t peak = atomic_load_explicit(&peak_live_bytes, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak(&peak_live_bytes, &peak, live)) {
+    }
+}
+
+static void count_free(void *ptr)
+{
+    if (ptr == NULL) return;
+    atomic_fetch_add_explicit(&frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&live_bytes, malloc_usable_size(ptr), memory_order_relaxed);
+}
+
+void *__wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+    count_alloc(ptr, size);
+    return ptr;
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    void *ptr = __real_calloc(nmemb, size);
+    count_alloc(ptr, nmemb * size);
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    count_free(ptr);
+    void *moved = __real_realloc(ptr, size);
+    if (moved == NULL && size > 0) {
+        // The old block is still there
+        atomic_fetch_sub_explicit(&frees, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&live_bytes, malloc_usable_size(ptr), memory_order_relaxed);
+        return NULL;
+    }
+    count_alloc(moved, size);
+    return moved;
+}
+
+void __wrap_free(void *ptr)
+{
+    count_free(ptr);
+    __real_free(ptr);
+}
+
+void host_alloc_get_stats(host_alloc_stats_t *stats)
+{
+    stats->allocs = atomic_load(&allocs);
+    stats->frees = atomic_load(&frees);
+    stats->alloc_bytes = atomic_load(&alloc_bytes);
+    stats->live_bytes = atomic_load(&live_bytes);
+    stats->peak_live_bytes = atomic_load(&peak_live_bytes);
+}
@@ -0,0 +1,819 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "esp_http_server.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "host.h"
+
+static const char *TAG = "HOST_HTTPD";
+
+#define RECV_BUF_SIZE   (HTTPD_MAX_REQ_HDR_LEN + HTTPD_MAX_URI_LEN + 64)
+#define MAX_REQ_HEADERS 32
+
+typedef struct {
+    const char *field;
+    const char *value;
+} resp_hdr_t;
+
+typedef struct {
+    int fd;                     // -1 for a free slot
+    bool detached;              // Owned by an async request, the server leaves it alone
+    bool async_begun;           // The running handler handed its request off
+    bool pending;               // Reattached, buffered data may hold the next request
+    bool close_after;           // Close once the current request is finished
+    int64_t last_used;
+
+    // Bytes received and not consumed yet. During a request the header block
+    // stays at the front, body_pos is where its unread body starts.
+    char buf[RECV_BUF_SIZE + 1];
+    size_t buf_len;
+    size_t body_pos;
+    size_t body_remaining;
+    int header_count;
+    const char *header_names[MAX_REQ_HEADERS];
+    const char *header_values[MAX_REQ_HEADERS];
+
+    // Response
+    const char *status;
+    const char *type;
+    resp_hdr_t *resp_hdrs;
+    int resp_hdr_count;
+    bool headers_sent;
+    bool chunked;
+
+    httpd_req_t req;
+} session_t;
+
+typedef struct {
+    httpd_config_t config;
+    int listen_fd;
+    int wake_pipe[2];
+    httpd_uri_t *handlers;
+    int handler_count;
+    session_t *sessions;
+    pthread_mutex_t lock;       // fd, detached and pending of every session
+    pthread_t thread;
+    volatile bool stopping;
+} httpd_data_t;
+
+static volatile uint16_t listening_port = 0;
+
+uint16_t host_http_port(void)
+{
+    return listening_port;
+}
+
+//
+// Socket helpers
+//
+
+// Sends every byte or fails, like the blocking send of the device server
+static bool send_all(int fd, struct iovec *iov, int count)
+{
+    while (count > 0) {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = count };
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        while (count > 0 && (size_t)sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+static void wake_server(httpd_data_t *hd)
+{
+    char byte = 0;
+    ssize_t ignored = write(hd->wake_pipe[1], &byte, 1);
+    (void)ignored;
+}
+
+static session_t *session_of(httpd_req_t *r)
+{
+    return r->aux;
+}
+
+// Called with hd->lock held
+static void close_session(session_t *sess)
+{
+    if (sess->fd >= 0) close(sess->fd);
+    sess->fd = -1;
+    sess->detached = false;
+    sess->async_begun = false;
+    sess->pending = false;
+}
+
+//
+// Requests
+//
+
+static const char *find_header(session_t *sess, const char *field)
+{
+    for (int i = 0; i < sess->header_count; i++) {
+        if (strcasecmp(sess->header_names[i], field) == 0) return sess->header_values[i];
+    }
+    return NULL;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t *r, const char *field)
+{
+    const char *value = find_header(session_of(r), field);
+    return value != NULL ? strlen(value) : 0;
+}
+
+// Copies up to buf_size - 1 bytes, reporting when that cut the value short
+static esp_err_t copy_truncated(const char *value, size_t length, char *buf, size_t buf_size)
+{
+    if (buf_size == 0) return ESP_ERR_INVALID_ARG;
+    size_t copied = length < buf_size ? length : buf_size - 1;
+    memcpy(buf, value, copied);
+    buf[copied] = '\0';
+    return copied < length ? ESP_ERR_HTTPD_RESULT_TRUNC : ESP_OK;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t *r, const char *field, char *val, size_t val_size)
+{
+    const char *value = find_header(session_of(r), field);
+    if (value == NULL) return ESP_ERR_NOT_FOUND;
+    return copy_truncated(value, strlen(value), val, val_size);
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t *r)
+{
+    const char *query = strchr(r->uri, '?');
+    return query != NULL ? strlen(query + 1) : 0;
+}
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    const char *query = strchr(r->uri, '?');
+    if (query == NULL) return ESP_ERR_NOT_FOUND;
+    return copy_truncated(query + 1, strlen(query + 1), buf, buf_len);
+}
+
+esp_err_t httpd_query_key_value(const char *qry, const char *key, char *val, size_t val_size)
+{
+    if (qry == NULL || key == NULL || val == NULL) return ESP_ERR_INVALID_ARG;
+    size_t key_len = strlen(key);
+    const char *pair = qry;
+    while (*pair != '\0') {
+        const char *end = strchr(pair, '&');
+        if (end == NULL) end = pair + strlen(pair);
+        if ((size_t)(end - pair) > key_len && strncmp(pair, key, key_len) == 0 && pair[key_len] == '=') {
+            const char *value = pair + key_len + 1;
+            return copy_truncated(value, end - value, val, val_size);
+        }
+        pair = *end == '&' ? end + 1 : end;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *r)
+{
+    return r != NULL ? session_of(r)->fd : -1;
+}
+
+int httpd_req_recv(httpd_req_t *r, char *buf, size_t buf_len)
+{
+    session_t *sess = session_of(r);
+    if (buf_len > sess->body_remaining) buf_len = sess->body_remaining;
+    if (buf_len == 0) return 0;
+
+    // Whatever arrived together with the headers first
+    size_t buffered = sess->buf_len - sess->body_pos;
+    if (buffered > 0) {
+        size_t n = buffered < buf_len ? buffered : buf_len;
+        memcpy(buf, sess->buf + sess->body_pos, n);
+        sess->body_pos += n;
+        sess->body_remaining -= n;
+        return n;
+    }
+
+    ssize_t n;
+    do {
+        n = recv(sess->fd, buf, buf_len, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? HTTPD_SOCK_ERR_TIMEOUT : HTTPD_SOCK_ERR_FAIL;
+    if (n == 0) return HTTPD_SOCK_ERR_FAIL;
+    sess->body_remaining -= n;
+    return n;
+}
+
+//
+// Responses
+//
+
+esp_err_t httpd_resp_set_status(httpd_req_t *r, const char *status)
+{
+    session_of(r)->status = status;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
+{
+    session_of(r)->type = type;
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t *r, const char *field, const char *value)
+{
+    session_t *sess = session_of(r);
+    httpd_data_t *hd = r->handle;
+    if (sess->resp_hdr_count >= hd->config.max_resp_headers) return ESP_ERR_HTTPD_RESP_HDR;
+    sess->resp_hdrs[sess->resp_hdr_count++] = (resp_hdr_t){ field, value };
+    return ESP_OK;
+}
+
+// Formats the status line and headers. content_length < 0 selects chunked encoding.
+static int format_headers(session_t *sess, char *out, size_t size, ssize_t content_length)
+{
+    int len = snprintf(out, size, "HTTP/1.1 %s\r\nContent-Type: %s\r\n", sess->status, sess->type);
+    if (content_length >= 0) {
+        len += snprintf(out + len, size - len, "Content-Length: %zd\r\n", content_length);
+    } else {
+        len += snprintf(out + len, size - len, "Transfer-Encoding: chunked\r\n");
+    }
+    for (int i = 0; i < sess->resp_hdr_count && (size_t)len < size; i++) {
+        len += snprintf(out + len, size - len, "%s: %s\r\n", sess->resp_hdrs[i].field, sess->resp_hdrs[i].value);
+    }
+    if ((size_t)len < size) len += snprintf(out + len, size - len, "\r\n");
+    return (size_t)len < size ? len : -1;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    session_t *sess = session_of(r);
+    if (buf == NULL) buf_len = 0;
+    if (buf_len == HTTPD_RESP_USE_STRLEN) buf_len = strlen(buf);
+
+    char headers[HTTPD_MAX_REQ_HDR_LEN];
+    int headers_len = format_headers(sess, headers, sizeof(headers), buf_len);
+    if (headers_len < 0) return ESP_ERR_HTTPD_RESP_HDR;
+
+    struct iovec iov[] = { { headers, headers_len }, { (void *)buf, buf_len } };
+    sess->headers_sent = true;
+    if (!send_all(sess->fd, iov, buf_len > 0 ? 2 : 1)) {
+        sess->close_after = true;
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, ssize_t buf_len)
+{
+    session_t *sess = session_of(r);
+    if (buf == NULL) buf_len = 0;
+    if (buf_len == HTTPD_RESP_USE_STRLEN) buf_len = strlen(buf);
+
+    struct iovec iov[4];
+    int count = 0;
+    char headers[HTTPD_MAX_REQ_HDR_LEN];
+    if (!sess->headers_sent) {
+        int headers_len = format_headers(sess, headers, sizeof(headers), -1);
+        if (headers_len < 0) return ESP_ERR_HTTPD_RESP_HDR;
+        iov[count++] = (struct iovec){ headers, headers_len };
+        sess->headers_sent = true;
+        sess->chunked = true;
+    }
+
+    // An empty chunk ends the response
+    char size_line[16];
+    int size_len = snprintf(size_line, sizeof(size_line), "%zx\r\n", (size_t)buf_len);
+    iov[count++] = (struct iovec){ size_line, size_len };
+    if (buf_len > 0) iov[count++] = (struct iovec){ (void *)buf, buf_len };
+    iov[count++] = (struct iovec){ "\r\n", 2 };
+    if (buf_len == 0) sess->chunked = false;
+
+    if (!send_all(sess->fd, iov, count)) {
+        sess->close_after = true;
+        return ESP_ERR_HTTPD_RESP_SEND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t *req, httpd_err_code_t error, const char *usr_msg)
+{
+    static const struct {
+        const char *status;
+        const char *msg;
+    } errors[HTTPD_ERR_CODE_MAX] = {
+        [HTTPD_500_INTERNAL_SERVER_ERROR]    = { "500 Internal Server Error", "Server has encountered an unexpected error" },
+        [HTTPD_501_METHOD_NOT_IMPLEMENTED]   = { "501 Method Not Implemented", "Request method is not supported by server" },
+        [HTTPD_505_VERSION_NOT_SUPPORTED]    = { "505 Version Not Supported", "HTTP version not supported by server" },
+        [HTTPD_400_BAD_REQUEST]              = { "400 Bad Request", "Bad request syntax" },
+        [HTTPD_401_UNAUTHORIZED]             = { "401 Unauthorized", "No permission -- see authorization schemes" },
+        [HTTPD_403_FORBIDDEN]                = { "403 Forbidden", "Request forbidden -- authorization will not help" },
+        [HTTPD_404_NOT_FOUND]                = { "404 Not Found", "Nothing matches the given URI" },
+        [HTTPD_405_METHOD_NOT_ALLOWED]       = { "405 Method Not Allowed", "Specified method is invalid for this resource" },
+        [HTTPD_408_REQ_TIMEOUT]              = { "408 Request Timeout", "Server closed this connection" },
+        [HTTPD_411_LENGTH_REQUIRED]          = { "411 Length Required", "Chunked encoding not supported" },
+        [HTTPD_414_URI_TOO_LONG]             = { "414 URI Too Long", "URI is too long" },
+        [HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE] = { "431 Request Header Fields Too Large", "Header fields are too long" },
+    };
+    if (error < 0 || error >= HTTPD_ERR_CODE_MAX) return ESP_ERR_INVALID_ARG;
+
+    httpd_resp_set_status(req, errors[error].status);
+    httpd_resp_set_type(req, HTTPD_TYPE_TEXT);
+    return httpd_resp_sendstr(req, usr_msg != NULL ? usr_msg : errors[error].msg);
+}
+
+//
+// Async requests
+//
+
+esp_err_t httpd_req_async_handler_begin(httpd_req_t *r, httpd_req_t **out)
+{
+    if (r == NULL || out == NULL) return ESP_ERR_INVALID_ARG;
+    httpd_req_t *copy = malloc(sizeof(httpd_req_t));
+    if (copy == NULL) return ESP_ERR_NO_MEM;
+    memcpy(copy, r, sizeof(httpd_req_t));
+
+    session_t *sess = session_of(r);
+    httpd_data_t *hd = r->handle;
+    pthread_mutex_lock(&hd->lock);
+    sess->detached = true;
+    sess->async_begun = true;
+    pthread_mutex_unlock(&hd->lock);
+    *out = copy;
+    return ESP_OK;
+}
+
+static void finish_request(session_t *sess);
+
+esp_err_t httpd_req_async_handler_complete(httpd_req_t *r)
+{
+    if (r == NULL) return ESP_ERR_INVALID_ARG;
+    session_t *sess = session_of(r);
+    httpd_data_t *hd = r->handle;
+    free(r);
+
+    finish_request(sess);
+    pthread_mutex_lock(&hd->lock);
+    sess->detached = false;
+    if (sess->close_after) {
+        close_session(sess);
+    } else {
+        sess->pending = true;
+        sess->last_used = esp_timer_get_time();
+    }
+    pthread_mutex_unlock(&hd->lock);
+    wake_server(hd);
+    return ESP_OK;
+}
+
+esp_err_t httpd_get_client_list(httpd_handle_t handle, size_t *fds, int *client_fds)
+{
+    httpd_data_t *hd = handle;
+    if (hd == NULL || fds == NULL || client_fds == NULL) return ESP_ERR_INVALID_ARG;
+    size_t capacity = *fds;
+    size_t count = 0;
+    pthread_mutex_lock(&hd->lock);
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        if (hd->sessions[i].fd < 0) continue;
+        if (count == capacity) {
+            pthread_mutex_unlock(&hd->lock);
+            return ESP_ERR_INVALID_ARG;
+        }
+        client_fds[count++] = hd->sessions[i].fd;
+    }
+    pthread_mutex_unlock(&hd->lock);
+    *fds = count;
+    return ESP_OK;
+}
+
+//
+// URI matching
+//
+
+bool httpd_uri_match_wildcard(const char *uri_template, const char *uri_to_match, size_t match_upto)
+{
+    // A trailing * matches any rest, a trailing ? makes the character before it optional
+    size_t tpl_len = strlen(uri_template);
+    bool asterisk = tpl_len > 0 && uri_template[tpl_len - 1] == '*';
+    if (asterisk) tpl_len--;
+    bool quest = tpl_len > 0 && uri_template[tpl_len - 1] == '?';
+    if (quest) tpl_len--;
+
+    if (match_upto >= tpl_len && strncmp(uri_template, uri_to_match, tpl_len) == 0) {
+        if (asterisk || match_upto == tpl_len) return true;
+    }
+    if (quest && tpl_len > 0 && match_upto == tpl_len - 1) {
+        return strncmp(uri_template, uri_to_match, tpl_len - 1) == 0;
+    }
+    return false;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+    httpd_data_t *hd = handle;
+    if (hd == NULL || uri_handler == NULL) return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < hd->handler_count; i++) {
+        if (hd->handlers[i].method == uri_handler->method && strcmp(hd->handlers[i].uri, uri_handler->uri) == 0) {
+            return ESP_ERR_HTTPD_HANDLER_EXISTS;
+        }
+    }
+    if (hd->handler_count == hd->config.max_uri_handlers) {
+        ESP_LOGW(TAG, "No slot left for registering handler %s", uri_handler->uri);
+        return ESP_ERR_HTTPD_HANDLERS_FULL;
+    }
+    hd->handlers[hd->handler_count++] = *uri_handler;
+    return ESP_OK;
+}
+
+static const httpd_uri_t *find_handler(httpd_data_t *hd, const char *uri, int method, httpd_err_code_t *err)
+{
+    const char *query = strchr(uri, '?');
+    size_t uri_len = query != NULL ? (size_t)(query - uri) : strlen(uri);
+
+    *err = HTTPD_404_NOT_FOUND;
+    for (int i = 0; i < hd->handler_count; i++) {
+        const httpd_uri_t *h = &hd->handlers[i];
+        bool matches = hd->config.uri_match_fn != NULL
+            ? hd->config.uri_match_fn(h->uri, uri, uri_len)
+            : strlen(h->uri) == uri_len && strncmp(h->uri, uri, uri_len) == 0;
+        if (!matches) continue;
+        if (h->method == method) return h;
+        *err = HTTPD_405_METHOD_NOT_ALLOWED;
+    }
+    return NULL;
+}
+
+//
+// Server task
+//
+
+static int parse_method(const char *method)
+{
+    static const struct {
+        const char *name;
+        httpd_method_t method;
+    } methods[] = {
+        { "GET", HTTP_GET }, { "POST", HTTP_POST }, { "PUT", HTTP_PUT }, { "DELETE", HTTP_DELETE },
+        { "HEAD", HTTP_HEAD }, { "OPTIONS", HTTP_OPTIONS }, { "PATCH", HTTP_PATCH },
+    };
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (strcmp(method, methods[i].name) == 0) return methods[i].method;
+    }
+    return -1;
+}
+
+// Discards what the handler left of the body and moves any pipelined bytes to the front
+static void finish_request(session_t *sess)
+{
+    char discard[256];
+    while (sess->body_remaining > 0) {
+        if (httpd_req_recv(&sess->req, discard, sizeof(discard)) <= 0) {
+            sess->close_after = true;
+            break;
+        }
+    }
+    if (sess->chunked) sess->close_after = true;   // Handler never ended its chunked response
+
+    memmove(sess->buf, sess->buf + sess->body_pos, sess->buf_len - sess->body_pos);
+    sess->buf_len -= sess->body_pos;
+    sess->body_pos = 0;
+    sess->header_count = 0;
+    sess->status = HTTPD_200;
+    sess->type = HTTPD_TYPE_TEXT;
+    sess->resp_hdr_count = 0;
+    sess->headers_sent = false;
+    sess->chunked = false;
+}
+
+// Sends an error for a request that never reached a handler and drops the connection
+static void reject_request(session_t *sess, httpd_err_code_t error)
+{
+    sess->body_pos = sess->buf_len;
+    sess->body_remaining = 0;
+    httpd_resp_send_err(&sess->req, error, NULL);
+    sess->close_after = true;
+}
+
+// Parses the request whose header block ends at header_end and runs its handler.
+// Returns false when the session was handed to an async request.
+static bool handle_request(httpd_data_t *hd, session_t *sess, char *header_end)
+{
+    *header_end = '\0';
+    sess->body_pos = header_end + 4 - sess->buf;
+
+    char *line_end = strstr(sess->buf, "\r\n");
+    char *headers = line_end != NULL ? line_end + 2 : header_end;
+    if (line_end != NULL) *line_end = '\0';
+
+    // Request line
+    char *method_str = sess->buf;
+    char *uri = strchr(method_str, ' ');
+    char *version = uri != NULL ? strchr(uri + 1, ' ') : NULL;
+    if (version == NULL) {
+        reject_request(sess, HTTPD_400_BAD_REQUEST);
+        return true;
+    }
+    *uri++ = '\0';
+    *version++ = '\0';
+    if (strncmp(version, "HTTP/1.", 7) != 0) {
+        reject_request(sess, HTTPD_505_VERSION_NOT_SUPPORTED);
+        return true;
+    }
+    if (strlen(uri) > HTTPD_MAX_URI_LEN) {
+        reject_request(sess, HTTPD_414_URI_TOO_LONG);
+        return true;
+    }
+    int method = parse_method(method_str);
+    if (method < 0) {
+        reject_request(sess, HTTPD_501_METHOD_NOT_IMPLEMENTED);
+        return true;
+    }
+    if (strcmp(version, "HTTP/1.0") == 0) sess->close_after = true;
+
+    // Header fields
+    sess->header_count = 0;
+    char *line = headers;
+    while (line < header_end) {
+        char *end = strstr(line, "\r\n");
+        if (end == NULL) end = header_end;
+        *end = '\0';
+        char *colon = strchr(line, ':');
+        if (colon != NULL) {
+            if (sess->header_count == MAX_REQ_HEADERS) {
+                reject_request(sess, HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE);
+                return true;
+            }
+            *colon = '\0';
+            char *value = colon + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            sess->header_names[sess->header_count] = line;
+            sess->header_values[sess->header_count] = value;
+            sess->header_count++;
+        }
+        line = end + 2;
+    }
+
+    const char *connection = find_header(sess, "Connection");
+    if (connection != NULL && strcasecmp(connection, "close") == 0) sess->close_after = true;
+    const char *encoding = find_header(sess, "Transfer-Encoding");
+    if (encoding != NULL && strcasecmp(encoding, "chunked") == 0) {
+        reject_request(sess, HTTPD_411_LENGTH_REQUIRED);
+        return true;
+    }
+    const char *length = find_header(sess, "Content-Length");
+    sess->body_remaining = length != NULL ? strtoul(length, NULL, 10) : 0;
+
+    httpd_req_t *req = &sess->req;
+    memset(req, 0, sizeof(*req));
+    req->handle = hd;
+    req->method = method;
+    strcpy((char *)req->uri, uri);
+    req->content_len = sess->body_remaining;
+    req->aux = sess;
+
+    httpd_err_code_t err;
+    const httpd_uri_t *handler = find_handler(hd, uri, method, &err);
+    if (handler == NULL) {
+        httpd_resp_send_err(req, err, NULL);
+        return true;
+    }
+
+    req->user_ctx = handler->user_ctx;
+    esp_err_t ret = handler->handler(req);
+
+    pthread_mutex_lock(&hd->lock);
+    bool handed_off = sess->async_begun;
+    sess->async_begun = false;
+    pthread_mutex_unlock(&hd->lock);
+    if (handed_off) return false;
+
+    if (ret != ESP_OK) sess->close_after = true;
+    return true;
+}
+
+// Runs every complete request buffered on a session. Called without hd->lock.
+static void serve_buffered(httpd_data_t *hd, session_t *sess)
+{
+    while (1) {
+        sess->buf[sess->buf_len] = '\0';
+        char *header_end = strstr(sess->buf, "\r\n\r\n");
+        if (header_end == NULL) {
+            if (sess->buf_len == RECV_BUF_SIZE) {
+                reject_request(sess, HTTPD_431_REQ_HDR_FIELDS_TOO_LARGE);
+            } else {
+                break;
+            }
+        } else if (!handle_request(hd, sess, header_end)) {
+            return;
+        } else {
+            finish_request(sess);
+        }
+
+        sess->last_used = esp_timer_get_time();
+        if (sess->close_after) {
+            pthread_mutex_lock(&hd->lock);
+            close_session(sess);
+            pthread_mutex_unlock(&hd->lock);
+            return;
+        }
+    }
+}
+
+static void accept_client(httpd_data_t *hd)
+{
+    int fd = accept(hd->listen_fd, NULL, NULL);
+    if (fd < 0) return;
+
+    // Responses go out in several writes, don't let them wait for delayed ACKs
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval recv_timeout = { .tv_sec = hd->config.recv_wait_timeout };
+    struct timeval send_timeout = { .tv_sec = hd->config.send_wait_timeout };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+
+    pthread_mutex_lock(&hd->lock);
+    session_t *slot = NULL;
+    session_t *lru = NULL;
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        session_t *sess = &hd->sessions[i];
+        if (sess->fd < 0) {
+            slot = sess;
+            break;
+        }
+        if (!sess->detached && (lru == NULL || sess->last_used < lru->last_used)) lru = sess;
+    }
+    if (slot == NULL && hd->config.lru_purge_enable && lru != NULL) {
+        ESP_LOGD(TAG, "Closing least recently used socket %d", lru->fd);
+        close_session(lru);
+        slot = lru;
+    }
+    if (slot == NULL) {
+        pthread_mutex_unlock(&hd->lock);
+        ESP_LOGW(TAG, "No free session, closing new connection");
+        close(fd);
+        return;
+    }
+
+    resp_hdr_t *resp_hdrs = slot->resp_hdrs;
+    memset(slot, 0, sizeof(*slot));
+    slot->resp_hdrs = resp_hdrs;
+    slot->status = HTTPD_200;
+    slot->type = HTTPD_TYPE_TEXT;
+    slot->last_used = esp_timer_get_time();
+    slot->req.handle = hd;
+    slot->req.aux = slot;
+    slot->fd = fd;
+    pthread_mutex_unlock(&hd->lock);
+}
+
+static void *server_thread(void *arg)
+{
+    httpd_data_t *hd = arg;
+    pthread_setname_np(pthread_self(), "httpd");
+
+    int max = hd->config.max_open_sockets;
+    struct pollfd *fds = calloc(max + 2, sizeof(struct pollfd));
+    session_t **polled = calloc(max, sizeof(session_t *));
+
+    while (!hd->stopping) {
+        // Sessions reattached by async requests may already hold their next request
+        for (int i = 0; i < max; i++) {
+            session_t *sess = &hd->sessions[i];
+            pthread_mutex_lock(&hd->lock);
+            bool pending = sess->pending && sess->fd >= 0 && !sess->detached;
+            sess->pending = false;
+            pthread_mutex_unlock(&hd->lock);
+            if (pending) serve_buffered(hd, sess);
+        }
+
+        int count = 0;
+        fds[count++] = (struct pollfd){ .fd = hd->wake_pipe[0], .events = POLLIN };
+        fds[count++] = (struct pollfd){ .fd = hd->listen_fd, .events = POLLIN };
+        int sessions = 0;
+        pthread_mutex_lock(&hd->lock);
+        for (int i = 0; i < max; i++) {
+            session_t *sess = &hd->sessions[i];
+            if (sess->fd < 0 || sess->detached) continue;
+            polled[sessions++] = sess;
+            fds[count++] = (struct pollfd){ .fd = sess->fd, .events = POLLIN };
+        }
+        pthread_mutex_unlock(&hd->lock);
+
+        if (poll(fds, count, -1) < 0) continue;
+
+        if (fds[0].revents) {
+            char drain[64];
+            ssize_t ignored = read(hd->wake_pipe[0], drain, sizeof(drain));
+            (void)ignored;
+        }
+        for (int i = 0; i < sessions; i++) {
+            if (!fds[i + 2].revents) continue;
+            session_t *sess = polled[i];
+            ssize_t n = recv(sess->fd, sess->buf + sess->buf_len, RECV_BUF_SIZE - sess->buf_len, 0);
+            if (n <= 0) {
+                pthread_mutex_lock(&hd->lock);
+                close_session(sess);
+                pthread_mutex_unlock(&hd->lock);
+                continue;
+            }
+            sess->buf_len += n;
+            serve_buffered(hd, sess);
+        }
+        if (fds[1].revents) accept_client(hd);
+    }
+
+    free(polled);
+    free(fds);
+    return NULL;
+}
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+    if (handle == NULL || config == NULL) return ESP_ERR_INVALID_ARG;
+
+    httpd_data_t *hd = calloc(1, sizeof(httpd_data_t));
+    if (hd == NULL) return ESP_ERR_HTTPD_ALLOC_MEM;
+    hd->config = *config;
+    const char *env_port = getenv("RF_HOST_PORT");
+    if (env_port != NULL) hd->config.server_port = atoi(env_port);
+
+    hd->handlers = calloc(config->max_uri_handlers, sizeof(httpd_uri_t));
+    hd->sessions = calloc(config->max_open_sockets, sizeof(session_t));
+    resp_hdr_t *resp_hdrs = calloc((size_t)config->max_open_sockets * config->max_resp_headers, sizeof(resp_hdr_t));
+    if (hd->handlers == NULL || hd->sessions == NULL || resp_hdrs == NULL) goto fail;
+    for (int i = 0; i < config->max_open_sockets; i++) {
+        hd->sessions[i].fd = -1;
+        hd->sessions[i].resp_hdrs = resp_hdrs + i * config->max_resp_headers;
+    }
+    pthread_mutex_init(&hd->lock, NULL);
+
+    if (pipe(hd->wake_pipe) != 0) goto fail;
+    fcntl(hd->wake_pipe[1], F_SETFL, O_NONBLOCK);
+
+    hd->listen_fd = socket(AF_INET6, SOCK_STREAM, 0);
+    if (hd->listen_fd < 0) goto fail;
+    int one = 1;
+    int zero = 0;
+    setsockopt(hd->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(hd->listen_fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+    struct sockaddr_in6 addr = {
+        .sin6_family = AF_INET6,
+        .sin6_addr = in6addr_any,
+        .sin6_port = htons(hd->config.server_port),
+    };
+    if (bind(hd->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(hd->listen_fd, hd->config.backlog_conn) != 0) {
+        ESP_LOGE(TAG, "Failed to listen on port %u: %s", hd->config.server_port, strerror(errno));
+        goto fail;
+    }
+    socklen_t addr_len = sizeof(addr);
+    getsockname(hd->listen_fd, (struct sockaddr *)&addr, &addr_len);
+
+    if (pthread_create(&hd->thread, NULL, server_thread, hd) != 0) goto fail;
+    listening_port = ntohs(addr.sin6_port);
+    ESP_LOGI(TAG, "Listening on port %u", listening_port);
+    *handle = hd;
+    return ESP_OK;
+
+fail:
+    if (hd->listen_fd > 0) close(hd->listen_fd);
+    free(resp_hdrs);
+    free(hd->sessions);
+    free(hd->handlers);
+    free(hd);
+    return ESP_ERR_HTTPD_TASK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+    httpd_data_t *hd = handle;
+    if (hd == NULL) return ESP_ERR_INVALID_ARG;
+    hd->stopping = true;
+    wake_server(hd);
+    pthread_join(hd->thread, NULL);
+
+    pthread_mutex_lock(&hd->lock);
+    for (int i = 0; i < hd->config.max_open_sockets; i++) {
+        if (!hd->sessions[i].detached) close_session(&hd->sessions[i]);
+    }
+    pthread_mutex_unlock(&hd->lock);
+    close(hd->listen_fd);
+    listening_port = 0;
+    return ESP_OK;
+}
@@ -0,0 +1,204 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "host.h"
+
+static const char *TAG = "HOST_TIMER";
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    const char *name;
+    int64_t alarm;              // esp_timer_get_time() when it fires, 0 when stopped
+    uint64_t period;            // 0 for one-shot timers
+    struct esp_timer *next;     // Armed timers, soonest first
+};
+
+static pthread_mutex_t timers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timers_changed;
+static struct esp_timer *armed = NULL;
+static pthread_once_t timer_thread_once = PTHREAD_ONCE_INIT;
+static struct timespec boot_time;
+static atomic_bool clock_virtual;
+static atomic_int_fast64_t virtual_ns;
+
+__attribute__((constructor))
+static void record_boot_time(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &boot_time);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    if (atomic_load_explicit(&clock_virtual, memory_order_relaxed)) {
+        return atomic_load_explicit(&virtual_ns, memory_order_relaxed) / 1000;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - boot_time.tv_sec) * 1000000 + (now.tv_nsec - boot_time.tv_nsec) / 1000;
+}
+
+void host_clock_set_virtual(bool enabled)
+{
+    atomic_store(&clock_virtual, enabled);
+}
+
+bool host_clock_is_virtual(void)
+{
+    return atomic_load_explicit(&clock_virtual, memory_order_relaxed);
+}
+
+void host_clock_advance_ns(uint64_t ns)
+{
+    atomic_fetch_add_explicit(&virtual_ns, ns, memory_order_relaxed);
+}
+
+static void to_timespec(int64_t time_us, struct timespec *ts)
+{
+    int64_t ns = boot_time.tv_nsec + (time_us % 1000000) * 1000;
+    ts->tv_sec = boot_time.tv_sec + time_us / 1000000 + ns / 1000000000;
+    ts->tv_nsec = ns % 1000000000;
+}
+
+// Called with timers_lock held
+static void unlink_timer(struct esp_timer *timer)
+{
+    for (struct esp_timer **p = &armed; *p != NULL; p = &(*p)->next) {
+        if (*p == timer) {
+            *p = timer->next;
+            break;
+        }
+    }
+    timer->next = NULL;
+    timer->alarm = 0;
+}
+
+// Called with timers_lock held
+static void insert_timer(struct esp_timer *timer, int64_t alarm)
+{
+    timer->alarm = alarm;
+    struct esp_timer **p = &armed;
+    while (*p != NULL && (*p)->alarm <= alarm) p = &(*p)->next;
+    timer->next = *p;
+    *p = timer;
+}
+
+static void *timer_thread(void *arg)
+{
+    pthread_setname_np(pthread_self(), "esp_timer");
+    pthread_mutex_lock(&timers_lock);
+    while (1) {
+        if (armed == NULL) {
+            pthread_cond_wait(&timers_changed, &timers_lock);
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        if (armed->alarm > now) {
+            struct timespec deadline;
+            to_timespec(armed->alarm, &deadline);
+            pthread_cond_timedwait(&timers_changed, &timers_lock, &deadline);
+            continue;
+        }
+
+        struct esp_timer *timer = armed;
+        unlink_timer(timer);
+        if (timer->period > 0) {
+            insert_timer(timer, now + timer->period);
+        }
+        // Callbacks may start or stop timers, including this one
+        pthread_mutex_unlock(&timers_lock);
+        timer->callback(timer->arg);
+        pthread_mutex_lock(&timers_lock);
+    }
+    return NULL;
+}
+
+static void start_timer_thread(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timers_changed, &attr);
+    pthread_condattr_destroy(&attr);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, timer_thread, NULL) != 0) {
+        ESP_LOGE(TAG, "Failed to start the timer thread");
+        abort();
+    }
+    pthread_detach(thread);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_once(&timer_thread_once, start_timer_thread);
+
+    struct esp_timer *timer = calloc(1, sizeof(struct esp_timer));
+    if (timer == NULL) return ESP_ERR_NO_MEM;
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->name = create_args->name;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period)
+{
+    if (timer == NULL) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&timers_lock);
+    if (timer->alarm != 0) {
+        pthread_mutex_unlock(&timers_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->period = period;
+    insert_timer(timer, esp_timer_get_time() + (int64_t)timeout_us);
+    pthread_cond_signal(&timers_changed);
+    pthread_mutex_unlock(&timers_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer == NULL) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&timers_lock);
+    bool active = timer->alarm != 0;
+    if (active) unlink_timer(timer);
+    pthread_mutex_unlock(&timers_lock);
+    return active ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == NULL) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&timers_lock);
+    bool active = timer->alarm != 0;
+    pthread_mutex_unlock(&timers_lock);
+    if (active) return ESP_ERR_INVALID_STATE;
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&timers_lock);
+    bool active = timer->alarm != 0;
+    pthread_mutex_unlock(&timers_lock);
+    return active;
+}
@@ -0,0 +1,526 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_freertos_hooks.h"
+#include "esp_cpu.h"
+#include "esp_ipc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "host.h"
+
+static const char *TAG = "HOST_RTOS";
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t function;
+    void *arg;
+    char name[16];
+    int core;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+};
+
+static __thread struct host_task *current_task = NULL;
+static __thread int current_core = 0;
+
+// Everything that plays an interrupt (GPIO edges, tick hooks) runs under this lock
+static pthread_mutex_t interrupt_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+static void cond_init_monotonic(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void deadline_after(TickType_t ticks, struct timespec *deadline)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    uint64_t ns = (uint64_t)pdTICKS_TO_MS(ticks) * 1000000ULL + deadline->tv_nsec;
+    deadline->tv_sec += ns / 1000000000ULL;
+    deadline->tv_nsec = ns % 1000000000ULL;
+}
+
+// Waits on cond until woken or the ticks run out. Returns false on timeout.
+static bool cond_wait_ticks(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks,
+                            const struct timespec *deadline)
+{
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+//
+// Critical sections and interrupt masking
+//
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    pthread_mutex_lock(&mux->lock);
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    pthread_mutex_unlock(&mux->lock);
+}
+
+void portMUX_INITIALIZE(portMUX_TYPE *mux)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mux->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+UBaseType_t xPortSetInterruptMaskFromISR(void)
+{
+    pthread_mutex_lock(&interrupt_lock);
+    return 0;
+}
+
+void vPortClearInterruptMaskFromISR(UBaseType_t state)
+{
+    (void)state;
+    pthread_mutex_unlock(&interrupt_lock);
+}
+
+//
+// Cores and ticks
+//
+
+void host_set_core(int core)
+{
+    current_core = (core >= 0 && core < portNUM_PROCESSORS) ? core : 0;
+}
+
+BaseType_t xPortGetCoreID(void)
+{
+    return current_core;
+}
+
+int esp_cpu_get_core_id(void)
+{
+    return current_core;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    if (host_clock_is_virtual()) return pdMS_TO_TICKS(esp_timer_get_time() / 1000);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return pdMS_TO_TICKS((uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void *arg)
+{
+    if (cpu_id >= portNUM_PROCESSORS) return ESP_ERR_INVALID_ARG;
+    int saved = current_core;
+    host_set_core(cpu_id);
+    func(arg);
+    host_set_core(saved);
+    return ESP_OK;
+}
+
+#define MAX_TICK_HOOKS 4
+
+static esp_freertos_tick_cb_t tick_hooks[portNUM_PROCESSORS][MAX_TICK_HOOKS];
+static pthread_mutex_t tick_hooks_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool tick_thread_started = false;
+
+static void *tick_thread(void *arg)
+{
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (1) {
+        next.tv_nsec += 1000000000L / configTICK_RATE_HZ;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        pthread_mutex_lock(&tick_hooks_lock);
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            host_set_core(core);
+            for (int i = 0; i < MAX_TICK_HOOKS && tick_hooks[core][i] != NULL; i++) {
+                UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+                tick_hooks[core][i]();
+                portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+            }
+        }
+        pthread_mutex_unlock(&tick_hooks_lock);
+    }
+    return NULL;
+}
+
+esp_err_t esp_register_freertos_tick_hook_for_cpu(esp_freertos_tick_cb_t new_tick_cb, int cpuid)
+{
+    if (cpuid < 0 || cpuid >= portNUM_PROCESSORS) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = ESP_ERR_NO_MEM;
+    pthread_mutex_lock(&tick_hooks_lock);
+    for (int i = 0; i < MAX_TICK_HOOKS; i++) {
+        if (tick_hooks[cpuid][i] == NULL) {
+            tick_hooks[cpuid][i] = new_tick_cb;
+            err = ESP_OK;
+            break;
+        }
+    }
+    if (err == ESP_OK && !tick_thread_started) {
+        pthread_t thread;
+        tick_thread_started = pthread_create(&thread, NULL, tick_thread, NULL) == 0;
+        if (tick_thread_started) pthread_detach(thread);
+    }
+    pthread_mutex_unlock(&tick_hooks_lock);
+    return err;
+}
+
+//
+// Tasks
+//
+
+static struct host_task *task_alloc(const char *name, int core)
+{
+    struct host_task *task = calloc(1, sizeof(struct host_task));
+    if (task == NULL) return NULL;
+    snprintf(task->name, sizeof(task->name), "%s", name);
+    task->core = core;
+    pthread_mutex_init(&task->lock, NULL);
+    cond_init_monotonic(&task->cond);
+    return task;
+}
+
+static void *task_entry(void *arg)
+{
+    struct host_task *task = arg;
+    current_task = task;
+    host_set_core(task->core);
+    task->function(task->arg);
+    ESP_LOGE(TAG, "Task %s returned without deleting itself", task->name);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *created, BaseType_t core_id)
+{
+    struct host_task *task = task_alloc(name, core_id == tskNO_AFFINITY ? 0 : core_id);
+    if (task == NULL) return pdFAIL;
+    task->function = function;
+    task->arg = arg;
+
+    // The firmware sizes stacks for its own code; libc on the host wants more
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, stack_depth < 65536 ? 65536 : stack_depth);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&task->thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        free(task);
+        return pdFAIL;
+    }
+
+    pthread_setname_np(task->thread, task->name);
+    if (created != NULL) *created = task;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *created)
+{
+    return xTaskCreatePinnedToCore(function, name, stack_depth, arg, priority, created, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != current_task) {
+        ESP_LOGE(TAG, "Deleting another task is not supported on the host");
+        abort();
+    }
+    // The handle stays allocated, other tasks may still hold it
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (host_clock_is_virtual()) {
+        host_clock_advance_ns((uint64_t)pdTICKS_TO_MS(ticks) * 1000000);
+        return;
+    }
+    struct timespec deadline;
+    deadline_after(ticks, &deadline);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    if (current_task == NULL) {
+        char name[16] = "thread";
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        current_task = task_alloc(name, current_core);
+        current_task->thread = pthread_self();
+    }
+    return current_task;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+    return task->name;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken != NULL) *higher_priority_task_woken = pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    deadline_after(ticks_to_wait, &deadline);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && ticks_to_wait > 0) {
+        if (!cond_wait_ticks(&task->cond, &task->lock, ticks_to_wait, &deadline)) break;
+    }
+    uint32_t value = task->notify;
+    if (value > 0) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+//
+// Queues and semaphores
+//
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t *items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    if (length == 0) return NULL;
+    struct host_queue *queue = calloc(1, sizeof(struct host_queue));
+    if (queue == NULL) return NULL;
+    if (item_size > 0) {
+        queue->items = malloc((size_t)length * item_size);
+        if (queue->items == NULL) {
+            free(queue);
+            return NULL;
+        }
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init_monotonic(&queue->not_empty);
+    cond_init_monotonic(&queue->not_full);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue == NULL) return;
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue->items);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    deadline_after(ticks_to_wait, &deadline);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (ticks_to_wait == 0 || !cond_wait_ticks(&queue->not_full, &queue->lock, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return errQUEUE_FULL;
+        }
+    }
+    if (queue->item_size > 0) {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + (size_t)tail * queue->item_size, item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    return xQueueSend(queue, item, ticks_to_wait);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_priority_task_woken)
+{
+    if (higher_priority_task_woken != NULL) *higher_priority_task_woken = pdFALSE;
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    deadline_after(ticks_to_wait, &deadline);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (ticks_to_wait == 0 || !cond_wait_ticks(&queue->not_empty, &queue->lock, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return errQUEUE_EMPTY;
+        }
+    }
+    if (queue->item_size > 0) {
+        memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void *item, BaseType_t *higher_priority_task_woken)
+{
+    if (higher_priority_task_woken != NULL) *higher_priority_task_woken = pdFALSE;
+    return xQueueReceive(queue, item, 0);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t spaces = queue->length - queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return spaces;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    SemaphoreHandle_t sem = xQueueCreate(max_count, 0);
+    if (sem != NULL) sem->count = initial_count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+//
+// Event groups
+//
+
+struct host_event_group {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    EventBits_t bits;
+};
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    struct host_event_group *group = calloc(1, sizeof(struct host_event_group));
+    if (group == NULL) return NULL;
+    pthread_mutex_init(&group->lock, NULL);
+    cond_init_monotonic(&group->changed);
+    return group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t now = group->bits;
+    pthread_cond_broadcast(&group->changed);
+    pthread_mutex_unlock(&group->lock);
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    pthread_mutex_lock(&group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    pthread_mutex_lock(&group->lock);
+    EventBits_t bits = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    deadline_after(ticks_to_wait, &deadline);
+
+    pthread_mutex_lock(&group->lock);
+    while (1) {
+        EventBits_t set = group->bits & bits;
+        bool done = wait_for_all ? set == bits : set != 0;
+        if (done || ticks_to_wait == 0 ||
+            !cond_wait_ticks(&group->changed, &group->lock, ticks_to_wait, &deadline)) {
+            break;
+        }
+    }
+    EventBits_t result = group->bits;
+    EventBits_t set = result & bits;
+    if (clear_on_exit && (wait_for_all ? set == bits : set != 0)) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return result;
+}
@@ -0,0 +1,130 @@
+#include <pthread.h>
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "host.h"
+
+typedef struct {
+    gpio_mode_t mode;
+    gpio_int_type_t intr_type;
+    uint32_t level;             // Driven level for outputs
+    gpio_isr_t isr;
+    void *isr_arg;
+} host_gpio_t;
+
+static host_gpio_t pins[GPIO_NUM_MAX];
+static pthread_mutex_t gpio_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static bool isr_service_installed = false;
+static uint32_t air_level = 0;
+static host_gpio_hook_t level_hook = NULL;
+static uint32_t set_level_cost_ns = 0;
+
+void host_gpio_set_hook(host_gpio_hook_t hook)
+{
+    level_hook = hook;
+}
+
+void host_gpio_set_level_cost(uint32_t ns)
+{
+    set_level_cost_ns = ns;
+}
+
+static bool valid_pin(gpio_num_t gpio_num)
+{
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    pthread_mutex_lock(&gpio_lock);
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if (!(config->pin_bit_mask & (1ULL << pin))) continue;
+        pins[pin].mode = config->mode;
+        pins[pin].intr_type = config->intr_type;
+    }
+    pthread_mutex_unlock(&gpio_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags)
+{
+    pthread_mutex_lock(&gpio_lock);
+    esp_err_t err = isr_service_installed ? ESP_ERR_INVALID_STATE : ESP_OK;
+    isr_service_installed = true;
+    pthread_mutex_unlock(&gpio_lock);
+    return err;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args)
+{
+    if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    if (!isr_service_installed) return ESP_ERR_INVALID_STATE;
+    pthread_mutex_lock(&gpio_lock);
+    pins[gpio_num].isr = isr_handler;
+    pins[gpio_num].isr_arg = args;
+    pthread_mutex_unlock(&gpio_lock);
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num)
+{
+    if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&gpio_lock);
+    pins[gpio_num].isr = NULL;
+    pins[gpio_num].isr_arg = NULL;
+    pthread_mutex_unlock(&gpio_lock);
+    return ESP_OK;
+}
+
+static bool edge_fires(gpio_int_type_t type, uint32_t level)
+{
+    switch (type) {
+        case GPIO_INTR_ANYEDGE:     return true;
+        case GPIO_INTR_POSEDGE:     return level != 0;
+        case GPIO_INTR_NEGEDGE:     return level == 0;
+        case GPIO_INTR_HIGH_LEVEL:  return level != 0;
+        case GPIO_INTR_LOW_LEVEL:   return level == 0;
+        default:                    return false;
+    }
+}
+
+// The air carries a signal while any output is high. Every change is an edge on
+// every input, handled right away on the calling thread like an interrupt would be.
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (!valid_pin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    level = level ? 1 : 0;
+
+    pthread_mutex_lock(&gpio_lock);
+    if (host_clock_is_virtual()) host_clock_advance_ns(set_level_cost_ns);
+    if (level_hook != NULL) level_hook(gpio_num, level, esp_timer_get_time());
+    pins[gpio_num].level = level;
+    uint32_t air = 0;
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        if ((pins[pin].mode & GPIO_MODE_OUTPUT) && pins[pin].level) air = 1;
+    }
+    bool changed = air != air_level;
+    air_level = air;
+
+    if (changed) {
+        for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+            host_gpio_t *p = &pins[pin];
+            if (p->isr == NULL || !(p->mode & GPIO_MODE_INPUT) || !edge_fires(p->intr_type, air)) continue;
+            UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+            p->isr(p->isr_arg);
+            portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+        }
+    }
+    pthread_mutex_unlock(&gpio_lock);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (!valid_pin(gpio_num)) return 0;
+    pthread_mutex_lock(&gpio_lock);
+    int level = (pins[gpio_num].mode & GPIO_MODE_OUTPUT) ? pins[gpio_num].level : air_level;
+    pthread_mutex_unlock(&gpio_lock);
+    return level;
+}
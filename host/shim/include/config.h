@@ -0,0 +1,16 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "driver/gpio.h"
+
+// Configuration for the host build. A main/config.h next to the firmware sources
+// takes precedence (the compiler looks next to main.c first), its pins work here too.
+
+#define WIFI_SSID      "host"
+#define WIFI_PASS      ""
+#define MAX_RETRY      10
+
+#define RF_RECEIVER_PIN    GPIO_NUM_4
+#define RF_TRANSMITTER_PIN GPIO_NUM_2
+
+#endif // CONFIG_H
@@ -0,0 +1,10 @@
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+// Placement attributes mean nothing off target
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define RTC_DATA_ATTR
+
+#endif // ESP_ATTR_H
@@ -0,0 +1,14 @@
+#ifndef ESP_CPU_H
+#define ESP_CPU_H
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+// A 240 MHz counter derived from the monotonic clock, wrapping like the real one
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+// The core the calling task was pinned to, 0 for everything else
+int esp_cpu_get_core_id(void);
+
+#endif // ESP_CPU_H
@@ -0,0 +1,35 @@
+#ifndef ESP_EVENT_H
+#define ESP_EVENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// The default event loop: one thread delivering posted events in order
+
+typedef const char *esp_event_base_t;
+typedef void *esp_event_handler_instance_t;
+typedef void (*esp_event_handler_t)(void *event_handler_arg, esp_event_base_t event_base,
+                                    int32_t event_id, void *event_data);
+
+#define ESP_EVENT_ANY_BASE  NULL
+#define ESP_EVENT_ANY_ID    -1
+
+#define ESP_EVENT_DECLARE_BASE(id) extern esp_event_base_t const id
+#define ESP_EVENT_DEFINE_BASE(id) esp_event_base_t const id = #id
+
+ESP_EVENT_DECLARE_BASE(WIFI_EVENT);
+ESP_EVENT_DECLARE_BASE(IP_EVENT);
+
+esp_err_t esp_event_loop_create_default(void);
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+                                              esp_event_handler_t event_handler, void *event_handler_arg,
+                                              esp_event_handler_instance_t *instance);
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg);
+// event_data is copied, handlers see the copy
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void *event_data,
+                         size_t event_data_size, TickType_t ticks_to_wait);
+
+#endif // ESP_EVENT_H
@@ -0,0 +1,11 @@
+#ifndef ESP_FREERTOS_HOOKS_H
+#define ESP_FREERTOS_HOOKS_H
+
+#include "esp_err.h"
+
+typedef void (*esp_freertos_tick_cb_t)(void);
+
+// Hooks run from a host thread once per tick, as if on the given core
+esp_err_t esp_register_freertos_tick_hook_for_cpu(esp_freertos_tick_cb_t new_tick_cb, int cpuid);
+
+#endif // ESP_FREERTOS_HOOKS_H
@@ -0,0 +1,12 @@
+#ifndef ESP_IPC_H
+#define ESP_IPC_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef void (*esp_ipc_func_t)(void *arg);
+
+// Runs func on the calling thread with the core id switched to cpu_id
+esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void *arg);
+
+#endif // ESP_IPC_H
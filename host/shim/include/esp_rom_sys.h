@@ -0,0 +1,9 @@
+#ifndef ESP_ROM_SYS_H
+#define ESP_ROM_SYS_H
+
+#include <stdint.h>
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void);
+void esp_rom_delay_us(uint32_t us);
+
+#endif // ESP_ROM_SYS_H
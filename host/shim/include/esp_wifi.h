@@ -0,0 +1,92 @@
+#ifndef ESP_WIFI_H
+#define ESP_WIFI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+
+// A station that always associates: esp_wifi_start posts STA_START, and
+// esp_wifi_connect posts STA_CONNECTED and then GOT_IP for 127.0.0.1.
+
+typedef struct {
+    int reserved;
+} wifi_init_config_t;
+
+#define WIFI_INIT_CONFIG_DEFAULT() { 0 }
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+} wifi_auth_mode_t;
+
+typedef struct {
+    wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    wifi_scan_threshold_t threshold;
+    uint16_t listen_interval;
+} wifi_sta_config_t;
+
+typedef union {
+    wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_IF_STA = 0,
+} wifi_interface_t;
+
+typedef enum {
+    WIFI_PS_NONE,
+    WIFI_PS_MIN_MODEM,
+    WIFI_PS_MAX_MODEM,
+} wifi_ps_type_t;
+
+typedef enum {
+    WIFI_EVENT_STA_START = 2,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+} wifi_event_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t ssid_len;
+    uint8_t bssid[6];
+    uint8_t reason;
+    int8_t rssi;
+} wifi_event_sta_disconnected_t;
+
+typedef enum {
+    IP_EVENT_STA_GOT_IP,
+    IP_EVENT_STA_LOST_IP,
+} ip_event_t;
+
+typedef struct {
+    esp_netif_t *esp_netif;
+    esp_netif_ip_info_t ip_info;
+    bool ip_changed;
+} ip_event_got_ip_t;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf);
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t *conf);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t *type);
+
+#endif // ESP_WIFI_H
@@ -0,0 +1,64 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_bit_defs.h"
+
+// FreeRTOS on POSIX threads, enough of it for the firmware to run unchanged.
+// Tasks are threads, priorities are ignored and the kernel never preempts, so
+// timing is only as good as the host scheduler.
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define configTICK_RATE_HZ      CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS      (1000 / configTICK_RATE_HZ)
+#define portNUM_PROCESSORS      2
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks)    ((uint32_t)(((uint64_t)(ticks) * 1000) / configTICK_RATE_HZ))
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdFAIL                  pdFALSE
+#define pdPASS                  pdTRUE
+#define errQUEUE_EMPTY          ((BaseType_t)0)
+#define errQUEUE_FULL           ((BaseType_t)0)
+
+// Critical sections are recursive mutexes. Masking interrupts takes one lock
+// shared by everything that pretends to be an interrupt (GPIO edges, tick hooks).
+typedef struct {
+    pthread_mutex_t lock;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP }
+
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
+void portMUX_INITIALIZE(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)      vPortExitCritical(mux)
+#define taskENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+
+UBaseType_t xPortSetInterruptMaskFromISR(void);
+void vPortClearInterruptMaskFromISR(UBaseType_t state);
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()       xPortSetInterruptMaskFromISR()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(state) vPortClearInterruptMaskFromISR(state)
+#define portYIELD_FROM_ISR(...)                 ((void)0)
+
+BaseType_t xPortGetCoreID(void);
+TickType_t xTaskGetTickCount(void);
+
+#endif // FREERTOS_H
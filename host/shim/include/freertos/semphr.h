@@ -0,0 +1,20 @@
+#ifndef FREERTOS_SEMPHR_H
+#define FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+
+#define xSemaphoreTake(sem, ticks)          xQueueReceive((sem), NULL, (ticks))
+#define xSemaphoreGive(sem)                 xQueueSend((sem), NULL, 0)
+#define xSemaphoreTakeFromISR(sem, woken)   xQueueReceiveFromISR((sem), NULL, (woken))
+#define xSemaphoreGiveFromISR(sem, woken)   xQueueSendFromISR((sem), NULL, (woken))
+#define uxSemaphoreGetCount(sem)            uxQueueMessagesWaiting(sem)
+#define vSemaphoreDelete(sem)               vQueueDelete(sem)
+
+#endif // FREERTOS_SEMPHR_H
@@ -0,0 +1,30 @@
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+#define tskIDLE_PRIORITY    ((UBaseType_t)0)
+#define tskNO_AFFINITY      ((BaseType_t)0x7FFFFFFF)
+
+// Stack depth and priority are accepted and ignored. Threads that were not
+// created here (main, the HTTP server) get a handle the first time they ask.
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *created, BaseType_t core_id);
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *created);
+
+// Only a task deleting itself is supported
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char *pcTaskGetName(TaskHandle_t task);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+
+#endif // FREERTOS_TASK_H
@@ -0,0 +1,57 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hooks into the host stand-ins for the programs in host/, the firmware never sees these
+
+#define HOST_HEAP_SIZE (300 * 1024)     // Roughly what an ESP32 has free after Wi-Fi starts
+
+typedef struct {
+    uint64_t allocs;            // malloc, calloc and realloc calls that returned memory
+    uint64_t frees;
+    uint64_t alloc_bytes;       // Requested by those calls
+    int64_t live_bytes;         // Allocated and not yet freed
+    int64_t peak_live_bytes;
+} host_alloc_stats_t;
+
+// Counts every allocation made by the firmware, the shim and cJSON, from any thread
+void host_alloc_get_stats(host_alloc_stats_t *stats);
+
+// Runs app_main and waits up to timeout_ms for the web server to listen.
+// Returns the port it listens on, 0 on timeout.
+uint16_t host_boot(uint32_t timeout_ms);
+
+// Port the web server listens on, 0 before it started
+uint16_t host_http_port(void);
+
+// Sets the core id the calling thread reports (trace rings, core pinning)
+void host_set_core(int core);
+
+// Virtual clock: esp_timer_get_time stops following the host clock and only moves
+// when something waits (esp_rom_delay_us, ets_delay_us, vTaskDelay) or when it is
+// advanced by hand. Meant for single-threaded simulations, not a booted firmware.
+void host_clock_set_virtual(bool enabled);
+bool host_clock_is_virtual(void);
+void host_clock_advance_ns(uint64_t ns);
+
+// Called on every gpio_set_level, with the time the level is driven, before any
+// input pin sees the edge
+typedef void (*host_gpio_hook_t)(gpio_num_t pin, uint32_t level, int64_t time_us);
+void host_gpio_set_hook(host_gpio_hook_t hook);
+
+// Virtual time one gpio_set_level call takes, 0 by default
+void host_gpio_set_level_cost(uint32_t ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_H
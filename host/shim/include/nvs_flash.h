@@ -0,0 +1,11 @@
+#ifndef NVS_FLASH_H
+#define NVS_FLASH_H
+
+#include "nvs.h"
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+esp_err_t nvs_flash_init_partition(const char *partition_label);
+esp_err_t nvs_flash_erase_partition(const char *partition_label);
+
+#endif // NVS_FLASH_H
@@ -0,0 +1,9 @@
+#ifndef ETS_SYS_H
+#define ETS_SYS_H
+
+#include <stdint.h>
+
+// Busy-waits like the ROM routine, transmit timing depends on it
+void ets_delay_us(uint32_t us);
+
+#endif // ETS_SYS_H
@@ -0,0 +1,13 @@
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+// The options the firmware reads, as set in sdkconfig.defaults and the Kconfig defaults
+
+#define CONFIG_RF_TRACE 1
+#define CONFIG_RF_TRACE_EVENTS 512
+#define CONFIG_HTTPD_MAX_URI_LEN 512
+#define CONFIG_HTTPD_MAX_REQ_HDR_LEN 1024
+#define CONFIG_LWIP_MAX_SOCKETS 16
+#define CONFIG_FREERTOS_HZ 1000
+
+#endif // SDKCONFIG_H
@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_netif_sntp.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+
+static const char *TAG = "HOST_NET";
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+
+//
+// Default event loop
+//
+
+#define MAX_EVENT_HANDLERS 8
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} event_handler_entry_t;
+
+typedef struct posted_event {
+    esp_event_base_t base;
+    int32_t id;
+    void *data;
+    struct posted_event *next;
+} posted_event_t;
+
+static event_handler_entry_t handlers[MAX_EVENT_HANDLERS];
+static int handler_count = 0;
+static posted_event_t *queue_head = NULL;
+static posted_event_t *queue_tail = NULL;
+static bool loop_created = false;
+static pthread_mutex_t loop_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t loop_posted = PTHREAD_COND_INITIALIZER;
+
+static void *event_loop_thread(void *arg)
+{
+    pthread_setname_np(pthread_self(), "sys_evt");
+    while (1) {
+        pthread_mutex_lock(&loop_lock);
+        while (queue_head == NULL) pthread_cond_wait(&loop_posted, &loop_lock);
+        posted_event_t *event = queue_head;
+        queue_head = event->next;
+        if (queue_head == NULL) queue_tail = NULL;
+        // Handlers only get added during boot, a snapshot keeps the lock out of their way
+        event_handler_entry_t snapshot[MAX_EVENT_HANDLERS];
+        int count = handler_count;
+        memcpy(snapshot, handlers, sizeof(snapshot));
+        pthread_mutex_unlock(&loop_lock);
+
+        for (int i = 0; i < count; i++) {
+            if (snapshot[i].base != ESP_EVENT_ANY_BASE && snapshot[i].base != event->base) continue;
+            if (snapshot[i].id != ESP_EVENT_ANY_ID && snapshot[i].id != event->id) continue;
+            snapshot[i].handler(snapshot[i].arg, event->base, event->id, event->data);
+        }
+        free(event->data);
+        free(event);
+    }
+    return NULL;
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    pthread_mutex_lock(&loop_lock);
+    bool created = loop_created;
+    loop_created = true;
+    pthread_mutex_unlock(&loop_lock);
+    if (created) return ESP_ERR_INVALID_STATE;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, event_loop_thread, NULL) != 0) return ESP_FAIL;
+    pthread_detach(thread);
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    pthread_mutex_lock(&loop_lock);
+    if (handler_count == MAX_EVENT_HANDLERS) {
+        pthread_mutex_unlock(&loop_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    handlers[handler_count++] = (event_handler_entry_t){ event_base, event_id, event_handler, event_handler_arg };
+    pthread_mutex_unlock(&loop_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+                                              esp_event_handler_t event_handler, void *event_handler_arg,
+                                              esp_event_handler_instance_t *instance)
+{
+    esp_err_t err = esp_event_handler_register(event_base, event_id, event_handler, event_handler_arg);
+    if (err == ESP_OK && instance != NULL) *instance = &handlers[handler_count - 1];
+    return err;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void *event_data,
+                         size_t event_data_size, TickType_t ticks_to_wait)
+{
+    posted_event_t *event = calloc(1, sizeof(posted_event_t));
+    if (event == NULL) return ESP_ERR_NO_MEM;
+    event->base = event_base;
+    event->id = event_id;
+    if (event_data != NULL && event_data_size > 0) {
+        event->data = malloc(event_data_size);
+        if (event->data == NULL) {
+            free(event);
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(event->data, event_data, event_data_size);
+    }
+
+    pthread_mutex_lock(&loop_lock);
+    if (!loop_created) {
+        pthread_mutex_unlock(&loop_lock);
+        free(event->data);
+        free(event);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (queue_tail != NULL) {
+        queue_tail->next = event;
+    } else {
+        queue_head = event;
+    }
+    queue_tail = event;
+    pthread_cond_signal(&loop_posted);
+    pthread_mutex_unlock(&loop_lock);
+    return ESP_OK;
+}
+
+//
+// Network interface
+//
+
+struct esp_netif_obj {
+    esp_netif_ip_info_t ip_info;
+};
+
+static struct esp_netif_obj sta_netif;
+
+esp_err_t esp_netif_init(void)
+{
+    sta_netif.ip_info.ip.addr = htonl(INADDR_LOOPBACK);
+    sta_netif.ip_info.netmask.addr = htonl(0xFF000000);
+    sta_netif.ip_info.gw.addr = htonl(INADDR_LOOPBACK);
+    return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void)
+{
+    return &sta_netif;
+}
+
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key)
+{
+    return strcmp(if_key, "WIFI_STA_DEF") == 0 ? &sta_netif : NULL;
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t *esp_netif, esp_netif_ip_info_t *ip_info)
+{
+    if (esp_netif == NULL || ip_info == NULL) return ESP_ERR_INVALID_ARG;
+    *ip_info = esp_netif->ip_info;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_sntp_init(const esp_sntp_config_t *config)
+{
+    ESP_LOGI(TAG, "SNTP (%s): using the host clock", config->servers[0]);
+    return ESP_OK;
+}
+
+//
+// Wi-Fi station
+//
+
+static wifi_config_t sta_config;
+static wifi_ps_type_t power_save = WIFI_PS_MIN_MODEM;
+static bool wifi_started = false;
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    return mode == WIFI_MODE_STA ? ESP_OK : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    sta_config = *conf;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    *conf = sta_config;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    wifi_started = true;
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, 0);
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    if (!wifi_started) return ESP_ERR_INVALID_STATE;
+    esp_err_t err = esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, NULL, 0, 0);
+    if (err != ESP_OK) return err;
+
+    ip_event_got_ip_t got_ip = {
+        .esp_netif = &sta_netif,
+        .ip_info = sta_netif.ip_info,
+        .ip_changed = true,
+    };
+    return esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), 0);
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, NULL, 0, 0);
+}
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+    power_save = type;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_ps(wifi_ps_type_t *type)
+{
+    *type = power_save;
+    return ESP_OK;
+}
@@ -0,0 +1,367 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include "nvs.h"
+#include "nvs_flash.h"
+
+// Namespaces get handles 1..MAX_NAMESPACES, entries are a flat list in RAM. Each
+// namespace belongs to one of the NVS partitions below.
+
+#define MAX_NAMESPACES  16
+#define MAX_ENTRIES     256
+
+typedef struct {
+    uint8_t ns;                 // Namespace index + 1, 0 for a free slot
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    nvs_type_t type;
+    size_t length;
+    uint8_t *data;
+} nvs_entry_t;
+
+typedef struct {
+    uint8_t part;               // Index in nvs_partitions
+    char name[NVS_NS_NAME_MAX_SIZE];
+} nvs_namespace_t;
+
+struct nvs_opaque_iterator_t {
+    uint8_t part;
+    uint8_t ns;                 // 0 matches every namespace of the partition
+    nvs_type_t type;
+    int index;
+};
+
+// The NVS partitions of partitions.csv
+static const char *const nvs_partitions[] = { NVS_DEFAULT_PART_NAME, "library" };
+#define NUM_NVS_PARTITIONS (sizeof(nvs_partitions) / sizeof(nvs_partitions[0]))
+
+static nvs_namespace_t namespaces[MAX_NAMESPACES];
+static nvs_entry_t entries[MAX_ENTRIES];
+static bool initialized[NUM_NVS_PARTITIONS];
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Returns the index in nvs_partitions, -1 for a label that is not in the table
+static int find_partition(const char *label)
+{
+    for (size_t i = 0; i < NUM_NVS_PARTITIONS; i++) {
+        if (strcmp(nvs_partitions[i], label) == 0) return i;
+    }
+    return -1;
+}
+
+esp_err_t nvs_flash_init_partition(const char *partition_label)
+{
+    int part = find_partition(partition_label);
+    if (part < 0) return ESP_ERR_NOT_FOUND;
+    pthread_mutex_lock(&nvs_lock);
+    initialized[part] = true;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return nvs_flash_init_partition(NVS_DEFAULT_PART_NAME);
+}
+
+esp_err_t nvs_flash_erase_partition(const char *partition_label)
+{
+    int part = find_partition(partition_label);
+    if (part < 0) return ESP_ERR_NOT_FOUND;
+    pthread_mutex_lock(&nvs_lock);
+    for (int n = 0; n < MAX_NAMESPACES; n++) {
+        if (namespaces[n].name[0] == '\0' || namespaces[n].part != part) continue;
+        for (int i = 0; i < MAX_ENTRIES; i++) {
+            if (entries[i].ns != n + 1) continue;
+            free(entries[i].data);
+            memset(&entries[i], 0, sizeof(entries[i]));
+        }
+        memset(&namespaces[n], 0, sizeof(namespaces[n]));
+    }
+    initialized[part] = false;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    return nvs_flash_erase_partition(NVS_DEFAULT_PART_NAME);
+}
+
+// Called with nvs_lock held. Returns the namespace index + 1, 0 when absent and not created.
+static uint8_t find_namespace(int part, const char *name, bool create)
+{
+    for (int i = 0; i < MAX_NAMESPACES; i++) {
+        if (namespaces[i].name[0] != '\0' && namespaces[i].part == part && strcmp(namespaces[i].name, name) == 0) {
+            return i + 1;
+        }
+    }
+    if (!create) return 0;
+    for (int i = 0; i < MAX_NAMESPACES; i++) {
+        if (namespaces[i].name[0] == '\0') {
+            namespaces[i].part = part;
+            strncpy(namespaces[i].name, name, NVS_NS_NAME_MAX_SIZE - 1);
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    return nvs_open_from_partition(NVS_DEFAULT_PART_NAME, namespace_name, open_mode, out_handle);
+}
+
+esp_err_t nvs_open_from_partition(const char *part_name, const char *namespace_name, nvs_open_mode_t open_mode,
+                                  nvs_handle_t *out_handle)
+{
+    if (strlen(namespace_name) >= NVS_NS_NAME_MAX_SIZE) return ESP_ERR_NVS_KEY_TOO_LONG;
+    int part = find_partition(part_name);
+
+    pthread_mutex_lock(&nvs_lock);
+    esp_err_t err = ESP_OK;
+    if (part < 0) {
+        err = ESP_ERR_NVS_PART_NOT_FOUND;
+    } else if (!initialized[part]) {
+        err = ESP_ERR_NVS_NOT_INITIALIZED;
+    } else {
+        uint8_t ns = find_namespace(part, namespace_name, open_mode == NVS_READWRITE);
+        if (ns == 0) {
+            err = open_mode == NVS_READWRITE ? ESP_ERR_NVS_NOT_ENOUGH_SPACE : ESP_ERR_NVS_NOT_FOUND;
+        } else {
+            // Read-only handles are marked in the top bit
+            *out_handle = ns | (open_mode == NVS_READONLY ? 0x80000000u : 0);
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    return ESP_OK;
+}
+
+static uint8_t handle_ns(nvs_handle_t handle)
+{
+    return handle & 0xff;
+}
+
+// Called with nvs_lock held
+static nvs_entry_t *find_entry(uint8_t ns, const char *key)
+{
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        if (entries[i].ns == ns && strcmp(entries[i].key, key) == 0) return &entries[i];
+    }
+    return NULL;
+}
+
+static esp_err_t set_value(nvs_handle_t handle, const char *key, nvs_type_t type, const void *value, size_t length)
+{
+    if (handle & 0x80000000u) return ESP_ERR_NVS_READ_ONLY;
+    if (handle_ns(handle) == 0 || handle_ns(handle) > MAX_NAMESPACES) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (strlen(key) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_NVS_KEY_TOO_LONG;
+
+    uint8_t *copy = malloc(length > 0 ? length : 1);
+    if (copy == NULL) return ESP_ERR_NO_MEM;
+    memcpy(copy, value, length);
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = find_entry(handle_ns(handle), key);
+    if (entry == NULL) {
+        for (int i = 0; i < MAX_ENTRIES && entry == NULL; i++) {
+            if (entries[i].ns == 0) entry = &entries[i];
+        }
+        if (entry == NULL) {
+            pthread_mutex_unlock(&nvs_lock);
+            free(copy);
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+        entry->ns = handle_ns(handle);
+        strcpy(entry->key, key);
+    }
+    free(entry->data);
+    entry->type = type;
+    entry->data = copy;
+    entry->length = length;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+// Copies a value out. With variable length types, out NULL only reports the length.
+static esp_err_t get_value(nvs_handle_t handle, const char *key, nvs_type_t type, void *out, size_t *length)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = find_entry(handle_ns(handle), key);
+    esp_err_t err = ESP_OK;
+    if (entry == NULL) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else if (entry->type != type) {
+        err = ESP_ERR_NVS_TYPE_MISMATCH;
+    } else if (out == NULL) {
+        *length = entry->length;
+    } else if (*length < entry->length) {
+        *length = entry->length;
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out, entry->data, entry->length);
+        *length = entry->length;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    if (handle & 0x80000000u) return ESP_ERR_NVS_READ_ONLY;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = find_entry(handle_ns(handle), key);
+    if (entry != NULL) {
+        free(entry->data);
+        memset(entry, 0, sizeof(*entry));
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return entry != NULL ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    if (handle & 0x80000000u) return ESP_ERR_NVS_READ_ONLY;
+    pthread_mutex_lock(&nvs_lock);
+    for (int i = 0; i < MAX_ENTRIES; i++) {
+        if (entries[i].ns == handle_ns(handle)) {
+            free(entries[i].data);
+            memset(&entries[i], 0, sizeof(entries[i]));
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    return set_value(handle, key, NVS_TYPE_U8, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    return set_value(handle, key, NVS_TYPE_U32, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_i64(nvs_handle_t handle, const char *key, int64_t value)
+{
+    return set_value(handle, key, NVS_TYPE_I64, &value, sizeof(value));
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    return set_value(handle, key, NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return set_value(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value)
+{
+    size_t length = sizeof(*out_value);
+    return get_value(handle, key, NVS_TYPE_U8, out_value, &length);
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value)
+{
+    size_t length = sizeof(*out_value);
+    return get_value(handle, key, NVS_TYPE_U32, out_value, &length);
+}
+
+esp_err_t nvs_get_i64(nvs_handle_t handle, const char *key, int64_t *out_value)
+{
+    size_t length = sizeof(*out_value);
+    return get_value(handle, key, NVS_TYPE_I64, out_value, &length);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    return get_value(handle, key, NVS_TYPE_STR, out_value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return get_value(handle, key, NVS_TYPE_BLOB, out_value, length);
+}
+
+// Called with nvs_lock held. Moves the iterator to the next match at or after index.
+static bool iterator_seek(struct nvs_opaque_iterator_t *it, int index)
+{
+    for (; index < MAX_ENTRIES; index++) {
+        nvs_entry_t *entry = &entries[index];
+        if (entry->ns == 0 || namespaces[entry->ns - 1].part != it->part) continue;
+        if (it->ns != 0 && entry->ns != it->ns) continue;
+        if (it->type != NVS_TYPE_ANY && entry->type != it->type) continue;
+        it->index = index;
+        return true;
+    }
+    return false;
+}
+
+esp_err_t nvs_entry_find(const char *part_name, const char *namespace_name, nvs_type_t type,
+                         nvs_iterator_t *output_iterator)
+{
+    *output_iterator = NULL;
+    int part = find_partition(part_name);
+    if (part < 0) return ESP_ERR_NVS_NOT_FOUND;
+    struct nvs_opaque_iterator_t *it = calloc(1, sizeof(*it));
+    if (it == NULL) return ESP_ERR_NO_MEM;
+    it->part = part;
+    it->type = type;
+
+    pthread_mutex_lock(&nvs_lock);
+    bool found = false;
+    if (namespace_name == NULL || (it->ns = find_namespace(part, namespace_name, false)) != 0) {
+        found = iterator_seek(it, 0);
+    }
+    pthread_mutex_unlock(&nvs_lock);
+
+    if (!found) {
+        free(it);
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *output_iterator = it;
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_next(nvs_iterator_t *iterator)
+{
+    pthread_mutex_lock(&nvs_lock);
+    bool found = iterator_seek(*iterator, (*iterator)->index + 1);
+    pthread_mutex_unlock(&nvs_lock);
+
+    if (!found) {
+        free(*iterator);
+        *iterator = NULL;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_info(const nvs_iterator_t iterator, nvs_entry_info_t *out_info)
+{
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = &entries[iterator->index];
+    memset(out_info, 0, sizeof(*out_info));
+    strncpy(out_info->namespace_name, namespaces[entry->ns - 1].name, NVS_NS_NAME_MAX_SIZE - 1);
+    strncpy(out_info->key, entry->key, NVS_KEY_NAME_MAX_SIZE - 1);
+    out_info->type = entry->type;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+void nvs_release_iterator(nvs_iterator_t iterator)
+{
+    free(iterator);
+}
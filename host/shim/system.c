@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/random.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "rom/ets_sys.h"
+#include "host.h"
+
+void app_main(void);
+
+static const char *TAG = "HOST";
+
+#define CPU_TICKS_PER_US 240
+
+//
+// Errors and logging
+//
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                    return "ESP_OK";
+        case ESP_FAIL:                  return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:  return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:       return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION:   return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_NOT_FINISHED:      return "ESP_ERR_NOT_FINISHED";
+        case ESP_ERR_NOT_ALLOWED:       return "ESP_ERR_NOT_ALLOWED";
+        case 0x1102:                    return "ESP_ERR_NVS_NOT_FOUND";
+        case 0x110c:                    return "ESP_ERR_NVS_INVALID_LENGTH";
+        case 0xb004:                    return "ESP_ERR_HTTPD_RESULT_TRUNC";
+        default:                        return "UNKNOWN ERROR";
+    }
+}
+
+static esp_log_level_t log_level = ESP_LOG_INFO;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t log_level_once = PTHREAD_ONCE_INIT;
+
+// Read on first use so programs can set it before booting the firmware
+static void log_level_from_env(void)
+{
+    // RF_HOST_LOG=E|W|I|D|V|N
+    const char *env = getenv("RF_HOST_LOG");
+    if (env == NULL) return;
+    switch (env[0]) {
+        case 'N': log_level = ESP_LOG_NONE; break;
+        case 'E': log_level = ESP_LOG_ERROR; break;
+        case 'W': log_level = ESP_LOG_WARN; break;
+        case 'I': log_level = ESP_LOG_INFO; break;
+        case 'D': log_level = ESP_LOG_DEBUG; break;
+        case 'V': log_level = ESP_LOG_VERBOSE; break;
+        default: break;
+    }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    pthread_once(&log_level_once, log_level_from_env);
+    log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    pthread_once(&log_level_once, log_level_from_env);
+    if (level > log_level) return;
+
+    static const char letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+    va_list args;
+    va_start(args, format);
+    pthread_mutex_lock(&log_lock);
+    fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(esp_timer_get_time() / 1000), tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    pthread_mutex_unlock(&log_lock);
+    va_end(args);
+}
+
+//
+// System
+//
+
+#define MAX_SHUTDOWN_HANDLERS 4
+static shutdown_handler_t shutdown_handlers[MAX_SHUTDOWN_HANDLERS];
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle)
+{
+    for (int i = 0; i < MAX_SHUTDOWN_HANDLERS; i++) {
+        if (shutdown_handlers[i] == NULL) {
+            shutdown_handlers[i] = handle;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void esp_restart(void)
+{
+    for (int i = MAX_SHUTDOWN_HANDLERS - 1; i >= 0; i--) {
+        if (shutdown_handlers[i] != NULL) shutdown_handlers[i]();
+    }
+    ESP_LOGI(TAG, "esp_restart: exiting");
+    exit(0);
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    host_alloc_stats_t stats;
+    host_alloc_get_stats(&stats);
+    return stats.live_bytes < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - stats.live_bytes : 0;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    host_alloc_stats_t stats;
+    host_alloc_get_stats(&stats);
+    return stats.peak_live_bytes < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - stats.peak_live_bytes : 0;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    if (caps & MALLOC_CAP_SPIRAM) return NULL;
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    if (caps & MALLOC_CAP_SPIRAM) return NULL;
+    return calloc(n, size);
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+uint32_t esp_random(void)
+{
+    uint32_t value;
+    esp_fill_random(&value, sizeof(value));
+    return value;
+}
+
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = getrandom(p, len, 0);
+        if (n <= 0) continue;
+        p += n;
+        len -= n;
+    }
+}
+
+//
+// CPU
+//
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ns = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    return (esp_cpu_cycle_count_t)(ns * CPU_TICKS_PER_US / 1000);
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void)
+{
+    return CPU_TICKS_PER_US;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    if (host_clock_is_virtual()) {
+        host_clock_advance_ns((uint64_t)us * 1000);
+        return;
+    }
+    int64_t until = esp_timer_get_time() + us;
+    while (esp_timer_get_time() < until) {
+    }
+}
+
+void ets_delay_us(uint32_t us)
+{
+    esp_rom_delay_us(us);
+}
+
+//
+// Partitions
+//
+
+#define FLASH_SECTOR_SIZE 4096
+
+typedef struct {
+    esp_partition_t info;
+    uint8_t *data;
+} host_partition_t;
+
+// The data partitions of partitions.csv the firmware opens by itself (NVS is emulated separately)
+static host_partition_t partitions[] = {
+    { .info = { ESP_PARTITION_TYPE_DATA, 0x40, 0x300000, 0x100000, FLASH_SECTOR_SIZE, "rflog", false } },
+};
+static pthread_mutex_t partitions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define NUM_PARTITIONS (sizeof(partitions) / sizeof(partitions[0]))
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    for (size_t i = 0; i < NUM_PARTITIONS; i++) {
+        host_partition_t *p = &partitions[i];
+        if (type != ESP_PARTITION_TYPE_ANY && p->info.type != type) continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && p->info.subtype != subtype) continue;
+        if (label != NULL && strcmp(p->info.label, label) != 0) continue;
+
+        pthread_mutex_lock(&partitions_lock);
+        if (p->data == NULL) {
+            p->data = malloc(p->info.size);
+            if (p->data != NULL) memset(p->data, 0xFF, p->info.size);
+        }
+        pthread_mutex_unlock(&partitions_lock);
+        return p->data != NULL ? &p->info : NULL;
+    }
+    return NULL;
+}
+
+static host_partition_t *partition_of(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    host_partition_t *p = (host_partition_t *)partition;
+    if (p == NULL || p->data == NULL || offset > p->info.size || size > p->info.size - offset) return NULL;
+    return p;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    host_partition_t *p = partition_of(partition, src_offset, size);
+    if (p == NULL) return ESP_ERR_INVALID_SIZE;
+    pthread_mutex_lock(&partitions_lock);
+    memcpy(dst, p->data + src_offset, size);
+    pthread_mutex_unlock(&partitions_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    host_partition_t *p = partition_of(partition, dst_offset, size);
+    if (p == NULL) return ESP_ERR_INVALID_SIZE;
+    const uint8_t *bytes = src;
+    pthread_mutex_lock(&partitions_lock);
+    for (size_t i = 0; i < size; i++) {
+        p->data[dst_offset + i] &= bytes[i];
+    }
+    pthread_mutex_unlock(&partitions_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    host_partition_t *p = partition_of(partition, offset, size);
+    if (p == NULL) return ESP_ERR_INVALID_SIZE;
+    if (offset % FLASH_SECTOR_SIZE != 0 || size % FLASH_SECTOR_SIZE != 0) return ESP_ERR_INVALID_SIZE;
+    pthread_mutex_lock(&partitions_lock);
+    memset(p->data + offset, 0xFF, size);
+    pthread_mutex_unlock(&partitions_lock);
+    return ESP_OK;
+}
+
+//
+// Boot
+//
+
+uint16_t host_boot(uint32_t timeout_ms)
+{
+    app_main();
+
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (host_http_port() == 0) {
+        if (esp_timer_get_time() > deadline) return 0;
+        usleep(1000);
+    }
+    return host_http_port();
+}
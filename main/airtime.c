@@ -0,0 +1,231 @@
+#include "airtime.h"
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "config.h"
+
+static const char *TAG = "AIRTIME";
+
+// Defaults follow the usual 433.05-434.79 MHz SRD limit: 10 % duty cycle over one hour
+#ifndef AIRTIME_DUTY_PERMILLE
+#define AIRTIME_DUTY_PERMILLE 100
+#endif
+#ifndef AIRTIME_WINDOW_S
+#define AIRTIME_WINDOW_S 3600
+#endif
+#ifndef AIRTIME_POLICY
+#define AIRTIME_POLICY AIRTIME_SHORTEN
+#endif
+#ifndef AIRTIME_MAX_DEFER_MS
+#define AIRTIME_MAX_DEFER_MS 10000
+#endif
+
+_Static_assert(AIRTIME_DUTY_PERMILLE > 0 && AIRTIME_DUTY_PERMILLE <= 1000, "AIRTIME_DUTY_PERMILLE must be 1..1000");
+_Static_assert(AIRTIME_WINDOW_S >= AIRTIME_BUCKETS, "AIRTIME_WINDOW_S must be at least one second per bucket");
+_Static_assert((uint64_t)AIRTIME_WINDOW_S * 1000 * AIRTIME_DUTY_PERMILLE <= UINT32_MAX, "Airtime budget must fit in 32 bits");
+
+#define BUCKET_US   ((int64_t)AIRTIME_WINDOW_S * 1000000 / AIRTIME_BUCKETS)
+#define BUDGET_US   ((uint32_t)((uint64_t)AIRTIME_WINDOW_S * 1000 * AIRTIME_DUTY_PERMILLE))
+
+static SemaphoreHandle_t airtime_mutex = NULL;
+
+// Airtime granted per bucket, the window is the last AIRTIME_BUCKETS buckets
+static uint32_t buckets[AIRTIME_BUCKETS];
+static int64_t current_bucket = 0;  // esp_timer time / BUCKET_US
+static uint32_t used_us = 0;        // Sum of buckets
+
+static airtime_usage_t total;
+static airtime_signal_t signals[AIRTIME_SIGNALS_MAX];
+static int64_t signal_last_used[AIRTIME_SIGNALS_MAX];  // 0 = free entry
+
+// Expires the buckets that slid out of the window, called with airtime_mutex held
+static void advance(int64_t now)
+{
+    int64_t bucket = now / BUCKET_US;
+    int64_t steps = bucket - current_bucket;
+    if (steps > AIRTIME_BUCKETS) steps = AIRTIME_BUCKETS;
+
+    for (int64_t i = 1; i <= steps; i++) {
+        uint32_t *slot = &buckets[(current_bucket + i) % AIRTIME_BUCKETS];
+        used_us -= *slot;
+        *slot = 0;
+    }
+    current_bucket = bucket;
+}
+
+static airtime_usage_t *signal_usage(uint32_t code, uint8_t bit_length, uint8_t protocol, int64_t now)
+{
+    int victim = 0;
+    for (int i = 0; i < AIRTIME_SIGNALS_MAX; i++) {
+        airtime_signal_t *s = &signals[i];
+        if (signal_last_used[i] != 0 && s->code == code &&
+            s->bit_length == bit_length && s->protocol == protocol) {
+            signal_last_used[i] = now;
+            return &s->usage;
+        }
+        if (signal_last_used[i] < signal_last_used[victim]) {
+            victim = i;
+        }
+    }
+
+    airtime_signal_t *s = &signals[victim];
+    memset(s, 0, sizeof(*s));
+    s->code = code;
+    s->bit_length = bit_length;
+    s->protocol = protocol;
+    signal_last_used[victim] = now;
+    return &s->usage;
+}
+
+static void grant(airtime_usage_t *usage, int frames, uint32_t frame_us)
+{
+    uint32_t us = frames * frame_us;
+    buckets[current_bucket % AIRTIME_BUCKETS] += us;
+    used_us += us;
+
+    usage->frames += frames;
+    usage->airtime_us += us;
+    total.frames += frames;
+    total.airtime_us += us;
+}
+
+void airtime_init(void)
+{
+    airtime_mutex = xSemaphoreCreateMutex();
+    current_bucket = esp_timer_get_time() / BUCKET_US;
+
+    ESP_LOGI(TAG, "Duty cycle %d.%d%% over %ds (%lu ms of airtime), policy %s",
+             AIRTIME_DUTY_PERMILLE / 10, AIRTIME_DUTY_PERMILLE % 10, AIRTIME_WINDOW_S,
+             BUDGET_US / 1000, airtime_policy_to_string(AIRTIME_POLICY));
+}
+
+int airtime_acquire(uint32_t code, uint8_t bit_length, uint8_t protocol,
+                    uint32_t frame_us, int repeats)
+{
+    if (airtime_mutex == NULL || repeats <= 0) return repeats;
+
+    int64_t started = esp_timer_get_time();
+    bool deferred = false;
+
+    xSemaphoreTake(airtime_mutex, portMAX_DELAY);
+    airtime_usage_t *usage = signal_usage(code, bit_length, protocol, started);
+    usage->sends++;
+    total.sends++;
+
+    while (true) {
+        int64_t now = esp_timer_get_time();
+        advance(now);
+
+        uint32_t available = used_us < BUDGET_US ? BUDGET_US - used_us : 0;
+        if ((uint64_t)repeats * frame_us <= available) {
+            grant(usage, repeats, frame_us);
+            break;
+        }
+
+        if (AIRTIME_POLICY == AIRTIME_SHORTEN && frame_us <= available) {
+            repeats = available / frame_us;
+            grant(usage, repeats, frame_us);
+            usage->shortened++;
+            total.shortened++;
+            break;
+        }
+
+        // A burst bigger than the whole budget never fits, no point waiting for it
+        int64_t waited_ms = (now - started) / 1000;
+        if (AIRTIME_POLICY != AIRTIME_DEFER || (uint64_t)repeats * frame_us > BUDGET_US ||
+            waited_ms >= AIRTIME_MAX_DEFER_MS) {
+            repeats = 0;
+            usage->dropped++;
+            total.dropped++;
+            break;
+        }
+
+        if (!deferred) {
+            deferred = true;
+            usage->deferred++;
+            total.deferred++;
+        }
+
+        // Budget only frees up when the oldest bucket leaves the window
+        int64_t wait_ms = ((current_bucket + 1) * BUCKET_US - now) / 1000 + 1;
+        if (wait_ms > AIRTIME_MAX_DEFER_MS - waited_ms) {
+            wait_ms = AIRTIME_MAX_DEFER_MS - waited_ms;
+        }
+        xSemaphoreGive(airtime_mutex);
+        vTaskDelay(pdMS_TO_TICKS(wait_ms));
+        xSemaphoreTake(airtime_mutex, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(airtime_mutex);
+
+    if (repeats == 0) {
+        ESP_LOGW(TAG, "Budget exhausted (%lu/%lu ms), dropped code %lu", used_us / 1000, BUDGET_US / 1000, code);
+    }
+    return repeats;
+}
+
+void airtime_refund(uint32_t code, uint8_t bit_length, uint8_t protocol, uint32_t frame_us, int frames)
+{
+    if (airtime_mutex == NULL || frames <= 0) return;
+
+    uint32_t us = frames * frame_us;
+    int64_t now = esp_timer_get_time();
+
+    xSemaphoreTake(airtime_mutex, portMAX_DELAY);
+    advance(now);
+    // Taken back from the current bucket, where the reservation normally still sits
+    uint32_t *slot = &buckets[current_bucket % AIRTIME_BUCKETS];
+    uint32_t back = MIN(us, *slot);
+    *slot -= back;
+    used_us -= back;
+
+    airtime_usage_t *usage = signal_usage(code, bit_length, protocol, now);
+    usage->frames -= MIN((uint32_t)frames, usage->frames);
+    usage->airtime_us -= MIN((uint64_t)us, usage->airtime_us);
+    total.frames -= MIN((uint32_t)frames, total.frames);
+    total.airtime_us -= MIN((uint64_t)us, total.airtime_us);
+    xSemaphoreGive(airtime_mutex);
+}
+
+void airtime_get_stats(airtime_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->policy = AIRTIME_POLICY;
+    stats->duty_permille = AIRTIME_DUTY_PERMILLE;
+    stats->window_s = AIRTIME_WINDOW_S;
+    stats->budget_us = BUDGET_US;
+    if (airtime_mutex == NULL) return;
+
+    xSemaphoreTake(airtime_mutex, portMAX_DELAY);
+    advance(esp_timer_get_time());
+    stats->used_us = used_us;
+    stats->total = total;
+    xSemaphoreGive(airtime_mutex);
+}
+
+bool airtime_get_signal(int index, airtime_signal_t *signal)
+{
+    if (airtime_mutex == NULL || index < 0 || index >= AIRTIME_SIGNALS_MAX) return false;
+
+    xSemaphoreTake(airtime_mutex, portMAX_DELAY);
+    bool used = signal_last_used[index] != 0;
+    if (used) {
+        *signal = signals[index];
+    }
+    xSemaphoreGive(airtime_mutex);
+    return used;
+}
+
+const char *airtime_policy_to_string(airtime_policy_t policy)
+{
+    switch (policy) {
+        case AIRTIME_DEFER:   return "defer";
+        case AIRTIME_DROP:    return "drop";
+        case AIRTIME_SHORTEN: return "shorten";
+        default:              return "unknown";
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AIRTIME_BUCKETS       60    // The sliding window is tracked in this many slices
+#define AIRTIME_SIGNALS_MAX   32    // Codes with their own usage counters, least recently sent is replaced
+
+// What happens to a transmit that does not fit in the remaining budget
+typedef enum {
+    AIRTIME_DEFER = 0,      // Wait for budget to free up (up to AIRTIME_MAX_DEFER_MS), then drop
+    AIRTIME_DROP,           // Refuse the transmit
+    AIRTIME_SHORTEN,        // Send as many repeats as still fit, drop when not even one does
+} airtime_policy_t;
+
+typedef struct {
+    uint32_t sends;         // Transmit requests that reached the governor
+    uint32_t frames;        // Frames granted, repeats included
+    uint64_t airtime_us;    // Airtime granted
+    uint32_t deferred;      // Requests that had to wait
+    uint32_t shortened;     // Requests sent with fewer repeats
+    uint32_t dropped;       // Requests refused
+} airtime_usage_t;
+
+typedef struct {
+    airtime_policy_t policy;
+    uint16_t duty_permille; // Allowed share of the window
+    uint32_t window_s;
+    uint32_t budget_us;     // Airtime per window
+    uint32_t used_us;       // Airtime used in the current window
+    airtime_usage_t total;
+} airtime_stats_t;
+
+typedef struct {
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    airtime_usage_t usage;
+} airtime_signal_t;
+
+void airtime_init(void);
+
+// Reserves airtime for a burst of up to repeats frames of frame_us each and returns
+// how many frames may be sent, 0 when the transmit is dropped. Blocks under AIRTIME_DEFER.
+int airtime_acquire(uint32_t code, uint8_t bit_length, uint8_t protocol,
+                    uint32_t frame_us, int repeats);
+
+// Returns frames reserved by airtime_acquire but never sent
+void airtime_refund(uint32_t code, uint8_t bit_length, uint8_t protocol, uint32_t frame_us, int frames);
+
+void airtime_get_stats(airtime_stats_t *stats);
+
+// Copies per-code usage entry index. Returns false for unused entries, iterate 0..AIRTIME_SIGNALS_MAX-1.
+bool airtime_get_signal(int index, airtime_signal_t *signal);
+
+const char *airtime_policy_to_string(airtime_policy_t policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AIRTIME_H
@@ -0,0 +1,154 @@
+#include "api_format.h"
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "API_FORMAT";
+
+static api_format_stats_t stats[API_FORMAT_COUNT];
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Looks for a media type in a header; truncated values are searched as far as they go
+static bool header_mentions(httpd_req_t *req, const char *header, const char *type)
+{
+    char value[96];
+    esp_err_t err = httpd_req_get_hdr_value_str(req, header, value, sizeof(value));
+    if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) return false;
+    return strstr(value, type) != NULL;
+}
+
+api_format_t api_format_of_response(httpd_req_t *req)
+{
+    // ?format= wins, same as for the library export
+    char query[64];
+    char value[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+        return strcmp(value, "cbor") == 0 ? API_FORMAT_CBOR : API_FORMAT_JSON;
+    }
+    return header_mentions(req, "Accept", API_CONTENT_CBOR) ? API_FORMAT_CBOR : API_FORMAT_JSON;
+}
+
+api_format_t api_format_of_request(httpd_req_t *req)
+{
+    return header_mentions(req, "Content-Type", API_CONTENT_CBOR) ? API_FORMAT_CBOR : API_FORMAT_JSON;
+}
+
+void api_format_record_response(api_format_t format, size_t bytes, int64_t start_us)
+{
+    uint32_t took = (uint32_t)(esp_timer_get_time() - start_us);
+    portENTER_CRITICAL(&stats_lock);
+    stats[format].responses++;
+    stats[format].response_bytes += bytes;
+    stats[format].send_us += took;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+void api_format_record_request(api_format_t format, size_t bytes, int64_t start_us, bool ok)
+{
+    uint32_t took = (uint32_t)(esp_timer_get_time() - start_us);
+    portENTER_CRITICAL(&stats_lock);
+    stats[format].requests++;
+    stats[format].request_bytes += bytes;
+    stats[format].parse_us += took;
+    if (!ok) stats[format].parse_errors++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+static esp_err_t flush_chunk(void *ctx, const uint8_t *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, (const char *)data, len);
+}
+
+void api_cbor_begin(httpd_req_t *req, cbor_writer_t *w)
+{
+    httpd_resp_set_type(req, API_CONTENT_CBOR);
+    cbor_writer_init(w, flush_chunk, req);
+}
+
+esp_err_t api_cbor_end(httpd_req_t *req, cbor_writer_t *w, int64_t start_us)
+{
+    esp_err_t err = cbor_writer_finish(w);
+    if (err == ESP_OK) {
+        err = httpd_resp_send_chunk(req, NULL, 0);
+    }
+    api_format_record_response(API_FORMAT_CBOR, w->total, start_us);
+    return err;
+}
+
+esp_err_t api_send(httpd_req_t *req, const cJSON *root)
+{
+    int64_t start = esp_timer_get_time();
+
+    if (api_format_of_response(req) == API_FORMAT_CBOR) {
+        cbor_writer_t w;
+        api_cbor_begin(req, &w);
+        cbor_put_cjson(&w, root);
+        return api_cbor_end(req, &w, start);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    if (json == NULL) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    size_t len = strlen(json);
+    httpd_resp_set_type(req, API_CONTENT_JSON);
+    esp_err_t err = httpd_resp_send(req, json, len);
+    cJSON_free(json);
+    api_format_record_response(API_FORMAT_JSON, len, start);
+    return err;
+}
+
+esp_err_t api_send_str(httpd_req_t *req, const char *json)
+{
+    int64_t start = esp_timer_get_time();
+
+    if (api_format_of_response(req) == API_FORMAT_CBOR) {
+        // Only used for documents of a few fields, the tree is tiny
+        cJSON *root = cJSON_Parse(json);
+        if (root != NULL) {
+            cbor_writer_t w;
+            api_cbor_begin(req, &w);
+            cbor_put_cjson(&w, root);
+            cJSON_Delete(root);
+            return api_cbor_end(req, &w, start);
+        }
+        ESP_LOGW(TAG, "Not JSON, sent as is: %s", json);
+    }
+
+    size_t len = strlen(json);
+    httpd_resp_set_type(req, API_CONTENT_JSON);
+    esp_err_t err = httpd_resp_send(req, json, len);
+    api_format_record_response(API_FORMAT_JSON, len, start);
+    return err;
+}
+
+cJSON *api_parse_body(httpd_req_t *req, const char *body, size_t len)
+{
+    int64_t start = esp_timer_get_time();
+    api_format_t format = api_format_of_request(req);
+
+    cJSON *root = format == API_FORMAT_CBOR ? cbor_to_cjson(body, len)
+                                            : cJSON_ParseWithLength(body, len);
+    api_format_record_request(format, len, start, root != NULL);
+    return root;
+}
+
+void api_format_get_stats(api_format_t format, api_format_stats_t *out)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats[format];
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+const char *api_format_to_string(api_format_t format)
+{
+    switch (format) {
+        case API_FORMAT_JSON: return "json";
+        case API_FORMAT_CBOR: return "cbor";
+        default:              return "unknown";
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef API_FORMAT_H
+#define API_FORMAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "cJSON.h"
+#include "cbor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Content negotiation for the JSON API. Every endpoint that answers JSON answers
+// CBOR instead when the client sends "Accept: application/cbor" (or ?format=cbor),
+// and every endpoint that takes a JSON body takes a CBOR one when the request has
+// "Content-Type: application/cbor". Field names and values are the same in both.
+
+#define API_CONTENT_JSON "application/json"
+#define API_CONTENT_CBOR "application/cbor"
+
+typedef enum {
+    API_FORMAT_JSON = 0,
+    API_FORMAT_CBOR,
+    API_FORMAT_COUNT
+} api_format_t;
+
+typedef struct {
+    uint32_t responses;
+    uint64_t response_bytes;
+    uint64_t send_us;           // Encoding plus handing the bytes to the socket
+    uint32_t requests;          // Bodies parsed
+    uint64_t request_bytes;
+    uint64_t parse_us;
+    uint32_t parse_errors;
+} api_format_stats_t;
+
+// Response format the client asked for
+api_format_t api_format_of_response(httpd_req_t *req);
+
+// Format of the request body
+api_format_t api_format_of_request(httpd_req_t *req);
+
+// Sends a cJSON tree in the negotiated format. The tree stays owned by the caller.
+esp_err_t api_send(httpd_req_t *req, const cJSON *root);
+
+// Sends a small fixed JSON document such as {"success":true} in the negotiated format
+esp_err_t api_send_str(httpd_req_t *req, const char *json);
+
+// Parses a request body of len bytes in whichever format it came in. NULL when malformed.
+cJSON *api_parse_body(httpd_req_t *req, const char *body, size_t len);
+
+// Streams a CBOR response straight from the handler's data:
+//     cbor_writer_t w;
+//     api_cbor_begin(req, &w);
+//     cbor_begin_map(&w, 2); ...
+//     return api_cbor_end(req, &w, start_us);
+// start_us is esp_timer_get_time() from before encoding, for the stats.
+void api_cbor_begin(httpd_req_t *req, cbor_writer_t *w);
+esp_err_t api_cbor_end(httpd_req_t *req, cbor_writer_t *w, int64_t start_us);
+
+// Accounting for handlers that stream JSON themselves
+void api_format_record_response(api_format_t format, size_t bytes, int64_t start_us);
+void api_format_record_request(api_format_t format, size_t bytes, int64_t start_us, bool ok);
+
+void api_format_get_stats(api_format_t format, api_format_stats_t *out);
+const char *api_format_to_string(api_format_t format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // API_FORMAT_H
@@ -0,0 +1,128 @@
+#include "burst.h"
+#include <string.h>
+#include <sys/param.h>
+#include "rc_switch.h"
+
+// A burst ends once no repeat arrived for BURST_RELEASE_FRAMES frame periods. The period
+// comes from the protocol timings (rc_frame_airtime_us), or from the spacing actually
+// seen when the remote pauses between frames. Bounded so noise cannot stretch a press.
+#define BURST_RELEASE_FRAMES  4
+#define BURST_GAP_MIN_US      100000
+#define BURST_GAP_MAX_US      600000
+
+typedef struct {
+    bool active;
+    uint16_t frames;
+    uint32_t gap_us;            // Silence that releases the burst
+    int64_t press_time;
+    int64_t last_time;
+    int64_t next_hold;          // Time the next hold event is due
+    radio_frame_t frame;        // Latest frame
+} burst_t;
+
+static burst_t bursts[BURST_MAX_ACTIVE];
+
+static uint32_t release_gap_us(const radio_frame_t *frame, uint32_t interval_us)
+{
+    uint32_t period = rc_frame_airtime_us(frame->protocol - 1, frame->pulse_length,
+                                          frame->code, frame->bit_length);
+    period = MAX(period, interval_us);
+    return MIN(MAX(period * BURST_RELEASE_FRAMES, BURST_GAP_MIN_US), BURST_GAP_MAX_US);
+}
+
+static void make_event(burst_t *b, burst_event_type_t type, burst_event_t *event)
+{
+    event->type = type;
+    event->duration_ms = (uint32_t)((b->last_time - b->press_time) / 1000);
+    event->frames = b->frames;
+    event->press_time = b->press_time;
+    event->frame = b->frame;
+}
+
+int burst_feed(const radio_frame_t *frame, burst_event_t events[2])
+{
+    int count = 0;
+    burst_t *slot = NULL;
+
+    for (int i = 0; i < BURST_MAX_ACTIVE; i++) {
+        burst_t *b = &bursts[i];
+        if (!b->active || b->frame.code != frame->code ||
+            b->frame.bit_length != frame->bit_length || b->frame.protocol != frame->protocol) {
+            continue;
+        }
+
+        int64_t interval = frame->time - b->last_time;
+        if (interval <= b->gap_us) {
+            // Repeat: only the spacing is learned, no event
+            uint32_t gap = release_gap_us(frame, (uint32_t)interval);
+            b->gap_us = MAX(b->gap_us, gap);
+            b->last_time = frame->time;
+            b->frame = *frame;
+            if (b->frames < UINT16_MAX) b->frames++;
+            return 0;
+        }
+
+        // Released but not polled yet, report that before the new press
+        make_event(b, BURST_RELEASE, &events[count++]);
+        slot = b;
+        break;
+    }
+
+    if (slot == NULL) {
+        // A free slot, or the burst heard from least recently
+        slot = &bursts[0];
+        for (int i = 0; i < BURST_MAX_ACTIVE; i++) {
+            if (!bursts[i].active) {
+                slot = &bursts[i];
+                break;
+            }
+            if (bursts[i].last_time < slot->last_time) {
+                slot = &bursts[i];
+            }
+        }
+        if (slot->active) {
+            make_event(slot, BURST_RELEASE, &events[count++]);
+        }
+    }
+
+    slot->active = true;
+    slot->frames = 1;
+    slot->gap_us = release_gap_us(frame, 0);
+    slot->press_time = frame->time;
+    slot->last_time = frame->time;
+    slot->next_hold = frame->time + (int64_t)BURST_HOLD_MS * 1000;
+    slot->frame = *frame;
+    make_event(slot, BURST_PRESS, &events[count++]);
+    return count;
+}
+
+bool burst_poll(int64_t now, burst_event_t *event)
+{
+    for (int i = 0; i < BURST_MAX_ACTIVE; i++) {
+        burst_t *b = &bursts[i];
+        if (!b->active) continue;
+
+        if (now - b->last_time > b->gap_us) {
+            b->active = false;
+            make_event(b, BURST_RELEASE, event);
+            return true;
+        }
+        if (now >= b->next_hold) {
+            b->next_hold += (int64_t)BURST_HOLD_REPEAT_MS * 1000;
+            make_event(b, BURST_HOLD, event);
+            event->duration_ms = (uint32_t)((now - b->press_time) / 1000);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *burst_event_to_string(burst_event_type_t type)
+{
+    switch (type) {
+        case BURST_PRESS:   return "press";
+        case BURST_HOLD:    return "hold";
+        case BURST_RELEASE: return "release";
+        default:            return "unknown";
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef BURST_H
+#define BURST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "radio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BURST_MAX_ACTIVE      8         // Buttons held at the same time
+#define BURST_HOLD_MS         500       // A press still going after this is a hold
+#define BURST_HOLD_REPEAT_MS  1000      // Further hold events while the button stays down
+
+// A remote repeats its frame for as long as the button is down. The burst tracker turns
+// that stream into one press, hold events every so often, and a release.
+typedef enum {
+    BURST_PRESS = 0,        // First frame of a burst
+    BURST_HOLD,             // Still held, duration_ms since the press
+    BURST_RELEASE,          // No repeat within the release gap, duration_ms is the whole press
+} burst_event_type_t;
+
+typedef struct {
+    burst_event_type_t type;
+    uint32_t duration_ms;   // Hold: time since the press, release: first to last frame, press: 0
+    uint16_t frames;        // Frames received in the burst so far
+    int64_t press_time;     // esp_timer time of the first frame, identifies the press
+    radio_frame_t frame;    // Press: the first frame, hold/release: the latest one
+} burst_event_t;
+
+// Feeds one accepted frame. Returns the number of events written to events (0-2): a
+// repeat of an ongoing burst gives none, a new burst gives a press, possibly preceded by
+// the release of a stale burst it replaces. Single consumer, call from the RF monitor.
+int burst_feed(const radio_frame_t *frame, burst_event_t events[2]);
+
+// Returns hold and release events that are due at now, one per call. Call until false.
+bool burst_poll(int64_t now, burst_event_t *event);
+
+const char *burst_event_to_string(burst_event_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BURST_H
@@ -0,0 +1,471 @@
+#include "cbor.h"
+#include <string.h>
+#include <math.h>
+
+#define MAJOR_UINT   0
+#define MAJOR_NEGINT 1
+#define MAJOR_BYTES  2
+#define MAJOR_TEXT   3
+#define MAJOR_ARRAY  4
+#define MAJOR_MAP    5
+#define MAJOR_TAG    6
+#define MAJOR_SIMPLE 7
+
+#define AI_INDEFINITE 31
+#define SIMPLE_FALSE  0xF4
+#define SIMPLE_TRUE   0xF5
+#define SIMPLE_NULL   0xF6
+#define FLOAT32       0xFA
+#define FLOAT64       0xFB
+#define BREAK         0xFF
+
+void cbor_writer_init(cbor_writer_t *w, cbor_flush_fn flush, void *ctx)
+{
+    w->len = 0;
+    w->total = 0;
+    w->flush = flush;
+    w->ctx = ctx;
+    w->err = ESP_OK;
+}
+
+static void writer_flush(cbor_writer_t *w)
+{
+    if (w->len > 0 && w->err == ESP_OK) {
+        w->err = w->flush(w->ctx, w->buf, w->len);
+    }
+    w->len = 0;
+}
+
+static void put_raw(cbor_writer_t *w, const void *data, size_t len)
+{
+    const uint8_t *src = data;
+    w->total += len;
+    while (len > 0) {
+        if (w->len == CBOR_WRITER_BUFFER) {
+            writer_flush(w);
+        }
+        size_t n = CBOR_WRITER_BUFFER - w->len;
+        if (n > len) n = len;
+        memcpy(w->buf + w->len, src, n);
+        w->len += n;
+        src += n;
+        len -= n;
+    }
+}
+
+// Head of a data item: major type plus the shortest encoding of its argument
+static void put_head(cbor_writer_t *w, uint8_t major, uint64_t arg)
+{
+    uint8_t head[9];
+    size_t len;
+    major <<= 5;
+
+    if (arg < 24) {
+        head[0] = major | arg;
+        len = 1;
+    } else if (arg <= UINT8_MAX) {
+        head[0] = major | 24;
+        head[1] = arg;
+        len = 2;
+    } else if (arg <= UINT16_MAX) {
+        head[0] = major | 25;
+        head[1] = arg >> 8;
+        head[2] = arg;
+        len = 3;
+    } else if (arg <= UINT32_MAX) {
+        head[0] = major | 26;
+        for (int i = 0; i < 4; i++) head[1 + i] = arg >> (24 - 8 * i);
+        len = 5;
+    } else {
+        head[0] = major | 27;
+        for (int i = 0; i < 8; i++) head[1 + i] = arg >> (56 - 8 * i);
+        len = 9;
+    }
+    put_raw(w, head, len);
+}
+
+void cbor_put_uint(cbor_writer_t *w, uint64_t value)
+{
+    put_head(w, MAJOR_UINT, value);
+}
+
+void cbor_put_int(cbor_writer_t *w, int64_t value)
+{
+    if (value >= 0) {
+        put_head(w, MAJOR_UINT, value);
+    } else {
+        put_head(w, MAJOR_NEGINT, (uint64_t)(-1 - value));
+    }
+}
+
+void cbor_put_double(cbor_writer_t *w, double value)
+{
+    // cJSON keeps every number as a double, most of ours are small integers
+    if (value == floor(value) && value >= -9007199254740992.0 && value <= 9007199254740992.0) {
+        cbor_put_int(w, (int64_t)value);
+        return;
+    }
+
+    uint8_t out[9];
+    float single = (float)value;
+    if ((double)single == value) {
+        uint32_t bits;
+        memcpy(&bits, &single, sizeof(bits));
+        out[0] = FLOAT32;
+        for (int i = 0; i < 4; i++) out[1 + i] = bits >> (24 - 8 * i);
+        put_raw(w, out, 5);
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        out[0] = FLOAT64;
+        for (int i = 0; i < 8; i++) out[1 + i] = bits >> (56 - 8 * i);
+        put_raw(w, out, 9);
+    }
+}
+
+void cbor_put_bool(cbor_writer_t *w, bool value)
+{
+    uint8_t b = value ? SIMPLE_TRUE : SIMPLE_FALSE;
+    put_raw(w, &b, 1);
+}
+
+void cbor_put_null(cbor_writer_t *w)
+{
+    uint8_t b = SIMPLE_NULL;
+    put_raw(w, &b, 1);
+}
+
+void cbor_put_text_len(cbor_writer_t *w, const char *text, size_t len)
+{
+    put_head(w, MAJOR_TEXT, len);
+    put_raw(w, text, len);
+}
+
+void cbor_put_text(cbor_writer_t *w, const char *text)
+{
+    cbor_put_text_len(w, text, strlen(text));
+}
+
+void cbor_put_bytes(cbor_writer_t *w, const void *data, size_t len)
+{
+    put_head(w, MAJOR_BYTES, len);
+    put_raw(w, data, len);
+}
+
+static void begin_container(cbor_writer_t *w, uint8_t major, size_t count)
+{
+    if (count == CBOR_INDEFINITE) {
+        uint8_t b = (major << 5) | AI_INDEFINITE;
+        put_raw(w, &b, 1);
+    } else {
+        put_head(w, major, count);
+    }
+}
+
+void cbor_begin_map(cbor_writer_t *w, size_t pairs)
+{
+    begin_container(w, MAJOR_MAP, pairs);
+}
+
+void cbor_begin_array(cbor_writer_t *w, size_t items)
+{
+    begin_container(w, MAJOR_ARRAY, items);
+}
+
+void cbor_end(cbor_writer_t *w)
+{
+    uint8_t b = BREAK;
+    put_raw(w, &b, 1);
+}
+
+void cbor_put_cjson(cbor_writer_t *w, const cJSON *item)
+{
+    if (cJSON_IsObject(item) || cJSON_IsArray(item)) {
+        size_t count = 0;
+        for (const cJSON *child = item->child; child != NULL; child = child->next) count++;
+
+        if (cJSON_IsObject(item)) {
+            cbor_begin_map(w, count);
+        } else {
+            cbor_begin_array(w, count);
+        }
+        for (const cJSON *child = item->child; child != NULL; child = child->next) {
+            if (cJSON_IsObject(item)) cbor_put_text(w, child->string);
+            cbor_put_cjson(w, child);
+        }
+    } else if (cJSON_IsString(item)) {
+        cbor_put_text(w, item->valuestring);
+    } else if (cJSON_IsNumber(item)) {
+        cbor_put_double(w, item->valuedouble);
+    } else if (cJSON_IsBool(item)) {
+        cbor_put_bool(w, cJSON_IsTrue(item));
+    } else {
+        cbor_put_null(w);
+    }
+}
+
+esp_err_t cbor_writer_finish(cbor_writer_t *w)
+{
+    writer_flush(w);
+    return w->err;
+}
+
+void cbor_reader_init(cbor_reader_t *r, const void *data, size_t len)
+{
+    r->pos = data;
+    r->end = r->pos + len;
+}
+
+static bool read_be(cbor_reader_t *r, size_t len, uint64_t *out)
+{
+    if ((size_t)(r->end - r->pos) < len) return false;
+    uint64_t value = 0;
+    for (size_t i = 0; i < len; i++) value = (value << 8) | *r->pos++;
+    *out = value;
+    return true;
+}
+
+static double half_to_double(uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1F;
+    int mantissa = half & 0x3FF;
+    double value;
+    if (exponent == 0) {
+        value = ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        value = ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        value = mantissa == 0 ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+bool cbor_read(cbor_reader_t *r, cbor_item_t *item)
+{
+    for (;;) {
+        if (r->pos >= r->end) return false;
+
+        uint8_t initial = *r->pos++;
+        uint8_t major = initial >> 5;
+        uint8_t ai = initial & 0x1F;
+        uint64_t arg = ai;
+
+        memset(item, 0, sizeof(*item));
+
+        if (major == MAJOR_SIMPLE) {
+            switch (initial) {
+                case SIMPLE_FALSE:
+                case SIMPLE_TRUE:
+                    item->type = CBOR_TYPE_BOOL;
+                    item->boolean = initial == SIMPLE_TRUE;
+                    return true;
+                case SIMPLE_NULL:
+                case 0xF7:  // undefined
+                    item->type = CBOR_TYPE_NULL;
+                    return true;
+                case 0xF9: {
+                    uint64_t bits;
+                    if (!read_be(r, 2, &bits)) return false;
+                    item->type = CBOR_TYPE_FLOAT;
+                    item->number = half_to_double(bits);
+                    return true;
+                }
+                case FLOAT32: {
+                    uint64_t bits;
+                    if (!read_be(r, 4, &bits)) return false;
+                    uint32_t bits32 = bits;
+                    float value;
+                    memcpy(&value, &bits32, sizeof(value));
+                    item->type = CBOR_TYPE_FLOAT;
+                    item->number = value;
+                    return true;
+                }
+                case FLOAT64: {
+                    uint64_t bits;
+                    if (!read_be(r, 8, &bits)) return false;
+                    item->type = CBOR_TYPE_FLOAT;
+                    memcpy(&item->number, &bits, sizeof(item->number));
+                    return true;
+                }
+                case BREAK:
+                    item->type = CBOR_TYPE_BREAK;
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        if (ai == AI_INDEFINITE) {
+            // Only containers may be indefinite here, chunked strings are not supported
+            if (major != MAJOR_ARRAY && major != MAJOR_MAP) return false;
+            item->type = major == MAJOR_ARRAY ? CBOR_TYPE_ARRAY : CBOR_TYPE_MAP;
+            item->indefinite = true;
+            return true;
+        }
+        if (ai >= 24) {
+            if (ai > 27) return false;
+            if (!read_be(r, (size_t)1 << (ai - 24), &arg)) return false;
+        }
+
+        switch (major) {
+            case MAJOR_UINT:
+                item->type = CBOR_TYPE_UINT;
+                item->number = (double)arg;
+                return true;
+            case MAJOR_NEGINT:
+                item->type = CBOR_TYPE_NEGINT;
+                item->number = -1.0 - (double)arg;
+                return true;
+            case MAJOR_BYTES:
+            case MAJOR_TEXT:
+                if (arg > (uint64_t)(r->end - r->pos)) return false;
+                item->type = major == MAJOR_BYTES ? CBOR_TYPE_BYTES : CBOR_TYPE_TEXT;
+                item->count = arg;
+                item->data = r->pos;
+                r->pos += arg;
+                return true;
+            case MAJOR_ARRAY:
+                item->type = CBOR_TYPE_ARRAY;
+                item->count = arg;
+                return true;
+            case MAJOR_MAP:
+                item->type = CBOR_TYPE_MAP;
+                item->count = arg;
+                return true;
+            default:
+                // A tag only annotates the item after it
+                continue;
+        }
+    }
+}
+
+static bool skip_item(cbor_reader_t *r, int depth)
+{
+    cbor_item_t item;
+    if (!cbor_read(r, &item)) return false;
+    if (item.type == CBOR_TYPE_BREAK) return false;
+    if (item.type != CBOR_TYPE_ARRAY && item.type != CBOR_TYPE_MAP) return true;
+    if (depth >= CBOR_MAX_DEPTH) return false;
+
+    uint64_t per_entry = item.type == CBOR_TYPE_MAP ? 2 : 1;
+    if (item.indefinite) {
+        for (;;) {
+            if (r->pos >= r->end) return false;
+            if (*r->pos == BREAK) {
+                r->pos++;
+                return true;
+            }
+            for (uint64_t i = 0; i < per_entry; i++) {
+                if (!skip_item(r, depth + 1)) return false;
+            }
+        }
+    }
+
+    // Every entry takes at least one byte, anything claiming more is truncated
+    if (item.count > (uint64_t)(r->end - r->pos)) return false;
+    for (uint64_t i = 0; i < item.count * per_entry; i++) {
+        if (!skip_item(r, depth + 1)) return false;
+    }
+    return true;
+}
+
+bool cbor_skip(cbor_reader_t *r)
+{
+    return skip_item(r, 0);
+}
+
+bool cbor_text_equals(const cbor_item_t *item, const char *text)
+{
+    size_t len = strlen(text);
+    return item->type == CBOR_TYPE_TEXT && item->count == len && memcmp(item->data, text, len) == 0;
+}
+
+// Container entries end at a break (indefinite) or after count entries
+static bool container_done(cbor_reader_t *r, const cbor_item_t *head, uint64_t seen)
+{
+    if (!head->indefinite) return seen == head->count;
+    if (r->pos < r->end && *r->pos == BREAK) {
+        r->pos++;
+        return true;
+    }
+    return false;
+}
+
+static cJSON *item_to_cjson(cbor_reader_t *r, int depth)
+{
+    cbor_item_t item;
+    if (!cbor_read(r, &item)) return NULL;
+
+    switch (item.type) {
+        case CBOR_TYPE_UINT:
+        case CBOR_TYPE_NEGINT:
+        case CBOR_TYPE_FLOAT:
+            return cJSON_CreateNumber(item.number);
+        case CBOR_TYPE_BOOL:
+            return cJSON_CreateBool(item.boolean);
+        case CBOR_TYPE_NULL:
+            return cJSON_CreateNull();
+        case CBOR_TYPE_TEXT:
+        case CBOR_TYPE_BYTES: {
+            // Byte strings have no JSON equivalent, handlers see them as text
+            char *text = cJSON_malloc(item.count + 1);
+            if (text == NULL) return NULL;
+            memcpy(text, item.data, item.count);
+            text[item.count] = '\0';
+            cJSON *str = cJSON_CreateString(text);
+            cJSON_free(text);
+            return str;
+        }
+        case CBOR_TYPE_ARRAY:
+        case CBOR_TYPE_MAP:
+            break;
+        default:
+            return NULL;
+    }
+
+    if (depth >= CBOR_MAX_DEPTH) return NULL;
+    if (!item.indefinite && item.count > (uint64_t)(r->end - r->pos)) return NULL;
+
+    bool is_map = item.type == CBOR_TYPE_MAP;
+    cJSON *container = is_map ? cJSON_CreateObject() : cJSON_CreateArray();
+    if (container == NULL) return NULL;
+
+    for (uint64_t seen = 0; !container_done(r, &item, seen); seen++) {
+        char key[32] = "";
+        if (is_map) {
+            cbor_item_t key_item;
+            if (!cbor_read(r, &key_item) || key_item.type != CBOR_TYPE_TEXT ||
+                key_item.count >= sizeof(key)) {
+                cJSON_Delete(container);
+                return NULL;
+            }
+            memcpy(key, key_item.data, key_item.count);
+            key[key_item.count] = '\0';
+        }
+
+        cJSON *child = item_to_cjson(r, depth + 1);
+        if (child == NULL) {
+            cJSON_Delete(container);
+            return NULL;
+        }
+        if (is_map) {
+            cJSON_AddItemToObject(container, key, child);
+        } else {
+            cJSON_AddItemToArray(container, child);
+        }
+    }
+    return container;
+}
+
+cJSON *cbor_to_cjson(const void *data, size_t len)
+{
+    cbor_reader_t r;
+    cbor_reader_init(&r, data, len);
+    cJSON *root = item_to_cjson(&r, 0);
+    if (root != NULL && !cbor_at_end(&r)) {
+        // Trailing bytes after the top level item
+        cJSON_Delete(root);
+        return NULL;
+    }
+    return root;
+}
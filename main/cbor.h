@@ -0,0 +1,131 @@
+#ifndef CBOR_H
+#define CBOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "cJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Minimal CBOR (RFC 8949) codec for the HTTP API.
+//
+// The writer encodes into a small buffer that is handed to a flush callback
+// whenever it fills up, so a response of any size goes out in chunks without
+// ever being held in memory. The reader is a pull parser that walks a body in
+// place, one data item at a time, without building a tree.
+//
+// Supported: unsigned/negative integers, byte and text strings (definite length),
+// arrays and maps (definite and indefinite length), tags (read and skipped),
+// false/true/null/undefined and half/single/double floats.
+
+#define CBOR_WRITER_BUFFER 256
+#define CBOR_INDEFINITE    SIZE_MAX     // Container length for cbor_begin_*, close with cbor_end
+#define CBOR_MAX_DEPTH     8            // Nesting the reader and cJSON bridges accept
+
+typedef esp_err_t (*cbor_flush_fn)(void *ctx, const uint8_t *data, size_t len);
+
+typedef struct {
+    uint8_t buf[CBOR_WRITER_BUFFER];
+    size_t len;             // Bytes waiting in buf
+    size_t total;           // Bytes encoded so far, flushed or not
+    cbor_flush_fn flush;
+    void *ctx;
+    esp_err_t err;          // First flush error, everything after it is dropped
+} cbor_writer_t;
+
+void cbor_writer_init(cbor_writer_t *w, cbor_flush_fn flush, void *ctx);
+
+void cbor_put_uint(cbor_writer_t *w, uint64_t value);
+void cbor_put_int(cbor_writer_t *w, int64_t value);
+void cbor_put_double(cbor_writer_t *w, double value);   // Integral values are encoded as integers
+void cbor_put_bool(cbor_writer_t *w, bool value);
+void cbor_put_null(cbor_writer_t *w);
+void cbor_put_text(cbor_writer_t *w, const char *text);
+void cbor_put_text_len(cbor_writer_t *w, const char *text, size_t len);
+void cbor_put_bytes(cbor_writer_t *w, const void *data, size_t len);
+void cbor_begin_map(cbor_writer_t *w, size_t pairs);
+void cbor_begin_array(cbor_writer_t *w, size_t items);
+void cbor_end(cbor_writer_t *w);    // Closes an indefinite-length container
+
+// Map entry shorthands
+static inline void cbor_put_key_uint(cbor_writer_t *w, const char *key, uint64_t value)
+{
+    cbor_put_text(w, key);
+    cbor_put_uint(w, value);
+}
+
+static inline void cbor_put_key_text(cbor_writer_t *w, const char *key, const char *value)
+{
+    cbor_put_text(w, key);
+    cbor_put_text(w, value);
+}
+
+static inline void cbor_put_key_bool(cbor_writer_t *w, const char *key, bool value)
+{
+    cbor_put_text(w, key);
+    cbor_put_bool(w, value);
+}
+
+// Encodes a cJSON tree item by item
+void cbor_put_cjson(cbor_writer_t *w, const cJSON *item);
+
+// Hands whatever is still buffered to the flush callback. Returns the first error seen.
+esp_err_t cbor_writer_finish(cbor_writer_t *w);
+
+typedef enum {
+    CBOR_TYPE_UINT,
+    CBOR_TYPE_NEGINT,
+    CBOR_TYPE_BYTES,
+    CBOR_TYPE_TEXT,
+    CBOR_TYPE_ARRAY,
+    CBOR_TYPE_MAP,
+    CBOR_TYPE_BOOL,
+    CBOR_TYPE_NULL,         // null and undefined
+    CBOR_TYPE_FLOAT,
+    CBOR_TYPE_BREAK,        // End of an indefinite-length container
+} cbor_type_t;
+
+typedef struct {
+    cbor_type_t type;
+    bool indefinite;        // Arrays and maps closed by a break
+    bool boolean;
+    uint64_t count;         // String length in bytes, array items or map pairs
+    double number;          // Value of UINT, NEGINT and FLOAT items
+    const uint8_t *data;    // String bytes, not NUL terminated
+} cbor_item_t;
+
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *end;
+} cbor_reader_t;
+
+void cbor_reader_init(cbor_reader_t *r, const void *data, size_t len);
+
+// Reads the next data item head. Strings are consumed whole, arrays and maps only
+// their head: their content follows as the next items. Tags are skipped.
+// Returns false at the end of input or on malformed data.
+bool cbor_read(cbor_reader_t *r, cbor_item_t *item);
+
+// Skips the next data item including everything nested in it
+bool cbor_skip(cbor_reader_t *r);
+
+static inline bool cbor_at_end(const cbor_reader_t *r)
+{
+    return r->pos >= r->end;
+}
+
+bool cbor_text_equals(const cbor_item_t *item, const char *text);
+
+// Decodes a whole CBOR body into a cJSON tree for handlers that work on trees.
+// Map keys must be text. Returns NULL on malformed input.
+cJSON *cbor_to_cjson(const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CBOR_H
@@ -0,0 +1,278 @@
+#include "event_log.h"
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "EVENT_LOG";
+
+#define SECTOR_SIZE          4096
+#define RECORDS_PER_SECTOR   (SECTOR_SIZE / sizeof(event_record_t))
+#define ERASED_SEQ           0xFFFFFFFFu
+#define EVENT_LOG_BATCH      16          // Records buffered before a flash write
+#define EVENT_LOG_FLUSH_US   5000000     // Max time a record waits in RAM
+
+_Static_assert(sizeof(event_record_t) == 16, "event_record_t must stay 16 bytes");
+
+static const esp_partition_t *partition = NULL;
+static SemaphoreHandle_t log_mutex = NULL;
+static volatile bool ready = false;  // Set once mounting is done, appends before that are dropped
+static uint32_t capacity = 0;       // In records
+static uint32_t head = 0;           // Record slot the next flash write goes to
+static uint32_t next_seq = 1;       // Sequence of the record at head
+static uint32_t oldest_seq = 1;
+static uint32_t oldest_pos = 0;
+static uint32_t sector_erases = 0;
+
+static event_record_t pending[EVENT_LOG_BATCH];
+static uint32_t pending_count = 0;
+static int64_t pending_since = 0;
+
+static uint32_t read_seq_at(uint32_t pos)
+{
+    uint32_t seq = ERASED_SEQ;
+    esp_partition_read(partition, pos * sizeof(event_record_t), &seq, sizeof(seq));
+    return seq;
+}
+
+static uint32_t pos_of_seq(uint32_t seq)
+{
+    return (oldest_pos + (seq - oldest_seq)) % capacity;
+}
+
+// Erases the sector head just entered and drops whatever old records lived there
+static void erase_sector_at_head(void)
+{
+    uint32_t sector = head / RECORDS_PER_SECTOR;
+    uint32_t sector_start = sector * RECORDS_PER_SECTOR;
+
+    if (next_seq != oldest_seq && oldest_pos >= sector_start &&
+        oldest_pos < sector_start + RECORDS_PER_SECTOR) {
+        oldest_seq += sector_start + RECORDS_PER_SECTOR - oldest_pos;
+        oldest_pos = (sector_start + RECORDS_PER_SECTOR) % capacity;
+    }
+
+    esp_partition_erase_range(partition, sector * SECTOR_SIZE, SECTOR_SIZE);
+    sector_erases++;
+}
+
+// Called with log_mutex held
+static void flush_locked(void)
+{
+    uint32_t written = 0;
+
+    while (written < pending_count) {
+        if (head % RECORDS_PER_SECTOR == 0) {
+            erase_sector_at_head();
+        }
+
+        // Write the longest run that stays inside the current sector
+        uint32_t room = RECORDS_PER_SECTOR - (head % RECORDS_PER_SECTOR);
+        uint32_t run = MIN(room, pending_count - written);
+
+        esp_err_t err = esp_partition_write(partition, head * sizeof(event_record_t),
+                                            &pending[written], run * sizeof(event_record_t));
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Flash write failed: %s", esp_err_to_name(err));
+            break;
+        }
+
+        written += run;
+        next_seq += run;
+        head = (head + run) % capacity;
+    }
+
+    // Anything that failed to write is dropped, the sequence stays contiguous on flash
+    pending_count = 0;
+}
+
+esp_err_t event_log_init(void)
+{
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         EVENT_LOG_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGW(TAG, "No '%s' partition, event log disabled", EVENT_LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    log_mutex = xSemaphoreCreateMutex();
+    if (log_mutex == NULL) {
+        partition = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t sectors = partition->size / SECTOR_SIZE;
+    capacity = sectors * RECORDS_PER_SECTOR;
+
+    // The first record of every sector tells us which sectors hold data and how old it is
+    int newest_sector = -1;
+    int oldest_sector = -1;
+    uint32_t newest_first = 0;
+    uint32_t oldest_first = ERASED_SEQ;
+    for (uint32_t s = 0; s < sectors; s++) {
+        uint32_t seq = read_seq_at(s * RECORDS_PER_SECTOR);
+        if (seq == ERASED_SEQ) continue;
+        if (newest_sector < 0 || seq > newest_first) {
+            newest_first = seq;
+            newest_sector = s;
+        }
+        if (seq < oldest_first) {
+            oldest_first = seq;
+            oldest_sector = s;
+        }
+    }
+
+    if (newest_sector < 0) {
+        head = 0;
+        next_seq = 1;
+        oldest_seq = 1;
+        oldest_pos = 0;
+    } else {
+        // Records in a sector are written front to back, so binary search for the last one
+        uint32_t base = newest_sector * RECORDS_PER_SECTOR;
+        uint32_t lo = 0, hi = RECORDS_PER_SECTOR - 1;
+        while (lo < hi) {
+            uint32_t mid = (lo + hi + 1) / 2;
+            if (read_seq_at(base + mid) != ERASED_SEQ) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        head = (base + lo + 1) % capacity;
+        next_seq = read_seq_at(base + lo) + 1;
+        oldest_seq = oldest_first;
+        oldest_pos = oldest_sector * RECORDS_PER_SECTOR;
+    }
+
+    ESP_LOGI(TAG, "Event log mounted: %lu KiB, %lu records stored (seq %lu..%lu), capacity %lu",
+             partition->size / 1024, next_seq - oldest_seq, oldest_seq, next_seq - 1, capacity);
+    ready = true;
+    return ESP_OK;
+}
+
+void event_log_append(event_kind_t kind, uint32_t code, uint8_t bit_length, uint8_t protocol, uint16_t pulse_length)
+{
+    if (!ready) return;
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+
+    if (pending_count == EVENT_LOG_BATCH) {
+        flush_locked();
+    }
+    if (pending_count == 0) {
+        pending_since = esp_timer_get_time();
+    }
+
+    event_record_t *rec = &pending[pending_count];
+    rec->seq = next_seq + pending_count;
+    rec->timestamp = (uint32_t)time(NULL);
+    rec->code = code;
+    rec->pulse_length = pulse_length;
+    rec->bit_length = bit_length;
+    rec->meta = (uint8_t)((kind << 4) | (protocol & 0x0F));
+    pending_count++;
+
+    xSemaphoreGive(log_mutex);
+}
+
+void event_log_tick(void)
+{
+    if (!ready || pending_count == 0) return;
+
+    if (pending_count < EVENT_LOG_BATCH &&
+        esp_timer_get_time() - pending_since < EVENT_LOG_FLUSH_US) {
+        return;
+    }
+
+    event_log_flush();
+}
+
+void event_log_flush(void)
+{
+    if (!ready) return;
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    if (pending_count > 0) {
+        flush_locked();
+    }
+    xSemaphoreGive(log_mutex);
+}
+
+size_t event_log_read(uint32_t start_seq, event_record_t *out, size_t max_records)
+{
+    if (!ready || max_records == 0) return 0;
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+
+    if (start_seq < oldest_seq) {
+        start_seq = oldest_seq;
+    }
+
+    size_t count = 0;
+    if (start_seq < next_seq) {
+        uint32_t pos = pos_of_seq(start_seq);
+        // One contiguous read, stopping where the ring wraps
+        count = MIN(max_records, next_seq - start_seq);
+        count = MIN(count, capacity - pos);
+        if (esp_partition_read(partition, pos * sizeof(event_record_t), out,
+                               count * sizeof(event_record_t)) != ESP_OK) {
+            count = 0;
+        }
+    }
+
+    xSemaphoreGive(log_mutex);
+    return count;
+}
+
+uint32_t event_log_seq_at_time(uint32_t timestamp)
+{
+    if (!ready) return 1;
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+
+    uint32_t lo = oldest_seq, hi = next_seq;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        event_record_t rec;
+        esp_partition_read(partition, pos_of_seq(mid) * sizeof(event_record_t), &rec, sizeof(rec));
+        if (rec.timestamp < timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    xSemaphoreGive(log_mutex);
+    return lo;
+}
+
+void event_log_get_stats(event_log_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (!ready) return;
+
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+    stats->capacity = capacity;
+    stats->oldest_seq = oldest_seq;
+    stats->next_seq = next_seq + pending_count;
+    stats->pending = pending_count;
+    stats->sector_erases = sector_erases;
+    xSemaphoreGive(log_mutex);
+}
+
+const char *event_kind_to_string(event_kind_t kind)
+{
+    switch (kind) {
+        case EVENT_KIND_FRAME:   return "frame";
+        case EVENT_KIND_RULE:    return "rule";
+        case EVENT_KIND_PRESS:   return "press";
+        case EVENT_KIND_HOLD:    return "hold";
+        case EVENT_KIND_RELEASE: return "release";
+        default:                 return "unknown";
+    }
+}
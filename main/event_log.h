@@ -0,0 +1,75 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Label of the data partition the log lives in (see partitions.csv)
+#define EVENT_LOG_PARTITION_LABEL "rflog"
+
+typedef enum {
+    EVENT_KIND_FRAME = 0,   // An accepted RF frame (older firmware logged every frame)
+    EVENT_KIND_RULE,        // A rule with a publish action fired, pulse_length holds the rule id
+    EVENT_KIND_PRESS,       // A button press, the first frame of a burst
+    EVENT_KIND_HOLD,        // Button still held, pulse_length holds the duration in ms
+    EVENT_KIND_RELEASE,     // Button released, pulse_length holds the press duration in ms
+} event_kind_t;
+
+// On-flash record. Kept at exactly 16 bytes so a 4 KiB sector holds 256 of them
+// and records never straddle a sector.
+typedef struct __attribute__((packed)) {
+    uint32_t seq;           // 0xFFFFFFFF means erased / never written
+    uint32_t timestamp;     // Unix seconds (seconds since boot until SNTP has synced)
+    uint32_t code;
+    uint16_t pulse_length;
+    uint8_t bit_length;
+    uint8_t meta;           // Low nibble: protocol, high nibble: event_kind_t
+} event_record_t;
+
+#define EVENT_RECORD_PROTOCOL(r) ((r)->meta & 0x0F)
+#define EVENT_RECORD_KIND(r)     ((event_kind_t)((r)->meta >> 4))
+
+typedef struct {
+    uint32_t capacity;      // Records the partition can hold
+    uint32_t oldest_seq;    // Oldest record still on flash
+    uint32_t next_seq;      // Sequence number the next record will get
+    uint32_t pending;       // Records buffered in RAM, not yet on flash
+    uint32_t sector_erases; // Erases since boot
+} event_log_stats_t;
+
+// Mounts the log partition and recovers the write position. Safe to call when
+// the partition is missing; the log then stays disabled and appends are dropped.
+esp_err_t event_log_init(void);
+
+// Buffers a record in RAM. Records hit flash in batches (see event_log_tick).
+void event_log_append(event_kind_t kind, uint32_t code, uint8_t bit_length, uint8_t protocol, uint16_t pulse_length);
+
+// Writes buffered records once the batch is full or has waited long enough.
+// Cheap to call often, the RF monitor loop calls it every iteration.
+void event_log_tick(void);
+
+// Forces all buffered records onto flash.
+void event_log_flush(void);
+
+// Reads up to max_records records starting at start_seq straight from flash.
+// Returns the number of records copied into out; 0 once start_seq reaches the end.
+size_t event_log_read(uint32_t start_seq, event_record_t *out, size_t max_records);
+
+// Returns the first sequence number whose timestamp is >= timestamp
+// (binary search over flash, assumes timestamps grow with the sequence).
+uint32_t event_log_seq_at_time(uint32_t timestamp);
+
+void event_log_get_stats(event_log_stats_t *stats);
+const char *event_kind_to_string(event_kind_t kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_LOG_H
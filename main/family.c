@@ -0,0 +1,202 @@
+#include "family.h"
+#include <string.h>
+#include "esp_log.h"
+
+static const char *TAG = "FAMILY";
+
+// Decoders share a protocol/bit length slot in registry order, so a strict
+// decoder placed first can claim frames before a catch-all one sees them.
+// A decoder only returns FAMILY_REJECTED when the protocol, bit length and sync
+// timing already identify its family; one that merely recognises a bit pattern
+// returns FAMILY_NONE on a mismatch, since the frame may be any other remote's.
+#define FAMILY_MAX_PER_SLOT 3
+
+typedef family_result_t (*family_decode_fn)(const radio_frame_t *frame, family_fields_t *fields);
+
+typedef struct {
+    const char *name;
+    uint8_t protocol;           // 0 = any
+    uint8_t bit_length;
+    uint16_t min_pulse_us;      // Decoded pulse length window, 0 = no limit
+    uint16_t max_pulse_us;
+    family_decode_fn decode;
+} family_decoder_t;
+
+// Remotes with the classic 1:31 sync. timings[0] is the gap before the frame; the first
+// frame of a burst follows idle air, so only a gap that is clearly too short disqualifies.
+static bool has_long_sync(const radio_frame_t *frame)
+{
+    return frame->timing_count == 0 || frame->pulse_length == 0 ||
+           frame->timings[0] >= 20 * frame->pulse_length;
+}
+
+// PT2262 / SC2262: 12 tri-state symbols of two bits each, 00 = '0', 11 = '1', 01 = 'F'.
+// The first 8 symbols are the address, the last 4 the data lines (buttons).
+static family_result_t decode_pt2262(const radio_frame_t *frame, family_fields_t *fields)
+{
+    if (!has_long_sync(frame)) return FAMILY_NONE;
+
+    uint32_t address = 0;
+    uint8_t data = 0;
+    for (int i = 0; i < 12; i++) {
+        uint8_t pair = (frame->code >> (22 - 2 * i)) & 0x3;
+        char symbol;
+        switch (pair) {
+            case 0x0: symbol = '0'; break;
+            case 0x3: symbol = '1'; break;
+            case 0x1: symbol = 'F'; break;
+            default:  return FAMILY_NONE;   // 10 is not a PT2262 symbol, most likely EV1527
+        }
+        fields->tristate[i] = symbol;
+        if (i < 8) {
+            address = (address << 2) | pair;
+        } else {
+            data = (data << 1) | (symbol == '1');
+        }
+    }
+    fields->tristate[12] = '\0';
+
+    fields->device_id = address;
+    fields->button = data;
+    fields->flags = FAMILY_HAS_DEVICE_ID | FAMILY_HAS_BUTTON | FAMILY_HAS_TRISTATE;
+    return FAMILY_DECODED;
+}
+
+// EV1527 learning code: 20-bit device ID followed by 4 key bits
+static family_result_t decode_ev1527(const radio_frame_t *frame, family_fields_t *fields)
+{
+    if (!has_long_sync(frame)) return FAMILY_NONE;
+
+    uint32_t id = frame->code >> 4;
+    if (id == 0 || id == 0xFFFFF) return FAMILY_NONE;
+
+    fields->device_id = id;
+    fields->button = frame->code & 0xF;
+    fields->flags = FAMILY_HAS_DEVICE_ID | FAMILY_HAS_BUTTON;
+    return FAMILY_DECODED;
+}
+
+// 32-bit temperature sensor frame, protocol 1 timing on a ~500 us clock:
+//   [31:28] 0x5 preamble  [27:20] ID  [19] battery low  [18:16] channel - 1
+//   [15:4] temperature, signed tenths of a degree  [3:0] sum of nibbles 27..4, mod 16
+// Remotes on protocol 1 run at 300-450 us, so the pulse window in the registry, the
+// long sync and the preamble together identify the sensor and a bad checksum is
+// a corrupt frame.
+static family_result_t decode_temp_sensor(const radio_frame_t *frame, family_fields_t *fields)
+{
+    uint32_t code = frame->code;
+    if (!has_long_sync(frame) || (code >> 28) != 0x5) return FAMILY_NONE;
+
+    uint8_t sum = 0;
+    for (int shift = 4; shift < 28; shift += 4) {
+        sum += (code >> shift) & 0xF;
+    }
+    if ((sum & 0xF) != (code & 0xF)) return FAMILY_REJECTED;
+
+    int16_t temperature = (code >> 4) & 0xFFF;
+    if (temperature & 0x800) temperature -= 0x1000;
+
+    fields->device_id = (code >> 20) & 0xFF;
+    fields->battery_low = (code >> 19) & 0x1;
+    fields->channel = ((code >> 16) & 0x7) + 1;
+    fields->temperature = temperature;
+    fields->flags = FAMILY_HAS_DEVICE_ID | FAMILY_HAS_BATTERY | FAMILY_HAS_CHANNEL | FAMILY_HAS_TEMPERATURE;
+    return FAMILY_DECODED;
+}
+
+static const family_decoder_t decoders[] = {
+    { "pt2262",      1, 24,   0,   0, decode_pt2262 },
+    { "ev1527",      1, 24,   0,   0, decode_ev1527 },
+    { "temp-sensor", 1, 32, 470, 560, decode_temp_sensor },
+};
+
+#define NUM_DECODERS (int)(sizeof(decoders) / sizeof(decoders[0]))
+
+// Indexed by [protocol][bit length], entries are decoder index + 1 (0 = empty)
+static uint8_t dispatch[RC_SWITCH_NUM_PROTOCOLS + 1][RC_SWITCH_MAX_BITS + 1][FAMILY_MAX_PER_SLOT];
+static uint32_t decoded_count[NUM_DECODERS];
+static uint32_t rejected_count[NUM_DECODERS];
+
+static void add_to_slot(uint8_t protocol, uint8_t bit_length, int decoder)
+{
+    uint8_t *slot = dispatch[protocol][bit_length];
+    for (int i = 0; i < FAMILY_MAX_PER_SLOT; i++) {
+        if (slot[i] == 0) {
+            slot[i] = decoder + 1;
+            return;
+        }
+    }
+    ESP_LOGW(TAG, "No room for '%s' at protocol %d / %d bits", decoders[decoder].name, protocol, bit_length);
+}
+
+void family_init(void)
+{
+    memset(dispatch, 0, sizeof(dispatch));
+
+    for (int d = 0; d < NUM_DECODERS; d++) {
+        const family_decoder_t *dec = &decoders[d];
+        if (dec->bit_length > RC_SWITCH_MAX_BITS || dec->protocol > RC_SWITCH_NUM_PROTOCOLS) continue;
+
+        if (dec->protocol == 0) {
+            for (uint8_t p = 1; p <= RC_SWITCH_NUM_PROTOCOLS; p++) {
+                add_to_slot(p, dec->bit_length, d);
+            }
+        } else {
+            add_to_slot(dec->protocol, dec->bit_length, d);
+        }
+    }
+
+    ESP_LOGI(TAG, "%d device family decoders registered", NUM_DECODERS);
+}
+
+family_result_t family_decode(const radio_frame_t *frame, family_fields_t *fields)
+{
+    memset(fields, 0, sizeof(*fields));
+
+    if (frame->protocol > RC_SWITCH_NUM_PROTOCOLS || frame->bit_length > RC_SWITCH_MAX_BITS) {
+        return FAMILY_NONE;
+    }
+
+    const uint8_t *slot = dispatch[frame->protocol][frame->bit_length];
+    for (int i = 0; i < FAMILY_MAX_PER_SLOT && slot[i] != 0; i++) {
+        int d = slot[i] - 1;
+        if ((decoders[d].min_pulse_us != 0 && frame->pulse_length < decoders[d].min_pulse_us) ||
+            (decoders[d].max_pulse_us != 0 && frame->pulse_length > decoders[d].max_pulse_us)) {
+            continue;
+        }
+        family_result_t result = decoders[d].decode(frame, fields);
+
+        if (result == FAMILY_DECODED) {
+            fields->family = decoders[d].name;
+            decoded_count[d]++;
+            return result;
+        }
+        if (result == FAMILY_REJECTED) {
+            memset(fields, 0, sizeof(*fields));
+            rejected_count[d]++;
+            return result;
+        }
+        memset(fields, 0, sizeof(*fields));
+    }
+
+    return FAMILY_NONE;
+}
+
+int family_count(void)
+{
+    return NUM_DECODERS;
+}
+
+bool family_get_stats(int index, family_stats_t *stats)
+{
+    if (index < 0 || index >= NUM_DECODERS) return false;
+
+    stats->name = decoders[index].name;
+    stats->protocol = decoders[index].protocol;
+    stats->bit_length = decoders[index].bit_length;
+    stats->min_pulse_us = decoders[index].min_pulse_us;
+    stats->max_pulse_us = decoders[index].max_pulse_us;
+    stats->decoded = decoded_count[index];
+    stats->rejected = rejected_count[index];
+    return true;
+}
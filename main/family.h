@@ -0,0 +1,61 @@
+#ifndef FAMILY_H
+#define FAMILY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "radio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Which fields of family_fields_t a decoder filled in
+#define FAMILY_HAS_DEVICE_ID   (1 << 0)
+#define FAMILY_HAS_BUTTON      (1 << 1)
+#define FAMILY_HAS_TRISTATE    (1 << 2)
+#define FAMILY_HAS_CHANNEL     (1 << 3)
+#define FAMILY_HAS_BATTERY     (1 << 4)
+#define FAMILY_HAS_TEMPERATURE (1 << 5)
+
+// Structured view of a frame from a known device family
+typedef struct {
+    const char *family;         // Decoder name, NULL when no family matched
+    uint8_t flags;              // FAMILY_HAS_*
+    uint32_t device_id;
+    uint8_t button;
+    char tristate[17];          // PT2262 symbols ('0', '1', 'F')
+    uint8_t channel;
+    bool battery_low;
+    int16_t temperature;        // Tenths of a degree Celsius
+} family_fields_t;
+
+typedef enum {
+    FAMILY_NONE = 0,            // No decoder for this protocol/bit length, or none matched
+    FAMILY_DECODED,             // fields are filled in
+    FAMILY_REJECTED,            // The frame is unmistakably this family's but failed validation, drop it
+} family_result_t;
+
+typedef struct {
+    const char *name;
+    uint8_t protocol;           // 1-based rc_switch protocol, 0 = any
+    uint8_t bit_length;
+    uint16_t min_pulse_us;      // Pulse length window the decoder runs in, 0 = no limit
+    uint16_t max_pulse_us;
+    uint32_t decoded;
+    uint32_t rejected;
+} family_stats_t;
+
+// Builds the protocol x bit length dispatch table from the decoder registry
+void family_init(void);
+
+// Runs the decoders registered for the frame's protocol and bit length
+family_result_t family_decode(const radio_frame_t *frame, family_fields_t *fields);
+
+int family_count(void);
+bool family_get_stats(int index, family_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FAMILY_H
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# Builds the HTTP route trie from routes.def, see router.h for the layout.
+#
+#   gen_routes.py routes.def routes_trie.h
+
+import re
+import sys
+
+METHODS = ["GET", "POST", "PUT", "DELETE"]  # Order of router_method_t
+NONE = 0xFF
+
+ROUTE_RE = re.compile(r'^\s*ROUTE\(\s*(\w+)\s*,\s*"([^"]*)"\s*,\s*(\w+)\s*\)\s*$')
+
+
+class Node:
+    def __init__(self, segment, param=None):
+        self.segment = segment      # None for a parameter
+        self.param = param
+        self.literals = {}
+        self.param_child = None
+        self.routes = [NONE] * len(METHODS)
+        self.index = None
+
+
+def fail(path, line_no, message):
+    sys.exit(f"{path}:{line_no}: {message}")
+
+
+def parse(path):
+    routes = []
+    with open(path) as f:
+        for line_no, line in enumerate(f, 1):
+            stripped = line.split("//", 1)[0].strip()
+            if not stripped:
+                continue
+            m = ROUTE_RE.match(stripped)
+            if not m:
+                fail(path, line_no, "expected ROUTE(method, \"path\", handler)")
+            method, route_path, handler = m.groups()
+            if method not in METHODS:
+                fail(path, line_no, f"unknown method {method}")
+            if not route_path.startswith("/") or route_path.endswith("/") or "//" in route_path:
+                fail(path, line_no, f"bad path {route_path}")
+            routes.append((line_no, method, route_path, handler))
+    if len(routes) >= NONE:
+        sys.exit(f"{path}: too many routes, the trie stores route indexes in a byte")
+    return routes
+
+
+def build(path, routes):
+    root = Node("")
+    for index, (line_no, method, route_path, _) in enumerate(routes):
+        node = root
+        params = 0
+        for segment in route_path[1:].split("/"):
+            if segment.startswith("{") and segment.endswith("}"):
+                name = segment[1:-1]
+                params += 1
+                if node.param_child is None:
+                    node.param_child = Node(None, name)
+                elif node.param_child.param != name:
+                    fail(path, line_no, f"{{{name}}} where other routes have {{{node.param_child.param}}}")
+                node = node.param_child
+            else:
+                if "{" in segment or "}" in segment or "%" in segment:
+                    fail(path, line_no, f"bad segment {segment}")
+                node = node.literals.setdefault(segment, Node(segment))
+        if params > 2:
+            fail(path, line_no, "more than ROUTER_MAX_PARAMS parameters")
+        m = METHODS.index(method)
+        if node.routes[m] != NONE:
+            fail(path, line_no, f"{method} {route_path} is already routed")
+        node.routes[m] = index
+    return root
+
+
+def layout(root):
+    # Breadth first, so the children of every node end up next to each other
+    nodes = [root]
+    root.index = 0
+    for node in nodes:
+        children = [node.literals[k] for k in sorted(node.literals, key=lambda s: s.encode())]
+        if node.param_child is not None:
+            children.append(node.param_child)
+        node.first_child = len(nodes)
+        for child in children:
+            child.index = len(nodes)
+            nodes.append(child)
+    if len(nodes) >= NONE:
+        sys.exit("too many trie nodes, they are indexed with a byte")
+    return nodes
+
+
+def c_string(s):
+    return "NULL" if s is None else '"' + s + '"'
+
+
+def emit(out_path, def_name, routes, nodes):
+    lines = [
+        f"// Generated by gen_routes.py from {def_name}, do not edit",
+        "#pragma once",
+        "",
+        '#include "router.h"',
+        "",
+        f"#define API_ROUTE_COUNT {len(routes)}",
+        "",
+        "static const router_node_t api_route_nodes[] = {",
+    ]
+    for node in nodes:
+        label = "/" if node.index == 0 else (node.segment if node.segment is not None else "{" + node.param + "}")
+        route = ", ".join("ROUTER_NONE" if r == NONE else str(r) for r in node.routes)
+        param_child = "ROUTER_NONE" if node.param_child is None else str(node.param_child.index)
+        lines.append(
+            f"    [{node.index}] = {{ .segment = {c_string(node.segment)}, "
+            f".length = {len(node.segment or '')}, .first_child = {node.first_child}, "
+            f".literal_count = {len(node.literals)}, .param_child = {param_child}, "
+            f".route = {{ {route} }} }},    // {label}")
+    lines += [
+        "};",
+        "",
+        "static const router_trie_t api_route_trie = {",
+        "    .nodes = api_route_nodes,",
+        "    .node_count = sizeof(api_route_nodes) / sizeof(api_route_nodes[0]),",
+        "};",
+        "",
+    ]
+    with open(out_path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: gen_routes.py routes.def routes_trie.h")
+    def_path, out_path = sys.argv[1:]
+    routes = parse(def_path)
+    nodes = layout(build(def_path, routes))
+    emit(out_path, def_path.replace("\\", "/").rsplit("/", 1)[-1], routes, nodes)
+
+
+if __name__ == "__main__":
+    main()
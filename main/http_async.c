@@ -0,0 +1,155 @@
+#include "http_async.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "trace.h"
+
+static const char *TAG = "HTTP_ASYNC";
+
+#define HTTP_ASYNC_MAX_WORKERS 2    // Per class
+#define HTTP_ASYNC_STACK       5120 // Handlers were written for the 4 KiB server task stack
+#define HTTP_ASYNC_PRIORITY    (tskIDLE_PRIORITY + 5)   // Same as the server task
+
+typedef struct {
+    const char *name;
+    uint8_t workers;
+    uint8_t queue_depth;
+} class_def_t;
+
+// One transmit at a time, the radio serializes them anyway. Storage requests run one
+// at a time so changes never interleave with each other or with an export.
+static const class_def_t classes[HTTP_ASYNC_CLASS_COUNT] = {
+    [HTTP_ASYNC_TRANSMIT] = { "transmit", 1, 4 },
+    [HTTP_ASYNC_STORAGE]  = { "storage",  1, 4 },
+    [HTTP_ASYNC_STREAM]   = { "stream",   1, 2 },
+};
+
+typedef struct {
+    httpd_req_t *req;
+    esp_err_t (*handler)(httpd_req_t *req);
+    int64_t queued_at;
+} job_t;
+
+static QueueHandle_t queues[HTTP_ASYNC_CLASS_COUNT];
+static TaskHandle_t workers[HTTP_ASYNC_CLASS_COUNT][HTTP_ASYNC_MAX_WORKERS];
+static http_async_stats_t stats[HTTP_ASYNC_CLASS_COUNT];
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool on_worker(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int c = 0; c < HTTP_ASYNC_CLASS_COUNT; c++) {
+        for (int w = 0; w < classes[c].workers; w++) {
+            if (workers[c][w] == self) return true;
+        }
+    }
+    return false;
+}
+
+static void worker_task(void *arg)
+{
+    http_async_class_t cls = (http_async_class_t)(intptr_t)arg;
+    job_t job;
+
+    while (1) {
+        if (xQueueReceive(queues[cls], &job, portMAX_DELAY) != pdTRUE) continue;
+
+        int64_t start = esp_timer_get_time();
+        uint32_t waited = (uint32_t)(start - job.queued_at);
+        portENTER_CRITICAL(&stats_lock);
+        stats[cls].queued--;
+        stats[cls].running++;
+        stats[cls].wait_us += waited;
+        stats[cls].max_wait_us = MAX(stats[cls].max_wait_us, waited);
+        portEXIT_CRITICAL(&stats_lock);
+
+        TRACE_BEGIN(TRACE_HTTP_WORKER, cls);
+        job.handler(job.req);
+        httpd_req_async_handler_complete(job.req);
+        TRACE_END(TRACE_HTTP_WORKER, cls);
+
+        uint32_t ran = (uint32_t)(esp_timer_get_time() - start);
+        portENTER_CRITICAL(&stats_lock);
+        stats[cls].running--;
+        stats[cls].completed++;
+        stats[cls].run_us += ran;
+        stats[cls].max_run_us = MAX(stats[cls].max_run_us, ran);
+        portEXIT_CRITICAL(&stats_lock);
+    }
+}
+
+esp_err_t http_async_init(void)
+{
+    if (queues[0] != NULL) return ESP_OK;   // The server restarts on reconnect, the pool stays
+
+    for (int c = 0; c < HTTP_ASYNC_CLASS_COUNT; c++) {
+        queues[c] = xQueueCreate(classes[c].queue_depth, sizeof(job_t));
+        if (queues[c] == NULL) return ESP_ERR_NO_MEM;
+        stats[c].workers = classes[c].workers;
+        stats[c].queue_depth = classes[c].queue_depth;
+
+        for (int w = 0; w < classes[c].workers; w++) {
+            char name[16];
+            snprintf(name, sizeof(name), "http_%s", classes[c].name);
+            if (xTaskCreate(worker_task, name, HTTP_ASYNC_STACK, (void *)(intptr_t)c,
+                            HTTP_ASYNC_PRIORITY, &workers[c][w]) != pdPASS) {
+                ESP_LOGE(TAG, "Failed to start %s worker", classes[c].name);
+                return ESP_ERR_NO_MEM;
+            }
+        }
+    }
+
+    ESP_LOGI(TAG, "Async workers started");
+    return ESP_OK;
+}
+
+bool http_async_defer(httpd_req_t *req, http_async_class_t cls, esp_err_t (*handler)(httpd_req_t *req))
+{
+    if (queues[cls] == NULL || on_worker()) return false;
+
+    // Only the server task submits, so the space check cannot go stale before the send
+    if (uxQueueSpacesAvailable(queues[cls]) == 0) {
+        portENTER_CRITICAL(&stats_lock);
+        stats[cls].rejected++;
+        portEXIT_CRITICAL(&stats_lock);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"error\":\"Server busy, try again\"}");
+        return true;
+    }
+
+    job_t job = {
+        .handler = handler,
+        .queued_at = esp_timer_get_time(),
+    };
+    if (httpd_req_async_handler_begin(req, &job.req) != ESP_OK) {
+        portENTER_CRITICAL(&stats_lock);
+        stats[cls].inline_runs++;
+        portEXIT_CRITICAL(&stats_lock);
+        return false;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    stats[cls].queued++;
+    portEXIT_CRITICAL(&stats_lock);
+    xQueueSend(queues[cls], &job, portMAX_DELAY);
+    return true;
+}
+
+void http_async_get_stats(http_async_class_t cls, http_async_stats_t *out)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats[cls];
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+const char *http_async_class_to_string(http_async_class_t cls)
+{
+    return cls < HTTP_ASYNC_CLASS_COUNT ? classes[cls].name : "unknown";
+}
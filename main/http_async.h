@@ -0,0 +1,54 @@
+#ifndef HTTP_ASYNC_H
+#define HTTP_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Slow handlers are handed from the server task to worker tasks so a transmit or a
+// long download never stalls the rest of the API. Each class has its own workers and
+// queue: its worker count is its concurrency limit, a full queue is answered with 503.
+typedef enum {
+    HTTP_ASYNC_TRANSMIT = 0,    // Radio sends, up to hundreds of ms each
+    HTTP_ASYNC_STORAGE,         // Signal library, rules, schedule and settings changes, library export
+    HTTP_ASYNC_STREAM,          // Long streamed responses (event log)
+    HTTP_ASYNC_CLASS_COUNT
+} http_async_class_t;
+
+typedef struct {
+    uint8_t workers;
+    uint8_t queue_depth;
+    uint32_t queued;            // Waiting for a worker right now
+    uint32_t running;
+    uint32_t completed;
+    uint32_t rejected;          // Answered with 503, the queue was full
+    uint32_t inline_runs;       // Ran on the server task, handing off failed
+    uint64_t wait_us;           // Total time spent queued
+    uint32_t max_wait_us;
+    uint64_t run_us;            // Total time spent in the handler
+    uint32_t max_run_us;
+} http_async_stats_t;
+
+// Starts the workers. Handlers run inline on the server task until this succeeded.
+esp_err_t http_async_init(void);
+
+// Call at the top of a slow handler:
+//     if (http_async_defer(req, HTTP_ASYNC_TRANSMIT, my_handler)) return ESP_OK;
+// Returns true when the request was queued for a worker (or rejected with 503), false
+// when the handler should do the work itself: it is already running on a worker, or
+// the request could not be handed off.
+bool http_async_defer(httpd_req_t *req, http_async_class_t cls, esp_err_t (*handler)(httpd_req_t *req));
+
+void http_async_get_stats(http_async_class_t cls, http_async_stats_t *out);
+const char *http_async_class_to_string(http_async_class_t cls);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_ASYNC_H
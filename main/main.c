@@ -1,9 +1,12 @@
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 #include <sys/param.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
 #include "esp_system.h"
 #include "esp_random.h"
 #include "esp_wifi.h"
@@ -12,13 +15,32 @@
 #include "esp_timer.h"
 #include "nvs_flash.h"
 #include "esp_netif.h"
+#include "esp_netif_sntp.h"
 #include "esp_http_server.h"
 #include "cJSON.h"
-#include "rc_switch.h"
+#include "radio.h"
+#include "airtime.h"
+#include "rollup.h"
+#include "usage.h"
+#include "family.h"
+#include "burst.h"
+#include "rules.h"
+#include "scheduler.h"
+#include "event_log.h"
+#include "seqlock.h"
+#include "wifi_profile.h"
+#include "settings.h"
+#include "http_async.h"
+#include "api_format.h"
+#include "routes_trie.h"
+#include "trace.h"
 #include "config.h"
 static const char *TAG = "433MHZ_CONTROLLER";
-#define MAX_SIGNALS 50
-#define MAX_TRACKED_SIGNALS 10
+#define MAX_SIGNALS 500
+#define MAX_TRACKED_SIGNALS SETTINGS_TRACKED_CAPACITY   // Runtime limit: settings tracked_max
+
+#define SIGNAL_MAX_GAP_MS   1000
+#define SIGNAL_MAX_PULSE_US 5000
 
 typedef struct {
     char name[64];
@@ -26,8 +48,33 @@ typedef struct {
     uint8_t bit_length;
     uint8_t protocol;
     uint16_t pulse_length;
+    // Transmit settings, 0 means the radio default
+    uint8_t repeats;
+    uint8_t verify;             // Stop repeating once our own receiver heard the frame this often
+    uint8_t max_repeats;        // With verify: repeat up to this many times while not heard
+    uint8_t reserved;
+    uint16_t gap_ms;            // Pause between repeats
+    uint16_t tx_pulse_length;   // Transmit with this pulse length instead of the captured one
 } rf_signal_t;
 
+// NVS layout before the transmit settings existed, migrated on the first boot
+typedef struct {
+    char name[64];
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    uint16_t pulse_length;
+} rf_signal_v1_t;
+
+#define SIGNALS_NVS_KEY    "signals_v2"
+#define SIGNALS_V1_NVS_KEY "signals"
+
+// The signal library has an NVS partition of its own: a full library is a ~40 KiB blob
+// and NVS needs room for the old and the new copy while rewriting it. Devices still on
+// an older partition table (app-only flash, OTA) keep it in the default NVS, where only
+// a smaller library fits.
+#define LIBRARY_NVS_PARTITION "library"
+
 typedef struct {
     uint32_t code;
     uint8_t bit_length;
@@ -36,28 +83,106 @@ typedef struct {
     uint32_t count;
     int64_t first_seen;
     int64_t last_seen;
+    uint32_t seq;           // Change sequence of the last update to this entry
+    family_fields_t fields; // Decoded device family fields of the latest frame
+    uint8_t state;          // burst_event_type_t of the latest button event
+    uint32_t duration_ms;   // Press duration so far (hold) or in total (release)
 } tracked_signal_t;
 
-static rc_receiver_t receiver;
-static rc_transmitter_t transmitter;
+// Latest button event. The RF monitor publishes it through latest_lock, HTTP handlers
+// copy it out without ever blocking the monitor.
+typedef struct {
+    uint32_t seq;           // Change sequence it was recorded under, 0 = nothing yet
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    uint16_t pulse_length;
+    uint32_t count;
+    uint8_t state;          // burst_event_type_t
+    uint32_t duration_ms;
+    family_fields_t fields;
+} latest_signal_t;
+
+typedef struct {
+    uint32_t acquisitions;
+    uint32_t contended;     // Acquisitions that found the mutex taken
+    uint64_t wait_us;
+    uint32_t max_wait_us;
+    uint64_t hold_us;
+    uint32_t max_hold_us;
+} lock_stats_t;
+
 static rf_signal_t saved_signals[MAX_SIGNALS];
 static int signal_count = 0;
+static SemaphoreHandle_t library_mutex = NULL;     // Guards saved_signals and signal_count
+static SemaphoreHandle_t library_write_mutex = NULL; // One change of the library at a time
+static const char *library_partition = NVS_DEFAULT_PART_NAME;
 static int retry_num = 0;
+static esp_timer_handle_t reconnect_timer = NULL;
 static tracked_signal_t tracked_signals[MAX_TRACKED_SIGNALS];
 static int tracked_count = 0;
 static SemaphoreHandle_t tracked_signals_mutex = NULL;
-static rf_signal_t last_signal = {0};
-static bool new_signal_received = false;
-static uint32_t last_signal_count = 0;
-static uint32_t last_valid_code = 0;
-static int64_t last_valid_time = 0;
+static lock_stats_t tracking_lock_stats = {0};     // Updated with the mutex held
+static int64_t tracking_locked_at = 0;
+static latest_signal_t latest_signal = {0};
+static seqlock_t latest_lock = SEQLOCK_INIT;
+static volatile bool filter_reset_requested = false; // Noise filter state is private to the RF monitor
 static httpd_handle_t server = NULL;
+
+// Boot is split into phases that run as soon as their inputs are ready: RF first,
+// storage in the background, network services once we actually have an IP.
+typedef enum {
+    BOOT_PHASE_RF_READY,
+    BOOT_PHASE_NVS_READY,
+    BOOT_PHASE_WIFI_STARTED,
+    BOOT_PHASE_STORAGE_LOADED,
+    BOOT_PHASE_GOT_IP,
+    BOOT_PHASE_HTTP_READY,
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+static const char *boot_phase_names[BOOT_PHASE_COUNT] = {
+    "rfReady", "nvsReady", "wifiStarted", "storageLoaded", "gotIp", "httpReady"
+};
+static int64_t boot_phase_us[BOOT_PHASE_COUNT];
+
+#define BOOT_STORAGE_LOADED_BIT BIT0
+#define BOOT_GOT_IP_BIT         BIT1
+static EventGroupHandle_t boot_events = NULL;
+static portMUX_TYPE services_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool services_started = false;
+
+// Wi-Fi reconnect backoff once MAX_RETRY quick retries are used up
+#define WIFI_BACKOFF_BASE_MS 1000
+#define WIFI_BACKOFF_MAX_MS  300000
+
+// Change sequence of the tracking store. Every insert/update bumps it and stamps the
+// entry, removals also move tracking_reset_seq so delta clients know to resync.
+static uint32_t tracking_seq = 0;
+static uint32_t tracking_reset_seq = 0;
+
+// Long-poll support for /api/signal-history?since=N&wait=ms
+#define LONGPOLL_MAX_PARKED 4
+#define HTTP_MAX_OPEN_SOCKETS 13    // CONFIG_LWIP_MAX_SOCKETS (16) minus the 3 the server uses itself
+#define LONGPOLL_MAX_WAIT_MS 30000
+typedef struct {
+    httpd_req_t *req;
+    uint32_t since;
+    int64_t deadline;
+} parked_poll_t;
+static QueueHandle_t longpoll_queue = NULL;
+static TaskHandle_t longpoll_task_handle = NULL;
+// Incremented by handlers, decremented by the long-poll task, only touched atomically
+static int longpoll_parked = 0;
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data);
 static void load_signals_from_nvs(void);
 static void save_signals_to_nvs(void);
-static void track_signal(uint32_t code, uint8_t bit_length, uint8_t protocol, uint16_t pulse_length);
+static uint32_t track_signal(uint32_t code, uint8_t bit_length, uint8_t protocol, uint16_t pulse_length,
+                             const family_fields_t *fields, burst_event_type_t state, uint32_t duration_ms,
+                             uint32_t *count);
 static void cleanup_old_tracked_signals(void);
+static httpd_handle_t start_webserver(void);
 static esp_err_t index_handler(httpd_req_t *req);
 static esp_err_t api_info_handler(httpd_req_t *req);
 static esp_err_t api_signals_get_handler(httpd_req_t *req);
@@ -68,7 +193,26 @@ static esp_err_t api_transmit_name_handler(httpd_req_t *req);
 static esp_err_t api_transmit_direct_handler(httpd_req_t *req);
 static esp_err_t api_signal_history_handler(httpd_req_t *req);
 static esp_err_t api_clear_tracking_handler(httpd_req_t *req);
+static esp_err_t api_settings_get_handler(httpd_req_t *req);
 static esp_err_t api_settings_handler(httpd_req_t *req);
+static esp_err_t api_events_handler(httpd_req_t *req);
+static esp_err_t api_wifi_profile_get_handler(httpd_req_t *req);
+static esp_err_t api_wifi_profile_post_handler(httpd_req_t *req);
+static esp_err_t api_ping_handler(httpd_req_t *req);
+static esp_err_t api_signals_export_handler(httpd_req_t *req);
+static esp_err_t api_signals_import_handler(httpd_req_t *req);
+static esp_err_t api_radios_handler(httpd_req_t *req);
+static esp_err_t api_families_handler(httpd_req_t *req);
+static esp_err_t api_airtime_handler(httpd_req_t *req);
+static esp_err_t api_rollups_handler(httpd_req_t *req);
+static esp_err_t api_http_stats_handler(httpd_req_t *req);
+static esp_err_t api_trace_handler(httpd_req_t *req);
+static esp_err_t api_rules_get_handler(httpd_req_t *req);
+static esp_err_t api_rules_post_handler(httpd_req_t *req);
+static esp_err_t api_rules_delete_handler(httpd_req_t *req);
+static esp_err_t api_schedule_get_handler(httpd_req_t *req);
+static esp_err_t api_schedule_post_handler(httpd_req_t *req);
+static esp_err_t api_schedule_delete_handler(httpd_req_t *req);
 
 static void wifi_init_sta(void)
 {
@@ -90,20 +234,71 @@ static void wifi_init_sta(void)
                                                         NULL,
                                                         &instance_got_ip));
 
+    wifi_profile_t profile = wifi_profile_load();
+
     wifi_config_t wifi_config = {
         .sta = {
             .ssid = WIFI_SSID,
             .password = WIFI_PASS,
             .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+            .listen_interval = wifi_profile_listen_interval(profile),
         },
     };
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
+    wifi_profile_apply();
 
     ESP_LOGI(TAG, "WiFi initialization finished. Connecting to %s...", WIFI_SSID);
 }
 
+// Records when a boot phase completed (first time only) and logs it
+static void boot_mark(boot_phase_t phase)
+{
+    if (boot_phase_us[phase] != 0) return;
+    boot_phase_us[phase] = esp_timer_get_time();
+    ESP_LOGI(TAG, "[BOOT] %s at %lld ms", boot_phase_names[phase], boot_phase_us[phase] / 1000);
+}
+
+// Starts the web server and other network services once storage is loaded and we
+// have an IP, whichever of the two happens last. Runs exactly once.
+static void start_network_services(void)
+{
+    EventBits_t bits = xEventGroupGetBits(boot_events);
+    if ((bits & (BOOT_STORAGE_LOADED_BIT | BOOT_GOT_IP_BIT)) != (BOOT_STORAGE_LOADED_BIT | BOOT_GOT_IP_BIT)) {
+        return;
+    }
+
+    portENTER_CRITICAL(&services_lock);
+    bool already_started = services_started;
+    services_started = true;
+    portEXIT_CRITICAL(&services_lock);
+    if (already_started) return;
+
+    // Wall-clock time for the event log and the scheduler
+    esp_sntp_config_t sntp_config = ESP_NETIF_SNTP_DEFAULT_CONFIG("pool.ntp.org");
+    esp_netif_sntp_init(&sntp_config);
+
+    server = start_webserver();
+    boot_mark(BOOT_PHASE_HTTP_READY);
+
+    ESP_LOGI(TAG, "===============================================================");
+    esp_netif_ip_info_t ip_info;
+    esp_err_t ip_ret = esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"), &ip_info);
+    if (server != NULL && ip_ret == ESP_OK) {
+        ESP_LOGI(TAG, "Web UI is now available! Access at http://" IPSTR, IP2STR(&ip_info.ip));
+    } else if (server != NULL) {
+        ESP_LOGI(TAG, "Web UI is now available, but failed to get device IP address.");
+    }
+    ESP_LOGI(TAG, "===============================================================");
+}
+
+static void reconnect_timer_callback(void *arg)
+{
+    ESP_LOGI(TAG, "Retry connecting to WiFi (backoff)...");
+    esp_wifi_connect();
+}
+
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
 {
@@ -115,85 +310,252 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
             retry_num++;
             ESP_LOGI(TAG, "Retry connecting to WiFi...");
         } else {
-            ESP_LOGE(TAG, "Failed to connect to WiFi");
+            // Out of quick retries, keep trying forever but back off exponentially
+            int shift = MIN(retry_num - MAX_RETRY, 16);
+            uint32_t delay_ms = MIN((uint32_t)WIFI_BACKOFF_BASE_MS << shift, WIFI_BACKOFF_MAX_MS);
+            retry_num++;
+            ESP_LOGW(TAG, "Failed to connect to WiFi, retrying in %lu ms", delay_ms);
+            esp_timer_stop(reconnect_timer);
+            esp_timer_start_once(reconnect_timer, (uint64_t)delay_ms * 1000);
         }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Got IP address: " IPSTR, IP2STR(&event->ip_info.ip));
         retry_num = 0;
+        boot_mark(BOOT_PHASE_GOT_IP);
+        xEventGroupSetBits(boot_events, BOOT_GOT_IP_BIT);
+        start_network_services();
+    }
+}
+
+// The signal library is shared by the storage and transmit workers, the rules engine,
+// the scheduler and the monitor. Every read or change of saved_signals and signal_count
+// holds library_mutex. Readers copy entries out and use the copy after unlocking, so a
+// delete or import running at the same time never hands them half of another signal.
+// Changes also hold library_write_mutex (taken first) from start to end, which lets an
+// import stage entries past signal_count without blocking readers for the upload.
+static void library_lock(void)
+{
+    xSemaphoreTake(library_mutex, portMAX_DELAY);
+}
+
+static void library_unlock(void)
+{
+    xSemaphoreGive(library_mutex);
+}
+
+static void library_write_lock(void)
+{
+    xSemaphoreTake(library_write_mutex, portMAX_DELAY);
+}
+
+static void library_write_unlock(void)
+{
+    xSemaphoreGive(library_write_mutex);
+}
+
+static int library_count(void)
+{
+    library_lock();
+    int count = signal_count;
+    library_unlock();
+    return count;
+}
+
+// Copies the signal at index out, false past the end of the library
+static bool library_get(int index, rf_signal_t *out)
+{
+    library_lock();
+    bool found = index >= 0 && index < signal_count;
+    if (found) *out = saved_signals[index];
+    library_unlock();
+    return found;
+}
+
+// Copies the signal with this name (case-insensitive) out, false if there is none
+static bool library_find_name(const char *name, rf_signal_t *out)
+{
+    bool found = false;
+    library_lock();
+    for (int i = 0; i < signal_count && !found; i++) {
+        if (strcasecmp(saved_signals[i].name, name) == 0) {
+            *out = saved_signals[i];
+            found = true;
+        }
+    }
+    library_unlock();
+    return found;
+}
+
+// Converts a v1 blob read into saved_signals. Records only grow, so expanding
+// from the back never overwrites a record that has not been converted yet.
+static void convert_signals_v1(size_t blob_size)
+{
+    signal_count = blob_size / sizeof(rf_signal_v1_t);
+    for (int i = signal_count - 1; i >= 0; i--) {
+        rf_signal_v1_t old = ((rf_signal_v1_t *)saved_signals)[i];
+        rf_signal_t *sig = &saved_signals[i];
+        memset(sig, 0, sizeof(*sig));
+        memcpy(sig->name, old.name, sizeof(sig->name));
+        sig->code = old.code;
+        sig->bit_length = old.bit_length;
+        sig->protocol = old.protocol;
+        sig->pulse_length = old.pulse_length;
+    }
+}
+
+// Reads a blob of records of record_size bytes into saved_signals
+static bool read_signals_blob(nvs_handle_t handle, const char *key, size_t record_size, size_t *size)
+{
+    *size = 0;
+    return nvs_get_blob(handle, key, NULL, size) == ESP_OK && *size > 0 && *size <= MAX_SIGNALS * record_size &&
+           nvs_get_blob(handle, key, saved_signals, size) == ESP_OK;
+}
+
+// Writes a library read from an older location in the current layout. The old copy is
+// only erased once the new one is committed, so a power loss in between loses nothing.
+static void store_migrated_signals(nvs_handle_t from, nvs_handle_t to)
+{
+    if (nvs_set_blob(to, SIGNALS_NVS_KEY, saved_signals, signal_count * sizeof(rf_signal_t)) != ESP_OK ||
+        nvs_commit(to) != ESP_OK) {
+        ESP_LOGE(TAG, "Could not migrate %d signals, the old copy is kept", signal_count);
+        return;
     }
+    if (from != to) nvs_erase_key(from, SIGNALS_NVS_KEY);
+    nvs_erase_key(from, SIGNALS_V1_NVS_KEY);
+    nvs_commit(from);
+    ESP_LOGI(TAG, "Migrated %d signals to the current NVS layout in '%s'", signal_count, library_partition);
 }
 
+// Called with the library lock held, replaces saved_signals with the stored library
 static void load_signals_from_nvs(void)
 {
-    nvs_handle_t handle;
-    esp_err_t err = nvs_open("storage", NVS_READONLY, &handle);
+    nvs_handle_t library;
+    esp_err_t err = nvs_open_from_partition(library_partition, "storage", NVS_READWRITE, &library);
     if (err != ESP_OK) {
         ESP_LOGI(TAG, "No saved signals found");
         return;
     }
 
-    size_t required_size = 0;
-    err = nvs_get_blob(handle, "signals", NULL, &required_size);
-    if (err == ESP_OK && required_size > 0) {
-        nvs_get_blob(handle, "signals", saved_signals, &required_size);
-        signal_count = required_size / sizeof(rf_signal_t);
+    // Libraries saved before the library partition existed are in the default NVS
+    nvs_handle_t old = library;
+    if (strcmp(library_partition, NVS_DEFAULT_PART_NAME) != 0 &&
+        nvs_open("storage", NVS_READWRITE, &old) != ESP_OK) {
+        old = library;
+    }
+
+    size_t size;
+    if (read_signals_blob(library, SIGNALS_NVS_KEY, sizeof(rf_signal_t), &size)) {
+        signal_count = size / sizeof(rf_signal_t);
         ESP_LOGI(TAG, "Loaded %d signals from NVS", signal_count);
+    } else if (old != library && read_signals_blob(old, SIGNALS_NVS_KEY, sizeof(rf_signal_t), &size)) {
+        signal_count = size / sizeof(rf_signal_t);
+        store_migrated_signals(old, library);
+    } else if (read_signals_blob(old, SIGNALS_V1_NVS_KEY, sizeof(rf_signal_v1_t), &size)) {
+        convert_signals_v1(size);
+        store_migrated_signals(old, library);
     }
 
-    nvs_close(handle);
+    if (old != library) nvs_close(old);
+    nvs_close(library);
 }
 
+// Called with the library lock held, the blob is written straight from saved_signals
 static void save_signals_to_nvs(void)
 {
     nvs_handle_t handle;
-    esp_err_t err = nvs_open("storage", NVS_READWRITE, &handle);
+    esp_err_t err = nvs_open_from_partition(library_partition, "storage", NVS_READWRITE, &handle);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Error opening NVS handle");
         return;
     }
 
-    err = nvs_set_blob(handle, "signals", saved_signals, signal_count * sizeof(rf_signal_t));
+    err = nvs_set_blob(handle, SIGNALS_NVS_KEY, saved_signals, signal_count * sizeof(rf_signal_t));
     if (err == ESP_OK) {
         nvs_commit(handle);
         ESP_LOGI(TAG, "Saved %d signals to NVS", signal_count);
+    } else {
+        ESP_LOGE(TAG, "Could not save %d signals to '%s': %s", signal_count, library_partition, esp_err_to_name(err));
     }
 
     nvs_close(handle);
 }
 
-static void track_signal(uint32_t code, uint8_t bit_length, uint8_t protocol, uint16_t pulse_length)
+// Wakes parked long-poll requests after the tracking store changed
+static void notify_tracking_changed(void)
 {
-    if (tracked_signals_mutex == NULL) return;
+    if (longpoll_task_handle != NULL) {
+        xTaskNotifyGive(longpoll_task_handle);
+    }
+}
+
+// The tracking mutex is only held to update entries or copy them out, these wrappers
+// count how often a taker had to wait and for how long it was held.
+static void tracking_lock(void)
+{
+    if (xSemaphoreTake(tracked_signals_mutex, 0) != pdTRUE) {
+        int64_t start = esp_timer_get_time();
+        xSemaphoreTake(tracked_signals_mutex, portMAX_DELAY);
+        uint32_t waited = (uint32_t)(esp_timer_get_time() - start);
+        tracking_lock_stats.contended++;
+        tracking_lock_stats.wait_us += waited;
+        tracking_lock_stats.max_wait_us = MAX(tracking_lock_stats.max_wait_us, waited);
+    }
+    tracking_lock_stats.acquisitions++;
+    tracking_locked_at = esp_timer_get_time();
+}
+
+static void tracking_unlock(void)
+{
+    uint32_t held = (uint32_t)(esp_timer_get_time() - tracking_locked_at);
+    tracking_lock_stats.hold_us += held;
+    tracking_lock_stats.max_hold_us = MAX(tracking_lock_stats.max_hold_us, held);
+    xSemaphoreGive(tracked_signals_mutex);
+}
+
+// Records a button event. Only presses count and create entries, holds and releases
+// update the state of the entry the press created. Returns the change sequence the
+// update was recorded under, 0 if there was nothing to update.
+static uint32_t track_signal(uint32_t code, uint8_t bit_length, uint8_t protocol, uint16_t pulse_length,
+                             const family_fields_t *fields, burst_event_type_t state, uint32_t duration_ms,
+                             uint32_t *count)
+{
+    if (tracked_signals_mutex == NULL) return 0;
     
-    xSemaphoreTake(tracked_signals_mutex, portMAX_DELAY);
+    TRACE_BEGIN(TRACE_TRACK, code);
+    tracking_lock();
     
     int64_t now = esp_timer_get_time();
-    bool found = false;
+    int found = -1;
     
     for (int i = 0; i < tracked_count; i++) {
         if (tracked_signals[i].code == code && 
             tracked_signals[i].bit_length == bit_length &&
             tracked_signals[i].protocol == protocol) {
-            tracked_signals[i].count++;
-            tracked_signals[i].last_seen = now;
-            last_signal_count = tracked_signals[i].count;
-            found = true;
+            found = i;
             break;
         }
     }
-    
-    if (!found) {
-        if (tracked_count < MAX_TRACKED_SIGNALS) {
-            tracked_signals[tracked_count].code = code;
-            tracked_signals[tracked_count].bit_length = bit_length;
-            tracked_signals[tracked_count].protocol = protocol;
-            tracked_signals[tracked_count].pulse_length = pulse_length;
-            tracked_signals[tracked_count].count = 1;
-            tracked_signals[tracked_count].first_seen = now;
-            tracked_signals[tracked_count].last_seen = now;
-            last_signal_count = 1;
-            tracked_count++;
+
+    if (found < 0 && state != BURST_PRESS) {
+        // The entry was evicted while the button was down
+        tracking_unlock();
+        TRACE_END(TRACE_TRACK, code);
+        return 0;
+    }
+
+    uint32_t seq = ++tracking_seq;
+    tracked_signal_t *entry;
+
+    if (found >= 0) {
+        entry = &tracked_signals[found];
+        if (state == BURST_PRESS) entry->count++;
+        entry->last_seen = now;
+    } else {
+        settings_t settings;
+        settings_get(&settings);
+        if (tracked_count < settings.tracked_max) {
+            entry = &tracked_signals[tracked_count++];
         } else {
             int oldest_idx = 0;
             int64_t oldest_time = tracked_signals[0].last_seen;
@@ -203,28 +565,43 @@ static void track_signal(uint32_t code, uint8_t bit_length, uint8_t protocol, ui
                     oldest_idx = i;
                 }
             }
-            tracked_signals[oldest_idx].code = code;
-            tracked_signals[oldest_idx].bit_length = bit_length;
-            tracked_signals[oldest_idx].protocol = protocol;
-            tracked_signals[oldest_idx].pulse_length = pulse_length;
-            tracked_signals[oldest_idx].count = 1;
-            tracked_signals[oldest_idx].first_seen = now;
-            tracked_signals[oldest_idx].last_seen = now;
-            last_signal_count = 1;
+            entry = &tracked_signals[oldest_idx];
+            // The evicted entry is gone, delta clients have to resync
+            tracking_reset_seq = seq;
         }
+        entry->code = code;
+        entry->bit_length = bit_length;
+        entry->protocol = protocol;
+        entry->pulse_length = pulse_length;
+        entry->count = 1;
+        entry->first_seen = now;
+        entry->last_seen = now;
+        memset(&entry->fields, 0, sizeof(entry->fields));
     }
+
+    entry->seq = seq;
+    entry->state = state;
+    entry->duration_ms = duration_ms;
+    if (fields != NULL) entry->fields = *fields;
+    *count = entry->count;
     
-    xSemaphoreGive(tracked_signals_mutex);
+    tracking_unlock();
+    TRACE_END(TRACE_TRACK, code);
+    return seq;
 }
 
 static void cleanup_old_tracked_signals(void)
 {
     if (tracked_signals_mutex == NULL) return;
     
-    xSemaphoreTake(tracked_signals_mutex, portMAX_DELAY);
+    tracking_lock();
     
+    settings_t settings;
+    settings_get(&settings);
     int64_t now = esp_timer_get_time();
-    int64_t threshold = 50000000;
+    int64_t threshold = (int64_t)settings.tracked_expiry_s * 1000000;
+    int expired = 0;
+    bool removed = false;
     
     for (int i = tracked_count - 1; i >= 0; i--) {
         if ((now - tracked_signals[i].last_seen) > threshold) {
@@ -232,19 +609,52 @@ static void cleanup_old_tracked_signals(void)
                 tracked_signals[j] = tracked_signals[j + 1];
             }
             tracked_count--;
-            ESP_LOGI(TAG, "Cleaned up old tracked signal (%d remaining)", tracked_count);
+            expired++;
+            removed = true;
         }
     }
+
+    // The limit may have been lowered, drop the least recently seen entries
+    while (tracked_count > settings.tracked_max) {
+        int oldest_idx = 0;
+        for (int i = 1; i < tracked_count; i++) {
+            if (tracked_signals[i].last_seen < tracked_signals[oldest_idx].last_seen) {
+                oldest_idx = i;
+            }
+        }
+        for (int j = oldest_idx; j < tracked_count - 1; j++) {
+            tracked_signals[j] = tracked_signals[j + 1];
+        }
+        tracked_count--;
+        removed = true;
+    }
+
+    if (removed) {
+        tracking_reset_seq = ++tracking_seq;
+    }
+    int remaining = tracked_count;
     
-    xSemaphoreGive(tracked_signals_mutex);
+    tracking_unlock();
+
+    if (expired > 0) {
+        ESP_LOGI(TAG, "Cleaned up %d old tracked signals (%d remaining)", expired, remaining);
+    }
+    if (removed) {
+        notify_tracking_changed();
+    }
 }
 
 // we clean up the tracked signals every 50 seconds to prevent the memory from filling up (this was a previous problem i had after running for a few days)
 static void cleanup_task(void *arg)
 {
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(50000));
+        // Never sleep longer than 50s, so a shorter expiry set at runtime applies soon
+        settings_t settings;
+        settings_get(&settings);
+        uint32_t interval_s = MIN(settings.tracked_expiry_s, 50);
+        vTaskDelay(pdMS_TO_TICKS(interval_s * 1000));
         cleanup_old_tracked_signals();
+        usage_tick();
     }
 }
 
@@ -286,8 +696,6 @@ static esp_err_t index_handler(httpd_req_t *req)
 
 static esp_err_t api_info_handler(httpd_req_t *req)
 {
-    httpd_resp_set_type(req, "application/json");
-
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "device", "ESP32 433MHz Controller");
 
@@ -297,100 +705,510 @@ static esp_err_t api_info_handler(httpd_req_t *req)
     sprintf(ip_str, IPSTR, IP2STR(&ip_info.ip));
     cJSON_AddStringToObject(root, "ip", ip_str);
 
-    cJSON_AddNumberToObject(root, "signalCount", signal_count);
-    cJSON_AddNumberToObject(root, "receiverPin", RF_RECEIVER_PIN);
-    cJSON_AddNumberToObject(root, "transmitterPin", RF_TRANSMITTER_PIN);
+    cJSON_AddNumberToObject(root, "signalCount", library_count());
+    radio_rx_stats_t rx;
+    radio_tx_stats_t tx;
+    radio_get_rx_stats(0, &rx);
+    radio_get_tx_stats(0, &tx);
+    cJSON_AddNumberToObject(root, "receiverPin", rx.pin);
+    cJSON_AddNumberToObject(root, "transmitterPin", tx.pin);
+    cJSON_AddNumberToObject(root, "receivers", radio_receiver_count());
+    cJSON_AddNumberToObject(root, "transmitters", radio_transmitter_count());
+
+    // Boot phase completion times in ms since power-on (0 = not reached yet)
+    cJSON *boot = cJSON_CreateObject();
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        cJSON_AddNumberToObject(boot, boot_phase_names[i], boot_phase_us[i] / 1000);
+    }
+    cJSON_AddItemToObject(root, "boot", boot);
 
-    const char *resp = cJSON_Print(root);
-    httpd_resp_sendstr(req, resp);
-    free((void *)resp);
+    // How much the RF monitor and the HTTP handlers get in each other's way
+    lock_stats_t lock = {0};
+    if (tracked_signals_mutex != NULL) {
+        tracking_lock();
+        lock = tracking_lock_stats;
+        tracking_unlock();
+    }
+    cJSON *tracking = cJSON_AddObjectToObject(root, "tracking");
+    cJSON_AddNumberToObject(tracking, "lockAcquisitions", lock.acquisitions);
+    cJSON_AddNumberToObject(tracking, "lockContended", lock.contended);
+    cJSON_AddNumberToObject(tracking, "lockWaitUs", lock.wait_us);
+    cJSON_AddNumberToObject(tracking, "lockMaxWaitUs", lock.max_wait_us);
+    cJSON_AddNumberToObject(tracking, "lockHoldUs", lock.hold_us);
+    cJSON_AddNumberToObject(tracking, "lockMaxHoldUs", lock.max_hold_us);
+    cJSON_AddNumberToObject(tracking, "latestWrites", latest_lock.writes);
+    cJSON_AddNumberToObject(tracking, "latestReadRetries", latest_lock.read_retries);
+
+    usage_stats_t usage;
+    usage_get_stats(&usage);
+    cJSON *usage_obj = cJSON_AddObjectToObject(root, "usage");
+    cJSON_AddNumberToObject(usage_obj, "entries", usage.entries);
+    cJSON_AddNumberToObject(usage_obj, "dirty", usage.dirty);
+    cJSON_AddNumberToObject(usage_obj, "deltas", usage.deltas);
+    cJSON_AddNumberToObject(usage_obj, "flushes", usage.flushes);
+    cJSON_AddNumberToObject(usage_obj, "compactions", usage.compactions);
+    cJSON_AddNumberToObject(usage_obj, "writeErrors", usage.write_errors);
+    cJSON_AddNumberToObject(usage_obj, "dropped", usage.dropped);
+
+    api_send(req, root);
     cJSON_Delete(root);
     return ESP_OK;
 }
 
-static esp_err_t api_signals_get_handler(httpd_req_t *req)
+// Lifetime send/receive counters, the time fields only once something happened
+static void add_usage_fields(cJSON *obj, const usage_record_t *usage)
 {
-    httpd_resp_set_type(req, "application/json");
+    cJSON *out = cJSON_AddObjectToObject(obj, "usage");
+    cJSON_AddNumberToObject(out, "sent", usage->sent);
+    if (usage->last_sent) cJSON_AddNumberToObject(out, "lastSent", usage->last_sent);
+    cJSON_AddNumberToObject(out, "received", usage->received);
+    if (usage->last_received) cJSON_AddNumberToObject(out, "lastReceived", usage->last_received);
+}
 
-    cJSON *root = cJSON_CreateObject();
-    cJSON *signals_array = cJSON_CreateArray();
+static void usage_to_cbor(cbor_writer_t *w, const usage_record_t *usage)
+{
+    cbor_put_text(w, "usage");
+    cbor_begin_map(w, 2 + (usage->last_sent != 0) + (usage->last_received != 0));
+    cbor_put_key_uint(w, "sent", usage->sent);
+    if (usage->last_sent) cbor_put_key_uint(w, "lastSent", usage->last_sent);
+    cbor_put_key_uint(w, "received", usage->received);
+    if (usage->last_received) cbor_put_key_uint(w, "lastReceived", usage->last_received);
+}
 
-    for (int i = 0; i < signal_count; i++) {
-        cJSON *signal = cJSON_CreateObject();
-        cJSON_AddStringToObject(signal, "name", saved_signals[i].name);
-        cJSON_AddNumberToObject(signal, "code", saved_signals[i].code);
-        cJSON_AddNumberToObject(signal, "bitLength", saved_signals[i].bit_length);
-        cJSON_AddNumberToObject(signal, "protocol", saved_signals[i].protocol);
-        cJSON_AddNumberToObject(signal, "pulseLength", saved_signals[i].pulse_length);
-        cJSON_AddItemToArray(signals_array, signal);
+// Serializes one signal as a compact JSON object (cJSON takes care of escaping the name).
+// usage is added when not NULL.
+static char *signal_to_json(const rf_signal_t *sig, const usage_record_t *usage)
+{
+    cJSON *signal = cJSON_CreateObject();
+    cJSON_AddStringToObject(signal, "name", sig->name);
+    cJSON_AddNumberToObject(signal, "code", sig->code);
+    cJSON_AddNumberToObject(signal, "bitLength", sig->bit_length);
+    cJSON_AddNumberToObject(signal, "protocol", sig->protocol);
+    cJSON_AddNumberToObject(signal, "pulseLength", sig->pulse_length);
+    if (sig->repeats) cJSON_AddNumberToObject(signal, "repeats", sig->repeats);
+    if (sig->gap_ms) cJSON_AddNumberToObject(signal, "gapMs", sig->gap_ms);
+    if (sig->tx_pulse_length) cJSON_AddNumberToObject(signal, "txPulseLength", sig->tx_pulse_length);
+    if (sig->verify) cJSON_AddNumberToObject(signal, "verify", sig->verify);
+    if (sig->max_repeats) cJSON_AddNumberToObject(signal, "maxRepeats", sig->max_repeats);
+    if (usage != NULL) add_usage_fields(signal, usage);
+    char *out = cJSON_PrintUnformatted(signal);
+    cJSON_Delete(signal);
+    return out;
+}
+
+// Reads an optional integer field, false when it is present but not a number in 0..max
+static bool json_optional_int(const cJSON *json, const char *key, int max, int *out)
+{
+    cJSON *item = cJSON_GetObjectItem(json, key);
+    if (item == NULL) return true;
+    if (!cJSON_IsNumber(item) || item->valueint < 0 || item->valueint > max) return false;
+    *out = item->valueint;
+    return true;
+}
+
+// Optional transmit settings of a signal, absent fields keep their value.
+// Returns an error message, or NULL once sig has been updated.
+static const char *parse_signal_tx_settings(const cJSON *json, rf_signal_t *sig)
+{
+    int repeats = sig->repeats;
+    int verify = sig->verify;
+    int max_repeats = sig->max_repeats;
+    int gap_ms = sig->gap_ms;
+    int tx_pulse_length = sig->tx_pulse_length;
+
+    if (!json_optional_int(json, "repeats", RADIO_MAX_REPEATS, &repeats) ||
+        !json_optional_int(json, "verify", RADIO_MAX_REPEATS, &verify) ||
+        !json_optional_int(json, "maxRepeats", RADIO_MAX_REPEATS, &max_repeats)) {
+        return "repeats, verify and maxRepeats must be 0-20";
+    }
+    if (!json_optional_int(json, "gapMs", SIGNAL_MAX_GAP_MS, &gap_ms)) {
+        return "gapMs must be 0-1000";
+    }
+    if (!json_optional_int(json, "txPulseLength", SIGNAL_MAX_PULSE_US, &tx_pulse_length)) {
+        return "txPulseLength must be 0-5000";
     }
 
-    cJSON_AddItemToObject(root, "signals", signals_array);
+    sig->repeats = repeats;
+    sig->verify = verify;
+    sig->max_repeats = max_repeats;
+    sig->gap_ms = gap_ms;
+    sig->tx_pulse_length = tx_pulse_length;
+    return NULL;
+}
 
-    const char *resp = cJSON_Print(root);
-    httpd_resp_sendstr(req, resp);
-    free((void *)resp);
-    cJSON_Delete(root);
+static esp_err_t send_json_error(httpd_req_t *req, const char *error)
+{
+    char resp[128];
+    snprintf(resp, sizeof(resp), "{\"error\":\"%s\"}", error);
+    api_send_str(req, resp);
+    return ESP_FAIL;
+}
+
+// Copies path parameter i of the request's route ({name} in routes.def), percent-decoded.
+// False when the route has no such parameter, it is malformed or does not fit in out.
+// Looked up again from the URI, deferred handlers run on a copy of the request.
+static bool api_path_param(httpd_req_t *req, int i, char *out, size_t size)
+{
+    router_match_t match;
+    if (router_lookup(&api_route_trie, req->method, req->uri, &match) != ROUTER_FOUND || i >= match.param_count) {
+        return false;
+    }
+    return router_decode(req->uri + match.params[i].offset, match.params[i].length, out, size) >= 0;
+}
+
+// A decimal path parameter, anything else (a name, a sign, trailing text) is rejected
+static bool api_path_uint(httpd_req_t *req, int i, uint32_t *value)
+{
+    char text[12];
+    if (!api_path_param(req, i, text, sizeof(text)) || text[0] < '0' || text[0] > '9') return false;
+    char *end = NULL;
+    unsigned long parsed = strtoul(text, &end, 10);
+    if (*end != '\0' || parsed > UINT32_MAX) return false;
+    *value = (uint32_t)parsed;
+    return true;
+}
+
+// Same fields as signal_to_json, encoded straight into the response
+static void signal_to_cbor(cbor_writer_t *w, const rf_signal_t *sig, const usage_record_t *usage)
+{
+    size_t fields = 5 + (sig->repeats != 0) + (sig->gap_ms != 0) + (sig->tx_pulse_length != 0) +
+                    (sig->verify != 0) + (sig->max_repeats != 0) + (usage != NULL);
+    cbor_begin_map(w, fields);
+    cbor_put_key_text(w, "name", sig->name);
+    cbor_put_key_uint(w, "code", sig->code);
+    cbor_put_key_uint(w, "bitLength", sig->bit_length);
+    cbor_put_key_uint(w, "protocol", sig->protocol);
+    cbor_put_key_uint(w, "pulseLength", sig->pulse_length);
+    if (sig->repeats) cbor_put_key_uint(w, "repeats", sig->repeats);
+    if (sig->gap_ms) cbor_put_key_uint(w, "gapMs", sig->gap_ms);
+    if (sig->tx_pulse_length) cbor_put_key_uint(w, "txPulseLength", sig->tx_pulse_length);
+    if (sig->verify) cbor_put_key_uint(w, "verify", sig->verify);
+    if (sig->max_repeats) cbor_put_key_uint(w, "maxRepeats", sig->max_repeats);
+    if (usage != NULL) usage_to_cbor(w, usage);
+}
+
+// Counters of a saved signal, NULL when it was never sent or received
+static const usage_record_t *signal_usage(const rf_signal_t *sig, usage_record_t *out)
+{
+    return usage_get(sig->code, sig->bit_length, sig->protocol, out) ? out : NULL;
+}
+
+// Streamed one signal at a time, a tree of a full library would not fit in heap
+static esp_err_t api_signals_get_handler(httpd_req_t *req)
+{
+    int64_t start = esp_timer_get_time();
+    usage_record_t usage;
+    rf_signal_t sig;
+
+    // Each entry is copied out on its own, the library is not locked while sending
+    if (api_format_of_response(req) == API_FORMAT_CBOR) {
+        cbor_writer_t w;
+        api_cbor_begin(req, &w);
+        cbor_begin_map(&w, 1);
+        cbor_put_text(&w, "signals");
+        cbor_begin_array(&w, CBOR_INDEFINITE);
+        for (int i = 0; w.err == ESP_OK && library_get(i, &sig); i++) {
+            signal_to_cbor(&w, &sig, signal_usage(&sig, &usage));
+        }
+        cbor_end(&w);
+        return api_cbor_end(req, &w, start);
+    }
+
+    size_t bytes = 0;
+    httpd_resp_set_type(req, API_CONTENT_JSON);
+    httpd_resp_sendstr_chunk(req, "{\"signals\":[");
+
+    for (int i = 0; library_get(i, &sig); i++) {
+        char *json = signal_to_json(&sig, signal_usage(&sig, &usage));
+        if (json == NULL) break;
+        if (i > 0) httpd_resp_sendstr_chunk(req, ",");
+        bytes += strlen(json) + 1;
+        esp_err_t err = httpd_resp_sendstr_chunk(req, json);
+        cJSON_free(json);
+        if (err != ESP_OK) return ESP_FAIL;
+    }
+
+    httpd_resp_sendstr_chunk(req, "]}");
+    httpd_resp_sendstr_chunk(req, NULL);
+    api_format_record_response(API_FORMAT_JSON, bytes + 14, start);
     return ESP_OK;
 }
 
-static esp_err_t api_signal_history_handler(httpd_req_t *req)
+// Builds and sends the history response. With has_since only entries changed after
+// `since` are included, unless something was removed since then (full resync).
+// Adds a "family" object with whatever fields the family decoder filled in
+static void add_family_fields(cJSON *obj, const family_fields_t *fields)
+{
+    if (fields->family == NULL) return;
+
+    cJSON *family = cJSON_AddObjectToObject(obj, "family");
+    cJSON_AddStringToObject(family, "name", fields->family);
+    if (fields->flags & FAMILY_HAS_DEVICE_ID) {
+        cJSON_AddNumberToObject(family, "deviceId", fields->device_id);
+    }
+    if (fields->flags & FAMILY_HAS_BUTTON) {
+        cJSON_AddNumberToObject(family, "button", fields->button);
+    }
+    if (fields->flags & FAMILY_HAS_CHANNEL) {
+        cJSON_AddNumberToObject(family, "channel", fields->channel);
+    }
+    if (fields->flags & FAMILY_HAS_BATTERY) {
+        cJSON_AddBoolToObject(family, "batteryLow", fields->battery_low);
+    }
+    if (fields->flags & FAMILY_HAS_TEMPERATURE) {
+        cJSON_AddNumberToObject(family, "temperature", fields->temperature / 10.0);
+    }
+    if (fields->flags & FAMILY_HAS_TRISTATE) {
+        cJSON_AddStringToObject(family, "tristate", fields->tristate);
+    }
+}
+
+static void family_fields_to_cbor(cbor_writer_t *w, const family_fields_t *fields)
+{
+    cbor_put_text(w, "family");
+    cbor_begin_map(w, CBOR_INDEFINITE);
+    cbor_put_key_text(w, "name", fields->family);
+    if (fields->flags & FAMILY_HAS_DEVICE_ID) {
+        cbor_put_key_uint(w, "deviceId", fields->device_id);
+    }
+    if (fields->flags & FAMILY_HAS_BUTTON) {
+        cbor_put_key_uint(w, "button", fields->button);
+    }
+    if (fields->flags & FAMILY_HAS_CHANNEL) {
+        cbor_put_key_uint(w, "channel", fields->channel);
+    }
+    if (fields->flags & FAMILY_HAS_BATTERY) {
+        cbor_put_key_bool(w, "batteryLow", fields->battery_low);
+    }
+    if (fields->flags & FAMILY_HAS_TEMPERATURE) {
+        cbor_put_text(w, "temperature");
+        cbor_put_double(w, fields->temperature / 10.0);
+    }
+    if (fields->flags & FAMILY_HAS_TRISTATE) {
+        cbor_put_key_text(w, "tristate", fields->tristate);
+    }
+    cbor_end(w);
+}
+
+// CBOR twin of the history document, encoded straight from the snapshot
+static void send_signal_history_cbor(httpd_req_t *req, const tracked_signal_t *snapshot, int count,
+                                     bool full, uint32_t since, uint32_t seq, int64_t server_time,
+                                     const latest_signal_t *last, bool is_new)
 {
-    httpd_resp_set_type(req, "application/json");
+    cbor_writer_t w;
+    api_cbor_begin(req, &w);
+    cbor_begin_map(&w, 5);
+
+    cbor_put_text(&w, "signals");
+    cbor_begin_array(&w, CBOR_INDEFINITE);
+    for (int i = 0; i < count && w.err == ESP_OK; i++) {
+        if (!full && snapshot[i].seq <= since) continue;
+
+        bool has_family = snapshot[i].fields.family != NULL;
+        usage_record_t usage;
+        bool has_usage = usage_get(snapshot[i].code, snapshot[i].bit_length, snapshot[i].protocol, &usage);
+        cbor_begin_map(&w, 9 + has_family + has_usage);
+        cbor_put_key_uint(&w, "code", snapshot[i].code);
+        cbor_put_key_uint(&w, "bitLength", snapshot[i].bit_length);
+        cbor_put_key_uint(&w, "protocol", snapshot[i].protocol);
+        cbor_put_key_uint(&w, "pulseLength", snapshot[i].pulse_length);
+        cbor_put_key_uint(&w, "count", snapshot[i].count);
+        cbor_put_key_uint(&w, "firstSeen", snapshot[i].first_seen);
+        cbor_put_key_uint(&w, "lastSeen", snapshot[i].last_seen);
+        cbor_put_key_text(&w, "state", burst_event_to_string(snapshot[i].state));
+        cbor_put_key_uint(&w, "durationMs", snapshot[i].duration_ms);
+        if (has_family) family_fields_to_cbor(&w, &snapshot[i].fields);
+        if (has_usage) usage_to_cbor(&w, &usage);
+    }
+    cbor_end(&w);
+
+    cbor_put_key_uint(&w, "serverTime", server_time);
+    cbor_put_key_uint(&w, "seq", seq);
+    cbor_put_key_bool(&w, "full", full);
+
+    cbor_put_text(&w, "latest");
+    if (is_new) {
+        bool has_family = last->fields.family != NULL;
+        cbor_begin_map(&w, 8 + has_family);
+        cbor_put_key_uint(&w, "code", last->code);
+        cbor_put_key_uint(&w, "bitLength", last->bit_length);
+        cbor_put_key_uint(&w, "protocol", last->protocol);
+        cbor_put_key_uint(&w, "pulseLength", last->pulse_length);
+        cbor_put_key_uint(&w, "count", last->count);
+        cbor_put_key_text(&w, "state", burst_event_to_string(last->state));
+        cbor_put_key_uint(&w, "durationMs", last->duration_ms);
+        if (has_family) family_fields_to_cbor(&w, &last->fields);
+        cbor_put_key_bool(&w, "new", true);
+    } else {
+        cbor_begin_map(&w, 1);
+        cbor_put_key_bool(&w, "new", false);
+    }
+
+    api_cbor_end(req, &w, server_time);
+}
 
-    int64_t server_time = esp_timer_get_time(); // Current server time in microseconds
+static void send_signal_history(httpd_req_t *req, bool has_since, uint32_t since)
+{
+    int64_t server_time = esp_timer_get_time(); // Current server time in microseconds, also starts the send timing
     
+    // Copy the tracking store out and build the JSON without holding the mutex,
+    // the RF monitor only ever waits for the memcpy
+    tracked_signal_t *snapshot = malloc(sizeof(tracked_signals));
+    if (snapshot == NULL) {
+        httpd_resp_send_500(req);
+        return;
+    }
+    int count = 0;
+    uint32_t seq = 0;
+    bool full = true;
+    if (tracked_signals_mutex != NULL) {
+        tracking_lock();
+        seq = tracking_seq;
+        full = !has_since || since < tracking_reset_seq || since > tracking_seq;
+        count = tracked_count;
+        memcpy(snapshot, tracked_signals, count * sizeof(tracked_signal_t));
+        tracking_unlock();
+    }
+
+    latest_signal_t last;
+    seqlock_read(&latest_lock, &last, &latest_signal, sizeof(last));
+    bool is_new = last.seq != 0 && (!has_since || last.seq > since) && last.code != 0;
+
+    if (api_format_of_response(req) == API_FORMAT_CBOR) {
+        send_signal_history_cbor(req, snapshot, count, full, since, seq, server_time, &last, is_new);
+        free(snapshot);
+        return;
+    }
+
     cJSON *root = cJSON_CreateObject();
     cJSON *signals_array = cJSON_CreateArray();
     
-    // Get all tracked signals
-    if (tracked_signals_mutex != NULL) {
-        xSemaphoreTake(tracked_signals_mutex, portMAX_DELAY);
-        
-        for (int i = 0; i < tracked_count; i++) {
-            cJSON *signal = cJSON_CreateObject();
-            cJSON_AddNumberToObject(signal, "code", tracked_signals[i].code);
-            cJSON_AddNumberToObject(signal, "bitLength", tracked_signals[i].bit_length);
-            cJSON_AddNumberToObject(signal, "protocol", tracked_signals[i].protocol);
-            cJSON_AddNumberToObject(signal, "pulseLength", tracked_signals[i].pulse_length);
-            cJSON_AddNumberToObject(signal, "count", tracked_signals[i].count);
-            cJSON_AddNumberToObject(signal, "firstSeen", tracked_signals[i].first_seen);
-            cJSON_AddNumberToObject(signal, "lastSeen", tracked_signals[i].last_seen);
-            cJSON_AddItemToArray(signals_array, signal);
+    for (int i = 0; i < count; i++) {
+        if (!full && snapshot[i].seq <= since) continue;
+
+        cJSON *signal = cJSON_CreateObject();
+        cJSON_AddNumberToObject(signal, "code", snapshot[i].code);
+        cJSON_AddNumberToObject(signal, "bitLength", snapshot[i].bit_length);
+        cJSON_AddNumberToObject(signal, "protocol", snapshot[i].protocol);
+        cJSON_AddNumberToObject(signal, "pulseLength", snapshot[i].pulse_length);
+        cJSON_AddNumberToObject(signal, "count", snapshot[i].count);
+        cJSON_AddNumberToObject(signal, "firstSeen", snapshot[i].first_seen);
+        cJSON_AddNumberToObject(signal, "lastSeen", snapshot[i].last_seen);
+        cJSON_AddStringToObject(signal, "state", burst_event_to_string(snapshot[i].state));
+        cJSON_AddNumberToObject(signal, "durationMs", snapshot[i].duration_ms);
+        add_family_fields(signal, &snapshot[i].fields);
+        usage_record_t usage;
+        if (usage_get(snapshot[i].code, snapshot[i].bit_length, snapshot[i].protocol, &usage)) {
+            add_usage_fields(signal, &usage);
         }
-        
-        xSemaphoreGive(tracked_signals_mutex);
+        cJSON_AddItemToArray(signals_array, signal);
     }
+    free(snapshot);
     
     cJSON_AddItemToObject(root, "signals", signals_array);
     cJSON_AddNumberToObject(root, "serverTime", server_time); // Send server's current time
+    cJSON_AddNumberToObject(root, "seq", seq);
+    cJSON_AddBoolToObject(root, "full", full);
     
-    // Add latest signal if available
-    cJSON *latest = NULL;
-    if (new_signal_received && last_signal.code != 0) {
-        latest = cJSON_CreateObject();
-        cJSON_AddNumberToObject(latest, "code", last_signal.code);
-        cJSON_AddNumberToObject(latest, "bitLength", last_signal.bit_length);
-        cJSON_AddNumberToObject(latest, "protocol", last_signal.protocol);
-        cJSON_AddNumberToObject(latest, "pulseLength", last_signal.pulse_length);
-        cJSON_AddNumberToObject(latest, "count", last_signal_count);
+    // Add latest signal if it changed since the client's last poll
+    cJSON *latest = cJSON_CreateObject();
+    if (is_new) {
+        cJSON_AddNumberToObject(latest, "code", last.code);
+        cJSON_AddNumberToObject(latest, "bitLength", last.bit_length);
+        cJSON_AddNumberToObject(latest, "protocol", last.protocol);
+        cJSON_AddNumberToObject(latest, "pulseLength", last.pulse_length);
+        cJSON_AddNumberToObject(latest, "count", last.count);
+        cJSON_AddStringToObject(latest, "state", burst_event_to_string(last.state));
+        cJSON_AddNumberToObject(latest, "durationMs", last.duration_ms);
+        add_family_fields(latest, &last.fields);
         cJSON_AddBoolToObject(latest, "new", true);
-        cJSON_AddItemToObject(root, "latest", latest);
     } else {
-        latest = cJSON_CreateObject();
         cJSON_AddBoolToObject(latest, "new", false);
-        cJSON_AddItemToObject(root, "latest", latest);
     }
+    cJSON_AddItemToObject(root, "latest", latest);
 
-    const char *resp = cJSON_Print(root);
-    httpd_resp_sendstr(req, resp);
-    free((void *)resp);
+    api_send(req, root);
     cJSON_Delete(root);
+}
+
+// Answers parked long-poll requests as soon as the tracking store moves past
+// their `since`, or when their wait runs out.
+static void longpoll_task(void *arg)
+{
+    parked_poll_t parked[LONGPOLL_MAX_PARKED];
+    int parked_count = 0;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, parked_count > 0 ? pdMS_TO_TICKS(100) : portMAX_DELAY);
+
+        while (parked_count < LONGPOLL_MAX_PARKED &&
+               xQueueReceive(longpoll_queue, &parked[parked_count], 0) == pdTRUE) {
+            parked_count++;
+        }
+
+        int64_t now = esp_timer_get_time();
+        for (int i = parked_count - 1; i >= 0; i--) {
+            if (tracking_seq > parked[i].since || now >= parked[i].deadline) {
+                send_signal_history(parked[i].req, true, parked[i].since);
+                httpd_req_async_handler_complete(parked[i].req);
+                parked[i] = parked[--parked_count];
+                __atomic_fetch_sub(&longpoll_parked, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+static esp_err_t api_signal_history_handler(httpd_req_t *req)
+{
+    char query[64];
+    bool has_since = false;
+    uint32_t since = 0;
+    uint32_t wait_ms = 0;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16];
+        if (httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK) {
+            has_since = true;
+            since = strtoul(value, NULL, 10);
+        }
+        if (httpd_query_key_value(query, "wait", value, sizeof(value)) == ESP_OK) {
+            wait_ms = MIN(strtoul(value, NULL, 10), LONGPOLL_MAX_WAIT_MS);
+        }
+    }
+
+    // Nothing new yet and the client is willing to wait: park the request so the
+    // server task is free for everyone else. A slot is reserved before parking and
+    // handed back when parking fails, falls through when all slots are taken.
+    if (has_since && wait_ms > 0 && tracking_seq <= since && longpoll_queue != NULL) {
+        if (__atomic_fetch_add(&longpoll_parked, 1, __ATOMIC_RELAXED) < LONGPOLL_MAX_PARKED) {
+            parked_poll_t poll = {
+                .since = since,
+                .deadline = esp_timer_get_time() + (int64_t)wait_ms * 1000,
+            };
+            if (httpd_req_async_handler_begin(req, &poll.req) == ESP_OK) {
+                if (xQueueSend(longpoll_queue, &poll, 0) == pdTRUE) {
+                    xTaskNotifyGive(longpoll_task_handle);
+                    return ESP_OK;
+                }
+                __atomic_fetch_sub(&longpoll_parked, 1, __ATOMIC_RELAXED);
+                send_signal_history(poll.req, has_since, since);
+                httpd_req_async_handler_complete(poll.req);
+                return ESP_OK;
+            }
+        }
+        __atomic_fetch_sub(&longpoll_parked, 1, __ATOMIC_RELAXED);
+    }
+
+    TRACE_BEGIN(TRACE_HTTP, since);
+    send_signal_history(req, has_since, since);
+    TRACE_END(TRACE_HTTP, since);
     return ESP_OK;
 }
 
 static esp_err_t api_signals_post_handler(httpd_req_t *req)
 {
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_signals_post_handler)) return ESP_OK;
+
     char buf[512];
     int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
     if (ret <= 0) {
@@ -399,10 +1217,9 @@ static esp_err_t api_signals_post_handler(httpd_req_t *req)
     }
     buf[ret] = '\0';
 
-    cJSON *json = cJSON_Parse(buf);
+    cJSON *json = api_parse_body(req, buf, ret);
     if (json == NULL) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid JSON\"}");
+        api_send_str(req, "{\"error\":\"Invalid JSON\"}");
         return ESP_FAIL;
     }
 
@@ -415,16 +1232,14 @@ static esp_err_t api_signals_post_handler(httpd_req_t *req)
 
     // Validate field types and values
     if (!cJSON_IsString(name) || name->valuestring == NULL || strlen(name->valuestring) == 0) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid or missing name\"}");
+        api_send_str(req, "{\"error\":\"Invalid or missing name\"}");
         cJSON_Delete(json);
         return ESP_FAIL;
     }
 
     if (!cJSON_IsNumber(code) || !cJSON_IsNumber(bitLength) ||
         !cJSON_IsNumber(protocol) || !cJSON_IsNumber(pulseLength)) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid numeric fields\"}");
+        api_send_str(req, "{\"error\":\"Invalid numeric fields\"}");
         cJSON_Delete(json);
         return ESP_FAIL;
     }
@@ -432,71 +1247,1211 @@ static esp_err_t api_signals_post_handler(httpd_req_t *req)
     // Validate ranges
     if (bitLength->valueint < 8 || bitLength->valueint > 64 ||
         protocol->valueint < 1 || protocol->valueint > 7) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid bit length or protocol\"}");
+        api_send_str(req, "{\"error\":\"Invalid bit length or protocol\"}");
         cJSON_Delete(json);
         return ESP_FAIL;
     }
 
-    // Check for existing signals with the same name or code
-    for (int i = 0; i < signal_count; i++) {
-        if (strcasecmp(saved_signals[i].name, name->valuestring) == 0 ||
-            saved_signals[i].code == code->valueint) {
-            httpd_resp_set_type(req, "application/json");
-            httpd_resp_sendstr(req, "{\"error\":\"Signal with this name or code already exists\"}");
-            cJSON_Delete(json);
-            return ESP_FAIL;
+    rf_signal_t parsed = {0};
+    const char *settings_error = parse_signal_tx_settings(json, &parsed);
+    if (settings_error != NULL) {
+        cJSON_Delete(json);
+        return send_json_error(req, settings_error);
+    }
+
+    strncpy(parsed.name, name->valuestring, sizeof(parsed.name) - 1);
+    parsed.code = code->valueint;
+    parsed.bit_length = bitLength->valueint;
+    parsed.protocol = protocol->valueint;
+    parsed.pulse_length = pulseLength->valueint;
+    cJSON_Delete(json);
+
+    // The duplicate and limit checks and the append happen under one lock
+    const char *error = NULL;
+    int index = -1;
+    library_write_lock();
+    library_lock();
+    for (int i = 0; i < signal_count && error == NULL; i++) {
+        if (strcasecmp(saved_signals[i].name, parsed.name) == 0 || saved_signals[i].code == parsed.code) {
+            error = "{\"error\":\"Signal with this name or code already exists\"}";
         }
     }
+    if (error == NULL && signal_count >= MAX_SIGNALS) {
+        error = "{\"error\":\"Maximum number of signals reached\"}";
+    }
+    if (error == NULL) {
+        index = signal_count;
+        saved_signals[signal_count++] = parsed;
+        save_signals_to_nvs();
+    }
+    library_unlock();
+    library_write_unlock();
 
-    // Check signal count limit
-    if (signal_count >= MAX_SIGNALS) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Maximum number of signals reached\"}");
-        cJSON_Delete(json);
+    if (error != NULL) {
+        api_send_str(req, error);
         return ESP_FAIL;
     }
 
-    // Save the signal
-    rf_signal_t *sig = &saved_signals[signal_count];
-    strncpy(sig->name, name->valuestring, sizeof(sig->name) - 1);
-    sig->code = code->valueint;
-    sig->bit_length = bitLength->valueint;
-    sig->protocol = protocol->valueint;
-    sig->pulse_length = pulseLength->valueint;
-    signal_count++;
-
-    // Persist to non-volatile storage
-    save_signals_to_nvs();
-
     // Respond with success
     char index_str[16];
-    snprintf(index_str, sizeof(index_str), "%d", signal_count - 1);
+    snprintf(index_str, sizeof(index_str), "%d", index);
     char resp_str[128];
     snprintf(resp_str, sizeof(resp_str), "{\"success\":true,\"signalIndex\":%s}", index_str);
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, resp_str);
-
-    cJSON_Delete(json);
+    api_send_str(req, resp_str);
     return ESP_OK;
 }
 
 static esp_err_t api_signals_put_handler(httpd_req_t *req)
 {
-    // Extract index from URI
-    char *uri = (char *)req->uri;
-    char *index_str = strrchr(uri, '/');
-    if (!index_str) {
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_signals_put_handler)) return ESP_OK;
+
+    uint32_t index;
+    rf_signal_t updated;
+    if (!api_path_uint(req, 0, &index) || !library_get(index, &updated)) {
         httpd_resp_send_404(req);
         return ESP_FAIL;
     }
+
+    char buf[512];
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+
+    cJSON *json = api_parse_body(req, buf, ret);
+    if (json == NULL) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+
+    cJSON *name = cJSON_GetObjectItem(json, "name");
+    cJSON *code = cJSON_GetObjectItem(json, "code");
+    cJSON *bitLength = cJSON_GetObjectItem(json, "bitLength");
+    cJSON *protocol = cJSON_GetObjectItem(json, "protocol");
+    cJSON *pulseLength = cJSON_GetObjectItem(json, "pulseLength");
+
+    const char *settings_error = parse_signal_tx_settings(json, &updated);
+    if (settings_error != NULL) {
+        cJSON_Delete(json);
+        return send_json_error(req, settings_error);
+    }
+
+    if (name && code && bitLength && protocol && pulseLength) {
+        strncpy(updated.name, name->valuestring, 63);
+        updated.code = code->valueint;
+        updated.bit_length = bitLength->valueint;
+        updated.protocol = protocol->valueint;
+        updated.pulse_length = pulseLength->valueint;
+
+        // A delete may have run since the copy was taken, the index is checked again
+        library_write_lock();
+        library_lock();
+        bool stored = index < (uint32_t)signal_count;
+        if (stored) {
+            saved_signals[index] = updated;
+            save_signals_to_nvs();
+        }
+        library_unlock();
+        library_write_unlock();
+
+        if (stored) {
+            api_send_str(req, "{\"success\":true}");
+        } else {
+            httpd_resp_send_404(req);
+        }
+    } else {
+        httpd_resp_send_500(req);
+    }
+
+    cJSON_Delete(json);
+    return ESP_OK;
+}
+
+static esp_err_t api_signals_delete_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_signals_delete_handler)) return ESP_OK;
+
+    uint32_t index;
+    bool deleted = false;
+    if (api_path_uint(req, 0, &index)) {
+        library_write_lock();
+        library_lock();
+        if (index < (uint32_t)signal_count) {
+            for (int i = index; i < signal_count - 1; i++) {
+                saved_signals[i] = saved_signals[i + 1];
+            }
+            signal_count--;
+            save_signals_to_nvs();
+            deleted = true;
+        }
+        library_unlock();
+        library_write_unlock();
+    }
+
+    if (deleted) {
+        api_send_str(req, "{\"success\":true}");
+        return ESP_OK;
+    }
+
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+}
+
+// Reads an unsigned query parameter, returns default_value when absent or malformed
+static uint32_t query_u32(const char *query, const char *key, uint32_t default_value)
+{
+    char value[16];
+    if (query == NULL || httpd_query_key_value(query, key, value, sizeof(value)) != ESP_OK) {
+        return default_value;
+    }
+    char *end = NULL;
+    unsigned long parsed = strtoul(value, &end, 10);
+    return (end != value && *end == '\0') ? (uint32_t)parsed : default_value;
+}
+
+// Transmit requests pick their transmitter with ?tx=N, the first one is the default
+static int get_transmitter_param(httpd_req_t *req)
+{
+    char query[32];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+        return 0;
+    }
+    return (int)query_u32(query, "tx", 0);
+}
+
+static esp_err_t send_transmit_error(httpd_req_t *req, esp_err_t err)
+{
+    if (err == ESP_ERR_NOT_ALLOWED) {
+        api_send_str(req, "{\"error\":\"Airtime budget exhausted\"}");
+    } else {
+        api_send_str(req, "{\"error\":\"Unknown transmitter\"}");
+    }
+    return ESP_FAIL;
+}
+
+// Sends a saved signal with its own repeat, gap, pulse and verify settings
+static esp_err_t transmit_signal(const rf_signal_t *sig, int transmitter, radio_tx_result_t *result)
+{
+    radio_tx_options_t options = {
+        .repeats = sig->repeats,
+        .verify = sig->verify,
+        .max_repeats = sig->max_repeats,
+        .gap_ms = sig->gap_ms,
+    };
+    uint16_t pulse_length = sig->tx_pulse_length ? sig->tx_pulse_length : sig->pulse_length;
+    esp_err_t err = radio_transmit_ex(transmitter, sig->code, sig->bit_length, sig->protocol,
+                                      pulse_length, &options, result);
+    if (err == ESP_OK) {
+        usage_count_sent(sig->code, sig->bit_length, sig->protocol);
+    }
+    return err;
+}
+
+// Reports what the send achieved: frames on air and, for verified sends, what our receiver heard
+static esp_err_t send_transmit_result(httpd_req_t *req, const rf_signal_t *sig, const radio_tx_result_t *result)
+{
+    bool verified = sig->verify && RADIO_CAN_VERIFY;
+    if (api_format_of_response(req) == API_FORMAT_CBOR) {
+        int64_t start = esp_timer_get_time();
+        cbor_writer_t w;
+        api_cbor_begin(req, &w);
+        cbor_begin_map(&w, verified ? 4 : 2);
+        cbor_put_key_bool(&w, "success", true);
+        cbor_put_key_uint(&w, "frames", result->frames);
+        if (verified) {
+            cbor_put_key_uint(&w, "heard", result->heard);
+            cbor_put_key_bool(&w, "verified", result->verified);
+        }
+        api_cbor_end(req, &w, start);
+        return ESP_OK;
+    }
+
+    char resp[96];
+    if (verified) {
+        snprintf(resp, sizeof(resp), "{\"success\":true,\"frames\":%u,\"heard\":%u,\"verified\":%s}",
+                 result->frames, result->heard, result->verified ? "true" : "false");
+    } else {
+        snprintf(resp, sizeof(resp), "{\"success\":true,\"frames\":%u}", result->frames);
+    }
+    api_send_str(req, resp);
+    return ESP_OK;
+}
+
+static esp_err_t api_transmit_index_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_TRANSMIT, api_transmit_index_handler)) return ESP_OK;
+
+    uint32_t index;
+    rf_signal_t sig;
+    if (api_path_uint(req, 0, &index) && library_get(index, &sig)) {
+        radio_tx_result_t result;
+        esp_err_t err = transmit_signal(&sig, get_transmitter_param(req), &result);
+        if (err != ESP_OK) {
+            return send_transmit_error(req, err);
+        }
+
+        ESP_LOGI(TAG, "Transmitted: %s (Code: %lu)", sig.name, sig.code);
+        return send_transmit_result(req, &sig, &result);
+    }
+
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+}
+
+static esp_err_t api_transmit_name_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_TRANSMIT, api_transmit_name_handler)) return ESP_OK;
+
+    char decoded_name[64];
+    rf_signal_t sig;
+    if (api_path_param(req, 0, decoded_name, sizeof(decoded_name)) && library_find_name(decoded_name, &sig)) {
+        radio_tx_result_t result;
+        esp_err_t err = transmit_signal(&sig, get_transmitter_param(req), &result);
+        if (err != ESP_OK) {
+            return send_transmit_error(req, err);
+        }
+
+        ESP_LOGI(TAG, "Transmitted: %s (Code: %lu)", sig.name, sig.code);
+        return send_transmit_result(req, &sig, &result);
+    }
+
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+}
+
+// Body of POST /api/transmit, decoded the same way from JSON and CBOR
+typedef enum {
+    DIRECT_TX_CODE,
+    DIRECT_TX_BIT_LENGTH,
+    DIRECT_TX_PROTOCOL,
+    DIRECT_TX_PULSE_LENGTH,
+    DIRECT_TX_TRANSMITTER,
+    DIRECT_TX_REPEATS,
+    DIRECT_TX_VERIFY,
+    DIRECT_TX_MAX_REPEATS,
+    DIRECT_TX_GAP_MS,
+    DIRECT_TX_TX_PULSE_LENGTH,
+    DIRECT_TX_FIELD_COUNT
+} direct_tx_field_t;
+
+static const char *const direct_tx_names[DIRECT_TX_FIELD_COUNT] = {
+    "code", "bitLength", "protocol", "pulseLength", "transmitter",
+    "repeats", "verify", "maxRepeats", "gapMs", "txPulseLength",
+};
+
+typedef struct {
+    uint32_t present;       // Bit per direct_tx_field_t
+    uint32_t invalid;       // Present but not a number
+    double value[DIRECT_TX_FIELD_COUNT];
+} direct_tx_t;
+
+static bool direct_tx_has(const direct_tx_t *body, direct_tx_field_t field)
+{
+    return (body->present & ~body->invalid & (1 << field)) != 0;
+}
+
+static int direct_tx_field(const char *name, size_t len)
+{
+    for (int i = 0; i < DIRECT_TX_FIELD_COUNT; i++) {
+        if (strlen(direct_tx_names[i]) == len && memcmp(direct_tx_names[i], name, len) == 0) return i;
+    }
+    return -1;
+}
+
+static bool direct_tx_from_json(const cJSON *json, direct_tx_t *body)
+{
+    memset(body, 0, sizeof(*body));
+    if (!cJSON_IsObject(json)) return false;
+
+    for (const cJSON *item = json->child; item != NULL; item = item->next) {
+        int field = direct_tx_field(item->string, strlen(item->string));
+        if (field < 0) continue;
+        body->present |= 1 << field;
+        if (cJSON_IsNumber(item)) {
+            body->value[field] = item->valuedouble;
+        } else {
+            body->invalid |= 1 << field;
+        }
+    }
+    return true;
+}
+
+// One pass over the map, unknown keys are skipped without being decoded
+static bool direct_tx_from_cbor(const char *data, size_t len, direct_tx_t *body)
+{
+    memset(body, 0, sizeof(*body));
+
+    cbor_reader_t r;
+    cbor_item_t map;
+    cbor_reader_init(&r, data, len);
+    if (!cbor_read(&r, &map) || map.type != CBOR_TYPE_MAP) return false;
+
+    for (uint64_t i = 0; map.indefinite || i < map.count; i++) {
+        cbor_item_t key;
+        if (!cbor_read(&r, &key)) return false;
+        if (key.type == CBOR_TYPE_BREAK && map.indefinite) break;
+        if (key.type != CBOR_TYPE_TEXT) return false;
+
+        int field = direct_tx_field((const char *)key.data, key.count);
+        if (field < 0) {
+            if (!cbor_skip(&r)) return false;
+            continue;
+        }
+
+        cbor_item_t value;
+        const uint8_t *value_start = r.pos;
+        if (!cbor_read(&r, &value)) return false;
+        body->present |= 1 << field;
+        if (value.type == CBOR_TYPE_UINT || value.type == CBOR_TYPE_NEGINT || value.type == CBOR_TYPE_FLOAT) {
+            body->value[field] = value.number;
+        } else {
+            // Step back and skip the whole value, it may be a container
+            r.pos = value_start;
+            if (!cbor_skip(&r)) return false;
+            body->invalid |= 1 << field;
+        }
+    }
+    return cbor_at_end(&r);
+}
+
+static bool direct_tx_int(const direct_tx_t *body, direct_tx_field_t field, int max, int *out)
+{
+    if (!(body->present & (1 << field))) return true;
+    if (body->invalid & (1 << field)) return false;
+    double value = body->value[field];
+    if (value < 0 || value > max) return false;
+    *out = (int)value;
+    return true;
+}
+
+// Same rules as parse_signal_tx_settings
+static const char *direct_tx_settings(const direct_tx_t *body, rf_signal_t *sig)
+{
+    int repeats = 0, verify = 0, max_repeats = 0, gap_ms = 0, tx_pulse_length = 0;
+
+    if (!direct_tx_int(body, DIRECT_TX_REPEATS, RADIO_MAX_REPEATS, &repeats) ||
+        !direct_tx_int(body, DIRECT_TX_VERIFY, RADIO_MAX_REPEATS, &verify) ||
+        !direct_tx_int(body, DIRECT_TX_MAX_REPEATS, RADIO_MAX_REPEATS, &max_repeats)) {
+        return "repeats, verify and maxRepeats must be 0-20";
+    }
+    if (!direct_tx_int(body, DIRECT_TX_GAP_MS, SIGNAL_MAX_GAP_MS, &gap_ms)) {
+        return "gapMs must be 0-1000";
+    }
+    if (!direct_tx_int(body, DIRECT_TX_TX_PULSE_LENGTH, SIGNAL_MAX_PULSE_US, &tx_pulse_length)) {
+        return "txPulseLength must be 0-5000";
+    }
+
+    sig->repeats = repeats;
+    sig->verify = verify;
+    sig->max_repeats = max_repeats;
+    sig->gap_ms = gap_ms;
+    sig->tx_pulse_length = tx_pulse_length;
+    return NULL;
+}
+
+static esp_err_t api_transmit_direct_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_TRANSMIT, api_transmit_direct_handler)) return ESP_OK;
+
+    char buf[512];
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        httpd_resp_send_500(req);
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+
+    // CBOR bodies are read field by field straight off the buffer, JSON goes through cJSON
+    direct_tx_t body;
+    bool parsed;
+    if (api_format_of_request(req) == API_FORMAT_CBOR) {
+        int64_t start = esp_timer_get_time();
+        parsed = direct_tx_from_cbor(buf, ret, &body);
+        api_format_record_request(API_FORMAT_CBOR, ret, start, parsed);
+    } else {
+        cJSON *json = api_parse_body(req, buf, ret);
+        parsed = json != NULL && direct_tx_from_json(json, &body);
+        cJSON_Delete(json);
+    }
+    if (!parsed) {
+        api_send_str(req, "{\"error\":\"Invalid JSON\"}");
+        return ESP_FAIL;
+    }
+
+    // Validate required fields
+    const uint32_t required = (1 << DIRECT_TX_CODE) | (1 << DIRECT_TX_BIT_LENGTH) |
+                              (1 << DIRECT_TX_PROTOCOL) | (1 << DIRECT_TX_PULSE_LENGTH);
+    if ((body.present & required) != required || (body.invalid & required) != 0) {
+        api_send_str(req, "{\"error\":\"Invalid numeric fields\"}");
+        return ESP_FAIL;
+    }
+
+    // Validate ranges
+    int bit_length = (int)body.value[DIRECT_TX_BIT_LENGTH];
+    int protocol = (int)body.value[DIRECT_TX_PROTOCOL];
+    if (bit_length < 8 || bit_length > 64 || protocol < 1 || protocol > 7) {
+        api_send_str(req, "{\"error\":\"Invalid bit length or protocol\"}");
+        return ESP_FAIL;
+    }
+
+    // Same optional repeat/verify settings as a saved signal
+    rf_signal_t sig = {
+        .code = (uint32_t)body.value[DIRECT_TX_CODE],
+        .bit_length = bit_length,
+        .protocol = protocol,
+        .pulse_length = (uint16_t)body.value[DIRECT_TX_PULSE_LENGTH],
+    };
+    const char *settings_error = direct_tx_settings(&body, &sig);
+    if (settings_error != NULL) {
+        return send_json_error(req, settings_error);
+    }
+
+    // Transmit directly without saving, "transmitter" in the body wins over ?tx=
+    int tx = direct_tx_has(&body, DIRECT_TX_TRANSMITTER) ? (int)body.value[DIRECT_TX_TRANSMITTER]
+                                                         : get_transmitter_param(req);
+    radio_tx_result_t result;
+    esp_err_t err = transmit_signal(&sig, tx, &result);
+    if (err != ESP_OK) {
+        return send_transmit_error(req, err);
+    }
+
+    ESP_LOGI(TAG, "Transmitted direct: Code: %lu, Protocol: %d, Bits: %d", 
+             sig.code, protocol, bit_length);
+
+    return send_transmit_result(req, &sig, &result);
+}
+
+static esp_err_t api_clear_tracking_handler(httpd_req_t *req)
+{
+    if (tracked_signals_mutex) {
+        tracking_lock();
+        tracked_count = 0;
+        tracking_reset_seq = ++tracking_seq;
+        tracking_unlock();
+        notify_tracking_changed();
+    }
     
-    int index = atoi(index_str + 1);
-    if (index < 0 || index >= signal_count) {
-        httpd_resp_send_404(req);
+    latest_signal_t empty = {0};
+    seqlock_write(&latest_lock, &latest_signal, &empty, sizeof(empty));
+    filter_reset_requested = true;
+    
+    ESP_LOGI(TAG, "Cleared all tracked signals and reset filter state");
+
+    api_send_str(req, "{\"success\":true}");
+    return ESP_OK;
+}
+
+static esp_err_t api_settings_get_handler(httpd_req_t *req)
+{
+    settings_t settings;
+    settings_get(&settings);
+    settings_t defaults;
+    settings_defaults(&defaults);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "syncGapUs", settings.sync_gap_us);
+    cJSON_AddNumberToObject(root, "shortPulseUs", settings.short_pulse_us);
+    cJSON_AddNumberToObject(root, "decoderMinBits", settings.decoder_min_bits);
+    cJSON_AddNumberToObject(root, "acceptMinBits", settings.accept_min_bits);
+    cJSON_AddNumberToObject(root, "trackedMax", settings.tracked_max);
+    cJSON_AddNumberToObject(root, "trackedExpiryS", settings.tracked_expiry_s);
+
+    cJSON *def = cJSON_AddObjectToObject(root, "defaults");
+    cJSON_AddNumberToObject(def, "syncGapUs", defaults.sync_gap_us);
+    cJSON_AddNumberToObject(def, "shortPulseUs", defaults.short_pulse_us);
+    cJSON_AddNumberToObject(def, "decoderMinBits", defaults.decoder_min_bits);
+    cJSON_AddNumberToObject(def, "acceptMinBits", defaults.accept_min_bits);
+    cJSON_AddNumberToObject(def, "trackedMax", defaults.tracked_max);
+    cJSON_AddNumberToObject(def, "trackedExpiryS", defaults.tracked_expiry_s);
+
+    api_send(req, root);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// Updates the fields present in the body, the rest keep their current value
+static esp_err_t api_settings_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_settings_handler)) return ESP_OK;
+
+    char buf[512];
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        httpd_resp_send_500(req);
         return ESP_FAIL;
     }
+    buf[ret] = '\0';
+
+    cJSON *json = api_parse_body(req, buf, ret);
+    if (json == NULL) {
+        api_send_str(req, "{\"error\":\"Invalid JSON\"}");
+        return ESP_FAIL;
+    }
+
+    settings_t settings;
+    settings_get(&settings);
+    int sync_gap = settings.sync_gap_us;
+    int short_pulse = settings.short_pulse_us;
+    int decoder_min_bits = settings.decoder_min_bits;
+    int accept_min_bits = settings.accept_min_bits;
+    int tracked_max = settings.tracked_max;
+    int tracked_expiry = settings.tracked_expiry_s;
+
+    bool numbers = json_optional_int(json, "syncGapUs", UINT16_MAX, &sync_gap) &&
+                   json_optional_int(json, "shortPulseUs", UINT16_MAX, &short_pulse) &&
+                   json_optional_int(json, "decoderMinBits", UINT8_MAX, &decoder_min_bits) &&
+                   json_optional_int(json, "acceptMinBits", UINT8_MAX, &accept_min_bits) &&
+                   json_optional_int(json, "trackedMax", UINT8_MAX, &tracked_max) &&
+                   json_optional_int(json, "trackedExpiryS", INT32_MAX, &tracked_expiry);
+    cJSON_Delete(json);
+    if (!numbers) {
+        return send_json_error(req, "Settings must be non-negative numbers");
+    }
+
+    settings.sync_gap_us = sync_gap;
+    settings.short_pulse_us = short_pulse;
+    settings.decoder_min_bits = decoder_min_bits;
+    settings.accept_min_bits = accept_min_bits;
+    settings.tracked_max = tracked_max;
+    settings.tracked_expiry_s = tracked_expiry;
+
+    const char *error = settings_validate(&settings);
+    if (error != NULL) {
+        return send_json_error(req, error);
+    }
+    if (settings_set(&settings) != ESP_OK) {
+        return send_json_error(req, "Failed to save settings");
+    }
+
+    // Applies a lowered tracking limit or expiry right away
+    cleanup_old_tracked_signals();
+
+    api_send_str(req, "{\"success\":true}");
+    return ESP_OK;
+}
+
+// Per-radio counters, receivers also show how many frames diversity merging folded away
+static esp_err_t api_radios_handler(httpd_req_t *req)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *receivers = cJSON_AddArrayToObject(root, "receivers");
+    for (int i = 0; i < radio_receiver_count(); i++) {
+        radio_rx_stats_t stats;
+        radio_get_rx_stats(i, &stats);
+        cJSON *rx = cJSON_CreateObject();
+        cJSON_AddNumberToObject(rx, "index", i);
+        cJSON_AddNumberToObject(rx, "pin", stats.pin);
+        cJSON_AddNumberToObject(rx, "isrCount", stats.isr_count);
+        cJSON_AddNumberToObject(rx, "decoded", stats.decoded);
+        cJSON_AddNumberToObject(rx, "accepted", stats.accepted);
+        cJSON_AddNumberToObject(rx, "merged", stats.merged);
+
+        cJSON *buffer = cJSON_AddObjectToObject(rx, "buffer");
+        cJSON_AddNumberToObject(buffer, "edges", stats.buffer_edges);
+        cJSON_AddNumberToObject(buffer, "width", stats.buffer_width);
+        cJSON_AddBoolToObject(buffer, "psram", stats.buffer_psram);
+        cJSON_AddNumberToObject(buffer, "overflows", stats.overflows);
+
+        rc_squelch_t sq;
+        radio_get_squelch(i, &sq);
+        cJSON *squelch = cJSON_AddObjectToObject(rx, "squelch");
+        cJSON_AddBoolToObject(squelch, "enabled", sq.enabled);
+        cJSON_AddBoolToObject(squelch, "noise", sq.noise);
+        cJSON_AddNumberToObject(squelch, "glitchUs", sq.glitch_us);
+        cJSON_AddNumberToObject(squelch, "glitchLimit", sq.glitch_limit);
+        cJSON_AddNumberToObject(squelch, "edgeRate", sq.edge_rate);
+        cJSON_AddNumberToObject(squelch, "noiseRate", sq.noise_rate);
+        cJSON_AddNumberToObject(squelch, "noiseMs", sq.noise_ms);
+        cJSON_AddNumberToObject(squelch, "abortedCaptures", sq.aborted_captures);
+        cJSON_AddNumberToObject(squelch, "skippedEdges", sq.skipped_edges);
+        cJSON_AddNumberToObject(squelch, "skippedDecodes", sq.skipped_decodes);
+        cJSON_AddNumberToObject(squelch, "decodeAttempts", sq.decode_attempts);
+        cJSON_AddItemToArray(receivers, rx);
+    }
+
+    cJSON *transmitters = cJSON_AddArrayToObject(root, "transmitters");
+    for (int i = 0; i < radio_transmitter_count(); i++) {
+        radio_tx_stats_t stats;
+        radio_get_tx_stats(i, &stats);
+        cJSON *tx = cJSON_CreateObject();
+        cJSON_AddNumberToObject(tx, "index", i);
+        cJSON_AddNumberToObject(tx, "pin", stats.pin);
+        cJSON_AddNumberToObject(tx, "sends", stats.sends);
+        cJSON_AddNumberToObject(tx, "frames", stats.frames);
+        cJSON_AddNumberToObject(tx, "airtimeUs", (double)stats.airtime_us);
+        cJSON_AddItemToArray(transmitters, tx);
+    }
+    cJSON_AddNumberToObject(root, "diversityWindowUs", RADIO_DIVERSITY_WINDOW_US);
+
+    api_send(req, root);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// Registered device family decoders with their match counters
+static esp_err_t api_families_handler(httpd_req_t *req)
+{
+    cJSON *root = cJSON_CreateArray();
+    for (int i = 0; i < family_count(); i++) {
+        family_stats_t stats;
+        family_get_stats(i, &stats);
+        cJSON *family = cJSON_CreateObject();
+        cJSON_AddStringToObject(family, "name", stats.name);
+        cJSON_AddNumberToObject(family, "protocol", stats.protocol);
+        cJSON_AddNumberToObject(family, "bitLength", stats.bit_length);
+        if (stats.min_pulse_us != 0 || stats.max_pulse_us != 0) {
+            cJSON_AddNumberToObject(family, "minPulse", stats.min_pulse_us);
+            cJSON_AddNumberToObject(family, "maxPulse", stats.max_pulse_us);
+        }
+        cJSON_AddNumberToObject(family, "decoded", stats.decoded);
+        cJSON_AddNumberToObject(family, "rejected", stats.rejected);
+        cJSON_AddItemToArray(root, family);
+    }
+
+    api_send(req, root);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// Sockets in use and how the worker classes keep up with what is handed to them
+static esp_err_t api_http_stats_handler(httpd_req_t *req)
+{
+    cJSON *root = cJSON_CreateObject();
+    size_t open_sockets = HTTP_MAX_OPEN_SOCKETS;
+    int client_fds[HTTP_MAX_OPEN_SOCKETS];
+    if (httpd_get_client_list(req->handle, &open_sockets, client_fds) == ESP_OK) {
+        cJSON_AddNumberToObject(root, "openSockets", open_sockets);
+    }
+    cJSON_AddNumberToObject(root, "maxOpenSockets", HTTP_MAX_OPEN_SOCKETS);
+
+    cJSON *classes = cJSON_AddArrayToObject(root, "classes");
+    for (int c = 0; c < HTTP_ASYNC_CLASS_COUNT; c++) {
+        http_async_stats_t stats;
+        http_async_get_stats(c, &stats);
+
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", http_async_class_to_string(c));
+        cJSON_AddNumberToObject(item, "workers", stats.workers);
+        cJSON_AddNumberToObject(item, "queueDepth", stats.queue_depth);
+        cJSON_AddNumberToObject(item, "queued", stats.queued);
+        cJSON_AddNumberToObject(item, "running", stats.running);
+        cJSON_AddNumberToObject(item, "completed", stats.completed);
+        cJSON_AddNumberToObject(item, "rejected", stats.rejected);
+        cJSON_AddNumberToObject(item, "inline", stats.inline_runs);
+        cJSON_AddNumberToObject(item, "waitUs", (double)stats.wait_us);
+        cJSON_AddNumberToObject(item, "maxWaitUs", stats.max_wait_us);
+        cJSON_AddNumberToObject(item, "runUs", (double)stats.run_us);
+        cJSON_AddNumberToObject(item, "maxRunUs", stats.max_run_us);
+        cJSON_AddItemToArray(classes, item);
+    }
+
+    // JSON against CBOR: bytes and time per response, and per parsed request body
+    cJSON *formats = cJSON_AddObjectToObject(root, "formats");
+    for (int f = 0; f < API_FORMAT_COUNT; f++) {
+        api_format_stats_t stats;
+        api_format_get_stats(f, &stats);
+
+        cJSON *item = cJSON_AddObjectToObject(formats, api_format_to_string(f));
+        cJSON_AddNumberToObject(item, "responses", stats.responses);
+        cJSON_AddNumberToObject(item, "responseBytes", (double)stats.response_bytes);
+        cJSON_AddNumberToObject(item, "sendUs", (double)stats.send_us);
+        cJSON_AddNumberToObject(item, "requests", stats.requests);
+        cJSON_AddNumberToObject(item, "requestBytes", (double)stats.request_bytes);
+        cJSON_AddNumberToObject(item, "parseUs", (double)stats.parse_us);
+        cJSON_AddNumberToObject(item, "parseErrors", stats.parse_errors);
+    }
+
+    trace_stats_t trace;
+    trace_get_stats(&trace);
+    cJSON *trace_obj = cJSON_AddObjectToObject(root, "trace");
+    cJSON_AddBoolToObject(trace_obj, "enabled", trace_enabled());
+    cJSON_AddNumberToObject(trace_obj, "capacity", trace.capacity);
+    cJSON *recorded = cJSON_AddArrayToObject(trace_obj, "recorded");
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        cJSON_AddItemToArray(recorded, cJSON_CreateNumber(trace.recorded[core]));
+    }
+
+    api_send(req, root);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// Copies the saved signal with this code, bit length and protocol out, false if there is
+// none. out may be NULL when only the match matters.
+static bool find_saved_signal(uint32_t code, uint8_t bit_length, uint8_t protocol, rf_signal_t *out)
+{
+    bool found = false;
+    library_lock();
+    for (int i = 0; i < signal_count && !found; i++) {
+        if (saved_signals[i].code == code && saved_signals[i].bit_length == bit_length &&
+            saved_signals[i].protocol == protocol) {
+            if (out != NULL) *out = saved_signals[i];
+            found = true;
+        }
+    }
+    library_unlock();
+    return found;
+}
+
+static void add_airtime_usage(cJSON *obj, const airtime_usage_t *usage)
+{
+    cJSON_AddNumberToObject(obj, "sends", usage->sends);
+    cJSON_AddNumberToObject(obj, "frames", usage->frames);
+    cJSON_AddNumberToObject(obj, "airtimeUs", (double)usage->airtime_us);
+    cJSON_AddNumberToObject(obj, "deferred", usage->deferred);
+    cJSON_AddNumberToObject(obj, "shortened", usage->shortened);
+    cJSON_AddNumberToObject(obj, "dropped", usage->dropped);
+}
+
+// Duty-cycle budget of the transmitters, overall and per code sent
+static esp_err_t api_airtime_handler(httpd_req_t *req)
+{
+    airtime_stats_t stats;
+    airtime_get_stats(&stats);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "policy", airtime_policy_to_string(stats.policy));
+    cJSON_AddNumberToObject(root, "dutyPermille", stats.duty_permille);
+    cJSON_AddNumberToObject(root, "windowS", stats.window_s);
+    cJSON_AddNumberToObject(root, "budgetUs", stats.budget_us);
+    cJSON_AddNumberToObject(root, "usedUs", stats.used_us);
+    add_airtime_usage(root, &stats.total);
+
+    cJSON *signals = cJSON_AddArrayToObject(root, "signals");
+    for (int i = 0; i < AIRTIME_SIGNALS_MAX; i++) {
+        airtime_signal_t sig;
+        if (!airtime_get_signal(i, &sig)) continue;
+
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "code", sig.code);
+        cJSON_AddNumberToObject(item, "bitLength", sig.bit_length);
+        cJSON_AddNumberToObject(item, "protocol", sig.protocol);
+        rf_signal_t saved;
+        if (find_saved_signal(sig.code, sig.bit_length, sig.protocol, &saved)) {
+            cJSON_AddStringToObject(item, "name", saved.name);
+        }
+        add_airtime_usage(item, &sig.usage);
+        cJSON_AddItemToArray(signals, item);
+    }
+
+    api_send(req, root);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+static cJSON *rollup_series_to_json(const uint32_t *values, int count)
+{
+    cJSON *series = cJSON_CreateArray();
+    for (int i = 0; i < count; i++) {
+        cJSON_AddItemToArray(series, cJSON_CreateNumber(values[i]));
+    }
+    return series;
+}
+
+// Writes one rollup item in the negotiated format: CBOR when w is set, otherwise a JSON chunk
+static esp_err_t rollup_send_item(httpd_req_t *req, cbor_writer_t *w, const cJSON *item,
+                                  const char *separator, size_t *bytes)
+{
+    if (w != NULL) {
+        cbor_put_cjson(w, item);
+        return w->err;
+    }
+    char *json = cJSON_PrintUnformatted(item);
+    if (json == NULL) return ESP_ERR_NO_MEM;
+    *bytes += strlen(separator) + strlen(json);
+    // An empty chunk would end the response
+    if (*separator != '\0') httpd_resp_sendstr_chunk(req, separator);
+    esp_err_t err = httpd_resp_sendstr_chunk(req, json);
+    cJSON_free(json);
+    return err;
+}
+
+// Press counts and receiver rates in time buckets, ?resolution=minute|hour|day (default minute).
+// Series are streamed one at a time, a tree of all of them would not fit in heap.
+static esp_err_t api_rollups_handler(httpd_req_t *req)
+{
+    int64_t start = esp_timer_get_time();
+
+    rollup_resolution_t resolution = ROLLUP_MINUTE;
+    char query[48];
+    char value[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "resolution", value, sizeof(value)) == ESP_OK &&
+        !rollup_resolution_from_string(value, &resolution)) {
+        return send_json_error(req, "resolution must be minute, hour or day");
+    }
+
+    rollup_info_t info;
+    rollup_get_info(resolution, &info);
+    uint32_t series[ROLLUP_BUCKETS_MAX];
+    uint32_t noise[ROLLUP_BUCKETS_MAX];
+
+    cJSON *header = cJSON_CreateObject();
+    cJSON_AddStringToObject(header, "resolution", rollup_resolution_to_string(resolution));
+    cJSON_AddNumberToObject(header, "bucketS", info.bucket_s);
+    cJSON_AddNumberToObject(header, "buckets", info.buckets);
+    cJSON_AddNumberToObject(header, "currentS", info.current_s);
+    rollup_get_total(resolution, series);
+    cJSON_AddItemToObject(header, "total", rollup_series_to_json(series, info.buckets));
+
+    cbor_writer_t cbor;
+    cbor_writer_t *w = NULL;
+    size_t bytes = 0;
+    if (api_format_of_response(req) == API_FORMAT_CBOR) {
+        w = &cbor;
+        api_cbor_begin(req, w);
+        cbor_begin_map(w, CBOR_INDEFINITE);
+        for (const cJSON *field = header->child; field != NULL; field = field->next) {
+            cbor_put_text(w, field->string);
+            cbor_put_cjson(w, field);
+        }
+        cbor_put_text(w, "signals");
+        cbor_begin_array(w, CBOR_INDEFINITE);
+    } else {
+        char *json = cJSON_PrintUnformatted(header);
+        if (json == NULL) {
+            cJSON_Delete(header);
+            return send_json_error(req, "Out of memory");
+        }
+        // The header object stays open for the arrays that follow
+        json[strlen(json) - 1] = '\0';
+        httpd_resp_set_type(req, API_CONTENT_JSON);
+        httpd_resp_sendstr_chunk(req, json);
+        bytes += strlen(json);
+        httpd_resp_sendstr_chunk(req, ",\"signals\":[");
+        cJSON_free(json);
+    }
+    cJSON_Delete(header);
+
+    esp_err_t err = ESP_OK;
+    int sent = 0;
+    for (int i = 0; i < ROLLUP_SIGNALS_MAX && err == ESP_OK; i++) {
+        rollup_signal_t sig;
+        uint16_t presses[ROLLUP_BUCKETS_MAX];
+        if (!rollup_get_signal(i, resolution, &sig, presses)) continue;
+        for (int b = 0; b < info.buckets; b++) {
+            series[b] = presses[b];
+        }
+
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "code", sig.code);
+        cJSON_AddNumberToObject(item, "bitLength", sig.bit_length);
+        cJSON_AddNumberToObject(item, "protocol", sig.protocol);
+        rf_signal_t saved;
+        if (find_saved_signal(sig.code, sig.bit_length, sig.protocol, &saved)) {
+            cJSON_AddStringToObject(item, "name", saved.name);
+        }
+        cJSON_AddNumberToObject(item, "presses", sig.presses);
+        cJSON_AddItemToObject(item, "series", rollup_series_to_json(series, info.buckets));
+        err = rollup_send_item(req, w, item, sent++ > 0 ? "," : "", &bytes);
+        cJSON_Delete(item);
+    }
+
+    if (w != NULL) {
+        cbor_end(w);
+        cbor_put_text(w, "receivers");
+        cbor_begin_array(w, CBOR_INDEFINITE);
+    } else {
+        httpd_resp_sendstr_chunk(req, "],\"receivers\":[");
+    }
+
+    for (int rx = 0; rx < radio_receiver_count() && err == ESP_OK; rx++) {
+        if (!rollup_get_rates(rx, resolution, series, noise)) continue;
+
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "index", rx);
+        cJSON_AddItemToObject(item, "edgeRate", rollup_series_to_json(series, info.buckets));
+        cJSON_AddItemToObject(item, "noiseRate", rollup_series_to_json(noise, info.buckets));
+        err = rollup_send_item(req, w, item, rx > 0 ? "," : "", &bytes);
+        cJSON_Delete(item);
+    }
+
+    if (w != NULL) {
+        cbor_end(w);
+        cbor_end(w);
+        return api_cbor_end(req, w, start);
+    }
+    if (err != ESP_OK) return ESP_FAIL;
+    httpd_resp_sendstr_chunk(req, "]}");
+    httpd_resp_sendstr_chunk(req, NULL);
+    api_format_record_response(API_FORMAT_JSON, bytes + 30, start);
+    return ESP_OK;
+}
+
+static esp_err_t trace_write_chunk(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+// Hot-path trace as Chrome trace event JSON, open it in ui.perfetto.dev.
+// ?clear=1 starts a fresh recording once this one is out.
+static esp_err_t api_trace_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_STREAM, api_trace_handler)) return ESP_OK;
+
+    if (!trace_enabled()) {
+        api_send_str(req, "{\"error\":\"Tracing disabled\"}");
+        return ESP_OK;
+    }
+
+    char query[32];
+    bool clear = false;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        clear = query_u32(query, "clear", 0) != 0;
+    }
+
+    httpd_resp_set_type(req, API_CONTENT_JSON);
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"rf-trace.json\"");
+    esp_err_t err = trace_export_chrome(trace_write_chunk, req);
+    if (err == ESP_OK) {
+        httpd_resp_send_chunk(req, NULL, 0);
+        if (clear) trace_clear();
+    } else {
+        ESP_LOGW(TAG, "Trace export failed: %s", esp_err_to_name(err));
+    }
+    return ESP_OK;
+}
+
+// Transmit action of the rules engine, rules reference saved signals by name
+static esp_err_t transmit_saved_signal(const char *name, int transmitter)
+{
+    rf_signal_t sig;
+    if (!library_find_name(name, &sig)) return ESP_ERR_NOT_FOUND;
+    return transmit_signal(&sig, transmitter, NULL);
+}
+
+static esp_err_t api_rules_get_handler(httpd_req_t *req)
+{
+    cJSON *root = cJSON_CreateArray();
+    rule_t rule;
+    rule_action_t actions[RULE_ACTIONS_MAX];
+    rule_stats_t stats;
+    for (int i = 0; rules_get(i, &rule, actions, &stats); i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "id", rule.id);
+        cJSON_AddBoolToObject(item, "enabled", rule.enabled);
+        cJSON_AddNumberToObject(item, "code", rule.code);
+        cJSON_AddNumberToObject(item, "mask", rule.mask);
+        cJSON_AddNumberToObject(item, "bitLength", rule.bit_length);
+        cJSON_AddNumberToObject(item, "protocol", rule.protocol);
+        cJSON_AddNumberToObject(item, "cooldownMs", rule.cooldown_ms);
+        cJSON_AddStringToObject(item, "trigger", burst_event_to_string(rule.trigger));
+        cJSON_AddNumberToObject(item, "holdMs", rule.hold_ms);
+
+        cJSON *action_array = cJSON_AddArrayToObject(item, "actions");
+        for (int a = 0; a < rule.action_count; a++) {
+            cJSON *action = cJSON_CreateObject();
+            if (actions[a].type == RULE_ACTION_TRANSMIT) {
+                cJSON_AddStringToObject(action, "type", "transmit");
+                cJSON_AddStringToObject(action, "signal", actions[a].signal);
+                cJSON_AddNumberToObject(action, "transmitter", actions[a].transmitter);
+            } else {
+                cJSON_AddStringToObject(action, "type", "publish");
+            }
+            cJSON_AddItemToArray(action_array, action);
+        }
+
+        cJSON_AddNumberToObject(item, "fired", stats.fired);
+        cJSON_AddNumberToObject(item, "lastFired", stats.last_fired);
+        cJSON_AddItemToArray(root, item);
+    }
+
+    api_send(req, root);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// Accepts a JSON number or a string such as "0xFFFFF0"
+static bool json_to_u32(const cJSON *item, uint32_t *out)
+{
+    if (cJSON_IsNumber(item)) {
+        *out = (uint32_t)item->valuedouble;
+        return true;
+    }
+    if (cJSON_IsString(item)) {
+        char *end = NULL;
+        *out = strtoul(item->valuestring, &end, 0);
+        return end != item->valuestring && *end == '\0';
+    }
+    return false;
+}
+
+// Returns 0xFF for an unknown trigger name
+static uint8_t rule_trigger_from_string(const char *name)
+{
+    if (strcmp(name, "press") == 0) return RULE_TRIGGER_PRESS;
+    if (strcmp(name, "hold") == 0) return RULE_TRIGGER_HOLD;
+    if (strcmp(name, "release") == 0) return RULE_TRIGGER_RELEASE;
+    return 0xFF;
+}
+
+static esp_err_t api_rules_post_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_rules_post_handler)) return ESP_OK;
+
+    char buf[1536];
+    if (req->content_len >= sizeof(buf)) {
+        api_send_str(req, "{\"error\":\"Rule too large\"}");
+        return ESP_FAIL;
+    }
+    int received = 0;
+    while (received < (int)req->content_len) {
+        int ret = httpd_req_recv(req, buf + received, req->content_len - received);
+        if (ret <= 0) {
+            httpd_resp_send_500(req);
+            return ESP_FAIL;
+        }
+        received += ret;
+    }
+    buf[received] = '\0';
+
+    cJSON *json = api_parse_body(req, buf, received);
+    if (json == NULL) {
+        api_send_str(req, "{\"error\":\"Invalid JSON\"}");
+        return ESP_FAIL;
+    }
+
+    rule_t rule = {
+        .enabled = true,
+        .mask = 0xFFFFFFFF,
+        .cooldown_ms = 1000,
+    };
+    rule_action_t actions[RULE_ACTIONS_MAX] = {0};
+    const char *error = NULL;
+
+    cJSON *bitLength = cJSON_GetObjectItem(json, "bitLength");
+    cJSON *protocol = cJSON_GetObjectItem(json, "protocol");
+    cJSON *cooldown = cJSON_GetObjectItem(json, "cooldownMs");
+    cJSON *trigger = cJSON_GetObjectItem(json, "trigger");
+    cJSON *hold = cJSON_GetObjectItem(json, "holdMs");
+    cJSON *enabled = cJSON_GetObjectItem(json, "enabled");
+    cJSON *action_array = cJSON_GetObjectItem(json, "actions");
+
+    if (!json_to_u32(cJSON_GetObjectItem(json, "code"), &rule.code) || !cJSON_IsNumber(bitLength)) {
+        error = "code and bitLength are required";
+    } else if (cJSON_GetObjectItem(json, "mask") != NULL &&
+               !json_to_u32(cJSON_GetObjectItem(json, "mask"), &rule.mask)) {
+        error = "Invalid mask";
+    } else if (!cJSON_IsArray(action_array) || cJSON_GetArraySize(action_array) == 0 ||
+               cJSON_GetArraySize(action_array) > RULE_ACTIONS_MAX) {
+        error = "actions must list 1 to 8 actions";
+    } else if (trigger != NULL && !(cJSON_IsString(trigger) &&
+               (rule.trigger = rule_trigger_from_string(trigger->valuestring)) != 0xFF)) {
+        error = "trigger must be press, hold or release";
+    } else if (hold != NULL && (!cJSON_IsNumber(hold) || hold->valueint < 0 || hold->valueint > UINT16_MAX)) {
+        error = "holdMs must be 0-65535";
+    } else {
+        rule.bit_length = bitLength->valueint;
+        rule.protocol = cJSON_IsNumber(protocol) ? protocol->valueint : 0;
+        if (cJSON_IsNumber(cooldown)) rule.cooldown_ms = cooldown->valueint;
+        if (hold != NULL) rule.hold_ms = hold->valueint;
+        if (cJSON_IsBool(enabled)) rule.enabled = cJSON_IsTrue(enabled);
+
+        cJSON *item;
+        cJSON_ArrayForEach(item, action_array) {
+            rule_action_t *action = &actions[rule.action_count++];
+            cJSON *type = cJSON_GetObjectItem(item, "type");
+            cJSON *signal = cJSON_GetObjectItem(item, "signal");
+            cJSON *transmitter = cJSON_GetObjectItem(item, "transmitter");
+
+            if (cJSON_IsString(type) && strcmp(type->valuestring, "publish") == 0) {
+                action->type = RULE_ACTION_PUBLISH;
+            } else if (cJSON_IsString(type) && strcmp(type->valuestring, "transmit") == 0 &&
+                       cJSON_IsString(signal) && signal->valuestring[0] != '\0' &&
+                       strlen(signal->valuestring) < RULE_SIGNAL_NAME_LEN) {
+                action->type = RULE_ACTION_TRANSMIT;
+                strcpy(action->signal, signal->valuestring);
+                action->transmitter = cJSON_IsNumber(transmitter) ? transmitter->valueint : 0;
+                if (action->transmitter >= radio_transmitter_count()) {
+                    error = "Unknown transmitter";
+                }
+            } else {
+                error = "Invalid action (transmit needs a signal name under 32 characters)";
+            }
+        }
+    }
+    cJSON_Delete(json);
+
+    if (error == NULL) {
+        esp_err_t err = rules_add(&rule, actions);
+        if (err == ESP_ERR_NO_MEM) {
+            error = "Rule table is full";
+        } else if (err == ESP_ERR_NOT_SUPPORTED) {
+            error = "Too many different mask/bit length combinations";
+        } else if (err != ESP_OK) {
+            error = "Invalid bit length or protocol";
+        }
+    }
+
+    if (error != NULL) {
+        char resp[128];
+        snprintf(resp, sizeof(resp), "{\"error\":\"%s\"}", error);
+        api_send_str(req, resp);
+        return ESP_FAIL;
+    }
+
+    char resp[48];
+    snprintf(resp, sizeof(resp), "{\"success\":true,\"id\":%u}", rule.id);
+    api_send_str(req, resp);
+    return ESP_OK;
+}
+
+static esp_err_t api_rules_delete_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_rules_delete_handler)) return ESP_OK;
+
+    uint32_t id;
+    if (api_path_uint(req, 0, &id) && id <= UINT16_MAX && rules_delete(id) == ESP_OK) {
+        api_send_str(req, "{\"success\":true}");
+        return ESP_OK;
+    }
+
+    httpd_resp_send_404(req);
+    return ESP_FAIL;
+}
+
+static const char *schedule_type_names[] = { "once", "interval", "daily" };
+
+static esp_err_t api_schedule_get_handler(httpd_req_t *req)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "time", (double)time(NULL));
+    cJSON_AddBoolToObject(root, "clockValid", scheduler_clock_valid());
+
+    cJSON *jobs = cJSON_AddArrayToObject(root, "jobs");
+    for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+        schedule_job_t job;
+        if (!scheduler_get(i, &job)) continue;
+
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "id", job.id);
+        cJSON_AddStringToObject(item, "type", schedule_type_names[job.type]);
+        cJSON_AddStringToObject(item, "signal", job.signal);
+        cJSON_AddNumberToObject(item, "transmitter", job.transmitter);
+        cJSON_AddNumberToObject(item, "due", job.due);
+        if (job.type == SCHEDULE_INTERVAL) {
+            cJSON_AddNumberToObject(item, "every", job.period);
+        } else if (job.type == SCHEDULE_DAILY) {
+            char hhmm[8];
+            snprintf(hhmm, sizeof(hhmm), "%02lu:%02lu", job.period / 60, job.period % 60);
+            cJSON_AddStringToObject(item, "daily", hhmm);
+        }
+        cJSON_AddStringToObject(item, "catchup", job.catchup == SCHEDULE_CATCHUP_SKIP ? "skip" : "once");
+        cJSON_AddNumberToObject(item, "lastRun", job.last_run);
+        cJSON_AddItemToArray(jobs, item);
+    }
+
+    api_send(req, root);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+static esp_err_t api_schedule_post_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_schedule_post_handler)) return ESP_OK;
 
     char buf[512];
     int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
@@ -506,203 +2461,590 @@ static esp_err_t api_signals_put_handler(httpd_req_t *req)
     }
     buf[ret] = '\0';
 
-    cJSON *json = cJSON_Parse(buf);
+    cJSON *json = api_parse_body(req, buf, ret);
     if (json == NULL) {
-        httpd_resp_send_500(req);
+        api_send_str(req, "{\"error\":\"Invalid JSON\"}");
         return ESP_FAIL;
     }
 
-    cJSON *name = cJSON_GetObjectItem(json, "name");
-    cJSON *code = cJSON_GetObjectItem(json, "code");
-    cJSON *bitLength = cJSON_GetObjectItem(json, "bitLength");
-    cJSON *protocol = cJSON_GetObjectItem(json, "protocol");
-    cJSON *pulseLength = cJSON_GetObjectItem(json, "pulseLength");
+    schedule_job_t job = {0};
+    const char *error = NULL;
+    cJSON *signal = cJSON_GetObjectItem(json, "signal");
+    cJSON *transmitter = cJSON_GetObjectItem(json, "transmitter");
+    cJSON *catchup = cJSON_GetObjectItem(json, "catchup");
+    cJSON *in = cJSON_GetObjectItem(json, "in");
+    cJSON *at = cJSON_GetObjectItem(json, "at");
+    cJSON *every = cJSON_GetObjectItem(json, "every");
+    cJSON *daily = cJSON_GetObjectItem(json, "daily");
+    unsigned hours, minutes;
+
+    if (!cJSON_IsString(signal) || strlen(signal->valuestring) >= SCHEDULER_SIGNAL_NAME_LEN) {
+        error = "signal must name a saved signal (under 32 characters)";
+    } else if (cJSON_IsNumber(in)) {
+        job.type = SCHEDULE_ONCE;
+        job.due = time(NULL) + in->valueint;
+    } else if (cJSON_IsNumber(at)) {
+        job.type = SCHEDULE_ONCE;
+        job.due = (uint32_t)at->valuedouble;
+    } else if (cJSON_IsNumber(every)) {
+        job.type = SCHEDULE_INTERVAL;
+        job.period = every->valueint;
+    } else if (cJSON_IsString(daily) && sscanf(daily->valuestring, "%u:%u", &hours, &minutes) == 2 &&
+               hours < 24 && minutes < 60) {
+        job.type = SCHEDULE_DAILY;
+        job.period = hours * 60 + minutes;
+    } else {
+        error = "Give one of in, at, every or daily (\"HH:MM\")";
+    }
 
-    if (name && code && bitLength && protocol && pulseLength) {
-        strncpy(saved_signals[index].name, name->valuestring, 63);
-        saved_signals[index].code = code->valueint;
-        saved_signals[index].bit_length = bitLength->valueint;
-        saved_signals[index].protocol = protocol->valueint;
-        saved_signals[index].pulse_length = pulseLength->valueint;
+    if (error == NULL) {
+        strcpy(job.signal, signal->valuestring);
+        job.transmitter = cJSON_IsNumber(transmitter) ? transmitter->valueint : 0;
+        job.catchup = cJSON_IsString(catchup) && strcmp(catchup->valuestring, "skip") == 0 ?
+                      SCHEDULE_CATCHUP_SKIP : SCHEDULE_CATCHUP_ONCE;
+        if (job.transmitter >= radio_transmitter_count()) {
+            error = "Unknown transmitter";
+        }
+    }
+    cJSON_Delete(json);
 
-        save_signals_to_nvs();
+    if (error == NULL) {
+        esp_err_t err = scheduler_add(&job);
+        if (err == ESP_ERR_INVALID_STATE) {
+            error = "Clock not synced yet";
+        } else if (err == ESP_ERR_NO_MEM) {
+            error = "Schedule is full";
+        } else if (err != ESP_OK) {
+            error = "Time must be in the future (max 1 year), intervals at least 10 s";
+        }
+    }
 
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"success\":true}");
-    } else {
-        httpd_resp_send_500(req);
+    if (error != NULL) {
+        char resp[128];
+        snprintf(resp, sizeof(resp), "{\"error\":\"%s\"}", error);
+        api_send_str(req, resp);
+        return ESP_FAIL;
     }
 
-    cJSON_Delete(json);
+    char resp[64];
+    snprintf(resp, sizeof(resp), "{\"success\":true,\"id\":%u,\"due\":%lu}", job.id, job.due);
+    api_send_str(req, resp);
     return ESP_OK;
 }
 
-static esp_err_t api_signals_delete_handler(httpd_req_t *req)
+static esp_err_t api_schedule_delete_handler(httpd_req_t *req)
 {
-    char *uri = (char *)req->uri;
-    char *index_str = strrchr(uri, '/');
-    if (index_str) {
-        int index = atoi(index_str + 1);
-        if (index >= 0 && index < signal_count) {
-            for (int i = index; i < signal_count - 1; i++) {
-                saved_signals[i] = saved_signals[i + 1];
-            }
-            signal_count--;
-            save_signals_to_nvs();
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_schedule_delete_handler)) return ESP_OK;
 
-            httpd_resp_set_type(req, "application/json");
-            httpd_resp_sendstr(req, "{\"success\":true}");
-            return ESP_OK;
-        }
+    uint32_t id;
+    if (api_path_uint(req, 0, &id) && id <= UINT16_MAX && scheduler_cancel(id) == ESP_OK) {
+        api_send_str(req, "{\"success\":true}");
+        return ESP_OK;
     }
 
     httpd_resp_send_404(req);
     return ESP_FAIL;
 }
 
-static esp_err_t api_transmit_index_handler(httpd_req_t *req)
+#define EVENTS_DEFAULT_LIMIT 500
+#define EVENTS_READ_CHUNK 16
+
+// Name of the field the 16-bit slot of a record carries for its kind
+static const char *event_record_field(event_kind_t kind)
+{
+    switch (kind) {
+        case EVENT_KIND_RULE:    return "rule";
+        case EVENT_KIND_HOLD:
+        case EVENT_KIND_RELEASE: return "durationMs";
+        default:                 return "pulseLength";
+    }
+}
+
+// Streams a range of the persistent event log. Select the range by sequence number
+// (from/to) or by Unix time (since/until), records are read from flash in small
+// chunks and written out as they come, so the whole log never sits in RAM.
+static esp_err_t api_events_handler(httpd_req_t *req)
 {
-    char *uri = (char *)req->uri;
-    char *index_str = strrchr(uri, '/');
-    if (index_str) {
-        int index = atoi(index_str + 1);
-        if (index >= 0 && index < signal_count) {
-            rf_signal_t *sig = &saved_signals[index];
+    if (http_async_defer(req, HTTP_ASYNC_STREAM, api_events_handler)) return ESP_OK;
+
+    char query[128];
+    const char *q = NULL;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        q = query;
+    }
 
-            rc_transmitter_set_protocol(&transmitter, sig->protocol - 1);
-            rc_transmitter_set_pulse_length(&transmitter, sig->pulse_length);
-            rc_transmitter_send(&transmitter, sig->code, sig->bit_length);
+    // Make sure the batch still in RAM is part of the answer
+    event_log_flush();
 
-            ESP_LOGI(TAG, "Transmitted: %s (Code: %lu)", sig->name, sig->code);
+    event_log_stats_t stats;
+    event_log_get_stats(&stats);
 
-            httpd_resp_set_type(req, "application/json");
-            httpd_resp_sendstr(req, "{\"success\":true}");
-            return ESP_OK;
-        }
+    uint32_t from_seq = query_u32(q, "from", stats.oldest_seq);
+    uint32_t to_seq = query_u32(q, "to", UINT32_MAX);
+    uint32_t since = query_u32(q, "since", 0);
+    uint32_t until = query_u32(q, "until", UINT32_MAX);
+    uint32_t limit = query_u32(q, "limit", EVENTS_DEFAULT_LIMIT);
+
+    if (since > 0) {
+        from_seq = MAX(from_seq, event_log_seq_at_time(since));
     }
 
-    httpd_resp_send_404(req);
-    return ESP_FAIL;
-}
+    int64_t start = esp_timer_get_time();
+    bool cbor = api_format_of_response(req) == API_FORMAT_CBOR;
+    cbor_writer_t w;
+    char line[192];
+    size_t bytes = 0;
+
+    if (cbor) {
+        api_cbor_begin(req, &w);
+        cbor_begin_map(&w, 4);
+        cbor_put_key_uint(&w, "oldestSeq", stats.oldest_seq);
+        cbor_put_key_uint(&w, "nextSeq", stats.next_seq);
+        cbor_put_key_uint(&w, "capacity", stats.capacity);
+        cbor_put_text(&w, "events");
+        cbor_begin_array(&w, CBOR_INDEFINITE);
+    } else {
+        httpd_resp_set_type(req, API_CONTENT_JSON);
+        bytes += snprintf(line, sizeof(line), "{\"oldestSeq\":%lu,\"nextSeq\":%lu,\"capacity\":%lu,\"events\":[",
+                          stats.oldest_seq, stats.next_seq, stats.capacity);
+        httpd_resp_sendstr_chunk(req, line);
+    }
 
-static esp_err_t api_transmit_name_handler(httpd_req_t *req)
-{
-    char *uri = (char *)req->uri;
-    char *name_start = strstr(uri, "/api/transmit/name/");
-    if (name_start) {
-        name_start += 19;
-        char decoded_name[64];
-        int j = 0;
-        for (int i = 0; name_start[i] && j < 63; i++) {
-            if (name_start[i] == '%' && name_start[i+1] == '2' && name_start[i+2] == '0') {
-                decoded_name[j++] = ' ';
-                i += 2;
+    event_record_t records[EVENTS_READ_CHUNK];
+    uint32_t seq = from_seq;
+    uint32_t sent = 0;
+    bool done = false;
+
+    while (!done && sent < limit) {
+        size_t n = event_log_read(seq, records, MIN(EVENTS_READ_CHUNK, limit - sent));
+        if (n == 0) break;
+
+        for (size_t i = 0; i < n; i++) {
+            const event_record_t *rec = &records[i];
+            if (rec->seq > to_seq || rec->timestamp > until) {
+                done = true;
+                break;
+            }
+            if (cbor) {
+                cbor_begin_map(&w, 7);
+                cbor_put_key_uint(&w, "seq", rec->seq);
+                cbor_put_key_uint(&w, "time", rec->timestamp);
+                cbor_put_key_text(&w, "kind", event_kind_to_string(EVENT_RECORD_KIND(rec)));
+                cbor_put_key_uint(&w, "code", rec->code);
+                cbor_put_key_uint(&w, "bitLength", rec->bit_length);
+                cbor_put_key_uint(&w, "protocol", EVENT_RECORD_PROTOCOL(rec));
+                cbor_put_key_uint(&w, event_record_field(EVENT_RECORD_KIND(rec)), rec->pulse_length);
+                if (w.err != ESP_OK) {
+                    return ESP_FAIL;
+                }
             } else {
-                decoded_name[j++] = name_start[i];
+                bytes += snprintf(line, sizeof(line),
+                         "%s{\"seq\":%lu,\"time\":%lu,\"kind\":\"%s\",\"code\":%lu,\"bitLength\":%u,\"protocol\":%u,\"%s\":%u}",
+                         sent > 0 ? "," : "", rec->seq, rec->timestamp,
+                         event_kind_to_string(EVENT_RECORD_KIND(rec)), rec->code,
+                         rec->bit_length, EVENT_RECORD_PROTOCOL(rec),
+                         event_record_field(EVENT_RECORD_KIND(rec)),
+                         rec->pulse_length);
+                if (httpd_resp_sendstr_chunk(req, line) != ESP_OK) {
+                    return ESP_FAIL;
+                }
             }
+            sent++;
         }
-        decoded_name[j] = '\0';
+        seq = records[n - 1].seq + 1;
+    }
 
-        for (int i = 0; i < signal_count; i++) {
-            if (strcasecmp(saved_signals[i].name, decoded_name) == 0) {
-                rf_signal_t *sig = &saved_signals[i];
+    if (cbor) {
+        cbor_end(&w);
+        return api_cbor_end(req, &w, start);
+    }
+
+    httpd_resp_sendstr_chunk(req, "]}");
+    httpd_resp_sendstr_chunk(req, NULL);
+    api_format_record_response(API_FORMAT_JSON, bytes + 2, start);
+    return ESP_OK;
+}
 
-                rc_transmitter_set_protocol(&transmitter, sig->protocol - 1);
-                rc_transmitter_set_pulse_length(&transmitter, sig->pulse_length);
-                rc_transmitter_send(&transmitter, sig->code, sig->bit_length);
+// Bulk library transfer. Two formats:
+//  - NDJSON: one signal object per line, same fields as POST /api/signals
+//  - Binary: "RFSL" magic, version byte, reserved byte, u16 count, then per signal
+//    u8 name length, name bytes, u32 code, u8 bit length, u8 protocol, u16 pulse length,
+//    u8 repeats, u8 verify, u8 max repeats, u16 gap ms, u16 tx pulse length
+//    (all little endian). About 21 bytes + name per signal. Version 1 files end each
+//    record after the pulse length and are still accepted.
+#define LIBRARY_MAGIC "RFSL"
+#define LIBRARY_VERSION 2
+#define LIBRARY_HEADER_SIZE 8
+#define LIBRARY_RECORD_FIXED_V1 9   // name length byte + code + bits + protocol + pulse
+#define LIBRARY_RECORD_FIXED 16     // v1 + transmit settings
+#define IMPORT_BUFFER_SIZE 1024
+
+typedef enum {
+    LIBRARY_FORMAT_NDJSON,
+    LIBRARY_FORMAT_BINARY
+} library_format_t;
+
+// ?format= wins, otherwise the Content-Type / Accept header decides
+static library_format_t get_library_format(httpd_req_t *req, const char *header)
+{
+    char query[64];
+    char value[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+        return strcmp(value, "binary") == 0 ? LIBRARY_FORMAT_BINARY : LIBRARY_FORMAT_NDJSON;
+    }
 
-                ESP_LOGI(TAG, "Transmitted: %s (Code: %lu)", sig->name, sig->code);
+    char type[48];
+    if (httpd_req_get_hdr_value_str(req, header, type, sizeof(type)) == ESP_OK &&
+        strstr(type, "application/octet-stream") != NULL) {
+        return LIBRARY_FORMAT_BINARY;
+    }
+    return LIBRARY_FORMAT_NDJSON;
+}
 
-                httpd_resp_set_type(req, "application/json");
-                httpd_resp_sendstr(req, "{\"success\":true}");
-                return ESP_OK;
+static esp_err_t api_signals_export_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_signals_export_handler)) return ESP_OK;
+
+    library_format_t format = get_library_format(req, "Accept");
+    rf_signal_t entry;
+
+    // Entries are copied out one at a time, the library is not locked while sending
+    if (format == LIBRARY_FORMAT_NDJSON) {
+        httpd_resp_set_type(req, "application/x-ndjson");
+        httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"signals.ndjson\"");
+
+        for (int i = 0; library_get(i, &entry); i++) {
+            char *json = signal_to_json(&entry, NULL);
+            if (json == NULL) break;
+            esp_err_t err = httpd_resp_sendstr_chunk(req, json);
+            cJSON_free(json);
+            if (err != ESP_OK || httpd_resp_sendstr_chunk(req, "\n") != ESP_OK) {
+                return ESP_FAIL;
             }
         }
+        httpd_resp_sendstr_chunk(req, NULL);
+        return ESP_OK;
     }
 
-    httpd_resp_send_404(req);
-    return ESP_FAIL;
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"signals.rfsl\"");
+
+    uint8_t chunk[512];
+    size_t len = 0;
+    int count = library_count();
+
+    memcpy(chunk, LIBRARY_MAGIC, 4);
+    chunk[4] = LIBRARY_VERSION;
+    chunk[5] = 0;
+    chunk[6] = count & 0xFF;
+    chunk[7] = (count >> 8) & 0xFF;
+    len = LIBRARY_HEADER_SIZE;
+
+    for (int i = 0; i < count; i++) {
+        // The header already promised count records, a delete that shrank the library
+        // meanwhile ends the response short so the importer sees a truncated file
+        if (!library_get(i, &entry)) return ESP_FAIL;
+        const rf_signal_t *sig = &entry;
+        size_t name_len = strnlen(sig->name, sizeof(sig->name) - 1);
+
+        if (len + LIBRARY_RECORD_FIXED + name_len > sizeof(chunk)) {
+            if (httpd_resp_send_chunk(req, (const char *)chunk, len) != ESP_OK) return ESP_FAIL;
+            len = 0;
+        }
+
+        chunk[len++] = (uint8_t)name_len;
+        memcpy(&chunk[len], sig->name, name_len);
+        len += name_len;
+        chunk[len++] = sig->code & 0xFF;
+        chunk[len++] = (sig->code >> 8) & 0xFF;
+        chunk[len++] = (sig->code >> 16) & 0xFF;
+        chunk[len++] = (sig->code >> 24) & 0xFF;
+        chunk[len++] = sig->bit_length;
+        chunk[len++] = sig->protocol;
+        chunk[len++] = sig->pulse_length & 0xFF;
+        chunk[len++] = (sig->pulse_length >> 8) & 0xFF;
+        chunk[len++] = sig->repeats;
+        chunk[len++] = sig->verify;
+        chunk[len++] = sig->max_repeats;
+        chunk[len++] = sig->gap_ms & 0xFF;
+        chunk[len++] = (sig->gap_ms >> 8) & 0xFF;
+        chunk[len++] = sig->tx_pulse_length & 0xFF;
+        chunk[len++] = (sig->tx_pulse_length >> 8) & 0xFF;
+    }
+
+    if (len > 0 && httpd_resp_send_chunk(req, (const char *)chunk, len) != ESP_OK) return ESP_FAIL;
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
 }
 
-static esp_err_t api_transmit_direct_handler(httpd_req_t *req)
+typedef struct {
+    rf_signal_t *signals;   // saved_signals, entries past signal_count are staged
+    int count;
+    int imported;
+    int duplicates;
+    int invalid;
+    uint8_t version;        // Binary format version from the header
+} import_state_t;
+
+// Same rules as POST /api/signals: names are unique (case-insensitive), codes are unique
+static void import_stage_signal(import_state_t *state, const rf_signal_t *sig)
 {
-    char buf[512];
-    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
-    if (ret <= 0) {
-        httpd_resp_send_500(req);
-        return ESP_FAIL;
+    if (sig->name[0] == '\0' || sig->bit_length < 8 || sig->bit_length > 64 ||
+        sig->protocol < 1 || sig->protocol > 7) {
+        state->invalid++;
+        return;
     }
-    buf[ret] = '\0';
 
-    cJSON *json = cJSON_Parse(buf);
+    for (int i = 0; i < state->count; i++) {
+        if (strcasecmp(state->signals[i].name, sig->name) == 0 || state->signals[i].code == sig->code) {
+            state->duplicates++;
+            return;
+        }
+    }
+
+    if (state->count >= MAX_SIGNALS) {
+        state->invalid++;
+        return;
+    }
+
+    state->signals[state->count++] = *sig;
+    state->imported++;
+}
+
+static void import_ndjson_line(import_state_t *state, char *line)
+{
+    cJSON *json = cJSON_Parse(line);
     if (json == NULL) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid JSON\"}");
-        return ESP_FAIL;
+        state->invalid++;
+        return;
     }
 
-    // Validate required fields
+    cJSON *name = cJSON_GetObjectItem(json, "name");
     cJSON *code = cJSON_GetObjectItem(json, "code");
     cJSON *bitLength = cJSON_GetObjectItem(json, "bitLength");
     cJSON *protocol = cJSON_GetObjectItem(json, "protocol");
     cJSON *pulseLength = cJSON_GetObjectItem(json, "pulseLength");
 
-    if (!cJSON_IsNumber(code) || !cJSON_IsNumber(bitLength) ||
+    if (!cJSON_IsString(name) || !cJSON_IsNumber(code) || !cJSON_IsNumber(bitLength) ||
         !cJSON_IsNumber(protocol) || !cJSON_IsNumber(pulseLength)) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid numeric fields\"}");
+        state->invalid++;
         cJSON_Delete(json);
-        return ESP_FAIL;
+        return;
     }
 
-    // Validate ranges
-    if (bitLength->valueint < 8 || bitLength->valueint > 64 ||
-        protocol->valueint < 1 || protocol->valueint > 7) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid bit length or protocol\"}");
-        cJSON_Delete(json);
+    rf_signal_t sig = {0};
+    strncpy(sig.name, name->valuestring, sizeof(sig.name) - 1);
+    sig.code = (uint32_t)code->valuedouble;
+    sig.bit_length = bitLength->valueint;
+    sig.protocol = protocol->valueint;
+    sig.pulse_length = pulseLength->valueint;
+    const char *settings_error = parse_signal_tx_settings(json, &sig);
+    cJSON_Delete(json);
+
+    if (settings_error != NULL) {
+        state->invalid++;
+        return;
+    }
+    import_stage_signal(state, &sig);
+}
+
+// Parses as many complete NDJSON lines as the buffer holds, returns bytes consumed
+static size_t import_parse_ndjson(import_state_t *state, char *buf, size_t len, bool final)
+{
+    size_t consumed = 0;
+    while (consumed < len) {
+        char *line = buf + consumed;
+        char *newline = memchr(line, '\n', len - consumed);
+        if (newline == NULL) {
+            if (!final) break;
+            newline = buf + len;  // Last line without a trailing newline
+        }
+        *newline = '\0';
+        if (newline > line && newline[-1] == '\r') newline[-1] = '\0';
+        if (line[0] != '\0') {
+            import_ndjson_line(state, line);
+        }
+        consumed = newline - buf + 1;
+    }
+    return MIN(consumed, len);
+}
+
+// Parses as many complete binary records as the buffer holds, returns bytes consumed
+static size_t import_parse_binary(import_state_t *state, const uint8_t *buf, size_t len)
+{
+    size_t fixed = state->version == 1 ? LIBRARY_RECORD_FIXED_V1 : LIBRARY_RECORD_FIXED;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t name_len = buf[pos];
+        if (len - pos < fixed + name_len) break;
+
+        rf_signal_t sig = {0};
+        memcpy(sig.name, &buf[pos + 1], MIN(name_len, sizeof(sig.name) - 1));
+        const uint8_t *p = &buf[pos + 1 + name_len];
+        sig.code = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+        sig.bit_length = p[4];
+        sig.protocol = p[5];
+        sig.pulse_length = p[6] | (p[7] << 8);
+        if (state->version >= 2) {
+            sig.repeats = MIN(p[8], RADIO_MAX_REPEATS);
+            sig.verify = MIN(p[9], RADIO_MAX_REPEATS);
+            sig.max_repeats = MIN(p[10], RADIO_MAX_REPEATS);
+            sig.gap_ms = MIN(p[11] | (p[12] << 8), SIGNAL_MAX_GAP_MS);
+            sig.tx_pulse_length = MIN(p[13] | (p[14] << 8), SIGNAL_MAX_PULSE_US);
+        }
+
+        import_stage_signal(state, &sig);
+        pos += fixed + name_len;
+    }
+    return pos;
+}
+
+// Imports a whole library in one request. The body is parsed incrementally in
+// IMPORT_BUFFER_SIZE pieces, so it can be arbitrarily long; signals are staged in
+// RAM and written to NVS once. ?mode=replace drops the current library first,
+// the default (merge) keeps it and skips duplicates.
+static esp_err_t api_signals_import_handler(httpd_req_t *req)
+{
+    if (http_async_defer(req, HTTP_ASYNC_STORAGE, api_signals_import_handler)) return ESP_OK;
+
+    library_format_t format = get_library_format(req, "Content-Type");
+
+    char query[64];
+    char mode[16] = "merge";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "mode", mode, sizeof(mode));
+    }
+    bool replace = strcmp(mode, "replace") == 0;
+
+    char *buf = malloc(IMPORT_BUFFER_SIZE + 1);
+    if (buf == NULL) {
+        httpd_resp_send_500(req);
         return ESP_FAIL;
     }
 
-    // Transmit directly without saving
-    rc_transmitter_set_protocol(&transmitter, protocol->valueint - 1);
-    rc_transmitter_set_pulse_length(&transmitter, pulseLength->valueint);
-    rc_transmitter_send(&transmitter, code->valueint, bitLength->valueint);
+    // Records are staged in saved_signals past signal_count, where readers never look,
+    // so the library stays usable during the upload and nothing is copied. A replace
+    // empties the library up front and reloads it from NVS if the import fails.
+    import_state_t state = {0};
+    library_write_lock();
+    library_lock();
+    if (replace) signal_count = 0;
+    state.signals = saved_signals;
+    state.count = signal_count;
+    library_unlock();
+
+    size_t remaining = req->content_len;
+    size_t buffered = 0;
+    bool header_done = format == LIBRARY_FORMAT_NDJSON;
+    const char *error = NULL;
+
+    while (error == NULL && (remaining > 0 || buffered > 0)) {
+        if (remaining > 0) {
+            int ret = httpd_req_recv(req, buf + buffered, MIN(remaining, IMPORT_BUFFER_SIZE - buffered));
+            if (ret == HTTPD_SOCK_ERR_TIMEOUT) continue;
+            if (ret <= 0) {
+                error = "Failed to receive body";
+                break;
+            }
+            buffered += ret;
+            remaining -= ret;
+        }
+        bool final = remaining == 0;
 
-    ESP_LOGI(TAG, "Transmitted direct: Code: %lu, Protocol: %d, Bits: %d", 
-             code->valueint, protocol->valueint, bitLength->valueint);
+        if (!header_done) {
+            if (buffered < LIBRARY_HEADER_SIZE) {
+                if (final) error = "Truncated header";
+                continue;
+            }
+            if (memcmp(buf, LIBRARY_MAGIC, 4) != 0 || buf[4] < 1 || buf[4] > LIBRARY_VERSION) {
+                error = "Not a signal library file";
+                break;
+            }
+            state.version = buf[4];
+            memmove(buf, buf + LIBRARY_HEADER_SIZE, buffered - LIBRARY_HEADER_SIZE);
+            buffered -= LIBRARY_HEADER_SIZE;
+            header_done = true;
+        }
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, "{\"success\":true}");
+        size_t consumed;
+        if (format == LIBRARY_FORMAT_NDJSON) {
+            buf[buffered] = '\0';
+            consumed = import_parse_ndjson(&state, buf, buffered, final);
+        } else {
+            consumed = import_parse_binary(&state, (const uint8_t *)buf, buffered);
+        }
 
-    cJSON_Delete(json);
+        if (consumed == 0 && buffered == IMPORT_BUFFER_SIZE) {
+            error = "Record too long";
+            break;
+        }
+        if (final && consumed < buffered) {
+            state.invalid++;  // Truncated trailing record
+            consumed = buffered;
+        }
+
+        memmove(buf, buf + consumed, buffered - consumed);
+        buffered -= consumed;
+    }
+
+    free(buf);
+
+    if (error != NULL) {
+        // Staged entries were never counted, only a replace has something to restore
+        if (replace) {
+            library_lock();
+            load_signals_from_nvs();
+            library_unlock();
+        }
+        library_write_unlock();
+        httpd_resp_set_status(req, "400 Bad Request");
+        return send_json_error(req, error);
+    }
+
+    // Single commit: count the staged entries in and write NVS once
+    library_lock();
+    signal_count = state.count;
+    save_signals_to_nvs();
+    library_unlock();
+    library_write_unlock();
+
+    char resp[128];
+    snprintf(resp, sizeof(resp),
+             "{\"success\":true,\"imported\":%d,\"duplicates\":%d,\"invalid\":%d,\"total\":%d}",
+             state.imported, state.duplicates, state.invalid, state.count);
+    api_send_str(req, resp);
     return ESP_OK;
 }
 
-static esp_err_t api_clear_tracking_handler(httpd_req_t *req)
+static esp_err_t api_wifi_profile_get_handler(httpd_req_t *req)
 {
-    if (tracked_signals_mutex) {
-        xSemaphoreTake(tracked_signals_mutex, portMAX_DELAY);
-        tracked_count = 0;
-        xSemaphoreGive(tracked_signals_mutex);
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "profile", wifi_profile_to_string(wifi_profile_get()));
+
+    // Round-trip times reported by the latency probe, per profile
+    cJSON *latency = cJSON_CreateObject();
+    for (int i = 0; i < WIFI_PROFILE_COUNT; i++) {
+        wifi_latency_stats_t stats;
+        wifi_profile_get_latency((wifi_profile_t)i, &stats);
+
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddNumberToObject(entry, "samples", stats.samples);
+        cJSON_AddNumberToObject(entry, "p50", stats.p50_ms);
+        cJSON_AddNumberToObject(entry, "p99", stats.p99_ms);
+        cJSON_AddNumberToObject(entry, "max", stats.max_ms);
+        cJSON_AddItemToObject(latency, wifi_profile_to_string((wifi_profile_t)i), entry);
     }
-    
-    last_signal.code = 0;
-    last_signal_count = 0;
-    new_signal_received = false;
-    last_valid_code = 0;
-    last_valid_time = 0;
-    
-    ESP_LOGI(TAG, "Cleared all tracked signals and reset filter state");
+    cJSON_AddItemToObject(root, "latency", latency);
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, "{\"success\":true}");
+    api_send(req, root);
+    cJSON_Delete(root);
     return ESP_OK;
 }
 
-static esp_err_t api_settings_handler(httpd_req_t *req)
+static esp_err_t api_wifi_profile_post_handler(httpd_req_t *req)
 {
-    char buf[512];
+    char buf[128];
     int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
     if (ret <= 0) {
         httpd_resp_send_500(req);
@@ -710,17 +3052,49 @@ static esp_err_t api_settings_handler(httpd_req_t *req)
     }
     buf[ret] = '\0';
 
-    cJSON *json = cJSON_Parse(buf);
+    cJSON *json = api_parse_body(req, buf, ret);
     if (json == NULL) {
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"error\":\"Invalid JSON\"}");
+        api_send_str(req, "{\"error\":\"Invalid JSON\"}");
+        return ESP_FAIL;
+    }
+
+    cJSON *profile = cJSON_GetObjectItem(json, "profile");
+    wifi_profile_t value;
+    if (!cJSON_IsString(profile) || !wifi_profile_from_string(profile->valuestring, &value)) {
+        api_send_str(req, "{\"error\":\"Invalid profile (latency, balanced or low-power)\"}");
+        cJSON_Delete(json);
         return ESP_FAIL;
     }
 
+    if (cJSON_IsTrue(cJSON_GetObjectItem(json, "resetLatency"))) {
+        wifi_profile_reset_latency();
+    }
     cJSON_Delete(json);
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, "{\"success\":true}");
+    if (wifi_profile_set(value) != ESP_OK) {
+        api_send_str(req, "{\"error\":\"Failed to persist profile\"}");
+        return ESP_FAIL;
+    }
+
+    api_send_str(req, "{\"success\":true}");
+    return ESP_OK;
+}
+
+// Latency probe: as cheap as a request gets. Clients pass the round trip they
+// measured for their previous ping as ?rtt=<ms>, it is filed under the active profile.
+static esp_err_t api_ping_handler(httpd_req_t *req)
+{
+    char query[32];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[12];
+        if (httpd_query_key_value(query, "rtt", value, sizeof(value)) == ESP_OK) {
+            wifi_profile_record_rtt(strtoul(value, NULL, 10));
+        }
+    }
+
+    char resp[64];
+    snprintf(resp, sizeof(resp), "{\"pong\":true,\"profile\":\"%s\"}", wifi_profile_to_string(wifi_profile_get()));
+    api_send_str(req, resp);
     return ESP_OK;
 }
 
@@ -937,114 +3311,75 @@ static esp_err_t static_file_handler(httpd_req_t *req)
 }
 
 
-// Starts the HTTP server and registers the API handlers
+// Handler of every route, indexed like routes.def
+static esp_err_t (*const api_route_handlers[])(httpd_req_t *req) = {
+#define ROUTE(method, path, handler) handler,
+#include "routes.def"
+#undef ROUTE
+};
+
+_Static_assert(sizeof(api_route_handlers) / sizeof(api_route_handlers[0]) == API_ROUTE_COUNT,
+               "routes_trie.h is out of date with routes.def");
+
+// The one handler esp_http_server calls: routes the request through the trie and
+// hands GETs that match no route to the static files
+static esp_err_t api_dispatch_handler(httpd_req_t *req)
+{
+    router_match_t match;
+    switch (router_lookup(&api_route_trie, req->method, req->uri, &match)) {
+        case ROUTER_FOUND:
+            return api_route_handlers[match.route](req);
+        case ROUTER_METHOD_NOT_ALLOWED:
+            httpd_resp_send_err(req, HTTPD_405_METHOD_NOT_ALLOWED, NULL);
+            return ESP_FAIL;
+        default:
+            if (req->method == HTTP_GET) {
+                return static_file_handler(req);
+            }
+            httpd_resp_send_404(req);
+            return ESP_FAIL;
+    }
+}
+
+// Starts the HTTP server and registers the dispatcher
 static httpd_handle_t start_webserver(void)
 {
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 32;
+    config.max_uri_handlers = ROUTER_METHOD_COUNT;
     config.uri_match_fn = httpd_uri_match_wildcard;
+    // Parked long-polls and queued async requests each hold a socket. When all are
+    // taken the least recently used one is closed instead of refusing new clients.
+    config.max_open_sockets = HTTP_MAX_OPEN_SOCKETS;
+    config.lru_purge_enable = true;
+    config.recv_wait_timeout = 5;
+    config.send_wait_timeout = 5;
+
+    // Slow handlers hand their requests to these workers
+    if (http_async_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Async workers unavailable, all handlers run on the server task");
+    }
 
     ESP_LOGI(TAG, "Starting HTTP server");
     if (httpd_start(&server, &config) == ESP_OK) {
-        // Register API handlers FIRST (before wildcard static handler)
-        httpd_uri_t api_info_uri = {
-            .uri       = "/api/info",
-            .method    = HTTP_GET,
-            .handler   = api_info_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_info_uri);
-
-        httpd_uri_t api_signals_get_uri = {
-            .uri       = "/api/signals",
-            .method    = HTTP_GET,
-            .handler   = api_signals_get_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_signals_get_uri);
-
-        httpd_uri_t api_signal_history_uri = {
-            .uri       = "/api/signal-history",
-            .method    = HTTP_GET,
-            .handler   = api_signal_history_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_signal_history_uri);
-
-        httpd_uri_t api_signals_post_uri = {
-            .uri       = "/api/signals",
-            .method    = HTTP_POST,
-            .handler   = api_signals_post_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_signals_post_uri);
-
-        httpd_uri_t api_signals_put_uri = {
-            .uri       = "/api/signals/*",
-            .method    = HTTP_PUT,
-            .handler   = api_signals_put_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_signals_put_uri);
-
-        httpd_uri_t api_signals_delete_uri = {
-            .uri       = "/api/signals/*",
-            .method    = HTTP_DELETE,
-            .handler   = api_signals_delete_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_signals_delete_uri);
-
-        httpd_uri_t api_transmit_index_uri = {
-            .uri       = "/api/transmit/*",
-            .method    = HTTP_POST,
-            .handler   = api_transmit_index_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_transmit_index_uri);
-
-        httpd_uri_t api_transmit_name_uri = {
-            .uri       = "/api/transmit/name/*",
-            .method    = HTTP_POST,
-            .handler   = api_transmit_name_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_transmit_name_uri);
-
-        httpd_uri_t api_transmit_direct_uri = {
-            .uri       = "/api/transmit",
-            .method    = HTTP_POST,
-            .handler   = api_transmit_direct_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_transmit_direct_uri);
-
-        httpd_uri_t api_clear_tracking_uri = {
-            .uri       = "/api/clear-tracking",
-            .method    = HTTP_POST,
-            .handler   = api_clear_tracking_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_clear_tracking_uri);
-
-        httpd_uri_t api_settings_uri = {
-            .uri       = "/api/settings",
-            .method    = HTTP_POST,
-            .handler   = api_settings_handler,
-            .user_ctx  = NULL
-        };
-        httpd_register_uri_handler(server, &api_settings_uri);
-
-        // Well i took too long to debug this, it just so happened to be because i didnt register the static file handler last, so now its here...
-        // -1 hour debugging session saved for future reference...
-        httpd_uri_t static_file_uri = {
-            .uri       = "/*",
-            .method    = HTTP_GET,
-            .handler   = static_file_handler,
-            .user_ctx  = NULL
+        // One catch-all per method, the routes themselves live in routes.def. The
+        // server walking its handler list in registration order used to let
+        // /api/transmit/* shadow /api/transmit/name/*.
+        static const httpd_method_t methods[ROUTER_METHOD_COUNT] = {
+            [ROUTER_GET]    = HTTP_GET,
+            [ROUTER_POST]   = HTTP_POST,
+            [ROUTER_PUT]    = HTTP_PUT,
+            [ROUTER_DELETE] = HTTP_DELETE,
         };
-        httpd_register_uri_handler(server, &static_file_uri);
+        for (int i = 0; i < ROUTER_METHOD_COUNT; i++) {
+            httpd_uri_t dispatch_uri = {
+                .uri       = "/*",
+                .method    = methods[i],
+                .handler   = api_dispatch_handler,
+                .user_ctx  = NULL
+            };
+            httpd_register_uri_handler(server, &dispatch_uri);
+        }
 
         return server;
     }
@@ -1053,24 +3388,92 @@ static httpd_handle_t start_webserver(void)
     return NULL;
 }
 
+// Fans one button event out to tracking, rules and the event log. fields is NULL for
+// holds and releases, which keep the fields decoded from the press.
+static void handle_burst_event(const burst_event_t *event, const family_fields_t *fields)
+{
+    const radio_frame_t *frame = &event->frame;
+    uint32_t count = 0;
+    uint32_t seq = track_signal(frame->code, frame->bit_length, frame->protocol, frame->pulse_length,
+                                fields, event->type, event->duration_ms, &count);
+    rules_evaluate(event);
+
+    if (event->type == BURST_PRESS) {
+        usage_count_received(frame->code, frame->bit_length, frame->protocol);
+        rollup_count_press(frame->code, frame->bit_length, frame->protocol,
+                           find_saved_signal(frame->code, frame->bit_length, frame->protocol, NULL));
+        event_log_append(EVENT_KIND_PRESS, frame->code, frame->bit_length, frame->protocol, frame->pulse_length);
+        ESP_LOGI(TAG, "RF: Code=%lu (0x%lX) | Bits=%d | Proto=%d | Pulse=%dµs | Count=%lu | RX=%d",
+                 frame->code, frame->code, frame->bit_length, frame->protocol, frame->pulse_length,
+                 count, frame->receiver);
+    } else {
+        event_log_append(event->type == BURST_HOLD ? EVENT_KIND_HOLD : EVENT_KIND_RELEASE,
+                         frame->code, frame->bit_length, frame->protocol, MIN(event->duration_ms, UINT16_MAX));
+        ESP_LOGI(TAG, "RF: Code=%lu (0x%lX) %s after %lums (%u frames)", frame->code, frame->code,
+                 burst_event_to_string(event->type), event->duration_ms, event->frames);
+    }
+
+    if (seq == 0) return;
+
+    latest_signal_t latest;
+    seqlock_read(&latest_lock, &latest, &latest_signal, sizeof(latest));
+    if (fields != NULL) {
+        latest.fields = *fields;
+    } else if (latest.code != frame->code) {
+        memset(&latest.fields, 0, sizeof(latest.fields));
+    }
+    latest.seq = seq;
+    latest.code = frame->code;
+    latest.bit_length = frame->bit_length;
+    latest.protocol = frame->protocol;
+    latest.pulse_length = frame->pulse_length;
+    latest.count = count;
+    latest.state = event->type;
+    latest.duration_ms = event->duration_ms;
+    seqlock_write(&latest_lock, &latest_signal, &latest, sizeof(latest));
+    // Only now, so a woken long-poll sees this press as the latest signal
+    notify_tracking_changed();
+}
+
 static void rf_monitor_task(void *arg)
 {
     ESP_LOGI(TAG, "RF monitor task started");
     ESP_LOGI(TAG, "Starting continuous RF monitoring with verbose logging...");
-    ESP_LOGI(TAG, "Will report ANY signal activity detected on GPIO%d", RF_RECEIVER_PIN);
+    for (int i = 0; i < radio_receiver_count(); i++) {
+        radio_rx_stats_t rx;
+        radio_get_rx_stats(i, &rx);
+        ESP_LOGI(TAG, "Will report ANY signal activity detected on GPIO%d (receiver %d)", rx.pin, i);
+    }
     ESP_LOGI(TAG, "Press any button on your 433MHz remote to test...");
     ESP_LOGI(TAG, "");
     
     uint32_t heartbeat_counter = 0;
     uint32_t last_isr_count = 0;
+    uint32_t last_valid_code = 0;
+    uint8_t last_valid_bits = 0;
+    int64_t last_valid_time = 0;
 
     while (1) {
         if (heartbeat_counter % 1000 == 0) {
-            uint32_t current_isr_count = rc_receiver_get_isr_count();
+            uint32_t current_isr_count = 0;
+            for (int i = 0; i < radio_receiver_count(); i++) {
+                radio_rx_stats_t rx;
+                radio_get_rx_stats(i, &rx);
+                current_isr_count += rx.isr_count;
+            }
             uint32_t isr_delta = current_isr_count - last_isr_count;
             
             ESP_LOGI(TAG, "[HEARTBEAT] RF Monitor active | ISR triggers: %lu total (%lu in last 10s)", 
                      current_isr_count, isr_delta);
+            for (int i = 0; i < radio_receiver_count(); i++) {
+                rc_squelch_t sq;
+                radio_get_squelch(i, &sq);
+                if (sq.enabled) {
+                    ESP_LOGI(TAG, "  RX%d squelch: %s | %lu edges/s (noise %lu) | glitch <%uus x%u | %lu decodes skipped",
+                             i, sq.noise ? "noise" : "open", sq.edge_rate, sq.noise_rate,
+                             sq.glitch_us, sq.glitch_limit, sq.skipped_decodes);
+                }
+            }
             
             if (isr_delta == 0 && heartbeat_counter > 0) {
                 ESP_LOGW(TAG, "⚠ WARNING: No ISR triggers detected! (You might be cooked?)");
@@ -1086,46 +3489,109 @@ static void rf_monitor_task(void *arg)
         }
         heartbeat_counter++;
 
-        if (rc_receiver_available(&receiver)) {
-            uint32_t code = rc_receiver_get_value(&receiver);
-            uint8_t bitlen = rc_receiver_get_bitlength(&receiver);
-            uint8_t protocol = rc_receiver_get_protocol(&receiver);
-            uint16_t pulse = rc_receiver_get_delay(&receiver);
+        if (filter_reset_requested) {
+            filter_reset_requested = false;
+            last_valid_code = 0;
+            last_valid_bits = 0;
+            last_valid_time = 0;
+        }
+
+        settings_t settings;
+        settings_get(&settings);
+        radio_frame_t frame;
+        while (radio_poll(&frame)) {
+            uint32_t code = frame.code;
+            uint8_t bitlen = frame.bit_length;
+            TRACE_BEGIN(TRACE_RF_FRAME, code);
+
+            // Only a frame that is unmistakably a family's and fails its validation stops here
+            family_fields_t fields;
+            if (family_decode(&frame, &fields) == FAMILY_REJECTED) {
+                ESP_LOGD(TAG, "Rejected corrupt frame: Code=%lu (0x%lX) | Bits=%d", code, code, bitlen);
+                TRACE_END(TRACE_RF_FRAME, code);
+                continue;
+            }
 
-            if (code != 0 && bitlen >= 12) {
+            if (code != 0 && bitlen >= settings.accept_min_bits) {
                 int64_t now = esp_timer_get_time();
                 int64_t time_since_last = now - last_valid_time;
-                bool is_noise = is_likely_noise(code, bitlen, last_valid_code, last_signal.bit_length, time_since_last);
+                bool is_noise = is_likely_noise(code, bitlen, last_valid_code, last_valid_bits, time_since_last);
                 
                 if (!is_noise) {
-                    track_signal(code, bitlen, protocol, pulse);
-                    ESP_LOGI(TAG, "RF: Code=%lu (0x%lX) | Bits=%d | Proto=%d | Pulse=%dµs | Count=%lu",
-                             code, code, bitlen, protocol, pulse, last_signal_count);
-
-                    last_signal.code = code;
-                    last_signal.bit_length = bitlen;
-                    last_signal.protocol = protocol;
-                    last_signal.pulse_length = pulse;
-                    new_signal_received = true;
+                    // Repeats of a held button only extend the burst, events come out of it
+                    burst_event_t events[2];
+                    int n = burst_feed(&frame, events);
+                    for (int i = 0; i < n; i++) {
+                        handle_burst_event(&events[i], events[i].type == BURST_PRESS ? &fields : NULL);
+                    }
                     last_valid_code = code;
+                    last_valid_bits = bitlen;
                     last_valid_time = now;
                 } else {
                     ESP_LOGD(TAG, "Filtered noise: Code=%lu (0x%lX) | Bits=%d (partial of 0x%lX)",
                              code, code, bitlen, last_valid_code);
                 }
             }
+            TRACE_END(TRACE_RF_FRAME, code);
+        }
 
-            rc_receiver_reset(&receiver);
+        burst_event_t event;
+        while (burst_poll(esp_timer_get_time(), &event)) {
+            handle_burst_event(&event, NULL);
         }
 
+        event_log_tick();
+        rollup_tick();
         vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
+// Loads everything persisted in flash while Wi-Fi is coming up
+static void storage_load_task(void *arg)
+{
+    settings_init();
+    event_log_init();
+    library_lock();
+    load_signals_from_nvs();
+    library_unlock();
+    usage_init(library_partition);
+    rules_init(transmit_saved_signal);
+    scheduler_init(transmit_saved_signal);
+
+    boot_mark(BOOT_PHASE_STORAGE_LOADED);
+    xEventGroupSetBits(boot_events, BOOT_STORAGE_LOADED_BIT);
+    start_network_services();
+
+    vTaskDelete(NULL);
+}
+
 void app_main(void)
 {
     ESP_LOGI(TAG, "=== ESP32 433MHz Controller ===");
 
+#ifdef TIMEZONE
+    // Daily scheduler jobs run in local time
+    setenv("TZ", TIMEZONE, 1);
+    tzset();
+#endif
+
+    trace_init();
+    boot_events = xEventGroupCreate();
+    tracked_signals_mutex = xSemaphoreCreateMutex();
+    library_mutex = xSemaphoreCreateMutex();
+    library_write_mutex = xSemaphoreCreateMutex();
+    if (tracked_signals_mutex == NULL || library_mutex == NULL || library_write_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+    }
+
+    // RF first, so we are not blind while the network comes up
+    ESP_LOGI(TAG, "Initializing RF modules...");
+    radio_init();
+    family_init();
+    rollup_init();
+    xTaskCreate(rf_monitor_task, "rf_monitor", 4096, NULL, 5, NULL);
+    boot_mark(BOOT_PHASE_RF_READY);
+
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
@@ -1133,37 +3599,43 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
-    tracked_signals_mutex = xSemaphoreCreateMutex();
-    if (tracked_signals_mutex == NULL) {
-        ESP_LOGE(TAG, "Failed to create mutex");
+    // Only there once the current partition table is flashed, see LIBRARY_NVS_PARTITION
+    ret = nvs_flash_init_partition(LIBRARY_NVS_PARTITION);
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGE(TAG, "Erasing the unreadable '%s' partition: %s", LIBRARY_NVS_PARTITION, esp_err_to_name(ret));
+        nvs_flash_erase_partition(LIBRARY_NVS_PARTITION);
+        ret = nvs_flash_init_partition(LIBRARY_NVS_PARTITION);
+    }
+    if (ret == ESP_OK) {
+        library_partition = LIBRARY_NVS_PARTITION;
+    } else {
+        ESP_LOGW(TAG, "No '%s' partition (%s), the signal library is kept in the default NVS",
+                 LIBRARY_NVS_PARTITION, esp_err_to_name(ret));
     }
+    boot_mark(BOOT_PHASE_NVS_READY);
 
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    xTaskCreate(storage_load_task, "storage_load", 4096, NULL, 4, NULL);
+    esp_register_shutdown_handler(event_log_flush);
+    esp_register_shutdown_handler(usage_flush);
 
-    wifi_init_sta();
-    vTaskDelay(pdMS_TO_TICKS(5000));
+    // usage_tick writes NVS from this task, which needs the same stack as the other storage tasks
+    xTaskCreate(cleanup_task, "cleanup", 4096, NULL, 3, NULL);
 
-    ESP_LOGI(TAG, "Initializing RF modules...");
-    rc_transmitter_init(&transmitter, RF_TRANSMITTER_PIN);
-    rc_transmitter_set_repeat(&transmitter, 5);
-    rc_receiver_init(&receiver, RF_RECEIVER_PIN);
-    ESP_LOGI(TAG, "RF modules initialized");
+    longpoll_queue = xQueueCreate(LONGPOLL_MAX_PARKED, sizeof(parked_poll_t));
+    xTaskCreate(longpoll_task, "longpoll", 4096, NULL, 4, &longpoll_task_handle);
 
-    load_signals_from_nvs();
-    server = start_webserver();
+    // Network last, the web server starts from the GOT_IP event
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
 
-    xTaskCreate(rf_monitor_task, "rf_monitor", 4096, NULL, 5, NULL);
-    xTaskCreate(cleanup_task, "cleanup", 2048, NULL, 3, NULL);
+    const esp_timer_create_args_t reconnect_timer_args = {
+        .callback = reconnect_timer_callback,
+        .name = "wifi_reconnect"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&reconnect_timer_args, &reconnect_timer));
 
-    ESP_LOGI(TAG, "===============================================================");
-    esp_netif_ip_info_t ip_info;
-    esp_err_t ip_ret = esp_netif_get_ip_info(esp_netif_get_handle_from_ifkey("WIFI_STA_DEF"), &ip_info);
-    ESP_LOGI(TAG, "Setup complete! RF monitor is active.");
-    if (ip_ret == ESP_OK) {
-        ESP_LOGI(TAG, "Web UI is now available! Access at http://" IPSTR, IP2STR(&ip_info.ip));
-    } else {
-        ESP_LOGI(TAG, "Web UI is now available, but failed to get device IP address.");
-    }
-    ESP_LOGI(TAG, "===============================================================");
+    wifi_init_sta();
+    boot_mark(BOOT_PHASE_WIFI_STARTED);
+
+    ESP_LOGI(TAG, "Setup complete! RF monitor is active, web UI starts once WiFi is connected.");
 }
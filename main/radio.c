@@ -0,0 +1,381 @@
+#include "radio.h"
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "rom/ets_sys.h"
+#include "rc_switch.h"
+#include "airtime.h"
+#include "config.h"
+
+static const char *TAG = "RADIO";
+
+// Older config.h files only name a single pin for each direction
+#ifndef RF_RECEIVER_PINS
+#define RF_RECEIVER_PINS { RF_RECEIVER_PIN }
+#endif
+#ifndef RF_TRANSMITTER_PINS
+#define RF_TRANSMITTER_PINS { RF_TRANSMITTER_PIN }
+#endif
+#ifndef RF_SQUELCH
+#define RF_SQUELCH 1
+#endif
+// Capture buffer of each receiver, long frames need more edges than the default: a frame
+// has up to RF_RX_BUFFER_EDGES / 2 bits, rc_receiver_get_bits returns the ones past 32
+#ifndef RF_RX_BUFFER_EDGES
+#define RF_RX_BUFFER_EDGES 256
+#endif
+#ifndef RF_RX_BUFFER_WIDTH
+#define RF_RX_BUFFER_WIDTH 2
+#endif
+#ifndef RF_RX_BUFFER_PSRAM
+#define RF_RX_BUFFER_PSRAM 0
+#endif
+
+#define VERIFY_SETTLE_MS 50 // The last frame only decodes once the air goes quiet after it
+
+static const gpio_num_t receiver_pins[] = RF_RECEIVER_PINS;
+static const gpio_num_t transmitter_pins[] = RF_TRANSMITTER_PINS;
+
+#define NUM_RECEIVERS    (int)(sizeof(receiver_pins) / sizeof(receiver_pins[0]))
+#define NUM_TRANSMITTERS (int)(sizeof(transmitter_pins) / sizeof(transmitter_pins[0]))
+
+_Static_assert(sizeof(receiver_pins) / sizeof(receiver_pins[0]) <= RADIO_MAX_RECEIVERS,
+               "Too many entries in RF_RECEIVER_PINS");
+_Static_assert(sizeof(transmitter_pins) / sizeof(transmitter_pins[0]) <= RADIO_MAX_TRANSMITTERS,
+               "Too many entries in RF_TRANSMITTER_PINS");
+
+static rc_receiver_t receivers[RADIO_MAX_RECEIVERS];
+static rc_transmitter_t transmitters[RADIO_MAX_TRANSMITTERS];
+static SemaphoreHandle_t transmitter_locks[RADIO_MAX_TRANSMITTERS];
+
+static uint32_t rx_accepted[RADIO_MAX_RECEIVERS];
+static uint32_t rx_merged[RADIO_MAX_RECEIVERS];
+
+// Frames reported recently, used to spot the same frame arriving on another receiver
+#define RECENT_FRAMES (RADIO_MAX_RECEIVERS * 2)
+typedef struct {
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    uint8_t receiver_mask;  // Receivers that already reported this frame
+    int64_t time;
+} recent_frame_t;
+static recent_frame_t recent[RECENT_FRAMES];
+static int recent_next = 0;
+static int poll_start = 0;  // Receiver polled first, rotated so none starves the others
+
+// Verified sends: while armed, radio_poll counts frames matching what the transmitter sends
+typedef struct {
+    volatile bool armed;
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    volatile uint8_t heard;
+} verify_arm_t;
+static verify_arm_t verify_arms[RADIO_MAX_TRANSMITTERS];
+
+typedef struct {
+    int transmitter;
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    uint16_t pulse_length;
+    radio_tx_options_t options;
+    int frames;                 // Frames the airtime governor granted
+    radio_tx_result_t *result;
+    TaskHandle_t caller;
+} burst_t;
+
+#if RADIO_CAN_VERIFY
+// A frame masks interrupts on the core sending it, so a verified burst has to run on the
+// core the receiver ISRs are not on, or our own frames could never be decoded
+static QueueHandle_t verify_queue = NULL;
+static void verify_task(void *arg);
+#endif
+
+void radio_init(void)
+{
+    for (int i = 0; i < NUM_TRANSMITTERS; i++) {
+        rc_transmitter_init(&transmitters[i], transmitter_pins[i]);
+        rc_transmitter_set_repeat(&transmitters[i], RADIO_DEFAULT_REPEATS);
+        transmitter_locks[i] = xSemaphoreCreateMutex();
+    }
+    const rc_receiver_buffer_config_t buffer = {
+        .edges = RF_RX_BUFFER_EDGES,
+        .width = RF_RX_BUFFER_WIDTH,
+        .psram = RF_RX_BUFFER_PSRAM,
+    };
+    for (int i = 0; i < NUM_RECEIVERS; i++) {
+        esp_err_t err = rc_receiver_init_ex(&receivers[i], receiver_pins[i], &buffer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Receiver on GPIO %d not started: %s", receiver_pins[i], esp_err_to_name(err));
+        }
+        if (!RF_SQUELCH) {
+            rc_receiver_set_squelch(&receivers[i], false);
+        }
+    }
+
+    airtime_init();
+
+#if RADIO_CAN_VERIFY
+    // The GPIO ISR service was installed on this core by rc_receiver_init
+    verify_queue = xQueueCreate(NUM_TRANSMITTERS, sizeof(burst_t));
+    xTaskCreatePinnedToCore(verify_task, "radio_verify", 3072, NULL, 6, NULL, !xPortGetCoreID());
+#endif
+
+    ESP_LOGI(TAG, "%d receiver(s), %d transmitter(s)", NUM_RECEIVERS, NUM_TRANSMITTERS);
+}
+
+int radio_receiver_count(void)
+{
+    return NUM_RECEIVERS;
+}
+
+int radio_transmitter_count(void)
+{
+    return NUM_TRANSMITTERS;
+}
+
+// Returns true if the frame is new, false if another receiver already reported it
+static bool diversity_accept(int rx, const radio_frame_t *frame)
+{
+    uint8_t bit = 1 << rx;
+
+    for (int i = 0; i < RECENT_FRAMES; i++) {
+        recent_frame_t *r = &recent[i];
+        if (r->receiver_mask == 0) continue;
+        if (r->code != frame->code || r->bit_length != frame->bit_length ||
+            r->protocol != frame->protocol) continue;
+
+        int64_t delta = frame->time - r->time;
+        if (delta < 0) delta = -delta;
+        // A second report from the same receiver is the remote repeating, not diversity
+        if (delta <= RADIO_DIVERSITY_WINDOW_US && !(r->receiver_mask & bit)) {
+            r->receiver_mask |= bit;
+            return false;
+        }
+    }
+
+    recent_frame_t *slot = &recent[recent_next];
+    recent_next = (recent_next + 1) % RECENT_FRAMES;
+    slot->code = frame->code;
+    slot->bit_length = frame->bit_length;
+    slot->protocol = frame->protocol;
+    slot->receiver_mask = bit;
+    slot->time = frame->time;
+    return true;
+}
+
+bool radio_poll(radio_frame_t *frame)
+{
+    for (int n = 0; n < NUM_RECEIVERS; n++) {
+        int rx = (poll_start + n) % NUM_RECEIVERS;
+        rc_receiver_t *receiver = &receivers[rx];
+
+        while (rc_receiver_available(receiver)) {
+            frame->code = rc_receiver_get_value(receiver);
+            frame->bit_length = rc_receiver_get_bitlength(receiver);
+            frame->protocol = rc_receiver_get_protocol(receiver);
+            frame->pulse_length = rc_receiver_get_delay(receiver);
+            frame->time = receiver->received_time;
+            frame->receiver = rx;
+            const uint16_t *timings;
+            frame->timing_count = rc_receiver_get_timings(receiver, &timings);
+            memcpy(frame->timings, timings, frame->timing_count * sizeof(uint16_t));
+            rc_receiver_reset(receiver);
+
+            if (diversity_accept(rx, frame)) {
+                rx_accepted[rx]++;
+                for (int t = 0; t < NUM_TRANSMITTERS; t++) {
+                    verify_arm_t *arm = &verify_arms[t];
+                    if (arm->armed && arm->code == frame->code &&
+                        arm->bit_length == frame->bit_length && arm->protocol == frame->protocol) {
+                        arm->heard++;
+                    }
+                }
+                poll_start = (rx + 1) % NUM_RECEIVERS;
+                return true;
+            }
+            rx_merged[rx]++;
+        }
+    }
+
+    return false;
+}
+
+static void repeat_gap(uint16_t gap_ms)
+{
+    TickType_t ticks = pdMS_TO_TICKS(gap_ms);
+    if (gap_ms == 0) {
+        vTaskDelay(1);  // Default, lets the watchdog breathe
+    } else if (ticks == 0) {
+        ets_delay_us(gap_ms * 1000);
+    } else {
+        vTaskDelay(ticks);
+    }
+}
+
+static void send_burst(burst_t *burst)
+{
+    rc_transmitter_t *tx = &transmitters[burst->transmitter];
+    verify_arm_t *arm = &verify_arms[burst->transmitter];
+    const radio_tx_options_t *options = &burst->options;
+    radio_tx_result_t *result = burst->result;
+
+    xSemaphoreTake(transmitter_locks[burst->transmitter], portMAX_DELAY);
+    rc_transmitter_set_protocol(tx, burst->protocol - 1);
+    rc_transmitter_set_pulse_length(tx, burst->pulse_length);
+    tx->send_count++;
+
+    if (options->verify) {
+        arm->code = burst->code;
+        arm->bit_length = burst->bit_length;
+        arm->protocol = burst->protocol;
+        arm->heard = 0;
+        arm->armed = true;
+    }
+
+    // Frame n is decoded when frame n+1 starts, so heard is checked after each gap
+    for (int i = 0; i < burst->frames; i++) {
+        if (i > 0) {
+            repeat_gap(options->gap_ms);
+            if (options->verify && arm->heard >= options->verify) break;
+        }
+        rc_transmitter_send_frame(tx, burst->code, burst->bit_length);
+        result->frames++;
+    }
+
+    if (options->verify) {
+        if (arm->heard < options->verify) {
+            vTaskDelay(pdMS_TO_TICKS(VERIFY_SETTLE_MS));
+        }
+        arm->armed = false;
+        result->heard = arm->heard;
+        result->verified = arm->heard >= options->verify;
+    }
+    xSemaphoreGive(transmitter_locks[burst->transmitter]);
+
+    ESP_LOGI(TAG, "TX%d: code=%lu, bits=%d, protocol=%d, %d/%d frames%s%s", burst->transmitter,
+             burst->code, burst->bit_length, burst->protocol, result->frames, burst->frames,
+             options->verify ? ", verify " : "",
+             options->verify ? (result->verified ? "ok" : "failed") : "");
+}
+
+#if RADIO_CAN_VERIFY
+static void verify_task(void *arg)
+{
+    burst_t burst;
+    while (1) {
+        if (xQueueReceive(verify_queue, &burst, portMAX_DELAY) == pdTRUE) {
+            send_burst(&burst);
+            xTaskNotifyGive(burst.caller);
+        }
+    }
+}
+#endif
+
+esp_err_t radio_transmit_ex(int transmitter, uint32_t code, uint8_t bit_length,
+                            uint8_t protocol, uint16_t pulse_length,
+                            const radio_tx_options_t *options, radio_tx_result_t *result)
+{
+    if (transmitter < 0 || transmitter >= NUM_TRANSMITTERS ||
+        protocol < 1 || protocol > RC_SWITCH_NUM_PROTOCOLS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    radio_tx_result_t unused;
+    if (result == NULL) result = &unused;
+    memset(result, 0, sizeof(*result));
+
+    burst_t burst = {
+        .transmitter = transmitter,
+        .code = code,
+        .bit_length = bit_length,
+        .protocol = protocol,
+        .pulse_length = pulse_length,
+        .result = result,
+    };
+    if (options != NULL) {
+        burst.options = *options;
+    }
+    radio_tx_options_t *opts = &burst.options;
+    if (opts->repeats == 0) opts->repeats = RADIO_DEFAULT_REPEATS;
+    if (opts->repeats > RADIO_MAX_REPEATS) opts->repeats = RADIO_MAX_REPEATS;
+    if (!RADIO_CAN_VERIFY) opts->verify = 0;
+    if (opts->verify && opts->max_repeats == 0) opts->max_repeats = MIN(opts->repeats * 2, RADIO_MAX_REPEATS);
+    if (opts->max_repeats < opts->repeats) opts->max_repeats = opts->repeats;
+    if (opts->max_repeats > RADIO_MAX_REPEATS) opts->max_repeats = RADIO_MAX_REPEATS;
+    int wanted = opts->verify ? opts->max_repeats : opts->repeats;
+
+    // Airtime is reserved before queueing for the transmitter, a deferred request holds no lock
+    uint32_t frame_us = rc_frame_airtime_us(protocol - 1, pulse_length, code, bit_length);
+    burst.frames = airtime_acquire(code, bit_length, protocol, frame_us, wanted);
+    if (burst.frames == 0) {
+        return ESP_ERR_NOT_ALLOWED;
+    }
+
+#if RADIO_CAN_VERIFY
+    if (opts->verify) {
+        burst.caller = xTaskGetCurrentTaskHandle();
+        xQueueSend(verify_queue, &burst, portMAX_DELAY);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    } else {
+        send_burst(&burst);
+    }
+#else
+    send_burst(&burst);
+#endif
+
+    // Verified sends usually stop early, hand back what was reserved but not used
+    if (result->frames < burst.frames) {
+        airtime_refund(code, bit_length, protocol, frame_us, burst.frames - result->frames);
+    }
+    return ESP_OK;
+}
+
+esp_err_t radio_transmit(int transmitter, uint32_t code, uint8_t bit_length,
+                         uint8_t protocol, uint16_t pulse_length)
+{
+    return radio_transmit_ex(transmitter, code, bit_length, protocol, pulse_length, NULL, NULL);
+}
+
+bool radio_get_rx_stats(int receiver, radio_rx_stats_t *stats)
+{
+    if (receiver < 0 || receiver >= NUM_RECEIVERS) return false;
+
+    rc_receiver_t *rx = &receivers[receiver];
+    stats->pin = rx->pin;
+    stats->isr_count = rc_receiver_get_isr_count(rx);
+    stats->decoded = rx->decoded_count;
+    stats->accepted = rx_accepted[receiver];
+    stats->merged = rx_merged[receiver];
+    stats->buffer_edges = rx->edge_capacity;
+    stats->buffer_width = rx->edge_width;
+    stats->buffer_psram = rx->edge_buffer_psram;
+    stats->overflows = rx->overflow_count;
+    return true;
+}
+
+bool radio_get_squelch(int receiver, rc_squelch_t *squelch)
+{
+    if (receiver < 0 || receiver >= NUM_RECEIVERS) return false;
+
+    rc_receiver_get_squelch(&receivers[receiver], squelch);
+    return true;
+}
+
+bool radio_get_tx_stats(int transmitter, radio_tx_stats_t *stats)
+{
+    if (transmitter < 0 || transmitter >= NUM_TRANSMITTERS) return false;
+
+    rc_transmitter_t *tx = &transmitters[transmitter];
+    stats->pin = tx->pin;
+    stats->sends = tx->send_count;
+    stats->frames = tx->frame_count;
+    stats->airtime_us = tx->airtime_us;
+    return true;
+}
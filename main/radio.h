@@ -0,0 +1,107 @@
+#ifndef RADIO_H
+#define RADIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+#include "rc_switch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RADIO_MAX_RECEIVERS    4
+#define RADIO_MAX_TRANSMITTERS 4
+
+#define RADIO_DEFAULT_REPEATS  5
+#define RADIO_MAX_REPEATS      20
+
+// Verified sends need a second core: frames mask interrupts on the core sending them
+#define RADIO_CAN_VERIFY (portNUM_PROCESSORS > 1)
+
+// Two receivers decoding the same over-the-air frame report it within a few ms of each
+// other, while a remote's own repeats are at least one frame length (~20 ms+) apart.
+#define RADIO_DIVERSITY_WINDOW_US 8000
+
+// A frame after diversity merging. receiver is the one that reported it first,
+// later copies from other receivers are folded in and only counted in the stats.
+typedef struct {
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    uint16_t pulse_length;
+    uint8_t receiver;
+    int64_t time;           // esp_timer time of the first decode
+    uint8_t timing_count;
+    uint16_t timings[RC_FRAME_TIMINGS]; // Raw durations in us, [0] is the sync gap before the frame
+} radio_frame_t;
+
+typedef struct {
+    gpio_num_t pin;
+    uint32_t isr_count;     // Edges seen on the pin
+    uint32_t decoded;       // Frames the decoder produced
+    uint32_t accepted;      // Frames this receiver reported first
+    uint32_t merged;        // Frames already reported by another receiver
+    uint16_t buffer_edges;  // Capture buffer size, 0 when the receiver failed to start
+    uint8_t buffer_width;   // Bytes per captured duration
+    bool buffer_psram;      // The capture buffer is in external RAM
+    uint32_t overflows;     // Captures longer than the buffer, their tail was dropped
+} radio_rx_stats_t;
+
+typedef struct {
+    gpio_num_t pin;
+    uint32_t sends;         // Transmit requests
+    uint32_t frames;        // Frames on air, repeats included
+    uint64_t airtime_us;    // Time spent on air
+} radio_tx_stats_t;
+
+// Per-send settings, zeroed fields mean the default
+typedef struct {
+    uint8_t repeats;        // Frames to send, default RADIO_DEFAULT_REPEATS
+    uint8_t verify;         // Stop once the local receivers decoded the frame this often, 0 = off
+    uint8_t max_repeats;    // With verify: keep repeating up to this many while not heard, default 2x repeats
+    uint16_t gap_ms;        // Pause between frames, default one RTOS tick
+} radio_tx_options_t;
+
+typedef struct {
+    uint8_t frames;         // Frames actually sent
+    uint8_t heard;          // Times a local receiver decoded the frame during the send
+    bool verified;          // heard reached options.verify
+} radio_tx_result_t;
+
+// Sets up every receiver and transmitter listed in config.h
+void radio_init(void);
+
+int radio_receiver_count(void);
+int radio_transmitter_count(void);
+
+// Returns the next frame from any receiver with duplicates across receivers merged.
+// Call in a loop until it returns false.
+bool radio_poll(radio_frame_t *frame);
+
+// Sends a code on the given transmitter. Transmitters are locked individually, so
+// requests for different transmitters run in parallel and requests for the same one queue.
+// All transmitters share one airtime budget (see airtime.h): returns ESP_ERR_NOT_ALLOWED
+// when the governor drops the request, ESP_ERR_INVALID_ARG for an unknown transmitter.
+esp_err_t radio_transmit(int transmitter, uint32_t code, uint8_t bit_length,
+                         uint8_t protocol, uint16_t pulse_length);
+
+// radio_transmit with per-send options (NULL for defaults) and the outcome in result
+// (may be NULL). Verified sends run on a task pinned to the core without the receiver
+// ISRs and usually end one frame after the count is reached, as a frame is only decoded
+// once the next one starts. Without a second core verify is ignored.
+esp_err_t radio_transmit_ex(int transmitter, uint32_t code, uint8_t bit_length,
+                            uint8_t protocol, uint16_t pulse_length,
+                            const radio_tx_options_t *options, radio_tx_result_t *result);
+
+bool radio_get_rx_stats(int receiver, radio_rx_stats_t *stats);
+bool radio_get_squelch(int receiver, rc_squelch_t *squelch);
+bool radio_get_tx_stats(int transmitter, radio_tx_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RADIO_H
@@ -0,0 +1,247 @@
+#include "rollup.h"
+#include <string.h>
+#include <strings.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "radio.h"
+
+#define SAMPLE_US   1000000     // Receiver rates are sampled once a second
+
+// Every series is one flat array holding the rings of all three resolutions
+#define ROLLUP_SLOTS (ROLLUP_MINUTES + ROLLUP_HOURS + ROLLUP_DAYS)
+
+_Static_assert(ROLLUP_BUCKETS_MAX >= ROLLUP_HOURS && ROLLUP_BUCKETS_MAX >= ROLLUP_DAYS,
+               "ROLLUP_BUCKETS_MAX must fit the longest ring");
+
+static const uint32_t bucket_s[ROLLUP_RESOLUTION_COUNT] = { 60, 3600, 86400 };
+static const uint16_t ring_length[ROLLUP_RESOLUTION_COUNT] = { ROLLUP_MINUTES, ROLLUP_HOURS, ROLLUP_DAYS };
+static const uint16_t ring_offset[ROLLUP_RESOLUTION_COUNT] = { 0, ROLLUP_MINUTES, ROLLUP_MINUTES + ROLLUP_HOURS };
+
+typedef struct {
+    uint32_t edges;         // ISR edges over the samples
+    uint32_t noise_sum;     // Sum of the sampled squelch noise rates
+    uint32_t samples;
+} rate_bucket_t;
+
+static SemaphoreHandle_t rollup_mutex = NULL;
+static int64_t current_bucket[ROLLUP_RESOLUTION_COUNT];    // Uptime seconds / bucket_s
+
+static uint32_t total_presses[ROLLUP_SLOTS];
+static rollup_signal_t signals[ROLLUP_SIGNALS_MAX];
+static int64_t signal_last_heard[ROLLUP_SIGNALS_MAX];      // 0 = free entry
+static uint16_t signal_presses[ROLLUP_SIGNALS_MAX][ROLLUP_SLOTS];
+static rate_bucket_t rates[RADIO_MAX_RECEIVERS][ROLLUP_SLOTS];
+
+static int64_t last_sample = 0;
+static uint32_t last_isr_count[RADIO_MAX_RECEIVERS];
+
+static inline int slot_of(rollup_resolution_t resolution, int64_t bucket)
+{
+    // Buckets before boot are negative while uptime is shorter than a ring
+    int length = ring_length[resolution];
+    return ring_offset[resolution] + (int)((bucket % length + length) % length);
+}
+
+// Clears the buckets the rings moved past, called with rollup_mutex held
+static void advance(int64_t now)
+{
+    int64_t now_s = now / 1000000;
+    for (int r = 0; r < ROLLUP_RESOLUTION_COUNT; r++) {
+        int64_t bucket = now_s / bucket_s[r];
+        int64_t steps = bucket - current_bucket[r];
+        if (steps > ring_length[r]) steps = ring_length[r];
+
+        for (int64_t i = 1; i <= steps; i++) {
+            int slot = slot_of(r, current_bucket[r] + i);
+            total_presses[slot] = 0;
+            for (int s = 0; s < ROLLUP_SIGNALS_MAX; s++) {
+                signal_presses[s][slot] = 0;
+            }
+            for (int rx = 0; rx < RADIO_MAX_RECEIVERS; rx++) {
+                memset(&rates[rx][slot], 0, sizeof(rate_bucket_t));
+            }
+        }
+        current_bucket[r] = bucket;
+    }
+}
+
+static int signal_entry(uint32_t code, uint8_t bit_length, uint8_t protocol, int64_t now)
+{
+    int victim = 0;
+    for (int i = 0; i < ROLLUP_SIGNALS_MAX; i++) {
+        rollup_signal_t *s = &signals[i];
+        if (signal_last_heard[i] != 0 && s->code == code &&
+            s->bit_length == bit_length && s->protocol == protocol) {
+            signal_last_heard[i] = now;
+            return i;
+        }
+        if (signal_last_heard[i] < signal_last_heard[victim]) {
+            victim = i;
+        }
+    }
+
+    rollup_signal_t *s = &signals[victim];
+    memset(s, 0, sizeof(*s));
+    s->code = code;
+    s->bit_length = bit_length;
+    s->protocol = protocol;
+    for (int slot = 0; slot < ROLLUP_SLOTS; slot++) {
+        signal_presses[victim][slot] = 0;
+    }
+    signal_last_heard[victim] = now;
+    return victim;
+}
+
+// Copies a ring out oldest first, called with rollup_mutex held
+#define COPY_RING(out, series, resolution)                                          \
+    do {                                                                            \
+        int64_t first = current_bucket[resolution] - ring_length[resolution] + 1;   \
+        for (int i = 0; i < ring_length[resolution]; i++) {                         \
+            (out)[i] = (series)[slot_of(resolution, first + i)];                    \
+        }                                                                           \
+    } while (0)
+
+void rollup_init(void)
+{
+    rollup_mutex = xSemaphoreCreateMutex();
+
+    int64_t now_s = esp_timer_get_time() / 1000000;
+    for (int r = 0; r < ROLLUP_RESOLUTION_COUNT; r++) {
+        current_bucket[r] = now_s / bucket_s[r];
+    }
+}
+
+void rollup_count_press(uint32_t code, uint8_t bit_length, uint8_t protocol, bool known)
+{
+    if (rollup_mutex == NULL) return;
+
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(rollup_mutex, portMAX_DELAY);
+    advance(now);
+
+    int entry = known ? signal_entry(code, bit_length, protocol, now) : -1;
+    if (entry >= 0) signals[entry].presses++;
+    for (int r = 0; r < ROLLUP_RESOLUTION_COUNT; r++) {
+        int slot = slot_of(r, current_bucket[r]);
+        total_presses[slot]++;
+        if (entry >= 0 && signal_presses[entry][slot] < UINT16_MAX) {
+            signal_presses[entry][slot]++;
+        }
+    }
+    xSemaphoreGive(rollup_mutex);
+}
+
+void rollup_tick(void)
+{
+    if (rollup_mutex == NULL) return;
+
+    int64_t now = esp_timer_get_time();
+    if (now - last_sample < SAMPLE_US) return;
+    bool first = last_sample == 0;
+    last_sample = now;
+
+    // Read outside the lock, the receivers have their own
+    uint32_t edges[RADIO_MAX_RECEIVERS] = {0};
+    uint32_t noise[RADIO_MAX_RECEIVERS] = {0};
+    int receivers = radio_receiver_count();
+    for (int rx = 0; rx < receivers; rx++) {
+        radio_rx_stats_t stats;
+        rc_squelch_t sq;
+        if (!radio_get_rx_stats(rx, &stats)) continue;
+        edges[rx] = stats.isr_count - last_isr_count[rx];
+        last_isr_count[rx] = stats.isr_count;
+        if (radio_get_squelch(rx, &sq) && sq.enabled) {
+            noise[rx] = sq.noise_rate;
+        }
+    }
+    if (first) return;
+
+    xSemaphoreTake(rollup_mutex, portMAX_DELAY);
+    advance(now);
+    for (int r = 0; r < ROLLUP_RESOLUTION_COUNT; r++) {
+        int slot = slot_of(r, current_bucket[r]);
+        for (int rx = 0; rx < receivers; rx++) {
+            rate_bucket_t *b = &rates[rx][slot];
+            b->edges += edges[rx];
+            b->noise_sum += noise[rx];
+            b->samples++;
+        }
+    }
+    xSemaphoreGive(rollup_mutex);
+}
+
+void rollup_get_info(rollup_resolution_t resolution, rollup_info_t *info)
+{
+    int64_t now_s = esp_timer_get_time() / 1000000;
+    info->bucket_s = bucket_s[resolution];
+    info->buckets = ring_length[resolution];
+    info->current_s = now_s % bucket_s[resolution];
+}
+
+void rollup_get_total(rollup_resolution_t resolution, uint32_t *presses)
+{
+    if (rollup_mutex == NULL) {
+        memset(presses, 0, ring_length[resolution] * sizeof(uint32_t));
+        return;
+    }
+
+    xSemaphoreTake(rollup_mutex, portMAX_DELAY);
+    advance(esp_timer_get_time());
+    COPY_RING(presses, total_presses, resolution);
+    xSemaphoreGive(rollup_mutex);
+}
+
+bool rollup_get_signal(int index, rollup_resolution_t resolution, rollup_signal_t *signal, uint16_t *presses)
+{
+    if (rollup_mutex == NULL || index < 0 || index >= ROLLUP_SIGNALS_MAX) return false;
+
+    xSemaphoreTake(rollup_mutex, portMAX_DELAY);
+    advance(esp_timer_get_time());
+    bool used = signal_last_heard[index] != 0;
+    if (used) {
+        *signal = signals[index];
+        COPY_RING(presses, signal_presses[index], resolution);
+    }
+    xSemaphoreGive(rollup_mutex);
+    return used;
+}
+
+bool rollup_get_rates(int receiver, rollup_resolution_t resolution, uint32_t *edge_rate, uint32_t *noise_rate)
+{
+    if (rollup_mutex == NULL || receiver < 0 || receiver >= radio_receiver_count()) return false;
+
+    rate_bucket_t buckets[ROLLUP_BUCKETS_MAX];
+    xSemaphoreTake(rollup_mutex, portMAX_DELAY);
+    advance(esp_timer_get_time());
+    COPY_RING(buckets, rates[receiver], resolution);
+    xSemaphoreGive(rollup_mutex);
+
+    for (int i = 0; i < ring_length[resolution]; i++) {
+        uint32_t samples = buckets[i].samples;
+        edge_rate[i] = samples ? buckets[i].edges / samples : 0;
+        noise_rate[i] = samples ? buckets[i].noise_sum / samples : 0;
+    }
+    return true;
+}
+
+const char *rollup_resolution_to_string(rollup_resolution_t resolution)
+{
+    switch (resolution) {
+        case ROLLUP_MINUTE: return "minute";
+        case ROLLUP_HOUR:   return "hour";
+        case ROLLUP_DAY:    return "day";
+        default:            return "unknown";
+    }
+}
+
+bool rollup_resolution_from_string(const char *name, rollup_resolution_t *resolution)
+{
+    for (int r = 0; r < ROLLUP_RESOLUTION_COUNT; r++) {
+        if (strcasecmp(name, rollup_resolution_to_string(r)) == 0) {
+            *resolution = r;
+            return true;
+        }
+    }
+    return false;
+}
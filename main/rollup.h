@@ -0,0 +1,71 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Activity rollups for charts: button presses and receiver edge/noise rates counted
+// into fixed ring buffers at three resolutions, kept up to date by the RF monitor.
+// Buckets follow uptime, the newest one is still filling.
+
+#define ROLLUP_MINUTES      60      // One-minute buckets, the last hour
+#define ROLLUP_HOURS        48      // One-hour buckets, the last two days
+#define ROLLUP_DAYS         30      // One-day buckets, the last month
+#define ROLLUP_BUCKETS_MAX  ROLLUP_MINUTES
+#define ROLLUP_SIGNALS_MAX  32      // Saved signals with their own series, least recently heard is replaced
+
+typedef enum {
+    ROLLUP_MINUTE = 0,
+    ROLLUP_HOUR,
+    ROLLUP_DAY,
+    ROLLUP_RESOLUTION_COUNT
+} rollup_resolution_t;
+
+typedef struct {
+    uint32_t bucket_s;      // Length of one bucket
+    uint16_t buckets;       // Buckets in every series of this resolution
+    uint32_t current_s;     // Seconds the newest bucket has been filling
+} rollup_info_t;
+
+typedef struct {
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    uint32_t presses;       // Since the signal got its series
+} rollup_signal_t;
+
+void rollup_init(void);
+
+// Counts a button press. Every press goes into the total, known (saved) signals also
+// into their own series.
+void rollup_count_press(uint32_t code, uint8_t bit_length, uint8_t protocol, bool known);
+
+// Rolls the buckets over and samples the receivers' edge and noise rates once a second.
+// Cheap to call often, the RF monitor loop calls it every iteration.
+void rollup_tick(void);
+
+void rollup_get_info(rollup_resolution_t resolution, rollup_info_t *info);
+
+// The series getters copy rollup_info_t.buckets values, oldest bucket first.
+
+// Presses of all signals, known or not
+void rollup_get_total(rollup_resolution_t resolution, uint32_t *presses);
+
+// Copies series entry index. Returns false for unused entries, iterate 0..ROLLUP_SIGNALS_MAX-1.
+bool rollup_get_signal(int index, rollup_resolution_t resolution, rollup_signal_t *signal, uint16_t *presses);
+
+// Average edges per second and squelch noise rate per bucket. False for a receiver that does not exist.
+bool rollup_get_rates(int receiver, rollup_resolution_t resolution, uint32_t *edge_rate, uint32_t *noise_rate);
+
+const char *rollup_resolution_to_string(rollup_resolution_t resolution);
+bool rollup_resolution_from_string(const char *name, rollup_resolution_t *resolution);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROLLUP_H
@@ -0,0 +1,106 @@
+#include "router.h"
+#include <string.h>
+#include "esp_http_server.h"
+
+static int method_index(int method)
+{
+    switch (method) {
+        case HTTP_GET:    return ROUTER_GET;
+        case HTTP_POST:   return ROUTER_POST;
+        case HTTP_PUT:    return ROUTER_PUT;
+        case HTTP_DELETE: return ROUTER_DELETE;
+        default:          return -1;
+    }
+}
+
+// Binary search over the literal children, they are sorted by gen_routes.py
+static uint8_t find_literal(const router_trie_t *trie, const router_node_t *node, const char *segment, size_t length)
+{
+    int low = 0;
+    int high = node->literal_count - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        const router_node_t *child = &trie->nodes[node->first_child + mid];
+        int cmp = memcmp(segment, child->segment, length < child->length ? length : child->length);
+        if (cmp == 0) cmp = (int)length - (int)child->length;
+        if (cmp == 0) return node->first_child + mid;
+        if (cmp < 0) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return ROUTER_NONE;
+}
+
+router_result_t router_lookup(const router_trie_t *trie, int method, const char *uri, router_match_t *match)
+{
+    match->param_count = 0;
+    if (uri[0] != '/') return ROUTER_NOT_FOUND;
+
+    const router_node_t *node = &trie->nodes[0];
+    const char *p = uri + 1;
+    while (*p != '\0' && *p != '?') {
+        const char *segment = p;
+        while (*p != '\0' && *p != '?' && *p != '/') p++;
+        size_t length = p - segment;
+        // Empty segments ("/api//x", a trailing slash) never match
+        if (length == 0) return ROUTER_NOT_FOUND;
+
+        uint8_t next = find_literal(trie, node, segment, length);
+        if (next == ROUTER_NONE) {
+            if (node->param_child == ROUTER_NONE || match->param_count == ROUTER_MAX_PARAMS) {
+                return ROUTER_NOT_FOUND;
+            }
+            next = node->param_child;
+            match->params[match->param_count].offset = segment - uri;
+            match->params[match->param_count].length = length;
+            match->param_count++;
+        }
+        node = &trie->nodes[next];
+
+        if (*p == '/') {
+            p++;
+            if (*p == '\0' || *p == '?') return ROUTER_NOT_FOUND;
+        }
+    }
+
+    int m = method_index(method);
+    if (m >= 0 && node->route[m] != ROUTER_NONE) {
+        match->route = node->route[m];
+        return ROUTER_FOUND;
+    }
+    for (int i = 0; i < ROUTER_METHOD_COUNT; i++) {
+        if (node->route[i] != ROUTER_NONE) return ROUTER_METHOD_NOT_ALLOWED;
+    }
+    return ROUTER_NOT_FOUND;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int router_decode(const char *src, size_t length, char *out, size_t size)
+{
+    size_t j = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = src[i];
+        if (c == '%') {
+            int high = i + 2 < length ? hex_value(src[i + 1]) : -1;
+            int low = high >= 0 ? hex_value(src[i + 2]) : -1;
+            if (low < 0 || (high == 0 && low == 0)) return -1;
+            c = (char)(high << 4 | low);
+            i += 2;
+        }
+        // '+' is only a space in query strings, in a path it is itself
+        if (j + 1 >= size) return -1;
+        out[j++] = c;
+    }
+    if (size == 0) return -1;
+    out[j] = '\0';
+    return (int)j;
+}
@@ -0,0 +1,73 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Request routing for the HTTP API. The routes are listed in routes.def and
+// gen_routes.py turns them into a trie of path segments at build time
+// (routes_trie.h), so a lookup walks the path once instead of trying every
+// pattern in registration order. Literal segments win over parameters, and
+// a parameter ({name} in routes.def) matches exactly one non-empty segment.
+
+#define ROUTER_NONE         0xFF    // No node, no route
+#define ROUTER_MAX_PARAMS   2       // Path parameters in one route
+
+typedef enum {
+    ROUTER_GET = 0,
+    ROUTER_POST,
+    ROUTER_PUT,
+    ROUTER_DELETE,
+    ROUTER_METHOD_COUNT
+} router_method_t;
+
+// One path segment. Children are stored next to each other, the literal ones
+// first and sorted so they can be binary searched, the parameter child after them.
+typedef struct {
+    const char *segment;            // Literal text, NULL for a parameter
+    uint8_t length;
+    uint8_t first_child;
+    uint8_t literal_count;
+    uint8_t param_child;            // ROUTER_NONE when there is none
+    uint8_t route[ROUTER_METHOD_COUNT]; // Route index ending here per method, or ROUTER_NONE
+} router_node_t;
+
+typedef struct {
+    const router_node_t *nodes;     // nodes[0] is the root, "/"
+    uint16_t node_count;
+} router_trie_t;
+
+typedef enum {
+    ROUTER_FOUND = 0,
+    ROUTER_NOT_FOUND,
+    ROUTER_METHOD_NOT_ALLOWED,      // The path has routes, none for this method
+} router_result_t;
+
+typedef struct {
+    uint8_t route;                  // Index in routes.def
+    uint8_t param_count;
+    struct {
+        uint16_t offset;            // Into the path, still percent-encoded
+        uint16_t length;
+    } params[ROUTER_MAX_PARAMS];
+} router_match_t;
+
+// Looks up the route of an esp_http_server method (HTTP_GET, ...) and a request
+// URI. The query string is ignored.
+router_result_t router_lookup(const router_trie_t *trie, int method, const char *uri, router_match_t *match);
+
+// Percent-decodes length bytes of src into out and terminates it. Returns the
+// decoded length, or -1 for a malformed escape, an escaped NUL or when the result
+// does not fit in size bytes.
+int router_decode(const char *src, size_t length, char *out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROUTER_H
@@ -0,0 +1,358 @@
+#include "rules.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "event_log.h"
+
+static const char *TAG = "RULES";
+
+#define RULES_HASH_SIZE     512     // Power of two, at least twice RULES_MAX
+#define RULES_MAX_CLASSES   8       // Distinct (mask, bit length) pairs, one probe each
+#define RULES_QUEUE_LEN     16
+#define RULES_ECHO_HOLDOFF_US 200000 // Ignore our own transmissions for this long after sending
+
+_Static_assert((RULES_HASH_SIZE & (RULES_HASH_SIZE - 1)) == 0, "RULES_HASH_SIZE must be a power of two");
+
+#define RULES_NVS_KEY    "rules_v2"
+
+typedef struct {
+    uint32_t mask;
+    uint8_t bit_length;
+} match_class_t;
+
+typedef struct {
+    uint16_t id;
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+} fired_rule_t;
+
+static SemaphoreHandle_t rules_mutex = NULL;
+// Held by rules_add and rules_delete across the change and the NVS write, so the rules
+// are saved as they changed while evaluation only waits for the change itself
+static SemaphoreHandle_t rules_write_mutex = NULL;
+static QueueHandle_t fire_queue = NULL;
+static rules_transmit_fn transmit_fn = NULL;
+
+// Rule set, actions are stored back to back in rule order
+static rule_t rules[RULES_MAX];
+static int rule_count = 0;
+static rule_action_t actions[RULES_MAX_ACTIONS];
+static int action_count = 0;
+static uint16_t next_id = 1;
+static rule_stats_t stats[RULES_MAX];
+static int64_t last_match[RULES_MAX];
+
+// Compiled lookup, rebuilt whenever the rule set changes
+static match_class_t classes[RULES_MAX_CLASSES];
+static int class_count = 0;
+static uint16_t buckets[RULES_HASH_SIZE];   // Rule index + 1, 0 = empty
+static uint16_t chain[RULES_MAX];           // Next rule index + 1 in the same bucket
+static uint8_t rule_class[RULES_MAX];
+static uint16_t action_start[RULES_MAX];
+
+static volatile bool transmitting = false;
+static volatile int64_t echo_until = 0;
+static uint32_t dropped = 0;
+
+static inline uint32_t hash_key(uint32_t key, uint8_t bit_length, uint8_t cls)
+{
+    uint32_t h = (key ^ ((uint32_t)bit_length << 24) ^ ((uint32_t)cls << 16)) * 2654435761u;
+    return (h >> 16) & (RULES_HASH_SIZE - 1);
+}
+
+static int find_class(uint32_t mask, uint8_t bit_length)
+{
+    for (int c = 0; c < class_count; c++) {
+        if (classes[c].mask == mask && classes[c].bit_length == bit_length) return c;
+    }
+    return -1;
+}
+
+// Called with rules_mutex held
+static void compile_locked(void)
+{
+    memset(buckets, 0, sizeof(buckets));
+    class_count = 0;
+
+    uint16_t start = 0;
+    for (int r = 0; r < rule_count; r++) {
+        const rule_t *rule = &rules[r];
+        action_start[r] = start;
+        start += rule->action_count;
+
+        int c = find_class(rule->mask, rule->bit_length);
+        if (c < 0) {
+            c = class_count++;   // rules_add keeps this within RULES_MAX_CLASSES
+            classes[c].mask = rule->mask;
+            classes[c].bit_length = rule->bit_length;
+        }
+        rule_class[r] = c;
+
+        uint32_t h = hash_key(rule->code & rule->mask, rule->bit_length, c);
+        chain[r] = buckets[h];
+        buckets[h] = r + 1;
+    }
+}
+
+// Called with rules_write_mutex held
+static void save_rules(void)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open("storage", NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS handle");
+        return;
+    }
+
+    err = nvs_set_blob(handle, RULES_NVS_KEY, rules, rule_count * sizeof(rule_t));
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, "rule_actions", actions, action_count * sizeof(rule_action_t));
+    }
+    if (err == ESP_OK) {
+        nvs_commit(handle);
+        ESP_LOGI(TAG, "Saved %d rules to NVS", rule_count);
+    } else {
+        ESP_LOGE(TAG, "Failed to save rules: %s", esp_err_to_name(err));
+    }
+
+    nvs_close(handle);
+}
+
+static void load_rules(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open("storage", NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+
+    size_t rules_size = sizeof(rules);
+    size_t actions_size = sizeof(actions);
+    bool loaded = false;
+    if (nvs_get_blob(handle, RULES_NVS_KEY, rules, &rules_size) == ESP_OK) {
+        rule_count = rules_size / sizeof(rule_t);
+        loaded = true;
+    }
+
+    if (loaded && nvs_get_blob(handle, "rule_actions", actions, &actions_size) == ESP_OK) {
+        action_count = actions_size / sizeof(rule_action_t);
+
+        int expected = 0;
+        for (int r = 0; r < rule_count; r++) {
+            expected += rules[r].action_count;
+            if (rules[r].id >= next_id) next_id = rules[r].id + 1;
+        }
+        if (expected != action_count) {
+            ESP_LOGW(TAG, "Stored rules are inconsistent, ignoring them");
+            rule_count = 0;
+            action_count = 0;
+        }
+    } else {
+        rule_count = 0;
+    }
+
+    nvs_close(handle);
+}
+
+static void rules_task(void *arg)
+{
+    fired_rule_t fired;
+    rule_action_t todo[RULE_ACTIONS_MAX];
+
+    while (1) {
+        xQueueReceive(fire_queue, &fired, portMAX_DELAY);
+
+        // Copy the actions out so the rule set can change while we transmit
+        int count = 0;
+        xSemaphoreTake(rules_mutex, portMAX_DELAY);
+        for (int r = 0; r < rule_count; r++) {
+            if (rules[r].id == fired.id) {
+                count = rules[r].action_count;
+                memcpy(todo, &actions[action_start[r]], count * sizeof(rule_action_t));
+                break;
+            }
+        }
+        xSemaphoreGive(rules_mutex);
+
+        for (int i = 0; i < count; i++) {
+            const rule_action_t *action = &todo[i];
+            switch (action->type) {
+                case RULE_ACTION_TRANSMIT:
+                    transmitting = true;
+                    if (transmit_fn(action->signal, action->transmitter) != ESP_OK) {
+                        ESP_LOGW(TAG, "Rule %u: cannot transmit '%s' on transmitter %u",
+                                 fired.id, action->signal, action->transmitter);
+                    }
+                    echo_until = esp_timer_get_time() + RULES_ECHO_HOLDOFF_US;
+                    transmitting = false;
+                    break;
+                case RULE_ACTION_PUBLISH:
+                    // pulse_length carries the rule id for rule records
+                    event_log_append(EVENT_KIND_RULE, fired.code, fired.bit_length, fired.protocol, fired.id);
+                    break;
+            }
+        }
+    }
+}
+
+void rules_init(rules_transmit_fn transmit)
+{
+    transmit_fn = transmit;
+    fire_queue = xQueueCreate(RULES_QUEUE_LEN, sizeof(fired_rule_t));
+
+    // rules_evaluate stays a no-op until the mutex exists, so load without it
+    load_rules();
+    compile_locked();
+    rules_write_mutex = xSemaphoreCreateMutex();
+    rules_mutex = xSemaphoreCreateMutex();
+    ESP_LOGI(TAG, "Loaded %d rules (%d match classes)", rule_count, class_count);
+
+    // Above the RF monitor so actions go out right after the frame that fired them
+    xTaskCreate(rules_task, "rules", 4096, NULL, 6, NULL);
+}
+
+void rules_evaluate(const burst_event_t *event)
+{
+    const radio_frame_t *frame = &event->frame;
+
+    if (rules_mutex == NULL || rule_count == 0) return;
+    if (transmitting || frame->time < echo_until) return;
+
+    xSemaphoreTake(rules_mutex, portMAX_DELAY);
+
+    for (int c = 0; c < class_count; c++) {
+        if (classes[c].bit_length != frame->bit_length) continue;
+
+        uint32_t key = frame->code & classes[c].mask;
+        for (uint16_t e = buckets[hash_key(key, frame->bit_length, c)]; e != 0; e = chain[e - 1]) {
+            int r = e - 1;
+            const rule_t *rule = &rules[r];
+            if (rule_class[r] != c || (rule->code & rule->mask) != key) continue;
+            if (!rule->enabled || (rule->protocol != 0 && rule->protocol != frame->protocol)) continue;
+            if (rule->trigger != event->type) continue;
+
+            if (rule->trigger == RULE_TRIGGER_PRESS) {
+                // A weak signal can split one press in two, presses inside the cooldown fire once
+                bool cooling = last_match[r] != 0 &&
+                               event->press_time - last_match[r] < (int64_t)rule->cooldown_ms * 1000;
+                last_match[r] = event->press_time;
+                if (cooling) continue;
+            } else {
+                // Hold and release fire at most once per press, last_match remembers which
+                if (event->duration_ms < rule->hold_ms || last_match[r] == event->press_time) continue;
+                last_match[r] = event->press_time;
+            }
+
+            fired_rule_t fired = {
+                .id = rule->id,
+                .code = frame->code,
+                .bit_length = frame->bit_length,
+                .protocol = frame->protocol,
+            };
+            if (xQueueSend(fire_queue, &fired, 0) == pdTRUE) {
+                stats[r].fired++;
+                stats[r].last_fired = frame->time;
+            } else {
+                dropped++;
+            }
+        }
+    }
+
+    xSemaphoreGive(rules_mutex);
+}
+
+esp_err_t rules_add(rule_t *rule, const rule_action_t *rule_actions)
+{
+    if (rule->bit_length == 0 || rule->bit_length > 32 || rule->protocol > 7 ||
+        rule->trigger > RULE_TRIGGER_RELEASE ||
+        rule->action_count == 0 || rule->action_count > RULE_ACTIONS_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < rule->action_count; i++) {
+        if (rule_actions[i].type > RULE_ACTION_PUBLISH) return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(rules_write_mutex, portMAX_DELAY);
+    xSemaphoreTake(rules_mutex, portMAX_DELAY);
+
+    if (rule_count >= RULES_MAX || action_count + rule->action_count > RULES_MAX_ACTIONS) {
+        xSemaphoreGive(rules_mutex);
+        xSemaphoreGive(rules_write_mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    if (find_class(rule->mask, rule->bit_length) < 0 && class_count >= RULES_MAX_CLASSES) {
+        xSemaphoreGive(rules_mutex);
+        xSemaphoreGive(rules_write_mutex);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    rule->id = next_id++;
+    rules[rule_count] = *rule;
+    memset(&stats[rule_count], 0, sizeof(rule_stats_t));
+    last_match[rule_count] = 0;
+    memcpy(&actions[action_count], rule_actions, rule->action_count * sizeof(rule_action_t));
+    rule_count++;
+    action_count += rule->action_count;
+    compile_locked();
+
+    xSemaphoreGive(rules_mutex);
+
+    // Outside rules_mutex, the flash write does not stall evaluation
+    save_rules();
+    xSemaphoreGive(rules_write_mutex);
+    ESP_LOGI(TAG, "Added rule %u", rule->id);
+    return ESP_OK;
+}
+
+esp_err_t rules_delete(uint16_t id)
+{
+    xSemaphoreTake(rules_write_mutex, portMAX_DELAY);
+    xSemaphoreTake(rules_mutex, portMAX_DELAY);
+
+    int r = 0;
+    while (r < rule_count && rules[r].id != id) r++;
+    if (r == rule_count) {
+        xSemaphoreGive(rules_mutex);
+        xSemaphoreGive(rules_write_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    int first = action_start[r];
+    int n = rules[r].action_count;
+    memmove(&actions[first], &actions[first + n], (action_count - first - n) * sizeof(rule_action_t));
+    action_count -= n;
+
+    memmove(&rules[r], &rules[r + 1], (rule_count - r - 1) * sizeof(rule_t));
+    memmove(&stats[r], &stats[r + 1], (rule_count - r - 1) * sizeof(rule_stats_t));
+    memmove(&last_match[r], &last_match[r + 1], (rule_count - r - 1) * sizeof(int64_t));
+    rule_count--;
+    compile_locked();
+
+    xSemaphoreGive(rules_mutex);
+
+    save_rules();
+    xSemaphoreGive(rules_write_mutex);
+    ESP_LOGI(TAG, "Deleted rule %u", id);
+    return ESP_OK;
+}
+
+bool rules_get(int index, rule_t *rule, rule_action_t *rule_actions, rule_stats_t *rule_stats)
+{
+    bool found = false;
+
+    xSemaphoreTake(rules_mutex, portMAX_DELAY);
+    if (index >= 0 && index < rule_count) {
+        *rule = rules[index];
+        memcpy(rule_actions, &actions[action_start[index]], rule->action_count * sizeof(rule_action_t));
+        *rule_stats = stats[index];
+        found = true;
+    }
+    xSemaphoreGive(rules_mutex);
+
+    return found;
+}
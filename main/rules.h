@@ -0,0 +1,79 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "radio.h"
+#include "burst.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RULES_MAX          256
+#define RULES_MAX_ACTIONS  512     // Shared by all rules
+#define RULE_ACTIONS_MAX   8       // Per rule, several transmit actions make a scene
+#define RULE_SIGNAL_NAME_LEN 32
+
+typedef enum {
+    RULE_ACTION_TRANSMIT = 0,   // Transmit a saved signal by name
+    RULE_ACTION_PUBLISH,        // Append a "rule" record to the event log
+} rule_action_type_t;
+
+typedef struct {
+    uint8_t type;               // rule_action_type_t
+    uint8_t transmitter;
+    char signal[RULE_SIGNAL_NAME_LEN];
+} rule_action_t;
+
+// Which button event of a matching remote fires the rule
+typedef enum {
+    RULE_TRIGGER_PRESS = BURST_PRESS,
+    RULE_TRIGGER_HOLD = BURST_HOLD,         // Once per press, when the hold reaches hold_ms
+    RULE_TRIGGER_RELEASE = BURST_RELEASE,   // Once per press, if it lasted at least hold_ms
+} rule_trigger_t;
+
+// A rule fires for events where (code & mask) == (rule code & mask) with the same
+// bit length, and the same protocol unless protocol is 0.
+typedef struct {
+    uint16_t id;
+    bool enabled;
+    uint8_t protocol;
+    uint8_t bit_length;
+    uint8_t action_count;
+    uint16_t cooldown_ms;       // Press trigger: presses closer together than this fire once
+    uint32_t code;
+    uint32_t mask;
+    uint8_t trigger;            // rule_trigger_t
+    uint8_t reserved;
+    uint16_t hold_ms;           // Hold/release triggers: minimum press duration
+} rule_t;
+
+typedef struct {
+    uint32_t fired;
+    int64_t last_fired;         // esp_timer time, 0 = never
+} rule_stats_t;
+
+// Main provides the transmit side, rules only know saved signals by name
+typedef esp_err_t (*rules_transmit_fn)(const char *signal, int transmitter);
+
+// Loads the rules from NVS, compiles the lookup table and starts the action task
+void rules_init(rules_transmit_fn transmit);
+
+// Looks the button event up and queues the actions of every matching rule. Constant time
+// in the number of rules: one hash probe per distinct (mask, bit length) pair in use.
+void rules_evaluate(const burst_event_t *event);
+
+// Adds a rule (rule->id is assigned) and persists the rule set
+esp_err_t rules_add(rule_t *rule, const rule_action_t *actions);
+esp_err_t rules_delete(uint16_t id);
+
+// Copies rule number index with its actions, for listing. Returns false past the end.
+bool rules_get(int index, rule_t *rule, rule_action_t *actions, rule_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RULES_H
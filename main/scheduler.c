@@ -0,0 +1,453 @@
+#include "scheduler.h"
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "SCHEDULER";
+
+#define NVS_NAMESPACE       "scheduler"
+#define CLOCK_VALID_AFTER   1700000000u     // Anything earlier means SNTP has not synced yet
+#define MAX_AHEAD_S         (366u * 86400u)
+#define MAX_DRIFT_S         300             // Larger clock jumps rebuild the wheel with catch-up
+
+// Hierarchical timer wheel: 256 one-second slots, then three levels of 64 slots that
+// each cover 64 times the span of the level below (256 s, ~4.5 h, ~12 days, ~2 years).
+// A job sits in one slot of one level and moves down a level when that slot comes
+// up (cascade), so every tick touches one slot no matter how many jobs exist.
+#define WHEEL_L0_BITS   8
+#define WHEEL_LN_BITS   6
+#define WHEEL_LEVELS    4
+#define WHEEL_L0_SLOTS  (1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SLOTS  (1 << WHEEL_LN_BITS)
+#define WHEEL_HEADS     (WHEEL_L0_SLOTS + (WHEEL_LEVELS - 1) * WHEEL_LN_SLOTS)
+#define NIL             0xFFFF
+
+_Static_assert(WHEEL_L0_BITS + (WHEEL_LEVELS - 1) * WHEEL_LN_BITS >= 25, "Wheel must span MAX_AHEAD_S");
+
+static SemaphoreHandle_t sched_mutex = NULL;
+static scheduler_transmit_fn transmit_fn = NULL;
+
+static schedule_job_t jobs[SCHEDULER_MAX_JOBS];
+static bool used[SCHEDULER_MAX_JOBS];
+static uint16_t next_id = 1;
+
+static uint16_t heads[WHEEL_HEADS];
+static uint16_t link_next[SCHEDULER_MAX_JOBS];
+static uint16_t link_prev[SCHEDULER_MAX_JOBS];
+static uint16_t link_head[SCHEDULER_MAX_JOBS];  // Slot the job is linked into, NIL if none
+static uint32_t wheel_time = 0;                 // Last second that was processed
+static bool wheel_running = false;
+
+// Work collected under the lock and carried out after releasing it. A slot with
+// pending work is not handed out again until the work is done.
+typedef struct {
+    uint16_t slot;
+    bool fire;
+    bool removed;
+} pending_t;
+static pending_t pending[2 * SCHEDULER_MAX_JOBS];
+static int pending_count = 0;
+static bool pending_mark[SCHEDULER_MAX_JOBS];
+
+static inline int level_shift(int level)
+{
+    return level == 0 ? 0 : WHEEL_L0_BITS + (level - 1) * WHEEL_LN_BITS;
+}
+
+static int bucket_for(uint32_t expires)
+{
+    uint32_t delta = expires - wheel_time;
+    if (delta < WHEEL_L0_SLOTS) {
+        return expires & (WHEEL_L0_SLOTS - 1);
+    }
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        int shift = level_shift(level);
+        if (level == WHEEL_LEVELS - 1 || delta < (1u << (shift + WHEEL_LN_BITS))) {
+            return WHEEL_L0_SLOTS + (level - 1) * WHEEL_LN_SLOTS + ((expires >> shift) & (WHEEL_LN_SLOTS - 1));
+        }
+    }
+    return 0;
+}
+
+static void wheel_link(int i)
+{
+    uint16_t head = bucket_for(jobs[i].due);
+    link_head[i] = head;
+    link_prev[i] = NIL;
+    link_next[i] = heads[head];
+    if (heads[head] != NIL) link_prev[heads[head]] = i;
+    heads[head] = i;
+}
+
+static void wheel_unlink(int i)
+{
+    if (link_head[i] == NIL) return;
+    if (link_prev[i] != NIL) {
+        link_next[link_prev[i]] = link_next[i];
+    } else {
+        heads[link_head[i]] = link_next[i];
+    }
+    if (link_next[i] != NIL) link_prev[link_next[i]] = link_prev[i];
+    link_head[i] = NIL;
+}
+
+// Detaches a whole slot and returns its first job
+static uint16_t wheel_take(int head)
+{
+    uint16_t first = heads[head];
+    heads[head] = NIL;
+    for (uint16_t i = first; i != NIL; i = link_next[i]) {
+        link_head[i] = NIL;
+    }
+    return first;
+}
+
+static uint32_t next_daily(uint32_t minute_of_day, uint32_t after)
+{
+    time_t t = after;
+    struct tm tm;
+    localtime_r(&t, &tm);
+
+    for (int day = 0; day < 2; day++) {
+        tm.tm_hour = minute_of_day / 60;
+        tm.tm_min = minute_of_day % 60;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;   // Let mktime work out DST for that day
+        time_t candidate = mktime(&tm);
+        if (candidate > (time_t)after) return candidate;
+        tm.tm_mday++;
+    }
+    return after + 86400;
+}
+
+// First run of a recurring job strictly after `after`
+static uint32_t next_run(const schedule_job_t *job, uint32_t after)
+{
+    if (job->type == SCHEDULE_DAILY) {
+        return next_daily(job->period, after);
+    }
+    if (job->due > after) {
+        return job->due;
+    }
+    // Interval jobs keep their phase
+    return job->due + ((after - job->due) / job->period + 1) * job->period;
+}
+
+static void queue_pending(int i, bool fire, bool removed)
+{
+    pending_t *p = &pending[pending_count++];
+    p->slot = i;
+    p->fire = fire;
+    p->removed = removed;
+    pending_mark[i] = true;
+}
+
+// A job whose due time is not after now: catch up or skip (lock held)
+static void handle_missed(int i, uint32_t now)
+{
+    schedule_job_t *job = &jobs[i];
+    uint32_t late = now - job->due;
+
+    if (job->catchup == SCHEDULE_CATCHUP_ONCE && late <= SCHEDULER_CATCHUP_MAX_S) {
+        ESP_LOGI(TAG, "Job %u missed by %lus, running it now", job->id, late);
+        job->due = now + 1;
+        return;
+    }
+
+    if (job->type == SCHEDULE_ONCE) {
+        ESP_LOGI(TAG, "Job %u missed by %lus, dropped", job->id, late);
+        used[i] = false;
+        queue_pending(i, false, true);
+        return;
+    }
+    job->due = next_run(job, now);
+    queue_pending(i, false, false);
+}
+
+// Puts every job back into an empty wheel starting at now (lock held)
+static void wheel_rebuild(uint32_t now)
+{
+    for (int h = 0; h < WHEEL_HEADS; h++) heads[h] = NIL;
+    wheel_time = now;
+
+    for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+        link_head[i] = NIL;
+        if (!used[i]) continue;
+        if (jobs[i].due <= now) {
+            handle_missed(i, now);
+            if (!used[i]) continue;
+        }
+        wheel_link(i);
+    }
+    wheel_running = true;
+}
+
+// Advances the wheel by one second (lock held)
+static void wheel_tick(void)
+{
+    uint32_t t = ++wheel_time;
+
+    // Cascade upper levels whose slot comes up at this second, highest first
+    for (int level = WHEEL_LEVELS - 1; level >= 1; level--) {
+        int shift = level_shift(level);
+        if ((t & ((1u << shift) - 1)) != 0) continue;
+        int head = WHEEL_L0_SLOTS + (level - 1) * WHEEL_LN_SLOTS + ((t >> shift) & (WHEEL_LN_SLOTS - 1));
+        uint16_t i = wheel_take(head);
+        while (i != NIL) {
+            uint16_t next = link_next[i];
+            wheel_link(i);
+            i = next;
+        }
+    }
+
+    uint16_t i = wheel_take(t & (WHEEL_L0_SLOTS - 1));
+    while (i != NIL) {
+        uint16_t next = link_next[i];
+        schedule_job_t *job = &jobs[i];
+
+        if (job->due != t) {
+            wheel_link(i);  // Not this lap of the wheel
+        } else {
+            job->last_run = t;
+            if (job->type == SCHEDULE_ONCE) {
+                used[i] = false;
+                queue_pending(i, true, true);
+            } else {
+                job->due = next_run(job, t);
+                wheel_link(i);
+                queue_pending(i, true, false);
+            }
+        }
+        i = next;
+    }
+}
+
+static void persist_job(nvs_handle_t handle, const schedule_job_t *job, bool removed)
+{
+    char key[16];
+    snprintf(key, sizeof(key), "job%u", job->id);
+    if (removed) {
+        nvs_erase_key(handle, key);
+    } else {
+        nvs_set_blob(handle, key, job, sizeof(*job));
+    }
+}
+
+// Runs the actions collected under the lock and writes the changed jobs to NVS
+static void flush_pending(void)
+{
+    if (pending_count == 0) return;
+
+    nvs_handle_t handle;
+    bool nvs_ok = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK;
+
+    for (int p = 0; p < pending_count; p++) {
+        int i = pending[p].slot;
+
+        xSemaphoreTake(sched_mutex, portMAX_DELAY);
+        schedule_job_t job = jobs[i];
+        bool cancelled = !pending[p].removed && !used[i];  // Cancelled since, already erased
+        xSemaphoreGive(sched_mutex);
+
+        if (pending[p].fire) {
+            ESP_LOGI(TAG, "Job %u: transmitting '%s'", job.id, job.signal);
+            if (transmit_fn(job.signal, job.transmitter) != ESP_OK) {
+                ESP_LOGW(TAG, "Job %u: cannot transmit '%s' on transmitter %u",
+                         job.id, job.signal, job.transmitter);
+            }
+        }
+        if (nvs_ok && !cancelled) {
+            persist_job(handle, &job, pending[p].removed);
+        }
+    }
+
+    if (nvs_ok) {
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+
+    xSemaphoreTake(sched_mutex, portMAX_DELAY);
+    for (int p = 0; p < pending_count; p++) {
+        pending_mark[pending[p].slot] = false;
+    }
+    pending_count = 0;
+    xSemaphoreGive(sched_mutex);
+}
+
+static void scheduler_task(void *arg)
+{
+    while (1) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        uint32_t now = tv.tv_sec;
+
+        if (now >= CLOCK_VALID_AFTER) {
+            xSemaphoreTake(sched_mutex, portMAX_DELAY);
+            if (!wheel_running || now > wheel_time + MAX_DRIFT_S || now + MAX_DRIFT_S < wheel_time) {
+                if (wheel_running) {
+                    ESP_LOGW(TAG, "Clock jumped by %ld s, rescheduling", (long)(now - wheel_time));
+                }
+                wheel_rebuild(now - 1);
+            }
+            // Each tick queues at most one entry per job, stop early so the buffer cannot overflow
+            while (wheel_time < now && pending_count < SCHEDULER_MAX_JOBS) {
+                wheel_tick();
+            }
+            xSemaphoreGive(sched_mutex);
+
+            flush_pending();
+        }
+
+        // Wake up just after the next full second
+        vTaskDelay(pdMS_TO_TICKS(1000 - tv.tv_usec / 1000) + 1);
+    }
+}
+
+static void load_jobs(void)
+{
+    for (int h = 0; h < WHEEL_HEADS; h++) heads[h] = NIL;
+    for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) link_head[i] = NIL;
+
+    nvs_iterator_t it = NULL;
+    esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, NVS_NAMESPACE, NVS_TYPE_BLOB, &it);
+    if (err != ESP_OK) return;
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        nvs_release_iterator(it);
+        return;
+    }
+
+    int count = 0;
+    while (err == ESP_OK && count < SCHEDULER_MAX_JOBS) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+
+        size_t size = sizeof(schedule_job_t);
+        if (nvs_get_blob(handle, info.key, &jobs[count], &size) == ESP_OK && size == sizeof(schedule_job_t)) {
+            used[count] = true;
+            if (jobs[count].id >= next_id) next_id = jobs[count].id + 1;
+            count++;
+        }
+        err = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+    nvs_close(handle);
+
+    ESP_LOGI(TAG, "Loaded %d scheduled jobs", count);
+}
+
+void scheduler_init(scheduler_transmit_fn transmit)
+{
+    transmit_fn = transmit;
+    load_jobs();
+    sched_mutex = xSemaphoreCreateMutex();
+    xTaskCreate(scheduler_task, "scheduler", 4096, NULL, 4, NULL);
+}
+
+bool scheduler_clock_valid(void)
+{
+    return (uint32_t)time(NULL) >= CLOCK_VALID_AFTER;
+}
+
+esp_err_t scheduler_add(schedule_job_t *job)
+{
+    if (!scheduler_clock_valid()) return ESP_ERR_INVALID_STATE;
+
+    uint32_t now = time(NULL);
+    job->signal[SCHEDULER_SIGNAL_NAME_LEN - 1] = '\0';
+    if (job->signal[0] == '\0' || job->catchup > SCHEDULE_CATCHUP_SKIP) return ESP_ERR_INVALID_ARG;
+
+    switch (job->type) {
+        case SCHEDULE_ONCE:
+            if (job->due <= now || job->due > now + MAX_AHEAD_S) return ESP_ERR_INVALID_ARG;
+            break;
+        case SCHEDULE_INTERVAL:
+            if (job->period < SCHEDULER_MIN_INTERVAL_S || job->period > MAX_AHEAD_S) return ESP_ERR_INVALID_ARG;
+            job->due = now + job->period;
+            break;
+        case SCHEDULE_DAILY:
+            if (job->period >= 24 * 60) return ESP_ERR_INVALID_ARG;
+            job->due = next_daily(job->period, now);
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(sched_mutex, portMAX_DELAY);
+
+    int slot = 0;
+    while (slot < SCHEDULER_MAX_JOBS && (used[slot] || pending_mark[slot])) slot++;
+    if (slot == SCHEDULER_MAX_JOBS) {
+        xSemaphoreGive(sched_mutex);
+        return ESP_ERR_NO_MEM;
+    }
+
+    job->id = next_id++;
+    job->last_run = 0;
+    jobs[slot] = *job;
+    used[slot] = true;
+    link_head[slot] = NIL;
+    if (wheel_running) {
+        if (jobs[slot].due <= wheel_time) jobs[slot].due = wheel_time + 1;
+        wheel_link(slot);
+    }
+
+    xSemaphoreGive(sched_mutex);
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        persist_job(handle, job, false);
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+
+    ESP_LOGI(TAG, "Added job %u ('%s'), first run at %lu", job->id, job->signal, job->due);
+    return ESP_OK;
+}
+
+esp_err_t scheduler_cancel(uint16_t id)
+{
+    xSemaphoreTake(sched_mutex, portMAX_DELAY);
+
+    int slot = 0;
+    while (slot < SCHEDULER_MAX_JOBS && !(used[slot] && jobs[slot].id == id)) slot++;
+    if (slot == SCHEDULER_MAX_JOBS) {
+        xSemaphoreGive(sched_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    wheel_unlink(slot);
+    used[slot] = false;
+    schedule_job_t job = jobs[slot];
+
+    xSemaphoreGive(sched_mutex);
+
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        persist_job(handle, &job, true);
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+
+    ESP_LOGI(TAG, "Cancelled job %u", id);
+    return ESP_OK;
+}
+
+bool scheduler_get(int index, schedule_job_t *job)
+{
+    if (index < 0 || index >= SCHEDULER_MAX_JOBS) return false;
+
+    xSemaphoreTake(sched_mutex, portMAX_DELAY);
+    bool found = used[index];
+    if (found) *job = jobs[index];
+    xSemaphoreGive(sched_mutex);
+
+    return found;
+}
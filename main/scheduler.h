@@ -0,0 +1,63 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCHEDULER_MAX_JOBS       256
+#define SCHEDULER_SIGNAL_NAME_LEN 32
+#define SCHEDULER_MIN_INTERVAL_S 10
+#define SCHEDULER_CATCHUP_MAX_S  86400   // Missed runs older than this are never caught up
+
+typedef enum {
+    SCHEDULE_ONCE = 0,          // Runs at due, then the job is removed
+    SCHEDULE_INTERVAL,          // Every period seconds
+    SCHEDULE_DAILY,             // Every day at period = minute of the day, local time
+} schedule_type_t;
+
+// What happens to a run that was missed because the device was off (or the clock jumped)
+typedef enum {
+    SCHEDULE_CATCHUP_ONCE = 0,  // Run once as soon as possible, if missed by less than SCHEDULER_CATCHUP_MAX_S
+    SCHEDULE_CATCHUP_SKIP,      // Drop it, recurring jobs wait for their next slot
+} schedule_catchup_t;
+
+// Persisted as is, one NVS blob per job
+typedef struct {
+    uint16_t id;
+    uint8_t type;               // schedule_type_t
+    uint8_t catchup;            // schedule_catchup_t
+    uint8_t transmitter;
+    uint8_t reserved[3];
+    uint32_t due;               // Unix time of the next run
+    uint32_t period;            // Interval in seconds, or minute of the day for daily jobs
+    uint32_t last_run;          // Unix time, 0 = never
+    char signal[SCHEDULER_SIGNAL_NAME_LEN];
+} schedule_job_t;
+
+typedef esp_err_t (*scheduler_transmit_fn)(const char *signal, int transmitter);
+
+// Loads jobs from NVS and starts the scheduler task. Jobs start running once the
+// wall clock is set (SNTP), missed runs are handled by each job's catch-up policy.
+void scheduler_init(scheduler_transmit_fn transmit);
+
+// True once the wall clock looks valid, jobs cannot be added before that
+bool scheduler_clock_valid(void);
+
+// Adds a job, job->id and job->due (for recurring jobs) are filled in.
+// For SCHEDULE_ONCE, due must be set by the caller.
+esp_err_t scheduler_add(schedule_job_t *job);
+esp_err_t scheduler_cancel(uint16_t id);
+
+// Copies the job in table slot index. Returns false for free slots, iterate 0..SCHEDULER_MAX_JOBS-1.
+bool scheduler_get(int index, schedule_job_t *job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCHEDULER_H
@@ -0,0 +1,56 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sequence lock for small structs that one side publishes and others copy out.
+// Readers never block a writer: they copy, then check the sequence did not move
+// (and was even, i.e. no write in progress) and copy again if it did. Writers
+// serialize on a spinlock held only for the memcpy, with interrupts masked on
+// their core, so a reader never waits on a preempted writer.
+typedef struct {
+    volatile uint32_t seq;          // Odd while a write is in progress
+    portMUX_TYPE writer;
+    volatile uint32_t writes;
+    volatile uint32_t read_retries; // Copies that raced a write and were redone
+} seqlock_t;
+
+#define SEQLOCK_INIT { .seq = 0, .writer = portMUX_INITIALIZER_UNLOCKED, .writes = 0, .read_retries = 0 }
+
+static inline void seqlock_write(seqlock_t *lock, void *dst, const void *src, size_t size)
+{
+    portENTER_CRITICAL(&lock->writer);
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(dst, src, size);
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELEASE);
+    lock->writes++;
+    portEXIT_CRITICAL(&lock->writer);
+}
+
+static inline void seqlock_read(seqlock_t *lock, void *dst, const void *src, size_t size)
+{
+    for (;;) {
+        uint32_t start = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE);
+        if ((start & 1) == 0) {
+            memcpy(dst, src, size);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&lock->seq, __ATOMIC_RELAXED) == start) return;
+        }
+        // Only reachable while the other core is inside seqlock_write
+        __atomic_fetch_add(&lock->read_retries, 1, __ATOMIC_RELAXED);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SEQLOCK_H
@@ -0,0 +1,125 @@
+#include "settings.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "rc_switch.h"
+#include "seqlock.h"
+
+static const char *TAG = "SETTINGS";
+
+#define SETTINGS_NVS_KEY "settings"
+
+#define SETTINGS_DEFAULT {       \
+    .sync_gap_us = 5000,            \
+    .short_pulse_us = 2000,         \
+    .decoder_min_bits = 8,          \
+    .accept_min_bits = 12,          \
+    .tracked_max = 10,              \
+    .tracked_expiry_s = 50,         \
+}
+
+static const settings_t defaults = SETTINGS_DEFAULT;
+
+// Readers copy the block out under the sequence lock, so a copy taken while
+// settings_set runs on the other core is redone instead of mixing old and new fields
+static settings_t current = SETTINGS_DEFAULT;
+static seqlock_t current_lock = SEQLOCK_INIT;
+static SemaphoreHandle_t write_mutex = NULL;
+
+static void apply(const settings_t *settings)
+{
+    seqlock_write(&current_lock, &current, settings, sizeof(current));
+
+    rc_decoder_config_t decoder = {
+        .sync_gap_us = settings->sync_gap_us,
+        .short_pulse_us = settings->short_pulse_us,
+        .min_bits = settings->decoder_min_bits,
+    };
+    rc_receiver_set_decoder_config(&decoder);
+}
+
+void settings_init(void)
+{
+    write_mutex = xSemaphoreCreateMutex();
+
+    // Older firmware stored a shorter block, the fields it lacks keep their defaults
+    settings_t loaded = defaults;
+    nvs_handle_t handle;
+    if (nvs_open("storage", NVS_READONLY, &handle) == ESP_OK) {
+        size_t size = sizeof(loaded);
+        if (nvs_get_blob(handle, SETTINGS_NVS_KEY, &loaded, &size) != ESP_OK) {
+            loaded = defaults;
+        }
+        nvs_close(handle);
+    }
+
+    const char *error = settings_validate(&loaded);
+    if (error != NULL) {
+        ESP_LOGW(TAG, "Stored settings rejected (%s), using defaults", error);
+        loaded = defaults;
+    }
+
+    apply(&loaded);
+    ESP_LOGI(TAG, "Sync gap %uus, short pulse <%uus, decode >=%u bits, accept >=%u bits, track %u for %lus",
+             loaded.sync_gap_us, loaded.short_pulse_us, loaded.decoder_min_bits,
+             loaded.accept_min_bits, loaded.tracked_max, loaded.tracked_expiry_s);
+}
+
+void settings_get(settings_t *out)
+{
+    seqlock_read(&current_lock, out, &current, sizeof(*out));
+}
+
+void settings_defaults(settings_t *out)
+{
+    *out = defaults;
+}
+
+const char *settings_validate(const settings_t *settings)
+{
+    if (settings->sync_gap_us < 2000 || settings->sync_gap_us > 20000) {
+        return "syncGapUs must be 2000-20000";
+    }
+    if (settings->short_pulse_us < 500 || settings->short_pulse_us >= settings->sync_gap_us) {
+        return "shortPulseUs must be at least 500 and below syncGapUs";
+    }
+    if (settings->decoder_min_bits < 4 || settings->decoder_min_bits > RC_SWITCH_MAX_BITS) {
+        return "decoderMinBits must be 4-32";
+    }
+    if (settings->accept_min_bits < settings->decoder_min_bits || settings->accept_min_bits > RC_SWITCH_MAX_BITS) {
+        return "acceptMinBits must be between decoderMinBits and 32";
+    }
+    if (settings->tracked_max < 1 || settings->tracked_max > SETTINGS_TRACKED_CAPACITY) {
+        return "trackedMax must be 1-50";
+    }
+    if (settings->tracked_expiry_s < 5 || settings->tracked_expiry_s > 86400) {
+        return "trackedExpiryS must be 5-86400";
+    }
+    return NULL;
+}
+
+esp_err_t settings_set(const settings_t *settings)
+{
+    if (write_mutex == NULL) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(write_mutex, portMAX_DELAY);
+    apply(settings);
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open("storage", NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, SETTINGS_NVS_KEY, settings, sizeof(*settings));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    xSemaphoreGive(write_mutex);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save settings: %s", esp_err_to_name(err));
+    }
+    return err;
+}
@@ -0,0 +1,45 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Room reserved for tracked signals, tracked_max picks how much of it is used
+#define SETTINGS_TRACKED_CAPACITY 50
+
+// Decoder and tracking parameters that can be tuned per site without reflashing.
+// Persisted in NVS as one blob, fields are only ever appended.
+typedef struct {
+    uint16_t sync_gap_us;       // Gap that ends one capture and starts the next
+    uint16_t short_pulse_us;    // Durations below this feed the pulse length estimate
+    uint8_t decoder_min_bits;   // Shortest frame the decoder accepts
+    uint8_t accept_min_bits;    // Shorter frames are dropped before tracking
+    uint8_t tracked_max;        // Signals kept in the tracking store
+    uint8_t reserved;
+    uint32_t tracked_expiry_s;  // Tracked signals not heard for this long are removed
+} settings_t;
+
+// Loads the settings from NVS (defaults for anything missing) and applies them
+void settings_init(void);
+
+// Copies the current settings out. Callers that need several fields for one pass
+// take one copy, so the pass sees a single version even across an update.
+void settings_get(settings_t *out);
+
+void settings_defaults(settings_t *out);
+
+// Returns an error message, or NULL if the settings are in range
+const char *settings_validate(const settings_t *settings);
+
+// Applies validated settings and persists them
+esp_err_t settings_set(const settings_t *settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SETTINGS_H
@@ -0,0 +1,352 @@
+#include "usage.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "config.h"
+
+static const char *TAG = "USAGE";
+
+// NVS is log structured, rewriting the whole table would put all of it on flash
+// again for every batch. The base holds every entry, each delta only what changed.
+#ifndef USAGE_FLUSH_INTERVAL_S
+#define USAGE_FLUSH_INTERVAL_S 600
+#endif
+
+#define USAGE_NVS_NAMESPACE "usage"
+#define USAGE_BASE_KEY      "base"
+#define USAGE_DELTA_KEY     "delta%d"
+
+// Every blob starts with the generation of the base it belongs to. A compaction writes
+// the base with the next generation before it erases the deltas, so deltas that outlive
+// it (power cut, failed erase) are recognised as already counted and skipped on load.
+typedef struct {
+    uint32_t generation;
+    usage_record_t records[USAGE_ENTRIES_MAX];
+} usage_blob_t;
+
+#define BLOB_HEADER_SIZE offsetof(usage_blob_t, records)
+
+static SemaphoreHandle_t usage_mutex = NULL;    // Guards the counters
+static SemaphoreHandle_t flush_mutex = NULL;    // One flush at a time, held while NVS is written
+
+static usage_record_t entries[USAGE_ENTRIES_MAX];
+static int entry_count = 0;
+// Counts since the last flush, written as a delta record
+static uint32_t pending_sent[USAGE_ENTRIES_MAX];
+static uint32_t pending_received[USAGE_ENTRIES_MAX];
+static bool dirty[USAGE_ENTRIES_MAX];
+
+static const char *partition = NULL;
+static uint32_t generation = 0;     // Of the base in NVS, new deltas are written with it
+static int delta_count = 0;         // Delta records of this generation in NVS
+static int delta_records = 0;       // Codes in those records together
+static bool compact_next = false;   // A write failed, the next flush rewrites the base
+static bool flush_soon = false;     // Every entry is dirty, usage_tick flushes without waiting
+static int64_t last_flush = 0;
+static usage_stats_t stats;
+
+static inline uint32_t last_used(const usage_record_t *e)
+{
+    return MAX(e->last_sent, e->last_received);
+}
+
+// Reads a blob, returns its record count or -1 when it is missing or malformed
+static int read_blob(nvs_handle_t handle, const char *key, usage_blob_t *blob)
+{
+    size_t size = sizeof(*blob);
+    if (nvs_get_blob(handle, key, blob, &size) != ESP_OK || size < BLOB_HEADER_SIZE ||
+        (size - BLOB_HEADER_SIZE) % sizeof(usage_record_t) != 0) {
+        return -1;
+    }
+    return (size - BLOB_HEADER_SIZE) / sizeof(usage_record_t);
+}
+
+// Finds the entry of a code or makes room for it, called with usage_mutex held.
+// Only an entry without unsaved counts is replaced; when every entry has some,
+// returns -1 and the next usage_tick flushes so there is room again.
+static int entry_index(uint32_t code, uint8_t bit_length, uint8_t protocol)
+{
+    int victim = -1;
+    for (int i = 0; i < entry_count; i++) {
+        const usage_record_t *e = &entries[i];
+        if (e->code == code && e->bit_length == bit_length && e->protocol == protocol) {
+            return i;
+        }
+        if (!dirty[i] && (victim < 0 || last_used(e) < last_used(&entries[victim]))) {
+            victim = i;
+        }
+    }
+
+    int index;
+    if (entry_count < USAGE_ENTRIES_MAX) {
+        index = entry_count++;
+    } else if (victim >= 0) {
+        index = victim;
+    } else {
+        flush_soon = true;
+        stats.dropped++;
+        return -1;
+    }
+    memset(&entries[index], 0, sizeof(usage_record_t));
+    entries[index].code = code;
+    entries[index].bit_length = bit_length;
+    entries[index].protocol = protocol;
+    pending_sent[index] = 0;
+    pending_received[index] = 0;
+    dirty[index] = false;
+    return index;
+}
+
+static void apply_delta(const usage_record_t *delta)
+{
+    int i = entry_index(delta->code, delta->bit_length, delta->protocol);
+    if (i < 0) return;
+    usage_record_t *e = &entries[i];
+    e->sent += delta->sent;
+    e->received += delta->received;
+    e->last_sent = MAX(e->last_sent, delta->last_sent);
+    e->last_received = MAX(e->last_received, delta->last_received);
+}
+
+void usage_init(const char *nvs_partition)
+{
+    usage_mutex = xSemaphoreCreateMutex();
+    flush_mutex = xSemaphoreCreateMutex();
+    last_flush = esp_timer_get_time();
+    partition = nvs_partition;
+
+    nvs_handle_t handle;
+    if (nvs_open_from_partition(partition, USAGE_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        ESP_LOGI(TAG, "No usage stored yet");
+        return;
+    }
+
+    usage_blob_t *blob = malloc(sizeof(*blob));
+    xSemaphoreTake(usage_mutex, portMAX_DELAY);
+    entry_count = 0;
+    int count = blob != NULL ? read_blob(handle, USAGE_BASE_KEY, blob) : -1;
+    if (count >= 0) {
+        generation = blob->generation;
+        entry_count = count;
+        memcpy(entries, blob->records, count * sizeof(usage_record_t));
+    }
+
+    // Deltas fill the slots from 0, the first missing or older one ends them
+    delta_records = 0;
+    for (delta_count = 0; blob != NULL && delta_count < USAGE_DELTAS_MAX; delta_count++) {
+        char key[16];
+        snprintf(key, sizeof(key), USAGE_DELTA_KEY, delta_count);
+        count = read_blob(handle, key, blob);
+        if (count < 0 || blob->generation != generation) break;
+        for (int i = 0; i < count; i++) {
+            apply_delta(&blob->records[i]);
+        }
+        delta_records += count;
+    }
+    if (blob == NULL) {
+        // Not replayed, the first flush writes a fresh base and erases every delta slot
+        delta_count = USAGE_DELTAS_MAX;
+    }
+    free(blob);
+    xSemaphoreGive(usage_mutex);
+    nvs_close(handle);
+
+    ESP_LOGI(TAG, "Loaded usage of %d codes (%d delta records)", entry_count, delta_count);
+}
+
+void usage_count_sent(uint32_t code, uint8_t bit_length, uint8_t protocol)
+{
+    if (usage_mutex == NULL) return;
+
+    uint32_t now = (uint32_t)time(NULL);
+    xSemaphoreTake(usage_mutex, portMAX_DELAY);
+    int i = entry_index(code, bit_length, protocol);
+    if (i >= 0) {
+        entries[i].sent++;
+        entries[i].last_sent = now;
+        pending_sent[i]++;
+        dirty[i] = true;
+    }
+    xSemaphoreGive(usage_mutex);
+}
+
+void usage_count_received(uint32_t code, uint8_t bit_length, uint8_t protocol)
+{
+    if (usage_mutex == NULL) return;
+
+    uint32_t now = (uint32_t)time(NULL);
+    xSemaphoreTake(usage_mutex, portMAX_DELAY);
+    int i = entry_index(code, bit_length, protocol);
+    if (i >= 0) {
+        entries[i].received++;
+        entries[i].last_received = now;
+        pending_received[i]++;
+        dirty[i] = true;
+    }
+    xSemaphoreGive(usage_mutex);
+}
+
+bool usage_get(uint32_t code, uint8_t bit_length, uint8_t protocol, usage_record_t *out)
+{
+    if (usage_mutex == NULL) return false;
+
+    bool found = false;
+    xSemaphoreTake(usage_mutex, portMAX_DELAY);
+    for (int i = 0; i < entry_count; i++) {
+        const usage_record_t *e = &entries[i];
+        if (e->code == code && e->bit_length == bit_length && e->protocol == protocol) {
+            *out = *e;
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(usage_mutex);
+    return found;
+}
+
+// Takes the changes out of the counters: every entry for a compaction, otherwise
+// only the dirty ones as deltas. A delta that would take the delta records past a
+// full base's worth of codes becomes a compaction, *compact tells which was done.
+// Returns the number of records copied.
+static int collect(usage_record_t *out, bool *compact)
+{
+    int count = 0;
+    xSemaphoreTake(usage_mutex, portMAX_DELAY);
+    if (!*compact) {
+        int changed = 0;
+        for (int i = 0; i < entry_count; i++) {
+            if (dirty[i]) changed++;
+        }
+        *compact = delta_records + changed > USAGE_ENTRIES_MAX;
+    }
+    flush_soon = false;
+    for (int i = 0; i < entry_count; i++) {
+        if (*compact || dirty[i]) {
+            out[count] = entries[i];
+            if (!*compact) {
+                out[count].sent = pending_sent[i];
+                out[count].received = pending_received[i];
+            }
+            count++;
+        }
+        pending_sent[i] = 0;
+        pending_received[i] = 0;
+        dirty[i] = false;
+    }
+    xSemaphoreGive(usage_mutex);
+    return count;
+}
+
+static bool any_dirty(void)
+{
+    bool found = false;
+    xSemaphoreTake(usage_mutex, portMAX_DELAY);
+    for (int i = 0; i < entry_count && !found; i++) {
+        found = dirty[i];
+    }
+    xSemaphoreGive(usage_mutex);
+    return found;
+}
+
+void usage_flush(void)
+{
+    if (usage_mutex == NULL) return;
+
+    xSemaphoreTake(flush_mutex, portMAX_DELAY);
+    last_flush = esp_timer_get_time();
+    if (!any_dirty()) {
+        xSemaphoreGive(flush_mutex);
+        return;
+    }
+
+    usage_blob_t *blob = malloc(sizeof(*blob));
+    nvs_handle_t handle;
+    esp_err_t err = blob == NULL ? ESP_ERR_NO_MEM
+                                 : nvs_open_from_partition(partition, USAGE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        // The base is written from the totals, which already hold every delta
+        bool compact = compact_next || delta_count >= USAGE_DELTAS_MAX;
+        int count = collect(blob->records, &compact);
+        size_t size = BLOB_HEADER_SIZE + count * sizeof(usage_record_t);
+        char key[16];
+        if (compact) {
+            // From here on the deltas of the old generation no longer count, erasing
+            // them only frees the space
+            blob->generation = generation + 1;
+            err = nvs_set_blob(handle, USAGE_BASE_KEY, blob, size);
+            for (int i = 0; err == ESP_OK && i < delta_count; i++) {
+                snprintf(key, sizeof(key), USAGE_DELTA_KEY, i);
+                esp_err_t erase_err = nvs_erase_key(handle, key);
+                if (erase_err != ESP_OK && erase_err != ESP_ERR_NVS_NOT_FOUND) {
+                    ESP_LOGW(TAG, "Failed to erase %s: %s", key, esp_err_to_name(erase_err));
+                }
+            }
+        } else {
+            blob->generation = generation;
+            snprintf(key, sizeof(key), USAGE_DELTA_KEY, delta_count);
+            err = nvs_set_blob(handle, key, blob, size);
+        }
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+
+        if (err == ESP_OK) {
+            compact_next = false;
+            if (compact) {
+                generation++;
+                delta_count = 0;
+                delta_records = 0;
+                stats.compactions++;
+            } else {
+                delta_count++;
+                delta_records += count;
+                stats.flushes++;
+            }
+            ESP_LOGD(TAG, "Wrote %s of %d codes", compact ? "base" : "delta", count);
+        }
+    }
+    free(blob);
+
+    if (err != ESP_OK) {
+        // The counts taken out are still in the totals, a fresh base brings NVS up to date
+        compact_next = true;
+        stats.write_errors++;
+        ESP_LOGE(TAG, "Failed to save usage: %s", esp_err_to_name(err));
+    }
+    xSemaphoreGive(flush_mutex);
+}
+
+void usage_tick(void)
+{
+    if (usage_mutex == NULL) return;
+
+    xSemaphoreTake(usage_mutex, portMAX_DELAY);
+    bool full = flush_soon;
+    xSemaphoreGive(usage_mutex);
+    if (!full && esp_timer_get_time() - last_flush < (int64_t)USAGE_FLUSH_INTERVAL_S * 1000000) return;
+    usage_flush();
+}
+
+void usage_get_stats(usage_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (usage_mutex == NULL) return;
+
+    xSemaphoreTake(usage_mutex, portMAX_DELAY);
+    *out = stats;
+    out->entries = entry_count;
+    for (int i = 0; i < entry_count; i++) {
+        if (dirty[i]) out->dirty++;
+    }
+    out->deltas = delta_count;
+    xSemaphoreGive(usage_mutex);
+}
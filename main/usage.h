@@ -0,0 +1,63 @@
+#ifndef USAGE_H
+#define USAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lifetime usage per code: how often it was sent and received, and when last.
+// Counted in RAM and written to NVS in batches (usage_tick, usage_flush), each
+// batch only holds the entries that changed since the one before.
+
+#define USAGE_ENTRIES_MAX   256     // Codes with counters, the least recently used is replaced
+#define USAGE_DELTAS_MAX    8       // Delta records in NVS before they are folded into the base
+// Delta records together never hold more codes than a full base, so NVS needs at most
+// three base sizes (~18 KB): the base, its deltas and the next base while it is written
+
+typedef struct {
+    uint32_t code;
+    uint8_t bit_length;
+    uint8_t protocol;
+    uint16_t reserved;
+    uint32_t sent;              // Transmits of this code
+    uint32_t received;          // Button presses received
+    uint32_t last_sent;         // Unix seconds (seconds since boot until SNTP has synced), 0 = never
+    uint32_t last_received;
+} usage_record_t;
+
+typedef struct {
+    uint32_t entries;           // Codes with counters
+    uint32_t dirty;             // Entries changed since the last flush
+    uint32_t deltas;            // Delta records in NVS on top of the base
+    uint32_t flushes;           // Delta records written since boot
+    uint32_t compactions;       // Times the base was rewritten since boot
+    uint32_t write_errors;
+    uint32_t dropped;           // Counts of new codes lost because every entry had unsaved changes
+} usage_stats_t;
+
+// Loads the base record and replays the deltas from the NVS partition the counters
+// live in. Needs NVS, call once storage is up.
+void usage_init(const char *partition);
+
+void usage_count_sent(uint32_t code, uint8_t bit_length, uint8_t protocol);
+void usage_count_received(uint32_t code, uint8_t bit_length, uint8_t protocol);
+
+// Copies the counters of a code. False when it was never sent or received.
+bool usage_get(uint32_t code, uint8_t bit_length, uint8_t protocol, usage_record_t *out);
+
+// Flushes once USAGE_FLUSH_INTERVAL_S has passed since the last flush. Cheap to call often.
+void usage_tick(void);
+
+// Writes the changed entries now, also registered as a shutdown handler.
+void usage_flush(void);
+
+void usage_get_stats(usage_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // USAGE_H
@@ -24,8 +24,13 @@ function fetchSavedSignals() {
         });
 }
 
+// Change sequence of the last history response, null until the first poll
+let historySeq = null;
+
 function pollLastSignal() {
-    return fetchWithErrorHandling('/api/signal-history')
+    // After the first poll only ask for entries that changed since then
+    const url = historySeq === null ? '/api/signal-history' : `/api/signal-history?since=${historySeq}`;
+    return fetchWithErrorHandling(url)
         .then(data => {
             if (!data) return;
             
@@ -35,22 +40,21 @@ function pollLastSignal() {
                 const receivedAt = Date.now() * 1000; // microseconds
                 const serverTime = data.serverTime || receivedAt;
                 
-                // Clear and rebuild signal map from server data
-                signalMap = {};
-                signalMap._order = [];
+                // A full response replaces the signal map, a delta only patches changed entries
+                if (data.full || !signalMap._order) {
+                    signalMap = {};
+                    signalMap._order = [];
+                }
                 signalMap._serverTime = serverTime;
                 signalMap._receivedAt = receivedAt;
                 
-                // Sort by firstSeen to maintain detection order
-                const sortedSignals = [...data.signals].sort((a, b) => a.firstSeen - b.firstSeen);
-                
-                sortedSignals.forEach((sig, index) => {
+                data.signals.forEach(sig => {
                     const signalKey = `${sig.code}_${sig.bitLength}_${sig.protocol}`;
-                    // ESP32 timestamps are in microseconds since boot
-                    // Calculate relative time using serverTime and lastSeen
-                    const timeAgo = formatTimeAgo(signalMap._serverTime, sig.lastSeen);
                     
+                    // ESP32 timestamps are in microseconds since boot, the
+                    // monitor turns them into relative times as it renders
                     signalMap[signalKey] = {
+                        key: signalKey,
                         signal: {
                             code: sig.code,
                             bitLength: sig.bitLength,
@@ -58,10 +62,11 @@ function pollLastSignal() {
                             pulseLength: sig.pulseLength
                         },
                         count: sig.count,
-                        lastUpdate: timeAgo,
+                        family: sig.family || null,
+                        state: sig.state || null,
+                        durationMs: sig.durationMs || 0,
                         lastSeenTimestamp: sig.lastSeen,
-                        firstDetected: sig.firstSeen,
-                        firstDetectedTime: formatTimeAgo(signalMap._serverTime, sig.firstSeen)
+                        firstDetected: sig.firstSeen
                     };
                     
                     if (!signalMap._order.includes(signalKey)) {
@@ -69,6 +74,13 @@ function pollLastSignal() {
                     }
                 });
                 
+                // Sort by firstSeen to maintain detection order
+                signalMap._order.sort((a, b) => signalMap[a].firstDetected - signalMap[b].firstDetected);
+                
+                if (typeof data.seq === 'number') {
+                    historySeq = data.seq;
+                }
+                
                 // Update display with all signals
                 displaySignal(null, false);
             }
@@ -150,7 +162,7 @@ function clearTracking() {
         if (data && data.success) {
             signalMap = {};
             signalMap._order = [];
-            document.getElementById('signalDisplay').innerHTML = '<div class="empty-state">Waiting for RF signals...</div>';
+            displaySignal(null, false);
         }
         return data;
     });
@@ -204,4 +216,44 @@ function saveCurrentSignalFromInput() {
         .catch(() => {
             // Error already shown by saveCurrentSignal
         });
-}
\ No newline at end of file
+}
+
+// Bulk library transfer
+function exportLibrary(format) {
+    const a = document.createElement('a');
+    a.href = `/api/signals/export?format=${format}`;
+    a.download = format === 'binary' ? 'signals.rfsl' : 'signals.ndjson';
+    a.click();
+}
+
+function importLibrary() {
+    const input = document.createElement('input');
+    input.type = 'file';
+    input.accept = '.ndjson,.jsonl,.rfsl';
+
+    input.onchange = (e) => {
+        const file = e.target.files[0];
+        if (!file) return;
+
+        const format = file.name.endsWith('.rfsl') ? 'binary' : 'ndjson';
+        const replace = confirm('Replace the current library?\n\nOK = replace, Cancel = merge (duplicates are skipped)');
+
+        fetch(`/api/signals/import?format=${format}&mode=${replace ? 'replace' : 'merge'}`, {
+            method: 'POST',
+            headers: {'Content-Type': format === 'binary' ? 'application/octet-stream' : 'application/x-ndjson'},
+            body: file
+        })
+        .then(response => response.json())
+        .then(data => {
+            if (data.success) {
+                alert(`Imported ${data.imported} signals (${data.duplicates} duplicates, ${data.invalid} invalid skipped)`);
+                fetchSavedSignals();
+            } else {
+                alert('Error: ' + (data.error || 'Import failed'));
+            }
+        })
+        .catch(error => alert('Error: ' + error.message));
+    };
+
+    input.click();
+}
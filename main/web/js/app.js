@@ -4,6 +4,7 @@ function switchTab(tabName) {
     if (tabName !== 'monitor' && monitorPollInterval) {
         clearInterval(monitorPollInterval);
         monitorPollInterval = null;
+        stopTimeAgoUpdates();
     }
 
     // Hide all tab contents
@@ -64,6 +65,7 @@ function initMonitorTab() {
         clearInterval(monitorPollInterval);
     }
     pollLastSignal(); // Initial poll
+    startTimeAgoUpdates();
     monitorPollInterval = setInterval(() => {
         pollLastSignal();
     }, 1000); // Poll every 1 second
@@ -79,6 +81,8 @@ function initManualTab() {
 
 function initSettingsTab() {
     loadSettings();
+    loadDeviceSettings();
+    loadWifiProfile();
 }
 
 function initApiTab() {
@@ -142,4 +142,102 @@ function resetToDefaults() {
 
     // Inform user
     alert('Settings reset to default values.');
-}
\ No newline at end of file
+}
+
+// Decoder and tracking settings (stored on the device)
+const DEVICE_SETTING_FIELDS = ['syncGapUs', 'shortPulseUs', 'decoderMinBits', 'acceptMinBits', 'trackedMax', 'trackedExpiryS'];
+let deviceSettingDefaults = null;
+
+function loadDeviceSettings() {
+    return fetchWithErrorHandling('/api/settings')
+        .then(data => {
+            if (!data) return;
+            deviceSettingDefaults = data.defaults;
+            DEVICE_SETTING_FIELDS.forEach(field => {
+                document.getElementById(field).value = data[field];
+            });
+        });
+}
+
+function postDeviceSettings(settings) {
+    return fetch('/api/settings', {
+        method: 'POST',
+        headers: {'Content-Type': 'application/json'},
+        body: JSON.stringify(settings)
+    })
+    .then(response => response.json())
+    .then(data => {
+        if (!data.success) {
+            alert('Error: ' + (data.error || 'Failed to save device settings'));
+        }
+        return loadDeviceSettings();
+    });
+}
+
+function saveDeviceSettings() {
+    const settings = {};
+    DEVICE_SETTING_FIELDS.forEach(field => {
+        settings[field] = parseInt(document.getElementById(field).value);
+    });
+    return postDeviceSettings(settings);
+}
+
+function restoreDeviceDefaults() {
+    if (!deviceSettingDefaults || !confirm('Restore the decoder and tracking defaults?')) return;
+    return postDeviceSettings(deviceSettingDefaults);
+}
+
+// WiFi power profile (stored on the device)
+function loadWifiProfile() {
+    return fetchWithErrorHandling('/api/wifi-profile')
+        .then(data => {
+            if (!data) return;
+            document.getElementById('wifiProfile').value = data.profile;
+            displayWifiLatency(data.latency);
+        });
+}
+
+function setWifiProfile(profile) {
+    return fetch('/api/wifi-profile', {
+        method: 'POST',
+        headers: {'Content-Type': 'application/json'},
+        body: JSON.stringify({ profile: profile })
+    })
+    .then(response => response.json())
+    .then(data => {
+        if (!data.success) {
+            alert('Error: ' + (data.error || 'Failed to set WiFi profile'));
+        }
+        return loadWifiProfile();
+    });
+}
+
+function displayWifiLatency(latency) {
+    const el = document.getElementById('wifiLatency');
+    if (!el || !latency) return;
+
+    const lines = Object.keys(latency)
+        .filter(name => latency[name].samples > 0)
+        .map(name => `${name}: p50 ${latency[name].p50} ms, p99 ${latency[name].p99} ms (${latency[name].samples} samples)`);
+    el.textContent = lines.length > 0 ? lines.join(' | ') : 'No latency samples yet';
+}
+
+// Sends a burst of sequential pings, each one reports the round trip of the one before
+function runLatencyProbe(count = 30) {
+    let lastRtt = null;
+    let chain = Promise.resolve();
+
+    for (let i = 0; i <= count; i++) {
+        chain = chain.then(() => {
+            const url = lastRtt === null ? '/api/ping' : `/api/ping?rtt=${Math.round(lastRtt)}`;
+            const started = performance.now();
+            return fetch(url, { cache: 'no-store' }).then(() => {
+                lastRtt = performance.now() - started;
+            });
+        });
+    }
+
+    return chain
+        .then(() => loadWifiProfile())
+        .catch(error => alert('Latency probe failed: ' + error.message));
+}
@@ -3,56 +3,251 @@ let lastSignal = null;
 let savedSignals = [];
 let signalMap = {};
 
+// Keyed list renderer. Each item gets one DOM row that is created once and then
+// patched in place: updateRow only touches the fields whose value changed, rows
+// are moved only when the order changed and dropped when their key disappears.
+// With virtualizeAbove set, lists longer than that only keep the rows in view
+// (plus a small margin) in the DOM, positioned over a spacer of the full height.
+class KeyedList {
+    constructor(container, options) {
+        this.container = container;
+        this.createRow = options.createRow;
+        this.updateRow = options.updateRow;
+        this.emptyHtml = options.emptyHtml;
+        this.rowHeight = options.rowHeight || 0;
+        this.virtualizeAbove = options.virtualizeAbove || Infinity;
+        this.overscan = options.overscan || 6;
+        this.items = [];
+        this.rows = new Map(); // key -> { el, item }
+        this.virtual = false;
+        this.spacer = null;
+        this.scrollScheduled = false;
+        this.onScroll = () => {
+            if (this.scrollScheduled) return;
+            this.scrollScheduled = true;
+            requestAnimationFrame(() => {
+                this.scrollScheduled = false;
+                this.render();
+            });
+        };
+    }
+
+    setItems(items) {
+        this.items = items;
+        this.render();
+    }
+
+    clear() {
+        this.setItems([]);
+    }
+
+    render() {
+        if (this.items.length === 0) {
+            this.setVirtual(false);
+            this.rows.clear();
+            this.container.innerHTML = this.emptyHtml;
+            return;
+        }
+        if (this.rows.size === 0 && !this.virtual) {
+            // Drop the empty state (or markup left by an older render)
+            this.container.innerHTML = '';
+        }
+
+        this.setVirtual(this.rowHeight > 0 && this.items.length > this.virtualizeAbove);
+
+        let first = 0;
+        let last = this.items.length;
+        if (this.virtual) {
+            this.spacer.style.height = (this.items.length * this.rowHeight) + 'px';
+            const viewport = this.container.clientHeight || (this.rowHeight * 10);
+            first = Math.max(0, Math.floor(this.container.scrollTop / this.rowHeight) - this.overscan);
+            last = Math.min(this.items.length, Math.ceil((this.container.scrollTop + viewport) / this.rowHeight) + this.overscan);
+        }
+
+        const parent = this.virtual ? this.spacer : this.container;
+        const wanted = new Set();
+        let cursor = parent.firstChild;
+
+        for (let i = first; i < last; i++) {
+            const item = this.items[i];
+            wanted.add(item.key);
+
+            let entry = this.rows.get(item.key);
+            if (!entry) {
+                entry = { el: this.createRow(item), item: null };
+                this.rows.set(item.key, entry);
+            }
+            if (entry.item !== item) {
+                this.updateRow(entry.el, item, entry.item, i);
+                entry.item = item;
+            }
+            if (this.virtual) {
+                entry.el.style.top = (i * this.rowHeight) + 'px';
+            }
+
+            // Only move the row when it is not already in place
+            if (entry.el !== cursor) {
+                parent.insertBefore(entry.el, cursor);
+            } else {
+                cursor = cursor.nextSibling;
+            }
+        }
+
+        for (const [key, entry] of this.rows) {
+            if (!wanted.has(key)) {
+                entry.el.remove();
+                this.rows.delete(key);
+            }
+        }
+    }
+
+    setVirtual(enabled) {
+        if (enabled === this.virtual) return;
+        this.virtual = enabled;
+        for (const entry of this.rows.values()) entry.el.remove();
+        this.rows.clear();
+
+        if (enabled) {
+            this.container.innerHTML = '';
+            this.container.classList.add('virtual-list');
+            this.container.style.setProperty('--row-height', this.rowHeight + 'px');
+            this.spacer = document.createElement('div');
+            this.spacer.className = 'virtual-spacer';
+            this.container.appendChild(this.spacer);
+            this.container.addEventListener('scroll', this.onScroll);
+        } else {
+            this.container.classList.remove('virtual-list');
+            this.container.removeEventListener('scroll', this.onScroll);
+            if (this.spacer) this.spacer.remove();
+            this.spacer = null;
+        }
+    }
+}
+
+// Returns the list bound to container, making a new one when the tab was
+// reloaded and the old container is gone
+function keyedListFor(list, container, options) {
+    if (list && list.container === container) return list;
+    return new KeyedList(container, options);
+}
+
+function setText(el, text) {
+    if (el.textContent !== text) el.textContent = text;
+}
+
+let signalList = null;
+
+function createSignalRow(item) {
+    const row = document.createElement('div');
+    row.className = 'console-line';
+    row.innerHTML = `
+        <span class="console-time"></span>
+        <span class="console-count"></span>
+        <span class="console-code"></span>
+        <span class="console-hex"></span>
+        <span class="console-meta">
+            <span class="meta-bits"></span>
+            <span class="meta-proto"></span>
+            <span class="meta-pulse"></span>
+            <span class="meta-state"></span>
+            <span class="meta-family"></span>
+        </span>
+        <div class="console-actions">
+            <button class="console-btn">Replay</button>
+            <button class="console-btn console-btn-save">Save</button>
+        </div>
+    `;
+
+    // The identity fields are part of the key, so the handlers never go stale
+    const sig = item.signal;
+    const buttons = row.querySelectorAll('.console-btn');
+    buttons[0].onclick = () => replaySignal(sig.code, sig.bitLength, sig.protocol, Number(row.dataset.pulse));
+    buttons[1].onclick = () => quickSaveSignal(sig.code, sig.bitLength, sig.protocol, Number(row.dataset.pulse));
+
+    setText(row.querySelector('.console-code'), String(sig.code));
+    setText(row.querySelector('.console-hex'), '0x' + sig.code.toString(16).toUpperCase().padStart(6, '0'));
+    setText(row.querySelector('.meta-bits'), `bits=${sig.bitLength}`);
+    setText(row.querySelector('.meta-proto'), `proto=${sig.protocol}`);
+    return row;
+}
+
+function updateSignalRow(row, item, prev) {
+    if (!prev || prev.lastSeenTimestamp !== item.lastSeenTimestamp) {
+        const time = row.querySelector('.console-time');
+        time.dataset.lastSeen = item.lastSeenTimestamp;
+        setText(time, formatTimeAgo(currentServerTime(), item.lastSeenTimestamp));
+    }
+    if (!prev || prev.count !== item.count) {
+        setText(row.querySelector('.console-count'), `[×${item.count.toString().padStart(3, ' ')}]`);
+    }
+    if (!prev || prev.signal.pulseLength !== item.signal.pulseLength) {
+        row.dataset.pulse = item.signal.pulseLength;
+        setText(row.querySelector('.meta-pulse'), `pulse=${item.signal.pulseLength}µs`);
+    }
+    setText(row.querySelector('.meta-state'), formatState(item.state, item.durationMs));
+    setText(row.querySelector('.meta-family'), item.family ? formatFamily(item.family) : '');
+}
+
+// Server clock now, extrapolated from the last history response
+function currentServerTime() {
+    const now = Date.now() * 1000; // Current time in microseconds
+    const elapsedSinceReceive = signalMap._receivedAt ? (now - signalMap._receivedAt) : 0;
+    return (signalMap._serverTime || now) + elapsedSinceReceive;
+}
+
 function displaySignal(signal, shouldFlash = false) {
     const display = document.getElementById('signalDisplay');
-    
-    // If signalMap is already populated from API, just refresh the display
-    if (signalMap._order && signalMap._order.length > 0) {
-        const signalsList = signalMap._order.map(key => ({
-            key,
-            ...signalMap[key]
-        }));
-        
-        // Update relative times for display
-        // Account for elapsed time since we received the server time
-        const now = Date.now() * 1000; // Current time in microseconds
-        const elapsedSinceReceive = signalMap._receivedAt ? (now - signalMap._receivedAt) : 0;
-        const currentServerTime = (signalMap._serverTime || now) + elapsedSinceReceive;
-        
-        const consoleHTML = signalsList.map(item => {
-            const sig = item.signal;
-            const hexCode = '0x' + sig.code.toString(16).toUpperCase().padStart(6, '0');
-            const itemKey = `${sig.code}_${sig.bitLength}_${sig.protocol}`;
-            const shouldFlashThis = false; // Flash is handled by new signal detection
-            
-            // Recalculate relative time on each display
-            const timeAgo = item.lastSeenTimestamp ? formatTimeAgo(currentServerTime, item.lastSeenTimestamp) : item.lastUpdate;
-
-        return `
-            <div class="console-line ${shouldFlashThis ? 'flash' : ''}">
-                <span class="console-time">${timeAgo}</span>
-                <span class="console-count">[×${item.count.toString().padStart(3, ' ')}]</span>
-                <span class="console-code">${sig.code}</span>
-                <span class="console-hex">${hexCode}</span>
-                <span class="console-meta">
-                    <span class="meta-bits">bits=${sig.bitLength}</span>
-                    <span class="meta-proto">proto=${sig.protocol}</span>
-                    <span class="meta-pulse">pulse=${sig.pulseLength}µs</span>
-                </span>
-                <div class="console-actions">
-                    <button class="console-btn" onclick="replaySignal(${sig.code}, ${sig.bitLength}, ${sig.protocol}, ${sig.pulseLength})">Replay</button>
-                    <button class="console-btn console-btn-save" onclick="quickSaveSignal(${sig.code}, ${sig.bitLength}, ${sig.protocol}, ${sig.pulseLength})">Save</button>
-                </div>
-            </div>
-        `;
-        }).join('');
-
-        display.innerHTML = consoleHTML || '<div class="empty-state">Waiting for RF signals...</div>';
-        return;
+    if (!display) return;
+
+    signalList = keyedListFor(signalList, display, {
+        createRow: createSignalRow,
+        updateRow: updateSignalRow,
+        emptyHtml: '<div class="empty-state">Waiting for RF signals...</div>'
+    });
+
+    // Entries are only replaced when the server reported a change, so unchanged
+    // rows keep their item and are skipped by the renderer
+    const order = signalMap._order || [];
+    signalList.setItems(order.map(key => signalMap[key]));
+}
+
+// Refreshes the "time ago" column once a second without re-rendering rows
+let timeAgoInterval = null;
+
+function startTimeAgoUpdates() {
+    if (timeAgoInterval) return;
+    timeAgoInterval = setInterval(() => {
+        const display = document.getElementById('signalDisplay');
+        if (!display) return;
+        const now = currentServerTime();
+        display.querySelectorAll('.console-time[data-last-seen]').forEach(el => {
+            setText(el, formatTimeAgo(now, Number(el.dataset.lastSeen)));
+        });
+    }, 1000);
+}
+
+function stopTimeAgoUpdates() {
+    if (timeAgoInterval) {
+        clearInterval(timeAgoInterval);
+        timeAgoInterval = null;
     }
+}
+
+function formatState(state, durationMs) {
+    if (!state || state === 'press') return '';
+    return durationMs ? `${state} ${(durationMs / 1000).toFixed(1)}s` : state;
+}
 
-    // Fallback: if signalMap is empty, show empty state
-    display.innerHTML = '<div class="empty-state">Waiting for RF signals...</div>';
+// Short text for the fields a device family decoder pulled out of a frame
+function formatFamily(family) {
+    const parts = [family.name];
+    if (family.deviceId !== undefined) parts.push('id=0x' + family.deviceId.toString(16).toUpperCase());
+    if (family.tristate !== undefined) parts.push(family.tristate);
+    if (family.button !== undefined) parts.push('btn=' + family.button);
+    if (family.channel !== undefined) parts.push('ch=' + family.channel);
+    if (family.temperature !== undefined) parts.push(family.temperature.toFixed(1) + '°C');
+    if (family.batteryLow) parts.push('battery low');
+    return parts.join(' ');
 }
 
 function updateLastSignalDisplay() {
@@ -65,42 +260,64 @@ function updateLastSignalDisplay() {
     }
 }
 
+// Above this many saved signals the library switches from the card grid to a
+// virtualized list of fixed-height rows
+const SAVED_SIGNALS_VIRTUALIZE_ABOVE = 100;
+const SAVED_SIGNAL_ROW_HEIGHT = 64;
+
+let savedSignalList = null;
+
+function savedSignalIndex(el) {
+    return Number(el.closest('.signal-card').dataset.signalIndex);
+}
+
+function createSavedSignalRow() {
+    const card = document.createElement('div');
+    card.className = 'signal-card';
+    card.innerHTML = `
+        <h3></h3>
+        <div class="signal-meta"></div>
+        <div class="signal-meta"></div>
+        <div class="button-group">
+            <button class="success" onclick="transmitSignal(savedSignalIndex(this))">Send</button>
+            <button onclick="editSignal(savedSignalIndex(this))">Edit</button>
+            <button class="danger" onclick="deleteSignal(savedSignalIndex(this))">Delete</button>
+        </div>
+    `;
+    return card;
+}
+
+function updateSavedSignalRow(card, item) {
+    // The index moves when an earlier signal is deleted, buttons read it from here
+    card.dataset.signalIndex = item.index;
+    const signal = item.signal;
+    const meta = card.querySelectorAll('.signal-meta');
+    setText(card.querySelector('h3'), signal.name);
+    setText(meta[0], `Code: ${signal.code} (0x${signal.code.toString(16).toUpperCase()})`);
+    setText(meta[1], `Bits: ${signal.bitLength} | Protocol: ${signal.protocol}`);
+}
+
 function displaySavedSignals() {
     const container = document.getElementById('savedSignals');
+    if (!container) return;
 
-    if (savedSignals.length === 0) {
-        container.innerHTML = '<div class="empty-state">No saved signals</div>';
-        return;
-    }
-
-    // Check if signals have actually changed
-    const signalsChanged =
-        savedSignals.length !== container.children.length ||
-        Array.from(container.children).some((el, index) => {
-            const signal = savedSignals[index];
-            return !signal ||
-                el.querySelector('h3').textContent !== signal.name ||
-                el.querySelector('.signal-meta:first-of-type').textContent !== `Code: ${signal.code} (0x${signal.code.toString(16).toUpperCase()})`;
-        });
+    savedSignalList = keyedListFor(savedSignalList, container, {
+        createRow: createSavedSignalRow,
+        updateRow: updateSavedSignalRow,
+        emptyHtml: '<div class="empty-state">No saved signals</div>',
+        rowHeight: SAVED_SIGNAL_ROW_HEIGHT,
+        virtualizeAbove: SAVED_SIGNALS_VIRTUALIZE_ABOVE
+    });
 
-    // Only update if there are actual changes
-    if (signalsChanged) {
-        // Generate new HTML
-        const signalsHTML = savedSignals.map((signal, index) => `
-            <div class="signal-card" data-signal-index="${index}">
-                <h3>${signal.name}</h3>
-                <div class="signal-meta">Code: ${signal.code} (0x${signal.code.toString(16).toUpperCase()})</div>
-                <div class="signal-meta">Bits: ${signal.bitLength} | Protocol: ${signal.protocol}</div>
-                <div class="button-group">
-                    <button class="success" onclick="transmitSignal(${index})">Send</button>
-                    <button onclick="editSignal(${index})">Edit</button>
-                    <button class="danger" onclick="deleteSignal(${index})">Delete</button>
-                </div>
-            </div>
-        `).join('');
-
-        container.innerHTML = signalsHTML;
-    }
+    // Rows are keyed by name (made unique in case an import brought duplicates).
+    // Items are rebuilt on every fetch; updateSavedSignalRow only writes the text
+    // that actually changed.
+    const seen = new Set();
+    savedSignalList.setItems(savedSignals.map((signal, index) => {
+        const key = seen.has(signal.name) ? `${signal.name}#${index}` : signal.name;
+        seen.add(key);
+        return { key, index, signal };
+    }));
 }
 
 function quickSaveSignal(code, bitLength, protocol, pulseLength) {
@@ -0,0 +1,162 @@
+#include "wifi_profile.h"
+#include <string.h>
+#include <strings.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "WIFI_PROFILE";
+
+#define LATENCY_WINDOW 64
+
+typedef struct {
+    wifi_ps_type_t ps;
+    uint16_t listen_interval;
+    const char *name;
+} profile_def_t;
+
+static const profile_def_t profiles[WIFI_PROFILE_COUNT] = {
+    [WIFI_PROFILE_LATENCY]   = { WIFI_PS_NONE,      0,  "latency"   },
+    [WIFI_PROFILE_BALANCED]  = { WIFI_PS_MIN_MODEM, 0,  "balanced"  },
+    [WIFI_PROFILE_LOW_POWER] = { WIFI_PS_MAX_MODEM, 10, "low-power" },
+};
+
+typedef struct {
+    uint16_t rtt_ms[LATENCY_WINDOW];
+    uint32_t count;
+    uint32_t next;
+} latency_window_t;
+
+static wifi_profile_t current_profile = WIFI_PROFILE_BALANCED;
+static latency_window_t latency[WIFI_PROFILE_COUNT];
+static portMUX_TYPE latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+wifi_profile_t wifi_profile_load(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open("storage", NVS_READONLY, &handle) == ESP_OK) {
+        uint8_t value;
+        if (nvs_get_u8(handle, "wifi_profile", &value) == ESP_OK && value < WIFI_PROFILE_COUNT) {
+            current_profile = (wifi_profile_t)value;
+        }
+        nvs_close(handle);
+    }
+
+    ESP_LOGI(TAG, "WiFi profile: %s", profiles[current_profile].name);
+    return current_profile;
+}
+
+uint16_t wifi_profile_listen_interval(wifi_profile_t profile)
+{
+    return profiles[profile].listen_interval;
+}
+
+void wifi_profile_apply(void)
+{
+    esp_err_t err = esp_wifi_set_ps(profiles[current_profile].ps);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set power save mode: %s", esp_err_to_name(err));
+    }
+}
+
+esp_err_t wifi_profile_set(wifi_profile_t profile)
+{
+    if (profile >= WIFI_PROFILE_COUNT) return ESP_ERR_INVALID_ARG;
+
+    current_profile = profile;
+    wifi_profile_apply();
+
+    wifi_config_t config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &config) == ESP_OK) {
+        config.sta.listen_interval = profiles[profile].listen_interval;
+        esp_wifi_set_config(WIFI_IF_STA, &config);
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open("storage", NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS handle");
+        return err;
+    }
+    err = nvs_set_u8(handle, "wifi_profile", (uint8_t)profile);
+    if (err == ESP_OK) {
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    ESP_LOGI(TAG, "WiFi profile set to %s", profiles[profile].name);
+    return err;
+}
+
+wifi_profile_t wifi_profile_get(void)
+{
+    return current_profile;
+}
+
+const char *wifi_profile_to_string(wifi_profile_t profile)
+{
+    return profile < WIFI_PROFILE_COUNT ? profiles[profile].name : "unknown";
+}
+
+bool wifi_profile_from_string(const char *name, wifi_profile_t *out)
+{
+    for (int i = 0; i < WIFI_PROFILE_COUNT; i++) {
+        if (strcasecmp(name, profiles[i].name) == 0) {
+            *out = (wifi_profile_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void wifi_profile_record_rtt(uint32_t rtt_ms)
+{
+    if (rtt_ms > UINT16_MAX) rtt_ms = UINT16_MAX;
+
+    portENTER_CRITICAL(&latency_lock);
+    latency_window_t *w = &latency[current_profile];
+    w->rtt_ms[w->next] = (uint16_t)rtt_ms;
+    w->next = (w->next + 1) % LATENCY_WINDOW;
+    if (w->count < LATENCY_WINDOW) w->count++;
+    portEXIT_CRITICAL(&latency_lock);
+}
+
+void wifi_profile_get_latency(wifi_profile_t profile, wifi_latency_stats_t *stats)
+{
+    uint16_t sorted[LATENCY_WINDOW];
+    uint32_t n;
+
+    memset(stats, 0, sizeof(*stats));
+    if (profile >= WIFI_PROFILE_COUNT) return;
+
+    portENTER_CRITICAL(&latency_lock);
+    n = latency[profile].count;
+    memcpy(sorted, latency[profile].rtt_ms, n * sizeof(uint16_t));
+    portEXIT_CRITICAL(&latency_lock);
+
+    if (n == 0) return;
+
+    // Insertion sort, the window is tiny
+    for (uint32_t i = 1; i < n; i++) {
+        uint16_t v = sorted[i];
+        uint32_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    stats->samples = n;
+    stats->p50_ms = sorted[(n - 1) * 50 / 100];
+    stats->p99_ms = sorted[(n - 1) * 99 / 100];
+    stats->max_ms = sorted[n - 1];
+}
+
+void wifi_profile_reset_latency(void)
+{
+    portENTER_CRITICAL(&latency_lock);
+    memset(latency, 0, sizeof(latency));
+    portEXIT_CRITICAL(&latency_lock);
+}
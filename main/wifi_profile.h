@@ -0,0 +1,54 @@
+#ifndef WIFI_PROFILE_H
+#define WIFI_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Trade-off between API responsiveness and radio power draw
+typedef enum {
+    WIFI_PROFILE_LATENCY = 0,   // Modem sleep off, every request is answered right away
+    WIFI_PROFILE_BALANCED,      // Modem sleep, wakes every DTIM (IDF default)
+    WIFI_PROFILE_LOW_POWER,     // Max modem sleep with a long listen interval
+    WIFI_PROFILE_COUNT
+} wifi_profile_t;
+
+typedef struct {
+    uint32_t samples;           // Samples currently in the window
+    uint32_t p50_ms;
+    uint32_t p99_ms;
+    uint32_t max_ms;
+} wifi_latency_stats_t;
+
+// Loads the persisted profile from NVS (defaults to balanced). Call before esp_wifi_start().
+wifi_profile_t wifi_profile_load(void);
+
+// Listen interval (in beacon intervals) to put in the station config for a profile
+uint16_t wifi_profile_listen_interval(wifi_profile_t profile);
+
+// Applies the power-save mode now and persists the choice. The listen interval is
+// part of the association, so it only changes after the next (re)connect.
+esp_err_t wifi_profile_set(wifi_profile_t profile);
+
+// Applies the power-save mode of the current profile, call after esp_wifi_start()
+void wifi_profile_apply(void);
+
+wifi_profile_t wifi_profile_get(void);
+const char *wifi_profile_to_string(wifi_profile_t profile);
+bool wifi_profile_from_string(const char *name, wifi_profile_t *out);
+
+// Latency probe: clients report the round trip they measured for their previous
+// probe request, samples are kept per profile in a small sliding window.
+void wifi_profile_record_rtt(uint32_t rtt_ms);
+void wifi_profile_get_latency(wifi_profile_t profile, wifi_latency_stats_t *stats);
+void wifi_profile_reset_latency(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIFI_PROFILE_H